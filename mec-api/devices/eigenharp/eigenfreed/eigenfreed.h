@@ -34,6 +34,10 @@ namespace EigenApi
 
         // min time betwen polling in uS (1000=1ms)
         bool poll(long uSleep,long minPollTime=100);
+
+        // block until usb data has arrived, or timeout in uS, false on timeout
+        // allows a thread to poll only when there is something to decode
+        bool waitForData(long timeout);
         
         // note: callback ownership is retained by caller
         void addCallback(Callback* api);
@@ -41,6 +41,11 @@ namespace EigenApi
     {
         return static_cast<EigenFreeD*>(impl)->poll(uSleep,minPollTime);
     }
+
+    bool Eigenharp::waitForData(long timeout)
+    {
+        return static_cast<EigenFreeD*>(impl)->waitForData(timeout);
+    }
     
     void Eigenharp::addCallback(Callback* api)
     {
@@ -9,6 +9,7 @@
 #include <picross/pic_time.h>
 #include <picross/pic_log.h>
 #include <picross/pic_resources.h>
+#include <picross/pic_usb.h>
 #include <string.h>
 
 
@@ -158,6 +159,11 @@ bool EigenFreeD::poll(long uSleepTime,long minPollTime)
     return false;
 }
 
+bool EigenFreeD::waitForData(long timeout)
+{
+    return pic::usb_wait_data(timeout);
+}
+
     
 void EigenFreeD::fireDeviceEvent(const char* dev, 
                                  Callback::DeviceType dt, int rows, int cols, int ribbons, int pedals)
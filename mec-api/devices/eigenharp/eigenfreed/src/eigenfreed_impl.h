@@ -24,6 +24,7 @@ namespace EigenApi
         virtual bool start();
         virtual bool stop();
         virtual bool poll(long uSleep,long minPollTime);
+        virtual bool waitForData(long timeout);
 
         void setLED(const char* dev, unsigned int keynum,unsigned int colour);
 
@@ -212,6 +212,10 @@ namespace pic
     PIC_DECLSPEC_FUNC(std::string) usb_string(usbdevice_t *device, unsigned index);
     PIC_DECLSPEC_FUNC(std::string) usb_serial(usbdevice_t *device);
     PIC_DECLSPEC_FUNC(std::string) usb_product(usbdevice_t *device);
+
+    // block until an inbound pipe has received data (since the last call), or timeout (uS)
+    // returns false on timeout. where not supported, sleeps (at most 1ms) and returns true
+    PIC_DECLSPEC_FUNC(bool) usb_wait_data(unsigned long long timeout);
 };
 
 #endif
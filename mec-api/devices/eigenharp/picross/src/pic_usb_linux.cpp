@@ -49,6 +49,9 @@
 
 namespace
 {
+    // opened as inbound buffers complete, see usb_wait_data
+    pic::xgate_t data_gate__;
+
 	struct usbpipe_out_t;
 	struct usbpipe_in_t;
 
@@ -593,6 +596,7 @@ void usbpipe_in_t::completed(libusb_transfer* transfer)
     }
 
 	pipe->append_receive_queue(buf);
+	data_gate__.open();
 	{
 	    pic::mutex_t::guard_t guard(&(buf->pipe_->device_->device_lock_));
 		pipe->device_->count_--;
@@ -1373,3 +1377,8 @@ int pic::usbenumerator_t::gc_clear()
     impl_->removed_.gc_clear();
     return 0;
 }
+
+bool pic::usb_wait_data(unsigned long long timeout)
+{
+    return data_gate__.pass_and_shut_timed(timeout) != 0;
+}
@@ -1879,3 +1879,9 @@ int pic::usbenumerator_t::gc_clear()
     pic::mutex_t::guard_t g(impl_->lock_);
     return impl_->delegate_.gc_clear();
 }
+
+bool pic::usb_wait_data(unsigned long long timeout)
+{
+    pic_microsleep(timeout < 1000ULL ? timeout : 1000ULL);
+    return true;
+}
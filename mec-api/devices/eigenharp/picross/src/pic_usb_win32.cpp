@@ -1377,3 +1377,9 @@ int pic::usbenumerator_t::gc_clear()
     impl_->removed_.gc_clear();
     return 0;
 }
+
+bool pic::usb_wait_data(unsigned long long timeout)
+{
+    pic_microsleep(timeout < 1000ULL ? timeout : 1000ULL);
+    return true;
+}
@@ -1,8 +1,11 @@
 #include "mec_eigenharp.h"
 
 #include "mec_log.h"
+#include "../mec_latency.h"
 #include "../mec_surfacemapper.h"
 #include "../mec_voice.h"
+#include "../mec_device_thread.h"
+#include "../mec_msg_merge.h"
 
 
 #include <set>
@@ -12,9 +15,14 @@ namespace mec {
 ////////////////////////////////////////////////
 class EigenharpHandler : public EigenApi::Callback {
 public:
+    static const unsigned PICO_KEYS = 22; // 18 + 4 mode keys
+    static const unsigned TAU_KEYS = 92; // 72 + 12 percussion + 8 mode keys
+    static const unsigned ALPHA_KEYS = 132; // 120 + 12 percussion keys
+
     EigenharpHandler(Preferences &p, ICallback &cb)
             : prefs_(p),
               callback_(cb),
+              timed_(dynamic_cast<MsgQueueCallback *>(&cb)),
               valid_(true),
               voices_(static_cast<unsigned>(p.getInt("voices", 15)),
                       static_cast<unsigned>(p.getInt("velocity count", 5))),
@@ -24,6 +32,7 @@ public:
                         ? 0 : 1000000ULL /
                               p.getInt("throttle",
                                        0)) {
+        voices_.setStealPolicy(Voices::parseStealPolicy(p.getString("steal policy", "oldest")));
         if (valid_) {
             LOG_0("EigenharpHandler enabling for mecapi");
         }
@@ -33,19 +42,25 @@ public:
 
     virtual void device(const char *dev, DeviceType dt, int rows, int cols, int ribbons, int pedals) {
         const char *dk;
+        // key ids include the percussion and mode keys, numbered after the main keys
+        unsigned keys = static_cast<unsigned>(rows * cols);
         switch (dt) {
             case EigenApi::Callback::PICO:
                 dk = "pico";
+                keys = PICO_KEYS;
                 break;
             case EigenApi::Callback::TAU:
                 dk = "tau";
+                keys = TAU_KEYS;
                 break;
             case EigenApi::Callback::ALPHA:
                 dk = "alpha";
+                keys = ALPHA_KEYS;
                 break;
             default:
                 dk = "default";
         }
+        voices_.setKeyCount(keys);
 
         LOG_1("EigenharpHandler device d: " << dev << " dt: " << (int) dt) << " dk: " << dk;
         LOG_1(" r: " << rows << " c: " << cols);
@@ -63,6 +78,8 @@ public:
 
     virtual void key(const char *dev, unsigned long long t, unsigned course, unsigned key, bool a, unsigned p, int r,
                      int y) {
+        MEC_TRACE_ARRIVAL();
+        stamp(t);
         Voices::Voice *voice = voices_.voiceId(key);
         float mx = bipolar(r);
         float my = bipolar(y);
@@ -86,7 +103,7 @@ public:
                 if (!voice && stealVoices_) {
                     LOG_2("voice steal required for " << key);
                     // no available voices, steal?
-                    Voices::Voice *stolen = voices_.oldestActiveVoice();
+                    Voices::Voice *stolen = voices_.voiceToSteal();
                     callback_.touchOff(stolen->i_, stolen->note_, stolen->x_, stolen->y_, 0.0f);
                     stolenKeys_.insert((unsigned) stolen->id_);
                     voices_.stopVoice(stolen);
@@ -131,20 +148,29 @@ public:
     }
 
     virtual void breath(const char *dev, unsigned long long t, unsigned val) {
+        MEC_TRACE_ARRIVAL();
+        stamp(t);
         callback_.control(0, unipolar(val));
     }
 
     virtual void strip(const char *dev, unsigned long long t, unsigned strip, unsigned val) {
+        MEC_TRACE_ARRIVAL();
+        stamp(t);
         callback_.control(0x10 + strip, unipolar(val));
     }
 
     virtual void pedal(const char *dev, unsigned long long t, unsigned pedal, unsigned val) {
+        MEC_TRACE_ARRIVAL();
+        stamp(t);
         callback_.control(0x20 + pedal, unipolar(val));
     }
 
 private:
     inline float clamp(float v, float mn, float mx) { return (std::max(std::min(v, mx), mn)); }
 
+    // when queued, messages are timed by the usb buffer time (uS), so can be ordered against other devices
+    void stamp(unsigned long long t) { if (timed_) timed_->setTime(clock_.hostTime(t)); }
+
     float unipolar(int val) { return std::min(float(val) / 4096.0f, 1.0f); }
 
     float bipolar(int val) { return clamp(float(val) / 4096.0f, -1.0f, 1.0f); }
@@ -156,6 +182,8 @@ private:
 
     Preferences prefs_;
     ICallback &callback_;
+    MsgQueueCallback *timed_;
+    DeviceClock clock_;
     SurfaceMapper mapper_;
     Voices voices_;
     bool valid_;
@@ -168,7 +196,7 @@ private:
 
 ////////////////////////////////////////////////
 Eigenharp::Eigenharp(ICallback &cb) :
-        active_(false), callback_(cb), minPollTime_(100) {
+        active_(false), callback_(cb), minPollTime_(100), usbThread_(false), running_(false) {
 }
 
 Eigenharp::~Eigenharp() {
@@ -185,14 +213,27 @@ bool Eigenharp::init(void *arg) {
     active_ = false;
     std::string fwDir = prefs.getString("firmware dir", "./resources/");
     minPollTime_ = prefs.getInt("min poll time", 100);
+    usbThread_ = prefs.getBool("usb thread", false);
+    ICallback *handlerCb = &callback_;
+    if (usbThread_) {
+        threadPrefs_ = ThreadPrefs(prefs);
+        queue_.resize(ringSize(prefs.getInt("queue size", MsgQueue::DEFAULT_CAPACITY), MsgQueue::DEFAULT_CAPACITY));
+        queueCallback_.reset(new MsgQueueCallback(queue_));
+        handlerCb = queueCallback_.get();
+    }
     eigenD_.reset(new EigenApi::Eigenharp(fwDir.c_str()));
-    EigenharpHandler *pCb = new EigenharpHandler(prefs, callback_);
+    EigenharpHandler *pCb = new EigenharpHandler(prefs, *handlerCb);
     if (pCb->isValid()) {
         eigenD_->addCallback(pCb);
         if (eigenD_->create()) {
             if (eigenD_->start()) {
                 active_ = true;
                 LOG_1("Eigenharp::init - started");
+                if (usbThread_) {
+                    running_ = true;
+                    thread_ = std::thread(&Eigenharp::usbRun, this);
+                    LOG_1("Eigenharp::init - usb thread started");
+                }
             } else {
                 LOG_2("Eigenharp::init - failed to start");
             }
@@ -207,15 +248,37 @@ bool Eigenharp::init(void *arg) {
 }
 
 bool Eigenharp::process() {
+    if (usbThread_) return queue_.process(callback_);
+
     const int sleepTime = 0;
     if (active_) eigenD_->poll(sleepTime, minPollTime_);
     return true;
 }
 
+// sleeps until picross signals usb data has arrived, rather than spinning in poll
+// the timeout keeps polling (e.g. for device housekeeping) going when idle
+void Eigenharp::usbRun() {
+    static const long WAIT_TIMEOUT = 100000; // uS
+    threadPrefs_.apply("Eigenharp");
+    while (running_) {
+        eigenD_->waitForData(WAIT_TIMEOUT);
+        if (!running_) break;
+        eigenD_->poll(0, 0);
+    }
+}
+
 void Eigenharp::deinit() {
     if (!eigenD_) return;
+    if (thread_.joinable()) {
+        running_ = false;
+        thread_.join();
+    }
     eigenD_->destroy();
     eigenD_.reset();
+    queueCallback_.reset();
+    if (queue_.overflowCount() > 0) {
+        LOG_0("Eigenharp::deinit - queue overflowed, msgs dropped : " << queue_.overflowCount());
+    }
     active_ = false;
 }
 
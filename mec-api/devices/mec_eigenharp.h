@@ -3,9 +3,13 @@
 
 #include "../mec_api.h"
 #include "../mec_device.h"
+#include "../mec_msg_queue.h"
+#include "../mec_thread.h"
 
 #include <eigenfreed/eigenfreed.h>
+#include <atomic>
 #include <memory>
+#include <thread>
 
 namespace mec {
 class Eigenharp : public Device {
@@ -17,12 +21,23 @@ public:
     virtual bool process();
     virtual void deinit();
     virtual bool isActive();
+    virtual MsgQueue* queue() { return usbThread_ ? &queue_ : nullptr; }
 
 private:
+    void usbRun();
+
     ICallback &callback_;
     std::unique_ptr<EigenApi::Eigenharp> eigenD_;
     bool active_;
     long minPollTime_;
+
+    // usb thread mode, usb is polled on its own thread when data arrives, touches are queued
+    bool usbThread_;
+    ThreadPrefs threadPrefs_;
+    MsgQueue queue_;
+    std::unique_ptr<ICallback> queueCallback_;
+    std::thread thread_;
+    std::atomic<bool> running_;
 };
 
 }
@@ -2,6 +2,8 @@
 
 #include "mec_log.h"
 
+#include <algorithm>
+
 namespace mec {
 
 
@@ -69,6 +71,7 @@ bool KontrolDevice::init(void *arg) {
     model_->addCallback("clienthandler", std::make_shared<KontrolDeviceClientHandler>(*this));
 
     listenPort_ = static_cast<unsigned>(prefs.getInt("listen port", 4000));
+    model_->setChangeInterval(static_cast<unsigned>(prefs.getInt("change interval", 0)));
 
     if (listenPort_ > 0) {
         auto p = std::make_shared<Kontrol::OSCReceiver>(model_);
@@ -150,7 +153,9 @@ void KontrolDevice::processorRun() {
                 }
             }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(OSC_POLL_MS));
+        model_->flushChanges();
+        unsigned pollMs = model_->changeInterval() > 0 ? std::min(model_->changeInterval(), OSC_POLL_MS) : OSC_POLL_MS;
+        std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
     }
 }
 
@@ -23,6 +23,7 @@ public:
     virtual bool process();
     virtual void deinit();
     virtual bool isActive();
+    virtual MsgQueue* queue() { return &queue_; }
 
     void newClient(Kontrol::ChangeSource src, const std::string &host, unsigned port, unsigned keepalive);
     void processorRun();
@@ -1,6 +1,7 @@
 #include "mec_mididevice.h"
 
 #include "mec_log.h"
+#include "../mec_latency.h"
 #include "../mec_voice.h"
 
 namespace mec {
@@ -33,6 +34,7 @@ bool MidiDevice::init(void *arg) {
         deinit();
     }
     active_ = false;
+    queue_.resize(ringSize(prefs.getInt("queue size", MsgQueue::DEFAULT_CAPACITY), MsgQueue::DEFAULT_CAPACITY));
 
     bool found = false;
 
@@ -140,6 +142,9 @@ void MidiDevice::deinit() {
     LOG_0("MidiDevice::deinit");
     if (midiInDevice_) midiInDevice_->cancelCallback();
     midiInDevice_.reset();
+    if (queue_.overflowCount() > 0) {
+        LOG_0("MidiDevice::deinit - queue overflowed, msgs dropped : " << queue_.overflowCount());
+    }
     active_ = false;
 }
 
@@ -148,6 +153,7 @@ bool MidiDevice::isActive() {
 }
 
 bool MidiDevice::midiCallback(double, std::vector<unsigned char> *message) {
+    MEC_TRACE_ARRIVAL();
     int status = 0, data1 = 0, data2 = 0; //data3 = 0;
     unsigned int n = message->size();
     if (n > 3) LOG_0("midiCallback unexpect midi size" << n);
@@ -21,6 +21,7 @@ public:
     virtual bool process();
     virtual void deinit();
     virtual bool isActive();
+    virtual MsgQueue* queue() { return &queue_; }
 
     virtual bool midiCallback(double deltatime, std::vector<unsigned char> *message);
 
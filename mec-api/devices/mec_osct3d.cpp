@@ -9,6 +9,7 @@
 #include <algorithm>
 
 #include "mec_log.h"
+#include "../mec_latency.h"
 #include "../mec_voice.h"
 
 ////////////////////////////////////////////////
@@ -19,18 +20,24 @@ namespace mec {
 
 class OscT3DHandler : public osc::OscPacketListener {
 public:
+    static const unsigned MAX_TOUCHES = 16; // touch ids sent by t3d
+
     OscT3DHandler(Preferences &p, MsgQueue &q)
         : prefs_(p),
           queue_(q),
           valid_(true),
-          socket_(nullptr) {
+          socket_(nullptr),
+          inFrame_(false),
+          frameTime_(0),
+          voices_(15, 5, MAX_TOUCHES) {
         if (valid_) {
             LOG_0("OscT3DHandler enabling for mecapi");
         }
-        for (int i = 0; i < sizeof(activeTouches_); i++) {
+        for (unsigned i = 0; i < MAX_TOUCHES; i++) {
             activeTouches_[i] = false;
         }
         stealVoices_ = false;
+        voices_.setStealPolicy(Voices::parseStealPolicy(p.getString("steal policy", "oldest")));
     }
 
     bool isValid() { return valid_; }
@@ -39,9 +46,16 @@ public:
         socket_ = pS;
     }
 
+    // t3d sends a frame as one bundle, /t3d/frm then its touches, so the frame ends with the packet
+    virtual void ProcessPacket(const char *data, int size, const IpEndpointName &remoteEndpoint) {
+        osc::OscPacketListener::ProcessPacket(data, size, remoteEndpoint);
+        endFrame();
+    }
+
     virtual void ProcessMessage(const osc::ReceivedMessage &m,
                                 const IpEndpointName &remoteEndpoint) {
         (void) remoteEndpoint; // suppress unused parameter warning
+        MEC_TRACE_ARRIVAL();
 
         try {
             // example of parsing single messages. osc::OsckPacketListener
@@ -62,6 +76,14 @@ public:
             } else if (addr == A_FRM) {
                 osc::int32 d1, d2;
                 args >> d1 >> d2 >> osc::EndMessage;
+                // frame id, timestamp
+                endFrame();
+                MecMsg msg;
+                msg.type_ = MecMsg::FRAME_START;
+                msg.data_.frame_.t_ = static_cast<unsigned long long>(d2);
+                queue_.addToQueue(msg);
+                inFrame_ = true;
+                frameTime_ = msg.data_.frame_.t_;
             } else if (addr == A_COMMAND) {
                 const char *cmd;
                 args >> cmd >> osc::EndMessage;
@@ -91,7 +113,7 @@ public:
 
                 if (!voice && stealVoices_) {
                     // no available voices, steal?
-                    Voices::Voice *stolen = voices_.oldestActiveVoice();
+                    Voices::Voice *stolen = voices_.voiceToSteal();
                     MecMsg msg;
                     msg.data_.touch_.touchId_ = stolen->i_;
                     msg.data_.touch_.note_ = stolen->note_;
@@ -160,11 +182,23 @@ private:
 
     float note(float n) { return n; }
 
+    // every FRAME_START is matched, the merge holds other devices until the frame ends
+    void endFrame() {
+        if (!inFrame_) return;
+        MecMsg msg;
+        msg.type_ = MecMsg::FRAME_END;
+        msg.data_.frame_.t_ = frameTime_;
+        queue_.addToQueue(msg);
+        inFrame_ = false;
+    }
+
     Preferences prefs_;
     MsgQueue &queue_;
     bool valid_;
-    bool activeTouches_[16];
+    bool activeTouches_[MAX_TOUCHES];
     UdpListeningReceiveSocket *socket_;
+    bool inFrame_;
+    unsigned long long frameTime_;
     bool stealVoices_;
     Voices voices_;
 
@@ -197,6 +231,7 @@ bool OscT3D::init(void *arg) {
         deinit();
     }
     active_ = false;
+    queue_.resize(ringSize(prefs.getInt("queue size", MsgQueue::DEFAULT_CAPACITY), MsgQueue::DEFAULT_CAPACITY));
     OscT3DHandler *pCb = new OscT3DHandler(prefs, queue_);
 
     port_ = (unsigned) prefs.getInt("port", 9000);
@@ -233,6 +268,9 @@ void OscT3D::deinit() {
         socket_->AsynchronousBreak();
         listenThread_.join();
         socket_.reset();
+        if (queue_.overflowCount() > 0) {
+            LOG_0("OscT3D::deinit - queue overflowed, msgs dropped : " << queue_.overflowCount());
+        }
         LOG_0("OscT3D::deinit done");
     }
     active_ = false;
@@ -22,6 +22,7 @@ public:
     virtual bool process();
     virtual void deinit();
     virtual bool isActive();
+    virtual MsgQueue* queue() { return &queue_; }
 
     void listenProc();
 
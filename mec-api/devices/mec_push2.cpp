@@ -71,6 +71,9 @@ bool Push2::init(void *arg) {
         push2Api_->init();
 
         push2Api_->clearDisplay();
+        // display is sent from its own thread, when changed
+        push2Api_->start(static_cast<unsigned>(prefs.getInt("display fps", Push2API::Push2::DEFAULT_MAX_FPS)),
+                         static_cast<unsigned>(prefs.getInt("display keep alive", Push2API::Push2::DEFAULT_KEEP_ALIVE_MS)));
 
         // Kontrol setup
         model_ = Kontrol::KontrolModel::model();
@@ -96,14 +99,16 @@ bool Push2::init(void *arg) {
 
 void Push2::processorRun() {
     while (active_) {
-        push2Api_->render();
-
         while (PaUtil_GetRingBufferReadAvailable(&midiQueue_)) {
             MidiMsg msg;
             PaUtil_ReadRingBuffer(&midiQueue_, &msg, 1);
             processMidi(msg);
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(OSC_POLL_MS));
+
+        std::unique_lock<std::mutex> lock(midiMtx_);
+        midiCond_.wait_for(lock, std::chrono::milliseconds(OSC_POLL_MS), [this] {
+            return !active_ || PaUtil_GetRingBufferReadAvailable(&midiQueue_) > 0;
+        });
     }
 }
 
@@ -114,7 +119,11 @@ bool Push2::process() {
 
 void Push2::deinit() {
     LOG_0("Push2::deinit");
-    active_ = false;
+    {
+        std::lock_guard<std::mutex> lock(midiMtx_);
+        active_ = false;
+    }
+    midiCond_.notify_one();
 
     if (processor_.joinable()) {
         processor_.join();
@@ -137,6 +146,10 @@ bool Push2::midiCallback(double, std::vector<unsigned char> *message) {
 
     // LOG_0("midi: s " << std::hex << m.status_ << " "<< m.data[1] << " " << m.data[2]);
     PaUtil_WriteRingBuffer(&midiQueue_, (void *) &m, 1);
+    {
+        std::lock_guard<std::mutex> lock(midiMtx_);
+    }
+    midiCond_.notify_one();
     return true;
 }
 
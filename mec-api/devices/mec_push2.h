@@ -12,6 +12,8 @@
 #include <push2lib/push2lib.h>
 #include <pa_ringbuffer.h>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace mec {
 static const unsigned P2_NOTE_PAD_START = 36;
@@ -178,6 +180,8 @@ private:
     static const unsigned int MAX_N_MIDI_MSGS = 16;
     PaUtilRingBuffer midiQueue_; // draw midi from P2
     char msgData_[sizeof(MidiMsg) * MAX_N_MIDI_MSGS];
+    std::mutex midiMtx_;
+    std::condition_variable midiCond_; // midi queued, or deactivated
     std::thread processor_;
 };
 
@@ -0,0 +1,118 @@
+#include "mec_replay.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "mec_log.h"
+
+namespace mec {
+
+////////////////////////////////////////////////
+Replay::Replay(ICallback &cb) :
+    callback_(cb), active_(false), running_(false),
+    realtime_(true), loop_(false), shutdownAtEnd_(false) {
+}
+
+Replay::~Replay() {
+    deinit();
+}
+
+bool Replay::init(void *arg) {
+    Preferences prefs(arg);
+
+    if (active_) {
+        deinit();
+    }
+    active_ = false;
+
+    std::string file = prefs.getString("file", "mec.rec");
+    std::vector<std::string> devices;
+    std::vector<RecordedMsg> msgs;
+    if (!Recorder::load(file, devices, msgs)) {
+        LOG_0("Replay::init - unable to load recording " << file);
+        return false;
+    }
+
+    // one recorded device is replayed, the first unless named, as touch ids are only unique within a device.
+    // all devices can be replayed into this one queue, if their touch ids do not collide
+    bool allDevices = prefs.getBool("all devices", false);
+    std::string device = prefs.getString("device", "");
+    if (device.empty() && !devices.empty()) device = devices[0];
+    msgs_.clear();
+    msgs_.reserve(msgs.size());
+    for (std::vector<RecordedMsg>::iterator it = msgs.begin(); it != msgs.end(); ++it) {
+        // controlling the api is left to the application
+        if (it->type_ == MecMsg::MEC_CONTROL) continue;
+        if (!allDevices && (it->device_ >= devices.size() || devices[it->device_] != device)) continue;
+        msgs_.push_back(*it);
+    }
+
+    realtime_ = prefs.getBool("realtime", true);
+    loop_ = prefs.getBool("loop", false);
+    shutdownAtEnd_ = prefs.getBool("shutdown at end", false);
+    queue_.resize(ringSize(prefs.getInt("queue size", MsgQueue::DEFAULT_CAPACITY), MsgQueue::DEFAULT_CAPACITY));
+
+    LOG_1("Replay::init - " << file << " msgs : " << msgs_.size() << (realtime_ ? " realtime" : " fast"));
+
+    running_ = true;
+    replayThread_ = std::thread(&Replay::replayProc, this);
+    active_ = true;
+    return active_;
+}
+
+bool Replay::process() {
+    return queue_.process(callback_);
+}
+
+void Replay::deinit() {
+    LOG_0("Replay::deinit");
+    if (active_) {
+        running_ = false;
+        replayThread_.join();
+        LOG_0("Replay::deinit done");
+    }
+    active_ = false;
+}
+
+bool Replay::isActive() {
+    return active_;
+}
+
+// unlike a real device, nothing is dropped: wait for the api to make space
+bool Replay::send(MecMsg &msg) {
+    while (!queue_.addToQueue(msg)) {
+        if (!running_) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void Replay::replayProc() {
+    typedef std::chrono::steady_clock Clock;
+    do {
+        Clock::time_point start = Clock::now();
+        uint64_t t0 = msgs_.empty() ? 0 : msgs_.front().t_;
+        for (std::vector<RecordedMsg>::const_iterator it = msgs_.begin(); it != msgs_.end() && running_; ++it) {
+            if (realtime_) {
+                // sleep in short steps, so deinit is not held up by gaps in the recording
+                Clock::time_point due = start + std::chrono::nanoseconds(it->t_ - t0);
+                while (running_ && Clock::now() < due) {
+                    std::this_thread::sleep_until(std::min(due, Clock::now() + std::chrono::milliseconds(10)));
+                }
+            }
+            MecMsg msg;
+            it->toMsg(msg);
+            send(msg);
+        }
+    } while (loop_ && running_ && !msgs_.empty());
+
+    if (shutdownAtEnd_ && running_) {
+        LOG_1("Replay - recording finished, requesting shutdown");
+        MecMsg msg;
+        msg.type_ = MecMsg::MEC_CONTROL;
+        msg.data_.mec_control_.cmd_ = MecMsg::SHUTDOWN;
+        send(msg);
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+#ifndef MecReplay_H
+#define MecReplay_H
+
+#include "../mec_api.h"
+#include "../mec_device.h"
+#include "../mec_msg_queue.h"
+#include "../mec_recorder.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mec {
+
+// plays back a Recorder recording, as if from the original devices
+// in real time, or as fast as the api consumes it
+class Replay : public Device {
+
+public:
+    Replay(ICallback &);
+    virtual ~Replay();
+    virtual bool init(void *);
+    virtual bool process();
+    virtual void deinit();
+    virtual bool isActive();
+    virtual MsgQueue* queue() { return &queue_; }
+
+    void replayProc();
+
+private:
+    bool send(MecMsg &msg);
+
+    ICallback &callback_;
+    bool active_;
+    MsgQueue queue_;
+    std::thread replayThread_;
+    std::atomic<bool> running_;
+
+    std::vector<RecordedMsg> msgs_;
+    bool realtime_;
+    bool loop_;
+    bool shutdownAtEnd_;
+};
+
+}
+
+#endif // MecReplay_H
@@ -5,11 +5,26 @@
 
 
 #include "mec_log.h"
+#include "../mec_latency.h"
+#include "../mec_msg_merge.h"
 #include "../mec_voice.h"
 
 
 namespace mec {
 
+#ifdef MEC_LATENCY_TRACE
+// stamps the arrival of each frame from the driver, touches are then output on the same thread
+class TracingSoundplaneModel : public SoundplaneModel {
+public:
+    virtual void receivedFrame(SoundplaneDriver &driver, const float *data, int size) override {
+        MEC_TRACE_ARRIVAL();
+        SoundplaneModel::receivedFrame(driver, data, size);
+    }
+};
+#else
+typedef SoundplaneModel TracingSoundplaneModel;
+#endif
+
 
 ////////////////////////////////////////////////
 // TODO
@@ -20,9 +35,15 @@ public:
     SoundplaneHandler(Preferences &p, MsgQueue &q)
             : prefs_(p),
               queue_(q),
+              voices_(static_cast<unsigned>(p.getInt("voices", 15)), 5, kSoundplaneMaxTouches),
               valid_(true),
-              voices_(static_cast<unsigned>(p.getInt("voices", 15))),
+              inFrame_(false),
+              frameStarted_(false),
+              frameTime_(0),
+              clock_(1000), // ms
+              frameHostTime_(0),
               stealVoices_(p.getBool("steal voices", true)) {
+        voices_.setStealPolicy(Voices::parseStealPolicy(p.getString("steal policy", "oldest")));
         if (valid_) {
             LOG_0("SoundplaneHandler enabling for mecapi");
         }
@@ -35,9 +56,38 @@ public:
         LOG_1(" r: " << rows << " c: " << cols);
     }
 
+    virtual void startFrame(const char *dev, unsigned long long t) {
+        // only queue frames which contain touches
+        inFrame_ = true;
+        frameStarted_ = false;
+        frameTime_ = t;
+        frameHostTime_ = clock_.hostTime(t);
+    }
+
+    virtual void endFrame(const char *dev, unsigned long long t) {
+        if (frameStarted_) {
+            MecMsg msg;
+            msg.type_ = MecMsg::FRAME_END;
+            msg.data_.frame_.t_ = t;
+            msg.t_ = frameHostTime_;
+            queue_.addToQueue(msg);
+        }
+        inFrame_ = false;
+        frameStarted_ = false;
+    }
+
     virtual void touch(const char *dev, unsigned long long t, bool a, int itouch, float n, float x, float y, float z) {
         static const unsigned int NOTE_CH_OFFSET = 1;
 
+        if (inFrame_ && !frameStarted_) {
+            MecMsg frameMsg;
+            frameMsg.type_ = MecMsg::FRAME_START;
+            frameMsg.data_.frame_.t_ = frameTime_;
+            frameMsg.t_ = frameHostTime_;
+            queue_.addToQueue(frameMsg);
+            frameStarted_ = true;
+        }
+
         unsigned touch = (unsigned) itouch;
         Voices::Voice *voice = voices_.voiceId(touch);
         float fn = n;
@@ -47,6 +97,7 @@ public:
         float mz = clamp(z, 0.0f, 1.0f);
 
         MecMsg msg;
+        msg.t_ = inFrame_ ? frameHostTime_ : clock_.hostTime(t);
         msg.type_ = MecMsg::TOUCH_OFF;
         msg.data_.touch_.touchId_ = -1;
         msg.data_.touch_.note_ = mn;
@@ -70,9 +121,10 @@ public:
 
                 if (!voice && stealVoices_) {
                     // no available voices, steal?
-                    Voices::Voice *stolen = voices_.oldestActiveVoice();
+                    Voices::Voice *stolen = voices_.voiceToSteal();
 
                     MecMsg stolenMsg;
+                    stolenMsg.t_ = msg.t_;
                     stolenMsg.type_ = MecMsg::TOUCH_OFF;
                     stolenMsg.data_.touch_.touchId_ = stolen->i_;
                     stolenMsg.data_.touch_.note_ = stolen->note_;
@@ -122,6 +174,7 @@ public:
 
     virtual void control(const char *dev, unsigned long long t, int id, float val) {
         MecMsg msg;
+        msg.t_ = clock_.hostTime(t);
         msg.type_ = MecMsg::CONTROL;
         msg.data_.control_.controlId_ = id;
         msg.data_.control_.value_ = clamp(val, -1.0f, 1.0f);
@@ -137,6 +190,11 @@ private:
     MsgQueue &queue_;
     Voices voices_;
     bool valid_;
+    bool inFrame_;
+    bool frameStarted_;
+    unsigned long long frameTime_;
+    DeviceClock clock_;
+    unsigned long long frameHostTime_;
     bool stealVoices_;
     std::set<unsigned> stolenTouches_;
 };
@@ -158,7 +216,8 @@ bool Soundplane::init(void *arg) {
         deinit();
     }
     active_ = false;
-    model_.reset(new SoundplaneModel());
+    queue_.resize(ringSize(prefs.getInt("queue size", MsgQueue::DEFAULT_CAPACITY), MsgQueue::DEFAULT_CAPACITY));
+    model_.reset(new TracingSoundplaneModel());
     std::string appDir = prefs.getString("app state dir", ".");
 
     // generate a persistent state for the Model
@@ -170,6 +229,14 @@ bool Soundplane::init(void *arg) {
     model_->setPropertyImmediate("osc_active", 0.0f);
     model_->setPropertyImmediate("mec_active", 1.0f);
     model_->setPropertyImmediate("data_freq_mec", 500.0f);
+    model_->setPropertyImmediate("fused_conditioning", prefs.getBool("fused conditioning", true) ? 1.0f : 0.0f);
+    model_->setPropertyImmediate("incremental_touch_sum", prefs.getBool("incremental touch sum", true) ? 1.0f : 0.0f);
+
+    // play back a frame capture instead of using the device, or capture the device's frames
+    model_->setPropertyImmediate("playback_file", prefs.getString("playback file", ""));
+    model_->setPropertyImmediate("playback_realtime", prefs.getBool("playback realtime", true) ? 1.0f : 0.0f);
+    model_->setPropertyImmediate("playback_loop", prefs.getBool("playback loop", false) ? 1.0f : 0.0f);
+    model_->setPropertyImmediate("capture_file", prefs.getString("capture file", ""));
 
     SoundplaneHandler *pCb = new SoundplaneHandler(prefs, queue_);
     if (pCb->isValid()) {
@@ -195,6 +262,9 @@ void Soundplane::deinit() {
     if (!model_) return;
     LOG_0("Soundplane::reset model");
     model_.reset();
+    if (queue_.overflowCount() > 0) {
+        LOG_0("Soundplane::deinit - queue overflowed, msgs dropped : " << queue_.overflowCount());
+    }
     active_ = false;
 }
 
@@ -23,6 +23,7 @@ public:
     virtual bool process();
     virtual void deinit();
     virtual bool isActive();
+    virtual MsgQueue* queue() { return &queue_; }
 
 private:
     ICallback &callback_;
@@ -182,13 +182,13 @@ void P2_ParamMode::setCurrentPage(int pageIdx) {
 
 void P2_ParamMode::rack(Kontrol::ChangeSource src, const Kontrol::Rack &rack) {
     P2_DisplayMode::rack(src, rack);
-    if (parent_.currentRack().length() == 0) parent_.currentRack(rack.id());
+    if (parent_.currentRack().empty()) parent_.currentRack(rack.id());
 }
 
 void P2_ParamMode::module(Kontrol::ChangeSource src, const Kontrol::Rack &rack, const Kontrol::Module &module) {
     P2_DisplayMode::module(src, rack, module);
     if (parent_.currentRack() != rack.id()) return;
-    if (parent_.currentModule().length() == 0) {
+    if (parent_.currentModule().empty()) {
         parent_.currentModule(module.id());
         setCurrentModule(0);
     } else {
@@ -222,7 +222,7 @@ void P2_ParamMode::page(Kontrol::ChangeSource src, const Kontrol::Rack &rack, co
     if (parent_.currentRack() != rack.id()) return;
     if (parent_.currentModule() != module.id()) return;
 
-    if (parent_.currentPage().length() == 0) {
+    if (parent_.currentPage().empty()) {
         auto pRack = model_->getRack(parent_.currentRack());
         auto pModule = model_->getModule(pRack, parent_.currentModule());
         auto pPages = model_->getPages(pModule);
@@ -51,20 +51,38 @@ static int perr(char const *format, ...) {
 #define ERR_EXIT(errcode) do { perr("   %s\n", libusb_strerror((enum libusb_error)errcode)); return -1; } while (0)
 #define CALL_CHECK(fcall) do { r=fcall; if (r < 0) ERR_EXIT(r); } while (0);
 
-Push2::Push2() : headerPkt_(headerPkt), handle_(NULL) {
-    ;
+Push2::Push2() : headerPkt_(headerPkt),
+                 dirtyFirst_(HEIGHT), dirtyLast_(0), renderRequested_(false),
+                 running_(false), frameInterval_(0), keepAlive_(0), framesSent_(0),
+                 headerTransfer_(NULL), dataTransfer_(NULL),
+                 ctx_(NULL), handle_(NULL) {
+    memset(dataPkt_, 0, DATA_PKT_SZ);
+    memset(frontPkt_, 0, DATA_PKT_SZ);
 }
 
 Push2::~Push2() {
-    ;
+    stop();
 }
 
+// display lines [first, last) have been drawn, call with drawMtx_ held
+void Push2::markDirty(unsigned first, unsigned last) {
+    if (last > HEIGHT) last = HEIGHT;
+    if (first >= last) return;
+    if (first < dirtyFirst_) dirtyFirst_ = first;
+    if (last > dirtyLast_) dirtyLast_ = last;
+    if (running_) renderCond_.notify_one();
+}
 
 void Push2::clearDisplay() {
+    std::lock_guard<std::mutex> lock(drawMtx_);
     memset(dataPkt_, 0, DATA_PKT_SZ);
+    markDirty(0, HEIGHT);
 }
 
 void Push2::clearRow(unsigned row, unsigned vscale) {
+    std::lock_guard<std::mutex> lock(drawMtx_);
+    if (((row + 1) * F_HEIGHT * vscale) > HEIGHT) return;
+    markDirty(row * F_HEIGHT * vscale, (row + 1) * F_HEIGHT * vscale);
     for (int line = 0; line < F_HEIGHT; line++) {
         for (int vs = 0; vs < vscale; vs++) {
             int bl = (((((row * F_HEIGHT) + line)) * vscale) + vs) * (LINE / 2);
@@ -88,50 +106,80 @@ void Push2::drawText(unsigned row, unsigned col,
                      unsigned vscale, unsigned hscale,
                      uint16_t colour,
                      bool invert) {
+    if (vscale == 0 || hscale == 0) return;
     unsigned CH_COLS = (WIDTH / F_WIDTH) / hscale;
     unsigned CH_ROWS = ((HEIGHT / F_HEIGHT) / vscale);
-    if (row > CH_ROWS) return;
+    if (row > CH_ROWS || col >= CH_COLS) return;
+
+    std::lock_guard<std::mutex> lock(drawMtx_);
+    markDirty(row * F_HEIGHT * vscale, (row + 1) * F_HEIGHT * vscale);
 
     unsigned len = col + ln < CH_COLS ? ln : CH_COLS - col;
-    for (int i = 0; i < len; i++) {
-        int c = col + i;
-        int ch = str[i];
-        for (int line = 0; line < F_HEIGHT; line++) {
-            int prow = ch / (GIMP_IMAGE_WIDTH / F_WIDTH);
-            int pchar = ch % (GIMP_IMAGE_WIDTH / F_WIDTH);
-            int pline = ((prow * F_HEIGHT) + line) * (GIMP_IMAGE_WIDTH * GIMP_IMAGE_BYTES_PER_PIXEL);
-
-            for (int vs = 0; vs < vscale; vs++) {
-                int bl = (((((row * F_HEIGHT) + line)) * vscale) + vs) * (LINE / 2);
-                for (int pix = 0; pix < F_WIDTH; pix++) {
-                    int poffset = (pline) + (((pchar * F_WIDTH) + pix) * GIMP_IMAGE_BYTES_PER_PIXEL);
-
-                    uint16_t clr = 0;
-                    unsigned red = GIMP_IMAGE_PIXEL_DATA[poffset];
-                    if (MONOCHROME) {
-                        if (red) {
-                            clr = colour;
-                        }
-
-                    } else {
-                        unsigned green = GIMP_IMAGE_PIXEL_DATA[poffset + 1];
-                        unsigned blue = GIMP_IMAGE_PIXEL_DATA[poffset + 2];
-                        clr = RGB565(red, blue, green);
-                    }
+    if (len == 0) return;
+
+    // each font line: a glyph row per char, then copied to the remaining (vscale) display lines
+    const GlyphSet &glyphSet = glyphs(hscale, colour, invert);
+    const unsigned gwidth = F_WIDTH * hscale;
+    const unsigned gsize = gwidth * F_HEIGHT;
+    for (unsigned line = 0; line < F_HEIGHT; line++) {
+        unsigned dline = ((row * F_HEIGHT) + line) * vscale;
+        if (dline >= HEIGHT) break;
+        uint16_t *dst = &dataPkt_[(dline * (LINE / 2)) + (col * gwidth)];
+        for (unsigned i = 0; i < len; i++) {
+            unsigned ch = static_cast<unsigned char>(str[i]) & 0x7F;
+            memcpy(dst + (i * gwidth), &glyphSet.pixels_[(ch * gsize) + (line * gwidth)], gwidth * sizeof(uint16_t));
+        }
+        for (unsigned vs = 1; vs < vscale && dline + vs < HEIGHT; vs++) {
+            memcpy(dst + (vs * (LINE / 2)), dst, len * gwidth * sizeof(uint16_t));
+        }
+    }
+}
 
+// call with drawMtx_ held
+const Push2::GlyphSet &Push2::glyphs(unsigned hscale, uint16_t colour, bool invert) {
+    for (const auto &g : glyphCache_) {
+        if (g->hscale_ == hscale && g->clr_ == colour && g->invert_ == invert) return *g;
+    }
 
-                    for (int hs = 0; hs < hscale; hs++) {
-                        int bpos = bl + ((((c * F_WIDTH) + pix) * hscale) + hs);
-                        // dataPkt_[bpos] = ( (clr & 0x00FF) << 8 ) | ( (clr & 0xFF00) >> 8);
-                        if (bpos < (DATA_PKT_SZ / 2)) {
-                            if(invert) clr = ~ clr;
-                            dataPkt_[bpos] = clr;
-                        }
+    if (glyphCache_.size() >= MAX_GLYPH_SETS) glyphCache_.erase(glyphCache_.begin());
+
+    std::unique_ptr<GlyphSet> glyphSet(new GlyphSet);
+    glyphSet->hscale_ = hscale;
+    glyphSet->clr_ = colour;
+    glyphSet->invert_ = invert;
+    const unsigned CHARS_PER_ROW = GIMP_IMAGE_WIDTH / F_WIDTH;
+    const unsigned NUM_CHARS = CHARS_PER_ROW * (GIMP_IMAGE_HEIGHT / F_HEIGHT);
+    glyphSet->pixels_.resize(NUM_CHARS * F_HEIGHT * F_WIDTH * hscale);
+
+    uint16_t *dst = glyphSet->pixels_.data();
+    for (unsigned ch = 0; ch < NUM_CHARS; ch++) {
+        unsigned prow = ch / CHARS_PER_ROW;
+        unsigned pchar = ch % CHARS_PER_ROW;
+        for (unsigned line = 0; line < F_HEIGHT; line++) {
+            unsigned pline = ((prow * F_HEIGHT) + line) * (GIMP_IMAGE_WIDTH * GIMP_IMAGE_BYTES_PER_PIXEL);
+            for (unsigned pix = 0; pix < F_WIDTH; pix++) {
+                unsigned poffset = (pline) + (((pchar * F_WIDTH) + pix) * GIMP_IMAGE_BYTES_PER_PIXEL);
+
+                uint16_t clr = 0;
+                unsigned red = GIMP_IMAGE_PIXEL_DATA[poffset];
+                if (MONOCHROME) {
+                    if (red) {
+                        clr = colour;
                     }
+                } else {
+                    unsigned green = GIMP_IMAGE_PIXEL_DATA[poffset + 1];
+                    unsigned blue = GIMP_IMAGE_PIXEL_DATA[poffset + 2];
+                    clr = RGB565(red, blue, green);
                 }
+                if (invert) clr = ~clr;
+
+                for (unsigned hs = 0; hs < hscale; hs++) *dst++ = clr;
             }
         }
     }
+
+    glyphCache_.push_back(std::move(glyphSet));
+    return *glyphCache_.back();
 }
 
 void Push2::p1_drawCell8(unsigned row, unsigned cell, const char *str) {
@@ -175,13 +223,139 @@ void Push2::drawCell8(unsigned row, unsigned cell, const char *str, unsigned vsc
 
 int Push2::render() {
     if (handle_ == NULL) return -1;
+
+    if (running_) {
+        // render thread will send a frame, even if not changed
+        std::lock_guard<std::mutex> lock(drawMtx_);
+        renderRequested_ = true;
+        renderCond_.notify_one();
+        return 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(drawMtx_);
+        memcpy(frontPkt_, dataPkt_, DATA_PKT_SZ);
+        dirtyFirst_ = HEIGHT;
+        dirtyLast_ = 0;
+    }
+
     int tfrsize = 0;
     int r = 0;
     CALL_CHECK(libusb_bulk_transfer(handle_, endpointOut_, headerPkt_, HDR_PKT_SZ, &tfrsize, 1000));
     if (tfrsize != HDR_PKT_SZ) { printf("header packet short %d", tfrsize); }
-    CALL_CHECK(libusb_bulk_transfer(handle_, endpointOut_, (unsigned char *) dataPkt_, DATA_PKT_SZ, &tfrsize, 1000));
+    CALL_CHECK(libusb_bulk_transfer(handle_, endpointOut_, (unsigned char *) frontPkt_, DATA_PKT_SZ, &tfrsize, 1000));
     if (tfrsize != DATA_PKT_SZ) { printf("data packet short %d", tfrsize); }
+    framesSent_++;
+
+    return 0;
+}
+
+bool Push2::start(unsigned maxFps, unsigned keepAliveMs) {
+    if (handle_ == NULL || running_) return false;
+
+    headerTransfer_ = libusb_alloc_transfer(0);
+    dataTransfer_ = libusb_alloc_transfer(0);
+    if (headerTransfer_ == NULL || dataTransfer_ == NULL) {
+        perr("  Failed to allocate transfers\n");
+        stop();
+        return false;
+    }
+
+    frameInterval_ = std::chrono::microseconds(maxFps > 0 ? 1000000 / maxFps : 0);
+    keepAlive_ = std::chrono::milliseconds(keepAliveMs);
+    {
+        std::lock_guard<std::mutex> lock(drawMtx_);
+        markDirty(0, HEIGHT); // initial frame
+    }
+    running_ = true;
+    renderThread_ = std::thread(&Push2::renderRun, this);
+    return true;
+}
+
+void Push2::stop() {
+    {
+        std::lock_guard<std::mutex> lock(drawMtx_);
+        running_ = false;
+    }
+    renderCond_.notify_one();
+    if (renderThread_.joinable()) renderThread_.join();
+
+    if (headerTransfer_ != NULL) libusb_free_transfer(headerTransfer_);
+    if (dataTransfer_ != NULL) libusb_free_transfer(dataTransfer_);
+    headerTransfer_ = NULL;
+    dataTransfer_ = NULL;
+}
+
+void Push2::renderRun() {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point lastFrame = Clock::now();
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(drawMtx_);
+            auto pending = [this] { return !running_ || renderRequested_ || dirtyFirst_ < dirtyLast_; };
+            if (keepAlive_.count() > 0) {
+                renderCond_.wait_until(lock, lastFrame + keepAlive_, pending);
+            } else {
+                renderCond_.wait(lock, pending);
+            }
+            if (!running_) break;
+        }
+
+        // cap frame rate, drawing until then is included in this frame
+        Clock::time_point next = lastFrame + frameInterval_;
+        if (Clock::now() < next) std::this_thread::sleep_until(next);
+
+        {
+            std::lock_guard<std::mutex> lock(drawMtx_);
+            if (dirtyFirst_ < dirtyLast_) {
+                unsigned offset = dirtyFirst_ * (LINE / 2);
+                memcpy(frontPkt_ + offset, dataPkt_ + offset, (dirtyLast_ - dirtyFirst_) * LINE);
+            }
+            dirtyFirst_ = HEIGHT;
+            dirtyLast_ = 0;
+            renderRequested_ = false;
+        }
+
+        lastFrame = Clock::now();
+        sendFrame();
+    }
+}
+
+void Push2::transferCallback(libusb_transfer *transfer) {
+    *static_cast<int *>(transfer->user_data) = 1;
+}
+
+// header then frame, queued on the endpoint together, this thread handles their completion
+int Push2::sendFrame() {
+    int headerDone = 0, dataDone = 0;
+    libusb_fill_bulk_transfer(headerTransfer_, handle_, endpointOut_, headerPkt_, HDR_PKT_SZ,
+                              transferCallback, &headerDone, 1000);
+    libusb_fill_bulk_transfer(dataTransfer_, handle_, endpointOut_, (unsigned char *) frontPkt_, DATA_PKT_SZ,
+                              transferCallback, &dataDone, 1000);
+
+    int r = libusb_submit_transfer(headerTransfer_);
+    if (r < 0) ERR_EXIT(r);
+    r = libusb_submit_transfer(dataTransfer_);
+    if (r < 0) {
+        perr("   %s\n", libusb_strerror((enum libusb_error) r));
+        dataDone = 1;
+    }
+
+    while (!headerDone || !dataDone) {
+        struct timeval tv = {1, 0};
+        int *completed = headerDone ? &dataDone : &headerDone;
+        r = libusb_handle_events_timeout_completed(ctx_, &tv, completed);
+        if (r < 0 && r != LIBUSB_ERROR_INTERRUPTED) {
+            // transfers reference this frame, so wait for them to be cancelled
+            perr("   %s\n", libusb_strerror((enum libusb_error) r));
+            if (!headerDone) libusb_cancel_transfer(headerTransfer_);
+            if (!dataDone) libusb_cancel_transfer(dataTransfer_);
+        }
+    }
 
+    if (headerTransfer_->actual_length != HDR_PKT_SZ) { printf("header packet short %d", headerTransfer_->actual_length); }
+    if (dataTransfer_->actual_length != DATA_PKT_SZ) { printf("data packet short %d", dataTransfer_->actual_length); }
+    framesSent_++;
     return 0;
 }
 
@@ -191,13 +365,14 @@ int Push2::init() {
     version = libusb_get_version();
     std::cout << "Using libusb " << version->major << "." << version->minor << "." << version->micro << "."
               << version->nano << std::endl;
-    int r = libusb_init(NULL);
-    libusb_set_debug(NULL, LIBUSB_LOG_LEVEL_INFO);
+    int r = libusb_init(&ctx_);
+    if (r < 0) ERR_EXIT(r);
+    libusb_set_debug(ctx_, LIBUSB_LOG_LEVEL_INFO);
     static uint16_t vid = VID, pid = PID;
 
     std::cout << "Open Push2 :" << std::hex << vid << ":" << pid << std::dec << std::endl;
 
-    handle_ = libusb_open_device_with_vid_pid(NULL, vid, pid);
+    handle_ = libusb_open_device_with_vid_pid(ctx_, vid, pid);
 
     if (handle_ == NULL) {
         perr("  Failed.\n");
@@ -210,11 +385,14 @@ int Push2::init() {
 }
 
 int Push2::deinit() {
+    stop();
     if (handle_ != NULL) {
         if (iface_ != 0) libusb_release_interface(handle_, iface_);
         libusb_close(handle_);
+        handle_ = NULL;
     }
-    libusb_exit(NULL);
+    if (ctx_ != NULL) libusb_exit(ctx_);
+    ctx_ = NULL;
     return 0;
 }
 
@@ -4,6 +4,14 @@
 #include <stdint.h>
 #include <libusb.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace Push2API {
 
 #define DATA_PKT_SZ (LINE * HEIGHT)
@@ -15,6 +23,14 @@ namespace Push2API {
 
 #define RGB565(r, g, b)   (uint16_t) ((((((uint16_t) b & 0x0078)>> 3)   << 5) | (((uint16_t) g & 0x00FC) >> 2 ) << 6 ) | (((uint16_t) r & 0x00f8) >> 3))   //use top bits of colour input
 
+// display rendering
+//
+// drawing goes to a back buffer, marking the lines it touches dirty.
+// once start() is called, a render thread copies dirty lines to the front buffer, and sends the frame
+// using asynchronous bulk transfers, at most maxFps. drawing is never blocked by usb.
+// when nothing changes only a keep alive frame is sent (the display blanks without a frame for 2 seconds),
+// keepAliveMs = 0 sends nothing when idle.
+// without start(), render() sends the frame synchronously.
 class Push2 {
 public:
     Push2();
@@ -23,6 +39,13 @@ public:
     int render();
     int deinit();
 
+    static const unsigned DEFAULT_MAX_FPS = 30;
+    static const unsigned DEFAULT_KEEP_ALIVE_MS = 1000;
+    bool start(unsigned maxFps = DEFAULT_MAX_FPS, unsigned keepAliveMs = DEFAULT_KEEP_ALIVE_MS);
+    void stop();
+
+    unsigned long getFramesSent() const { return framesSent_; }
+
 
     void clearDisplay();
     void clearRow(unsigned row, unsigned vscale);
@@ -43,9 +66,44 @@ public:
 
 
 private:
-    uint8_t *headerPkt_;
-    uint16_t dataPkt_[DATA_PKT_SZ / 2];
+    // font expanded for a (hscale, colour, invert), rows of RGB565 ready to copy to the display
+    // laid out [char][font line][F_WIDTH * hscale]
+    struct GlyphSet {
+        unsigned hscale_;
+        uint16_t clr_;
+        bool invert_;
+        std::vector<uint16_t> pixels_;
+    };
+    static const unsigned MAX_GLYPH_SETS = 32;
+    const GlyphSet &glyphs(unsigned hscale, uint16_t clr, bool invert);
+
+    void markDirty(unsigned first, unsigned last);
+    void renderRun();
+    int sendFrame();
+    static void transferCallback(libusb_transfer *transfer);
 
+    uint8_t *headerPkt_;
+    uint16_t dataPkt_[DATA_PKT_SZ / 2];   // drawn to
+    uint16_t frontPkt_[DATA_PKT_SZ / 2];  // sent from
+
+    // guards dataPkt_ and the dirty lines
+    std::mutex drawMtx_;
+    std::condition_variable renderCond_;
+    unsigned dirtyFirst_;
+    unsigned dirtyLast_;    // exclusive, none dirty if first >= last
+    bool renderRequested_;
+
+    std::thread renderThread_;
+    std::atomic<bool> running_;
+    std::chrono::microseconds frameInterval_;
+    std::chrono::milliseconds keepAlive_;
+    std::atomic<unsigned long> framesSent_;
+    libusb_transfer *headerTransfer_;
+    libusb_transfer *dataTransfer_;
+
+    std::vector<std::unique_ptr<GlyphSet>> glyphCache_; // guarded by drawMtx_
+
+    libusb_context *ctx_;
     libusb_device_handle *handle_;
     int iface_ = 0;
     int endpointOut_ = 1;
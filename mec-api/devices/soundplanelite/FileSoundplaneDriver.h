@@ -0,0 +1,76 @@
+// Driver for Soundplane Model A that plays back a captured frame file.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef __FILE_SOUNDPLANE_DRIVER__
+#define __FILE_SOUNDPLANE_DRIVER__
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "SoundplaneDriver.h"
+#include "SoundplaneFrameFile.h"
+
+/**
+ * Plays the frames of a SoundplaneFrameWriter capture to the listener, as if
+ * they came from a device, so that SoundplaneModel, TouchTracker and the zones
+ * can be run without a Soundplane attached.
+ *
+ * The device goes through kDeviceConnected and kDeviceHasIsochSync as a real
+ * one does, then frames are played from the mapped file without copying,
+ * either at the Soundplane's 1 kHz frame rate or as fast as the listener takes
+ * them. When the file ends (and it is not looping) the state returns to
+ * kNoDevice.
+ */
+class FileSoundplaneDriver : public SoundplaneDriver
+{
+public:
+	FileSoundplaneDriver(SoundplaneDriverListener* listener, const std::string& path, bool realtime, bool loop);
+	~FileSoundplaneDriver() noexcept(true);
+
+	/**
+	 * Returns false if the file can't be read, in which case nothing is played.
+	 */
+	bool init();
+
+	virtual MLSoundplaneState getDeviceState() const override;
+	virtual uint16_t getFirmwareVersion() const override;
+	virtual std::string getSerialNumberString() const override;
+
+	virtual const unsigned char *getCarriers() const override;
+	virtual void setCarriers(const Carriers& carriers) override;
+	virtual void enableCarriers(unsigned long mask) override;
+
+	int getFramesInFile() const { return mReader.getFrames(); }
+
+	/**
+	 * Frames delivered to the listener so far, over all loops.
+	 */
+	long getFramesPlayed() const { return mFramesPlayed.load(std::memory_order_acquire); }
+
+	/**
+	 * Create a driver playing path. Falls back to an InertSoundplaneDriver if
+	 * the file can't be read.
+	 */
+	static std::unique_ptr<SoundplaneDriver> create(SoundplaneDriverListener *listener, const std::string& path, bool realtime, bool loop);
+
+private:
+	void setDeviceState(MLSoundplaneState newState);
+	void processThread();
+
+	SoundplaneDriverListener * const mListener;
+	const std::string mPath;
+	const bool mRealtime;
+	const bool mLoop;
+
+	SoundplaneFrameReader mReader;
+	std::thread mProcessThread;
+	std::atomic<MLSoundplaneState> mState;
+	std::atomic<bool> mQuitting;
+	std::atomic<long> mFramesPlayed;
+
+	Carriers mCurrentCarriers;
+};
+
+#endif // __FILE_SOUNDPLANE_DRIVER__
@@ -201,5 +201,61 @@ public:
 	float mScale;
 };
 
+// 1/z calibration, BoxFilter2D and two Biquad2D filters applied in one pass.
+// each cell goes through the whole chain while in registers, instead of one sweep
+// over the surface per stage. state is kept interleaved in one array, in blocks of
+// kLanes neighbouring cells, processed with the MLSignalKernels vectors where available.
+// gives the same results as running the stages in turn.
+class SurfaceConditioner
+{
+public:
+	static const int kLanes = 8;
+
+	SurfaceConditioner(int w = 0, int h = 0);
+	~SurfaceConditioner();
+
+	void setDims(int w, int h);
+	void setInputSignal(const MLSignal* pIn)
+	{ mpIn = pIn; }
+	void setOutputSignal(MLSignal* pOut)
+	{ mpOut = pOut; }
+	void clear();
+
+	// take box length and biquad coefficients from the separate filters
+	void setFilters(const BoxFilter2D& box, const Biquad2D& biquad1, const Biquad2D& biquad2);
+
+	// scale input to 1/z curve against the calibration mean
+	void setCalibration(const MLSignal& mean);
+
+	void process(int frames);
+
+private:
+	// state planes of each block, each kLanes wide, followed by the box filter delay line
+	enum
+	{
+		kCalibrate = 0,
+		kX1a, kX2a, kY1a, kY2a,
+		kX1b, kX2b, kY1b, kY2b,
+		kBlockStateSize
+	};
+
+	void allocate();
+	float* blockState(int j, int block) { return &mState[(j*mBlocksPerRow + block)*mBlockStride]; }
+	inline void processBlock(const float* pIn, float* pOut, float* pBlock, int n);
+
+	int mWidth, mHeight;
+	int mBlocksPerRow;
+	bool mHasCalibration;
+	int mN;
+	int mDelayIdx;
+	float mScale;
+	MLBiquad mCoeffsA;
+	MLBiquad mCoeffsB;
+	int mBlockStride;
+	std::vector<float> mState;
+	const MLSignal* mpIn;
+	MLSignal* mpOut;
+};
+
 
 #endif // __FILTERS2D__
@@ -0,0 +1,76 @@
+
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef __ML_SIGNAL_KERNELS__
+#define __ML_SIGNAL_KERNELS__
+
+// inner loops of the MLSignal per sample and 2D operations, on raw buffers.
+// MLKernelsScalar is always built, it is the fallback and the reference for tests.
+// MLKernelsSIMD is SSE2 (AVX if the compiler targets it) with ML_USE_SSE, NEON with ML_USE_NEON.
+// MLKernels is the fastest implementation for the platform. with ML_USE_AVX, an SSE2 build also
+// has MLKernelsAVX, built with AVX enabled, and MLKernels picks scalar, SSE2 or AVX for each kernel,
+// checking the CPU for AVX when first loaded.
+
+// 2D kernels take a row stride, in samples. out and in must not overlap.
+#define ML_SIGNAL_KERNELS \
+	void add(float* a, const float* b, int n); \
+	void subtract(float* a, const float* b, int n); \
+	void multiply(float* a, const float* b, int n); \
+	void sigMin(float* a, const float* b, int n); \
+	void sigMax(float* a, const float* b, int n); \
+	void add(float* a, float k, int n); \
+	void scale(float* a, float k, int n); \
+	void sigMin(float* a, float k, int n); \
+	void sigMax(float* a, float k, int n); \
+	/* a[i] += bilinear interpolation of rows r0, r1 between i and i+1 */ \
+	void addLerp2D(float* a, const float* r0, const float* r1, float mx, float my, int n); \
+	/* 3x3 convolution, zero outside the signal */ \
+	void convolve3x3r(float* out, const float* in, int width, int height, int stride, float kc, float ke, float kk); \
+	/* 3x3 convolution, border samples duplicated */ \
+	void convolve3x3rb(float* out, const float* in, int width, int height, int stride, float kc, float ke, float kk);
+
+namespace MLKernelsScalar
+{
+	ML_SIGNAL_KERNELS
+}
+
+#if defined(ML_USE_SSE) || defined(ML_USE_NEON)
+	#define ML_SIGNAL_KERNELS_SIMD 1
+
+	namespace MLKernelsSIMD
+	{
+		ML_SIGNAL_KERNELS
+	}
+#endif
+
+#if defined(ML_USE_SSE) && defined(ML_USE_AVX)
+	namespace MLKernelsAVX
+	{
+		ML_SIGNAL_KERNELS
+	}
+
+	#if !defined(__AVX__)
+		// SSE2 build with the AVX kernels built alongside, MLKernels picks between them at run time.
+		#define ML_SIGNAL_KERNELS_DISPATCH 1
+
+		namespace MLKernelsDispatch
+		{
+			ML_SIGNAL_KERNELS
+		}
+
+		// true if MLKernels is using the AVX convolutions
+		bool MLKernelsHaveAVX();
+	#endif
+#endif
+
+#if ML_SIGNAL_KERNELS_DISPATCH
+	namespace MLKernels = MLKernelsDispatch;
+#elif ML_SIGNAL_KERNELS_SIMD
+	namespace MLKernels = MLKernelsSIMD;
+#else
+	namespace MLKernels = MLKernelsScalar;
+#endif
+
+#endif // __ML_SIGNAL_KERNELS__
@@ -104,6 +104,14 @@ public:
 	 */
 	virtual void enableCarriers(unsigned long mask) = 0;
 
+	/**
+	 * Write every frame received from now on to a frame file at path (see
+	 * SoundplaneFrameFile.h), or stop writing if path is empty. The file is
+	 * written on the driver's processing thread, without copying to an
+	 * intermediate buffer. Returns false if the driver can't capture.
+	 */
+	virtual bool setCaptureFile(const std::string& path) { return false; }
+
 	/**
 	 * Helper function for getting the serial number as a number rather than
 	 * as a string.
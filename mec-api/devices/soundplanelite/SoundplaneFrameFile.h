@@ -0,0 +1,105 @@
+// Raw Soundplane frame capture files.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef __SOUNDPLANE_FRAME_FILE__
+#define __SOUNDPLANE_FRAME_FILE__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "SoundplaneModelA.h"
+
+/**
+ * A frame file holds the frames a SoundplaneDriver passes to
+ * SoundplaneDriverListener::receivedFrame, as they arrived:
+ *
+ *   header   magic "SPFRAME1", uint32 width, uint32 height
+ *   frames   width * height floats each, host byte order
+ *
+ * Both reader and writer memory map the file, so frames are read in place and
+ * written straight into the page cache, with no buffering or syscall per frame.
+ */
+struct SoundplaneFrameFileHeader
+{
+	char magic[8];
+	uint32_t width;
+	uint32_t height;
+};
+
+class SoundplaneFrameReader
+{
+public:
+	SoundplaneFrameReader() {}
+	~SoundplaneFrameReader();
+
+	SoundplaneFrameReader(const SoundplaneFrameReader &) = delete;
+	SoundplaneFrameReader& operator=(const SoundplaneFrameReader &) = delete;
+
+	/**
+	 * Returns false if the file can't be mapped, or is not a frame file of
+	 * kSoundplaneWidth * kSoundplaneHeight frames.
+	 */
+	bool open(const std::string& path);
+	void close();
+
+	int getFrames() const { return mFrames; }
+	int getFrameSize() const { return kSoundplaneOutputFrameLength; }
+
+	/**
+	 * Pointer into the mapping, valid until close.
+	 */
+	const float* getFrame(int i) const { return mpFirstFrame + (size_t)i * kSoundplaneOutputFrameLength; }
+
+private:
+	void* mpMapping = nullptr;
+	size_t mMappingSize = 0;
+	const float* mpFirstFrame = nullptr;
+	int mFrames = 0;
+};
+
+class SoundplaneFrameWriter
+{
+public:
+	/**
+	 * The file is grown and mapped this many frames at a time.
+	 */
+	static constexpr int kChunkFrames = 1024;
+
+	SoundplaneFrameWriter() {}
+	~SoundplaneFrameWriter();
+
+	SoundplaneFrameWriter(const SoundplaneFrameWriter &) = delete;
+	SoundplaneFrameWriter& operator=(const SoundplaneFrameWriter &) = delete;
+
+	bool open(const std::string& path);
+
+	/**
+	 * Truncates the file to the frames written and unmaps it.
+	 */
+	void close();
+
+	bool isOpen() const { return mFd >= 0; }
+
+	/**
+	 * Returns false if size is not a whole frame, or the file can't be grown.
+	 * Only every kChunkFrames frames does this do more than a copy.
+	 */
+	bool write(const float* data, int size);
+
+	int getFrames() const { return mFrames; }
+
+private:
+	bool mapChunk();
+	void unmapChunk();
+
+	int mFd = -1;
+	void* mpMapping = nullptr;
+	size_t mMappingSize = 0;
+	float* mpChunk = nullptr;
+	int mChunkFramesLeft = 0;
+	int mFrames = 0;
+};
+
+#endif // __SOUNDPLANE_FRAME_FILE__
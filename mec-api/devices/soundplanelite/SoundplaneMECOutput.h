@@ -18,6 +18,9 @@ public:
     virtual void device(const char* dev, int rows, int cols) = 0;
     virtual void touch(const char* dev, unsigned long long t, bool a, int touch, float note, float x, float y, float z) = 0;
     virtual void control(const char* dev, unsigned long long t, int id, float val) = 0;
+    // optional, frames that touches are sent in
+    virtual void startFrame(const char* dev, unsigned long long t) {};
+    virtual void endFrame(const char* dev, unsigned long long t) {};
 };
 
 class SoundplaneMECOutput_Impl;
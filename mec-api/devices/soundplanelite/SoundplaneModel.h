@@ -195,6 +195,11 @@ private:
 	Biquad2D mLopassFilter;
 	BoxFilter2D mBoxFilter;
 
+	// calibration and the filters above in one pass, see fused_conditioning property
+	SurfaceConditioner mConditioner;
+	bool mFusedConditioning;
+	bool mConditioningWasFused;
+
     // store current key for each touch to implement hysteresis.
 	int mCurrentKeyX[kSoundplaneMaxTouches];
 	int mCurrentKeyY[kSoundplaneMaxTouches];
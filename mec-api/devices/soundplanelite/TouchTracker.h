@@ -114,6 +114,9 @@ public:
 		~Calibrator();
 
 		const MLSignal& getTemplate(Vec2 pos) const;		
+		void getScaledTemplate(Vec2 pos, float scale, MLSignal& out) const;
+		// changes whenever the templates do
+		int getTemplateVersion() const { return mTemplateVersion; }
 		void setThreshold(float t) { mOnThreshold = t; }
 		
 		// process and add an input sample to the current calibration. 
@@ -131,7 +134,7 @@ public:
 		void setDefaultNormalizeMap();
 		void setNormalizeMap(const MLSignal& m);
 		
-		float getZAdjust(const Vec2 p);
+		float getZAdjust(const Vec2 p) const;
 		float differenceFromTemplateTouch(const MLSignal& in, Vec2 inPos);
 		float differenceFromTemplateTouchWithMask(const MLSignal& in, Vec2 inPos, const MLSignal& mask);
 		void normalizeInput(MLSignal& in);
@@ -146,6 +149,8 @@ public:
 		
 	private:	
 		void makeDefaultTemplate();
+		void makeBinTemplates();
+		void getNeighborTemplates(Vec2 p, const MLSignal* d[4], Vec2& fPos) const;
 		float makeNormalizeMap();
 		
 		void getAverageTemplateDistance();
@@ -165,6 +170,7 @@ public:
 		std::vector<int> mPassesCount;
 		MLSignal mIncomingSample;
 		MLSignal mDefaultTemplate;
+		std::vector<MLSignal> mBinTemplates;
 		MLSignal mNormalizeCount;
 		MLSignal mFilteredInput;
 		MLSignal mTemp;
@@ -174,10 +180,53 @@ public:
 		int mWaitSamplesAfterNormalize;
 		float mStartupSum;
 		float mAutoThresh;
+		int mTemplateVersion;
 		Vec2 mPeak;
 		int age;
 	};
 	
+	// Renders the sum of touches: the scaled templates of the active touches, smoothed.
+	// Each touch's template is kept as a patch until the touch moves or changes z,
+	// and the sum is only rebuilt and smoothed when a patch has changed.
+	//
+	class TouchSumRenderer
+	{
+	public:
+		TouchSumRenderer(int w, int h);
+		~TouchSumRenderer();
+		
+		void clear();
+		
+		// get the sum of the active touches, scaled by scale.
+		const MLSignal& process(const std::vector<Touch>& touches, int maxTouches, const Calibrator& calibrator, float scale);
+		
+		// number of patches redrawn by the last process()
+		int getRenderedTouches() const { return mRenderedTouches; }
+		
+	private:
+		struct Patch
+		{
+			MLSignal signal;
+			float x, y, z;
+			int destX, destY;
+			bool valid;
+		};
+		
+		// template with a border of zeros: one before, two after for interpolation.
+		static const int kPaddedSize = kTemplateSize + 3;
+		
+		void renderPatch(Vec2 f, MLSignal& patch);
+		
+		std::vector<Patch> mPatches;
+		MLSignal mScaled;
+		float mPadded[kPaddedSize*kPaddedSize];
+		MLSignal mSum;
+		bool mSumValid;
+		int mTemplateVersion;
+		float mScale;
+		int mRenderedTouches;
+	};
+	
 	// We keep a vector of KeyStates, one for each key over the surface. 
 	// This allows sensor data to be collected and filtered before it triggers a touch.
 	//
@@ -234,6 +283,7 @@ public:
 	void setLopass(float k); 	
 	void setForceCurve(float f) { mForceCurve = f; }
 	void setZScale(float f) { mZScale = f; }
+	void setIncrementalTouchSum(bool b) { mIncrementalTouchSum = b; }
 	
 	// process input and get touches. creates one frame of touch data in buffer.
 	void process(int);
@@ -357,6 +407,8 @@ private:
 	bool mNeedsClear;
 
 	Calibrator mCalibrator;
+	TouchSumRenderer mTouchSumRenderer;
+	bool mIncrementalTouchSum;
 
 };
 
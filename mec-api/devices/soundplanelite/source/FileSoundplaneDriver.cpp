@@ -0,0 +1,121 @@
+// FileSoundplaneDriver.cpp
+//
+// Plays back captured Soundplane frames as if from a device.
+
+#include "FileSoundplaneDriver.h"
+
+#include <cassert>
+#include <chrono>
+
+#include "InertSoundplaneDriver.h"
+
+std::unique_ptr<SoundplaneDriver> FileSoundplaneDriver::create(SoundplaneDriverListener *listener, const std::string& path, bool realtime, bool loop)
+{
+	std::unique_ptr<FileSoundplaneDriver> driver(new FileSoundplaneDriver(listener, path, realtime, loop));
+	if (!driver->init())
+	{
+		fprintf(stderr, "FileSoundplaneDriver: can't read frames from %s\n", path.c_str());
+		return std::unique_ptr<SoundplaneDriver>(new InertSoundplaneDriver());
+	}
+	return std::move(driver);
+}
+
+FileSoundplaneDriver::FileSoundplaneDriver(SoundplaneDriverListener* listener, const std::string& path, bool realtime, bool loop) :
+	mListener(listener),
+	mPath(path),
+	mRealtime(realtime),
+	mLoop(loop),
+	mState(kNoDevice),
+	mQuitting(false),
+	mFramesPlayed(0)
+{
+	assert(listener);
+	mCurrentCarriers.fill(0);
+}
+
+FileSoundplaneDriver::~FileSoundplaneDriver() noexcept(true)
+{
+	mQuitting.store(true, std::memory_order_release);
+	if (mProcessThread.joinable())
+	{
+		mProcessThread.join();
+	}
+	mListener->deviceStateChanged(*this, kDeviceIsTerminating);
+}
+
+bool FileSoundplaneDriver::init()
+{
+	if (!mReader.open(mPath)) return false;
+	mProcessThread = std::thread(&FileSoundplaneDriver::processThread, this);
+	return true;
+}
+
+MLSoundplaneState FileSoundplaneDriver::getDeviceState() const
+{
+	return mQuitting.load(std::memory_order_acquire) ?
+		kDeviceIsTerminating :
+		mState.load(std::memory_order_acquire);
+}
+
+uint16_t FileSoundplaneDriver::getFirmwareVersion() const
+{
+	return 0;
+}
+
+std::string FileSoundplaneDriver::getSerialNumberString() const
+{
+	return "0";
+}
+
+const unsigned char *FileSoundplaneDriver::getCarriers() const
+{
+	return mCurrentCarriers.data();
+}
+
+void FileSoundplaneDriver::setCarriers(const Carriers& carriers)
+{
+	// the carriers are whatever they were when the file was captured
+	mCurrentCarriers = carriers;
+}
+
+void FileSoundplaneDriver::enableCarriers(unsigned long mask)
+{
+}
+
+void FileSoundplaneDriver::setDeviceState(MLSoundplaneState newState)
+{
+	mState.store(newState, std::memory_order_release);
+	mListener->deviceStateChanged(*this, newState);
+}
+
+void FileSoundplaneDriver::processThread()
+{
+	typedef std::chrono::steady_clock Clock;
+	const Clock::duration framePeriod = std::chrono::microseconds((long)(1000000.f / kSoundplaneSampleRate));
+
+	setDeviceState(kDeviceConnected);
+	setDeviceState(kDeviceHasIsochSync);
+
+	const int frames = mReader.getFrames();
+	Clock::time_point nextFrameTime = Clock::now();
+	do
+	{
+		for (int i = 0; i < frames && !mQuitting.load(std::memory_order_acquire); ++i)
+		{
+			if (mRealtime)
+			{
+				// pace from the start, so listener time doesn't accumulate as drift
+				nextFrameTime += framePeriod;
+				std::this_thread::sleep_until(nextFrameTime);
+			}
+			mListener->receivedFrame(*this, mReader.getFrame(i), mReader.getFrameSize());
+			mFramesPlayed.fetch_add(1, std::memory_order_release);
+		}
+	}
+	while (mLoop && frames > 0 && !mQuitting.load(std::memory_order_acquire));
+
+	if (!mQuitting.load(std::memory_order_acquire))
+	{
+		setDeviceState(kNoDevice);
+	}
+}
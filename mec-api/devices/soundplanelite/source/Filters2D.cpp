@@ -4,6 +4,13 @@
 // Distributed under the MIT license: http://madrona-labs.mit-license.org/
 
 #include "Filters2D.h"
+#include "MLSignalKernels.h"
+
+#if defined(ML_USE_SSE)
+	#include "source/sse/MLSignalKernels.h"
+#elif defined(ML_USE_NEON)
+	#include "source/neon/MLSignalKernels.h"
+#endif
 
 #pragma mark Biquad2D
 
@@ -380,3 +387,267 @@ void BoxFilter2D::process(int)
 	
 	mpOut->copy(mAccum);
 }
+
+#pragma mark SurfaceConditioner
+
+const int SurfaceConditioner::kLanes;
+
+SurfaceConditioner::SurfaceConditioner(int w, int h) :
+	mWidth(w),
+	mHeight(h),
+	mBlocksPerRow(0),
+	mHasCalibration(false),
+	mN(1),
+	mDelayIdx(0),
+	mScale(1.f),
+	mBlockStride(0),
+	mpIn(0),
+	mpOut(0)
+{
+	allocate();
+}
+
+SurfaceConditioner::~SurfaceConditioner()
+{
+}
+
+void SurfaceConditioner::setDims(int w, int h)
+{
+	mWidth = w;
+	mHeight = h;
+	mHasCalibration = false;
+	mBlockStride = 0;
+	allocate();
+}
+
+void SurfaceConditioner::allocate()
+{
+	// keep calibration over a resize of the delay line
+	int blocks = mHeight*((mWidth + kLanes - 1) / kLanes);
+	std::vector<float> calibration(blocks*kLanes, 0.f);
+	if(mBlockStride > 0)
+	{
+		for(int b=0; b<blocks; ++b)
+		{
+			std::copy(&mState[b*mBlockStride], &mState[b*mBlockStride] + kLanes, &calibration[b*kLanes]);
+		}
+	}
+	
+	mBlocksPerRow = (mWidth + kLanes - 1) / kLanes;
+	mBlockStride = (kBlockStateSize + mN)*kLanes;
+	mState.assign(blocks*mBlockStride, 0.f);
+	for(int b=0; b<blocks; ++b)
+	{
+		std::copy(&calibration[b*kLanes], &calibration[b*kLanes] + kLanes, &mState[b*mBlockStride]);
+	}
+	mDelayIdx = 0;
+}
+
+void SurfaceConditioner::clear()
+{
+	int blocks = mHeight*mBlocksPerRow;
+	for(int b=0; b<blocks; ++b)
+	{
+		float* pBlock = &mState[b*mBlockStride];
+		std::fill(pBlock + kLanes, pBlock + mBlockStride, 0.f);
+	}
+	mDelayIdx = 0;
+}
+
+void SurfaceConditioner::setFilters(const BoxFilter2D& box, const Biquad2D& biquad1, const Biquad2D& biquad2)
+{
+	mScale = box.mScale;
+	mCoeffsA = biquad1.mCoeffs;
+	mCoeffsB = biquad2.mCoeffs;
+	if(box.mN != mN)
+	{
+		mN = box.mN;
+		allocate();
+	}
+}
+
+void SurfaceConditioner::setCalibration(const MLSignal& mean)
+{
+	const float epsilon = 0.000001;
+	for(int j=0; j<mHeight; ++j)
+	{
+		for(int i=0; i<mWidth; ++i)
+		{
+			blockState(j, i / kLanes)[kCalibrate*kLanes + i % kLanes] = mean(i, j) + epsilon;
+		}
+	}
+	mHasCalibration = true;
+}
+
+// run n <= kLanes neighbouring cells through the chain.
+// operations are in the same order as the separate filters, to give the same results.
+#if ML_SIGNAL_KERNELS_SIMD
+
+inline void SurfaceConditioner::processBlock(const float* pIn, float* pOut, float* pBlock, int n)
+{
+	// pad a partial block, the spare lanes are computed and thrown away
+	float in[kLanes] = {0.f};
+	float out[kLanes];
+	const float* pBlockIn = pIn;
+	float* pBlockOut = pOut;
+	if(n < kLanes)
+	{
+		std::copy(pIn, pIn + n, in);
+		pBlockIn = in;
+		pBlockOut = out;
+	}
+	
+	const MLKernelVec one = vecSet(1.f);
+	const MLKernelVec epsilon = vecSet(0.000001f);
+	const MLKernelVec scale = vecSet(mScale);
+	const MLKernelVec a0a = vecSet(mCoeffsA.a0), a1a = vecSet(mCoeffsA.a1), a2a = vecSet(mCoeffsA.a2);
+	const MLKernelVec b1a = vecSet(mCoeffsA.b1), b2a = vecSet(mCoeffsA.b2);
+	const MLKernelVec a0b = vecSet(mCoeffsB.a0), a1b = vecSet(mCoeffsB.a1), a2b = vecSet(mCoeffsB.a2);
+	const MLKernelVec b1b = vecSet(mCoeffsB.b1), b2b = vecSet(mCoeffsB.b2);
+	const float* pDelay = pBlock + kBlockStateSize*kLanes;
+	
+	for(int l=0; l<kLanes; l += kMLKernelVecSize)
+	{
+		float* pCell = pBlock + l;
+		
+		// scale to 1/z curve, into the box filter delay line
+		MLKernelVec x = vecLoad(pBlockIn + l);
+		if(mHasCalibration)
+		{
+			x = vecSub(one, vecDiv(vecLoad(pCell + kCalibrate*kLanes), vecAdd(x, epsilon)));
+		}
+		vecStore(pCell + (kBlockStateSize + mDelayIdx)*kLanes, x);
+		
+		// box filter
+		MLKernelVec sum = vecSet(0.f);
+		for(int k=0; k<mN; ++k)
+		{
+			sum = vecAdd(sum, vecLoad(pDelay + k*kLanes + l));
+		}
+		x = vecMul(sum, scale);
+		
+		// biquads
+		MLKernelVec x1 = vecLoad(pCell + kX1a*kLanes);
+		MLKernelVec y1 = vecLoad(pCell + kY1a*kLanes);
+		MLKernelVec y = vecMul(x, a0a);
+		y = vecAdd(y, vecMul(x1, a1a));
+		y = vecAdd(y, vecMul(vecLoad(pCell + kX2a*kLanes), a2a));
+		y = vecSub(y, vecMul(y1, b1a));
+		y = vecSub(y, vecMul(vecLoad(pCell + kY2a*kLanes), b2a));
+		vecStore(pCell + kX2a*kLanes, x1);
+		vecStore(pCell + kX1a*kLanes, x);
+		vecStore(pCell + kY2a*kLanes, y1);
+		vecStore(pCell + kY1a*kLanes, y);
+		
+		x = y;
+		x1 = vecLoad(pCell + kX1b*kLanes);
+		y1 = vecLoad(pCell + kY1b*kLanes);
+		y = vecMul(x, a0b);
+		y = vecAdd(y, vecMul(x1, a1b));
+		y = vecAdd(y, vecMul(vecLoad(pCell + kX2b*kLanes), a2b));
+		y = vecSub(y, vecMul(y1, b1b));
+		y = vecSub(y, vecMul(vecLoad(pCell + kY2b*kLanes), b2b));
+		vecStore(pCell + kX2b*kLanes, x1);
+		vecStore(pCell + kX1b*kLanes, x);
+		vecStore(pCell + kY2b*kLanes, y1);
+		vecStore(pCell + kY1b*kLanes, y);
+		
+		vecStore(pBlockOut + l, y);
+	}
+	
+	if(n < kLanes)
+	{
+		std::copy(out, out + n, pOut);
+	}
+}
+
+#else
+
+inline void SurfaceConditioner::processBlock(const float* pIn, float* pOut, float* pBlock, int n)
+{
+	const float epsilon = 0.000001;
+	
+	// locals, so that stores to the state can't alias them
+	const bool calibrate = mHasCalibration;
+	const int boxN = mN;
+	const int delayIdx = mDelayIdx;
+	const float scale = mScale;
+	const float a0a = mCoeffsA.a0, a1a = mCoeffsA.a1, a2a = mCoeffsA.a2, b1a = mCoeffsA.b1, b2a = mCoeffsA.b2;
+	const float a0b = mCoeffsB.a0, a1b = mCoeffsB.a1, a2b = mCoeffsB.a2, b1b = mCoeffsB.b1, b2b = mCoeffsB.b2;
+	
+	for(int l=0; l<n; ++l)
+	{
+		float* pCell = pBlock + l;
+		
+		// scale to 1/z curve, into the box filter delay line
+		float in = pIn[l];
+		if(calibrate)
+		{
+			in = (1.f - (pCell[kCalibrate*kLanes] / (in + epsilon)));
+		}
+		float* pDelay = pCell + kBlockStateSize*kLanes;
+		pDelay[delayIdx*kLanes] = in;
+		
+		// box filter
+		float sum = 0.f;
+		for(int k=0; k<boxN; ++k)
+		{
+			sum += pDelay[k*kLanes];
+		}
+		in = sum*scale;
+		
+		// biquads
+		float y = in*a0a;
+		y += pCell[kX1a*kLanes]*a1a;
+		y += pCell[kX2a*kLanes]*a2a;
+		y -= pCell[kY1a*kLanes]*b1a;
+		y -= pCell[kY2a*kLanes]*b2a;
+		pCell[kX2a*kLanes] = pCell[kX1a*kLanes];
+		pCell[kX1a*kLanes] = in;
+		pCell[kY2a*kLanes] = pCell[kY1a*kLanes];
+		pCell[kY1a*kLanes] = y;
+		
+		in = y;
+		y = in*a0b;
+		y += pCell[kX1b*kLanes]*a1b;
+		y += pCell[kX2b*kLanes]*a2b;
+		y -= pCell[kY1b*kLanes]*b1b;
+		y -= pCell[kY2b*kLanes]*b2b;
+		pCell[kX2b*kLanes] = pCell[kX1b*kLanes];
+		pCell[kX1b*kLanes] = in;
+		pCell[kY2b*kLanes] = pCell[kY1b*kLanes];
+		pCell[kY1b*kLanes] = y;
+		
+		pOut[l] = y;
+	}
+}
+
+#endif
+
+void SurfaceConditioner::process(int)
+{
+	mDelayIdx++;
+	if(mDelayIdx >= mN)
+	{
+		mDelayIdx = 0;
+	}
+	
+	for(int j=0; j<mHeight; ++j)
+	{
+		const MLSample* pInRow = mpIn->getConstBuffer() + (j << mpIn->getWidthBits());
+		MLSample* pOutRow = mpOut->getBuffer() + (j << mpOut->getWidthBits());
+		int i = 0;
+		for(int b=0; b<mBlocksPerRow; ++b, i += kLanes)
+		{
+			float* pBlock = blockState(j, b);
+			if(i + kLanes <= mWidth)
+			{
+				processBlock(pInRow + i, pOutRow + i, pBlock, kLanes);
+			}
+			else
+			{
+				processBlock(pInRow + i, pOutRow + i, pBlock, mWidth - i);
+			}
+		}
+	}
+}
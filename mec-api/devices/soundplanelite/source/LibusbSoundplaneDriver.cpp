@@ -100,7 +100,8 @@ LibusbSoundplaneDriver::LibusbSoundplaneDriver(SoundplaneDriverListener* listene
 	mQuitting(false),
 	mListener(listener),
 	mSetCarriersRequest(nullptr),
-	mEnableCarriersRequest(nullptr)
+	mEnableCarriersRequest(nullptr),
+	mCaptureRequest(nullptr)
 {
 	assert(listener);
 }
@@ -114,6 +115,7 @@ LibusbSoundplaneDriver::~LibusbSoundplaneDriver() noexcept(true)
 
 	delete mEnableCarriersRequest.load(std::memory_order_acquire);
 	delete mSetCarriersRequest.load(std::memory_order_acquire);
+	delete mCaptureRequest.load(std::memory_order_acquire);
 
 	libusb_exit(mLibusbContext);
 }
@@ -168,6 +170,13 @@ void LibusbSoundplaneDriver::enableCarriers(unsigned long mask)
 		new unsigned long(mask), std::memory_order_release);
 }
 
+bool LibusbSoundplaneDriver::setCaptureFile(const std::string& path)
+{
+	delete mCaptureRequest.exchange(
+		new std::string(path), std::memory_order_release);
+	return true;
+}
+
 void LibusbSoundplaneDriver::processThreadControlTransferCallback(struct libusb_transfer *xfr) {
 	LibusbSoundplaneDriver* driver = static_cast<LibusbSoundplaneDriver*>(xfr->user_data);
 	driver->mOutstandingTransfers--;
@@ -482,6 +491,20 @@ bool LibusbSoundplaneDriver::processThreadHandleRequests(libusb_device_handle *d
 	return carrierMask || carriers;
 }
 
+void LibusbSoundplaneDriver::processThreadHandleCaptureRequest()
+{
+	const auto path = mCaptureRequest.exchange(nullptr, std::memory_order_acquire);
+	if (path)
+	{
+		mCapture.close();
+		if (!path->empty() && !mCapture.open(*path))
+		{
+			fprintf(stderr, "Unable to capture frames to %s\n", path->c_str());
+		}
+		delete path;
+	}
+}
+
 void LibusbSoundplaneDriver::processThread()
 {
 	// Each iteration of this loop is one cycle of finding a Soundplane device,
@@ -502,6 +525,10 @@ void LibusbSoundplaneDriver::processThread()
 			},
 			[this](const SoundplaneOutputFrame& frame)
 			{
+				if (mCapture.isOpen())
+				{
+					mCapture.write(frame.data(), frame.size());
+				}
 				mListener->receivedFrame(*this, frame.data(), frame.size());
 			});
 		LibusbUnpacker unpacker(anomalyFilter);
@@ -531,6 +558,7 @@ void LibusbSoundplaneDriver::processThread()
 				fprintf(stderr, "Libusb error! %i\n", status);
 				break;
 			}
+			processThreadHandleCaptureRequest();
 			if (mState.load(std::memory_order_acquire) == kDeviceHasIsochSync &&
 				processThreadHandleRequests(handle.get()))
 			{
@@ -15,6 +15,7 @@
 #include <libusb-1.0/libusb.h>
 
 #include "SoundplaneDriver.h"
+#include "SoundplaneFrameFile.h"
 #include "SoundplaneModelA.h"
 #include "Unpacker.h"
 
@@ -34,6 +35,8 @@ public:
 	virtual void setCarriers(const Carriers& carriers) override;
 	virtual void enableCarriers(unsigned long mask) override;
 
+	virtual bool setCaptureFile(const std::string& path) override;
+
 private:
 	/**
 	 * A RAII helper for libusb device handles. It closes the device handle on
@@ -279,6 +282,10 @@ private:
 	 * Returns true if a control request was sent.
 	 */
 	bool processThreadHandleRequests(libusb_device_handle *device);
+	/**
+	 * Opens or closes mCapture if setCaptureFile was called.
+	 */
+	void processThreadHandleCaptureRequest();
 	void processThread();
 
 	/**
@@ -360,6 +367,18 @@ private:
 	 * by the processing thread.
 	 */
 	std::atomic<const unsigned long*> mEnableCarriersRequest;
+
+	/**
+	 * Set to a value (allocated with new) by setCaptureFile. Read (and deleted)
+	 * by the processing thread.
+	 */
+	std::atomic<const std::string*> mCaptureRequest;
+
+	/**
+	 * Frames are written here as they are received, when open. Accessed only
+	 * from the processing thread.
+	 */
+	SoundplaneFrameWriter		mCapture;
 };
 
 #endif // __LIBUSB_SOUNDPLANE_DRIVER__
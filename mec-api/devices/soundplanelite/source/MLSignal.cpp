@@ -7,6 +7,7 @@
 // TODO organize
 
 #include "MLSignal.h"
+#include "MLSignalKernels.h"
 
 const MLSample kMLSignalEndSamples[4] = 
 {
@@ -373,22 +374,14 @@ void MLSignal::sigClamp(const MLSignal& a, const MLSignal& b)
 void MLSignal::sigMin(const MLSignal& b)
 {
 	int n = min(mSize, b.getSize());
-	for(int i = 0; i < n; ++i)
-	{
-		MLSample f = mDataAligned[i];
-		mDataAligned[i] = min(f, b.mDataAligned[i]);
-	}
+	MLKernels::sigMin(mDataAligned, b.mDataAligned, n);
 	setConstant(false);
 }
 
 void MLSignal::sigMax(const MLSignal& b)
 {
 	int n = min(mSize, b.getSize());
-	for(int i = 0; i < n; ++i)
-	{
-		MLSample f = mDataAligned[i];
-		mDataAligned[i] = max(f, b.mDataAligned[i]);
-	}
+	MLKernels::sigMax(mDataAligned, b.mDataAligned, n);
 	setConstant(false);
 }
 
@@ -452,16 +445,14 @@ void MLSignal::copy(const MLSignal& b)
 // 
 void MLSignal::add2D(const MLSignal& b, int destX, int destY)
 {
-	MLSignal& a = *this;
 	MLRect srcRect(0, 0, b.getWidth(), b.getHeight());
 	MLRect destRect = srcRect.translated(Vec2(destX, destY)).intersect(getBoundsRect());
 	
+	int left = destRect.left();
+	int n = destRect.right() - left;
 	for(int j=destRect.top(); j<destRect.bottom(); ++j)
 	{
-		for(int i=destRect.left(); i<destRect.right(); ++i)
-		{
-			a(i, j) += b(i - destX, j - destY);
-		}
+		MLKernels::add(mDataAligned + row(j) + left, b.mDataAligned + b.row(j - destY) + left - destX, n);
 	}
 
 	setConstant(false);
@@ -484,9 +475,49 @@ void MLSignal::add2D(const MLSignal& b, const Vec2& destOffset)
 	MLRect srcRect(0, 0, b.getWidth() + 1, b.getHeight() + 1); // add (1, 1) for interpolation
 	MLRect destRect = srcRect.translated(iDestOffset).intersect(getBoundsRect());
 	
+	// find the columns where both source samples are inside b, as getInterpolatedLinear() would.
+	// these are interpolated a row at a time, the columns at the edges of b one sample at a time.
+	int left = destRect.left();
+	int right = destRect.right();
+	int spanLeft = right, spanRight = right;
+	int srcLeft = 0;
+	float mx = 0.f;
+	for(int i=left; i<right; ++i)
+	{
+		float fi = i - destX - srcPosFX;
+		int si = (int)fi;
+		if (fi < 0) si--;
+		bool inside = within(si, 0, b.getWidth() - 1);
+		if(inside && (spanLeft == right))
+		{
+			spanLeft = i;
+			srcLeft = si;
+			mx = fi - si;
+		}
+		else if(!inside && (spanLeft != right))
+		{
+			spanRight = i;
+			break;
+		}
+	}
+	
 	for(int j=destRect.top(); j<destRect.bottom(); ++j)
 	{
-		for(int i=destRect.left(); i<destRect.right(); ++i)
+		float fj = j - destY - srcPosFY;
+		int sj = (int)fj;
+		if (fj < 0) sj--;
+		int iStart = left;
+		if(within(sj, 0, b.getHeight() - 1))
+		{
+			const MLSample* r0 = b.mDataAligned + b.row(sj) + srcLeft;
+			MLKernels::addLerp2D(mDataAligned + row(j) + spanLeft, r0, r0 + b.getRowStride(), mx, fj - sj, spanRight - spanLeft);
+			for(int i=left; i<spanLeft; ++i)
+			{
+				a(i, j) += b.getInterpolatedLinear(i - destX - srcPosFX, j - destY - srcPosFY);
+			}
+			iStart = spanRight;
+		}
+		for(int i=iStart; i<right; ++i)
 		{
 			a(i, j) += b.getInterpolatedLinear(i - destX - srcPosFX, j - destY - srcPosFY);
 		}
@@ -504,7 +535,6 @@ const MLSample MLSignal::operator() (const float i, const float j) const
 }*/
 
 
-// TODO SSE
 void MLSignal::add(const MLSignal& b)
 {
 	const bool ka = isConstant();
@@ -534,16 +564,12 @@ void MLSignal::add(const MLSignal& b)
 		}
 		else
 		{
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] += b.mDataAligned[i];
-			}
+			MLKernels::add(mDataAligned, b.mDataAligned, n);
 		}
 		setConstant(false);
 	}
 }
 
-// TODO SSE
 void MLSignal::subtract(const MLSignal& b)
 {
 	const bool ka = isConstant();
@@ -573,17 +599,13 @@ void MLSignal::subtract(const MLSignal& b)
 		}
 		else
 		{
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] -= b.mDataAligned[i];
-			}
+			MLKernels::subtract(mDataAligned, b.mDataAligned, n);
 		}
 		setConstant(false);
 	}
 }
 
 
-// TODO SSE
 void MLSignal::multiply(const MLSignal& b)
 {
 	const bool ka = isConstant();
@@ -613,10 +635,7 @@ void MLSignal::multiply(const MLSignal& b)
 		}
 		else
 		{
-			for(int i = 0; i < n; ++i)
-			{
-				mDataAligned[i] *= b.mDataAligned[i];
-			}
+			MLKernels::multiply(mDataAligned, b.mDataAligned, n);
 		}
 		setConstant(false);
 	}
@@ -681,26 +700,18 @@ void MLSignal::fill(const MLSample f)
 
 void MLSignal::scale(const MLSample k)
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] *= k;
-	}
+	MLKernels::scale(mDataAligned, k, mSize);
 }
 
 void MLSignal::add(const MLSample k)
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] += k;
-	}
+	MLKernels::add(mDataAligned, k, mSize);
 }
 
+// a - k is exactly a + -k
 void MLSignal::subtract(const MLSample k)
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		mDataAligned[i] -= k;
-	}
+	MLKernels::add(mDataAligned, -k, mSize);
 }
 
 void MLSignal::subtractFrom(const MLSample k)
@@ -721,24 +732,14 @@ void MLSignal::sigClamp(const MLSample min, const MLSample max)
 	}
 }
 
-// TODO SSE
 void MLSignal::sigMin(const MLSample m)
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		float f = mDataAligned[i];
-		mDataAligned[i] = min(f, (float)m);
-	}
+	MLKernels::sigMin(mDataAligned, m, mSize);
 }
 
-// TODO SSE
 void MLSignal::sigMax(const MLSample m)	
 {
-	for(int i=0; i<mSize; ++i)
-	{
-		float f = mDataAligned[i];
-		mDataAligned[i] = max(f, (float)m);
-	}
+	MLKernels::sigMax(mDataAligned, m, mSize);
 }
 
 // convolve a 1D signal with a 3-point impulse response.
@@ -786,110 +787,8 @@ void MLSignal::convolve5x1(const MLSample kmm, const MLSample km, const MLSample
 // an operator for 2D signals only
 void MLSignal::convolve3x3r(const MLSample kc, const MLSample ke, const MLSample kk)
 {
-	int i, j;
-    float f;
-    float * pr1, * pr2, * pr3; // input row ptrs
-    float * prOut; 	
-	
 	MLSample* pIn = getCopy();
-	MLSample* pOut = mDataAligned;
-	int width = mWidth;
-	int height = mHeight;
-	
-	j = 0;	// top row
-	{
-		// row ptrs
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-		
-		i = 0; // top left corner
-		{
-			f = ke * (pr2[i+1] + pr3[i]);
-			f += kk * (pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // top side
-		{
-			f = ke * (pr2[i-1] + pr2[i+1] + pr3[i]);
-			f += kk * (pr3[i-1] + pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // top right corner
-		{
-			f = ke * (pr2[i-1] + pr3[i]);
-			f += kk * (pr3[i-1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-	}
-	for(j = 1; j < height - 1; j++) // center rows
-	{
-		// row ptrs
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-		
-		i = 0; // left side
-		{
-			f = ke * (pr1[i] + pr2[i+1] + pr3[i]);
-			f += kk * (pr1[i+1] + pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // center
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr3[i]);
-			f += kk * (pr1[i-1] + pr1[i+1] + pr3[i-1] + pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // right side
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr3[i]);
-			f += kk * (pr1[i-1] + pr3[i-1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-	}
-	j = height - 1;	// bottom row
-	{
-		// row ptrs
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		prOut = (pOut + row(j));
-		
-		i = 0; // bottom left corner
-		{
-			f = ke * (pr1[i] + pr2[i+1]);
-			f += kk * (pr1[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // bottom side
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1]);
-			f += kk * (pr1[i-1] + pr1[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // bottom right corner
-		{
-			f = ke * (pr2[i-1] + pr1[i]);
-			f += kk * (pr1[i-1]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-	}
+	MLKernels::convolve3x3r(mDataAligned, pIn, mWidth, mHeight, getRowStride(), kc, ke, kk);
 }
 
 
@@ -897,110 +796,8 @@ void MLSignal::convolve3x3r(const MLSample kc, const MLSample ke, const MLSample
 // convolve signal with coefficients, duplicating samples at border. 
 void MLSignal::convolve3x3rb(const MLSample kc, const MLSample ke, const MLSample kk)
 {
-	int i, j;
-	float f;
-	float * pr1, * pr2, * pr3; // input row ptrs
-	float * prOut; 	
-	
 	MLSample* pIn = getCopy();
-	MLSample* pOut = mDataAligned;
-	int width = mWidth;
-	int height = mHeight;
-	
-	j = 0;	// top row
-	{
-		// row ptrs
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-		
-		i = 0; // top left corner
-		{
-			f = ke * (pr2[i+1] + pr3[i] + pr2[i] + pr2[i]);
-			f += kk * (pr3[i+1] + pr2[i+1] + pr3[i] + pr2[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // top side
-		{
-			f = ke * (pr2[i-1] + pr2[i+1] + pr3[i] + pr2[i]);
-			f += kk * (pr3[i-1] + pr3[i+1] + pr2[i-1] + pr2[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // top right corner
-		{
-			f = ke * (pr2[i-1] + pr3[i] + pr2[i] + pr2[i]);
-			f += kk * (pr3[i-1] + pr2[i-1] + pr3[i] + pr2[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-	}
-	for(j = 1; j < height - 1; j++) // center rows
-	{
-		// row ptrs
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		pr3 = (pIn + row(j + 1));
-		prOut = (pOut + row(j));
-		
-		i = 0; // left side
-		{
-			f = ke * (pr1[i] + pr2[i+1] + pr3[i] + pr2[i]);
-			f += kk * (pr1[i+1] + pr3[i+1] + pr1[i] + pr3[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // center
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr3[i]);
-			f += kk * (pr1[i-1] + pr1[i+1] + pr3[i-1] + pr3[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // right side
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr3[i] + pr2[i]);
-			f += kk * (pr1[i-1] + pr3[i-1] + pr1[i] + pr3[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-	}
-	j = height - 1;	// bottom row
-	{
-		// row ptrs
-		pr1 = (pIn + row(j - 1));
-		pr2 = (pIn + row(j));
-		prOut = (pOut + row(j));
-		
-		i = 0; // bottom left corner
-		{
-			f = ke * (pr1[i] + pr2[i+1] + pr2[i] + pr2[i]);
-			f += kk * (pr1[i+1] + pr1[i] + pr2[i+1] + pr2[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-			
-		for(i = 1; i < width - 1; i++) // bottom side
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr2[i]);
-			f += kk * (pr1[i-1] + pr1[i+1] + pr2[i-1] + pr2[i+1]);
-			f += kc * pr2[i];
-			prOut[i] = f;
-		}
-		
-		i = width - 1; // bottom right corner
-		{
-			f = ke * (pr2[i-1] + pr1[i] + pr2[i] + pr2[i]);
-			f += kk * (pr1[i-1] + pr1[i] + pr2[i-1] + pr2[i]);
-			f += kc * pr2[i];
-			prOut[i] = f;		
-		}
-	}
+	MLKernels::convolve3x3rb(mDataAligned, pIn, mWidth, mHeight, getRowStride(), kc, ke, kk);
 }
 
 // an operator for 2D signals only
@@ -0,0 +1,397 @@
+
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#include "MLSignalKernels.h"
+#include "MLDSP.h"
+
+// ----------------------------------------------------------------
+#pragma mark scalar
+
+void MLKernelsScalar::add(float* a, const float* b, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] += b[i];
+	}
+}
+
+void MLKernelsScalar::subtract(float* a, const float* b, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] -= b[i];
+	}
+}
+
+void MLKernelsScalar::multiply(float* a, const float* b, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] *= b[i];
+	}
+}
+
+void MLKernelsScalar::sigMin(float* a, const float* b, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] = (min)(a[i], b[i]);
+	}
+}
+
+void MLKernelsScalar::sigMax(float* a, const float* b, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] = (max)(a[i], b[i]);
+	}
+}
+
+void MLKernelsScalar::add(float* a, float k, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] += k;
+	}
+}
+
+void MLKernelsScalar::scale(float* a, float k, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] *= k;
+	}
+}
+
+void MLKernelsScalar::sigMin(float* a, float k, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] = (min)(a[i], k);
+	}
+}
+
+void MLKernelsScalar::sigMax(float* a, float k, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] = (max)(a[i], k);
+	}
+}
+
+void MLKernelsScalar::addLerp2D(float* a, const float* r0, const float* r1, float mx, float my, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		a[i] += lerp(lerp(r0[i], r0[i + 1], mx), lerp(r1[i], r1[i + 1], mx), my);
+	}
+}
+
+void MLKernelsScalar::convolve3x3r(float* out, const float* in, int width, int height, int stride, float kc, float ke, float kk)
+{
+	int i, j;
+    float f;
+    const float * pr1, * pr2, * pr3; // input row ptrs
+    float * prOut; 	
+	
+	j = 0;	// top row
+	{
+		// row ptrs
+		pr2 = (in + j*stride);
+		pr3 = (in + (j + 1)*stride);
+		prOut = (out + j*stride);
+		
+		i = 0; // top left corner
+		{
+			f = ke * (pr2[i+1] + pr3[i]);
+			f += kk * (pr3[i+1]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+			
+		for(i = 1; i < width - 1; i++) // top side
+		{
+			f = ke * (pr2[i-1] + pr2[i+1] + pr3[i]);
+			f += kk * (pr3[i-1] + pr3[i+1]);
+			f += kc * pr2[i];
+			prOut[i] = f;
+		}
+		
+		i = width - 1; // top right corner
+		{
+			f = ke * (pr2[i-1] + pr3[i]);
+			f += kk * (pr3[i-1]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+	}
+	for(j = 1; j < height - 1; j++) // center rows
+	{
+		// row ptrs
+		pr1 = (in + (j - 1)*stride);
+		pr2 = (in + j*stride);
+		pr3 = (in + (j + 1)*stride);
+		prOut = (out + j*stride);
+		
+		i = 0; // left side
+		{
+			f = ke * (pr1[i] + pr2[i+1] + pr3[i]);
+			f += kk * (pr1[i+1] + pr3[i+1]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+			
+		for(i = 1; i < width - 1; i++) // center
+		{
+			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr3[i]);
+			f += kk * (pr1[i-1] + pr1[i+1] + pr3[i-1] + pr3[i+1]);
+			f += kc * pr2[i];
+			prOut[i] = f;
+		}
+		
+		i = width - 1; // right side
+		{
+			f = ke * (pr2[i-1] + pr1[i] + pr3[i]);
+			f += kk * (pr1[i-1] + pr3[i-1]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+	}
+	j = height - 1;	// bottom row
+	{
+		// row ptrs
+		pr1 = (in + (j - 1)*stride);
+		pr2 = (in + j*stride);
+		prOut = (out + j*stride);
+		
+		i = 0; // bottom left corner
+		{
+			f = ke * (pr1[i] + pr2[i+1]);
+			f += kk * (pr1[i+1]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+			
+		for(i = 1; i < width - 1; i++) // bottom side
+		{
+			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1]);
+			f += kk * (pr1[i-1] + pr1[i+1]);
+			f += kc * pr2[i];
+			prOut[i] = f;
+		}
+		
+		i = width - 1; // bottom right corner
+		{
+			f = ke * (pr2[i-1] + pr1[i]);
+			f += kk * (pr1[i-1]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+	}
+}
+
+// convolve signal with coefficients, duplicating samples at border.
+void MLKernelsScalar::convolve3x3rb(float* out, const float* in, int width, int height, int stride, float kc, float ke, float kk)
+{
+	int i, j;
+	float f;
+	const float * pr1, * pr2, * pr3; // input row ptrs
+	float * prOut; 	
+	
+	j = 0;	// top row
+	{
+		// row ptrs
+		pr2 = (in + j*stride);
+		pr3 = (in + (j + 1)*stride);
+		prOut = (out + j*stride);
+		
+		i = 0; // top left corner
+		{
+			f = ke * (pr2[i+1] + pr3[i] + pr2[i] + pr2[i]);
+			f += kk * (pr3[i+1] + pr2[i+1] + pr3[i] + pr2[i]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+			
+		for(i = 1; i < width - 1; i++) // top side
+		{
+			f = ke * (pr2[i-1] + pr2[i+1] + pr3[i] + pr2[i]);
+			f += kk * (pr3[i-1] + pr3[i+1] + pr2[i-1] + pr2[i+1]);
+			f += kc * pr2[i];
+			prOut[i] = f;
+		}
+		
+		i = width - 1; // top right corner
+		{
+			f = ke * (pr2[i-1] + pr3[i] + pr2[i] + pr2[i]);
+			f += kk * (pr3[i-1] + pr2[i-1] + pr3[i] + pr2[i]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+	}
+	for(j = 1; j < height - 1; j++) // center rows
+	{
+		// row ptrs
+		pr1 = (in + (j - 1)*stride);
+		pr2 = (in + j*stride);
+		pr3 = (in + (j + 1)*stride);
+		prOut = (out + j*stride);
+		
+		i = 0; // left side
+		{
+			f = ke * (pr1[i] + pr2[i+1] + pr3[i] + pr2[i]);
+			f += kk * (pr1[i+1] + pr3[i+1] + pr1[i] + pr3[i]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+			
+		for(i = 1; i < width - 1; i++) // center
+		{
+			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr3[i]);
+			f += kk * (pr1[i-1] + pr1[i+1] + pr3[i-1] + pr3[i+1]);
+			f += kc * pr2[i];
+			prOut[i] = f;
+		}
+		
+		i = width - 1; // right side
+		{
+			f = ke * (pr2[i-1] + pr1[i] + pr3[i] + pr2[i]);
+			f += kk * (pr1[i-1] + pr3[i-1] + pr1[i] + pr3[i]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+	}
+	j = height - 1;	// bottom row
+	{
+		// row ptrs
+		pr1 = (in + (j - 1)*stride);
+		pr2 = (in + j*stride);
+		prOut = (out + j*stride);
+		
+		i = 0; // bottom left corner
+		{
+			f = ke * (pr1[i] + pr2[i+1] + pr2[i] + pr2[i]);
+			f += kk * (pr1[i+1] + pr1[i] + pr2[i+1] + pr2[i]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+			
+		for(i = 1; i < width - 1; i++) // bottom side
+		{
+			f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr2[i]);
+			f += kk * (pr1[i-1] + pr1[i+1] + pr2[i-1] + pr2[i+1]);
+			f += kc * pr2[i];
+			prOut[i] = f;
+		}
+		
+		i = width - 1; // bottom right corner
+		{
+			f = ke * (pr2[i-1] + pr1[i] + pr2[i] + pr2[i]);
+			f += kk * (pr1[i-1] + pr1[i] + pr2[i-1] + pr2[i]);
+			f += kc * pr2[i];
+			prOut[i] = f;		
+		}
+	}
+}
+
+#if ML_SIGNAL_KERNELS_SIMD
+
+// ----------------------------------------------------------------
+#pragma mark SIMD
+
+#define ML_SIGNAL_KERNELS_NAMESPACE MLKernelsSIMD
+#include "source/MLSignalKernelsSIMD.h"
+#undef ML_SIGNAL_KERNELS_NAMESPACE
+
+#endif // ML_SIGNAL_KERNELS_SIMD
+
+#if ML_SIGNAL_KERNELS_DISPATCH
+
+// ----------------------------------------------------------------
+#pragma mark dispatch
+
+// each kernel uses the set measured fastest on a 64x8 frame, the Soundplane's size.
+// per sample kernels: SSE2. AVX is no faster over 512 samples, and slower where a load splits a cache line.
+// addLerp2D: scalar, template rows are too short to fill a vector.
+// convolutions: AVX if the CPU has it, otherwise scalar. the compiler vectorizes the scalar versions
+// to SSE2 as well, and they handle the borders with less work than the SSE2 kernels.
+
+static bool cpuHasAVX()
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx");
+}
+
+// false until static initialization reaches it, so earlier callers get the scalar path.
+static const bool kUseAVX = cpuHasAVX();
+
+bool MLKernelsHaveAVX()
+{
+	return kUseAVX;
+}
+
+void MLKernelsDispatch::add(float* a, const float* b, int n)
+{
+	MLKernelsSIMD::add(a, b, n);
+}
+
+void MLKernelsDispatch::subtract(float* a, const float* b, int n)
+{
+	MLKernelsSIMD::subtract(a, b, n);
+}
+
+void MLKernelsDispatch::multiply(float* a, const float* b, int n)
+{
+	MLKernelsSIMD::multiply(a, b, n);
+}
+
+void MLKernelsDispatch::sigMin(float* a, const float* b, int n)
+{
+	MLKernelsSIMD::sigMin(a, b, n);
+}
+
+void MLKernelsDispatch::sigMax(float* a, const float* b, int n)
+{
+	MLKernelsSIMD::sigMax(a, b, n);
+}
+
+void MLKernelsDispatch::add(float* a, float k, int n)
+{
+	MLKernelsSIMD::add(a, k, n);
+}
+
+void MLKernelsDispatch::scale(float* a, float k, int n)
+{
+	MLKernelsSIMD::scale(a, k, n);
+}
+
+void MLKernelsDispatch::sigMin(float* a, float k, int n)
+{
+	MLKernelsSIMD::sigMin(a, k, n);
+}
+
+void MLKernelsDispatch::sigMax(float* a, float k, int n)
+{
+	MLKernelsSIMD::sigMax(a, k, n);
+}
+
+void MLKernelsDispatch::addLerp2D(float* a, const float* r0, const float* r1, float mx, float my, int n)
+{
+	MLKernelsScalar::addLerp2D(a, r0, r1, mx, my, n);
+}
+
+void MLKernelsDispatch::convolve3x3r(float* out, const float* in, int width, int height, int stride, float kc, float ke, float kk)
+{
+	if(kUseAVX) MLKernelsAVX::convolve3x3r(out, in, width, height, stride, kc, ke, kk);
+	else MLKernelsScalar::convolve3x3r(out, in, width, height, stride, kc, ke, kk);
+}
+
+void MLKernelsDispatch::convolve3x3rb(float* out, const float* in, int width, int height, int stride, float kc, float ke, float kk)
+{
+	if(kUseAVX) MLKernelsAVX::convolve3x3rb(out, in, width, height, stride, kc, ke, kk);
+	else MLKernelsScalar::convolve3x3rb(out, in, width, height, stride, kc, ke, kk);
+}
+
+#endif // ML_SIGNAL_KERNELS_DISPATCH
@@ -0,0 +1,270 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// the SIMD kernels, written once for MLKernelVec and included by each file building a set of them,
+// with ML_SIGNAL_KERNELS_NAMESPACE set to the namespace to define.
+// files built for a wider instruction set include this, so it must not use inline functions
+// from other headers, the linker could use their copies from any of the files.
+
+#if defined(ML_USE_SSE)
+	#include "source/sse/MLSignalKernels.h"
+#elif defined(ML_USE_NEON)
+	#include "source/neon/MLSignalKernels.h"
+#endif
+
+// each kernel runs whole vectors, then finishes the tail with the scalar kernel.
+// operations are done in the same order as the scalar versions, so results match
+// exactly unless the compiler contracts the scalar code into fused multiply-adds.
+
+void ML_SIGNAL_KERNELS_NAMESPACE::add(float* a, const float* b, int n)
+{
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		vecStore(a + i, vecAdd(vecLoad(a + i), vecLoad(b + i)));
+	}
+	MLKernelsScalar::add(a + i, b + i, n - i);
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::subtract(float* a, const float* b, int n)
+{
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		vecStore(a + i, vecSub(vecLoad(a + i), vecLoad(b + i)));
+	}
+	MLKernelsScalar::subtract(a + i, b + i, n - i);
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::multiply(float* a, const float* b, int n)
+{
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		vecStore(a + i, vecMul(vecLoad(a + i), vecLoad(b + i)));
+	}
+	MLKernelsScalar::multiply(a + i, b + i, n - i);
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::sigMin(float* a, const float* b, int n)
+{
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		vecStore(a + i, vecMin(vecLoad(a + i), vecLoad(b + i)));
+	}
+	MLKernelsScalar::sigMin(a + i, b + i, n - i);
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::sigMax(float* a, const float* b, int n)
+{
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		vecStore(a + i, vecMax(vecLoad(a + i), vecLoad(b + i)));
+	}
+	MLKernelsScalar::sigMax(a + i, b + i, n - i);
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::add(float* a, float k, int n)
+{
+	const MLKernelVec vk = vecSet(k);
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		vecStore(a + i, vecAdd(vecLoad(a + i), vk));
+	}
+	MLKernelsScalar::add(a + i, k, n - i);
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::scale(float* a, float k, int n)
+{
+	const MLKernelVec vk = vecSet(k);
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		vecStore(a + i, vecMul(vecLoad(a + i), vk));
+	}
+	MLKernelsScalar::scale(a + i, k, n - i);
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::sigMin(float* a, float k, int n)
+{
+	const MLKernelVec vk = vecSet(k);
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		vecStore(a + i, vecMin(vecLoad(a + i), vk));
+	}
+	MLKernelsScalar::sigMin(a + i, k, n - i);
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::sigMax(float* a, float k, int n)
+{
+	const MLKernelVec vk = vecSet(k);
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		vecStore(a + i, vecMax(vecLoad(a + i), vk));
+	}
+	MLKernelsScalar::sigMax(a + i, k, n - i);
+}
+
+static inline MLKernelVec vecLerp(MLKernelVec a, MLKernelVec b, MLKernelVec m)
+{
+	return vecAdd(a, vecMul(m, vecSub(b, a)));
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::addLerp2D(float* a, const float* r0, const float* r1, float mx, float my, int n)
+{
+	const MLKernelVec vmx = vecSet(mx);
+	const MLKernelVec vmy = vecSet(my);
+	int i = 0;
+	for(; i + kMLKernelVecSize <= n; i += kMLKernelVecSize)
+	{
+		MLKernelVec top = vecLerp(vecLoad(r0 + i), vecLoad(r0 + i + 1), vmx);
+		MLKernelVec bottom = vecLerp(vecLoad(r1 + i), vecLoad(r1 + i + 1), vmx);
+		vecStore(a + i, vecAdd(vecLoad(a + i), vecLerp(top, bottom, vmy)));
+	}
+	MLKernelsScalar::addLerp2D(a + i, r0 + i, r1 + i, mx, my, n - i);
+}
+
+static inline int clampIndex(int x, int n)
+{
+	return (x < 0) ? 0 : ((x >= n) ? n - 1 : x);
+}
+
+// one output sample of a 3x3 convolution, used for the left and right columns.
+// samples outside the signal are zero, or duplicated from the border.
+static inline float convolve3x3Sample(const float* in, int width, int height, int stride, int i, int j,
+	float kc, float ke, float kk, bool duplicateBorder)
+{
+	float s[3][3];
+	for(int dj = 0; dj < 3; ++dj)
+	{
+		int y = j + dj - 1;
+		for(int di = 0; di < 3; ++di)
+		{
+			int x = i + di - 1;
+			if((x >= 0) && (x < width) && (y >= 0) && (y < height))
+			{
+				s[dj][di] = in[y*stride + x];
+			}
+			else if(duplicateBorder)
+			{
+				s[dj][di] = in[clampIndex(y, height)*stride + clampIndex(x, width)];
+			}
+			else
+			{
+				s[dj][di] = 0.f;
+			}
+		}
+	}
+	float f = ke * (s[1][0] + s[0][1] + s[1][2] + s[2][1]);
+	f += kk * (s[0][0] + s[0][2] + s[2][0] + s[2][2]);
+	f += kc * s[1][1];
+	return f;
+}
+
+// samples 1 to width - 2 of an output row, from input rows above, at and below it.
+static inline void convolve3x3Row(float* prOut, const float* pr1, const float* pr2, const float* pr3, int width,
+	float kc, float ke, float kk)
+{
+	const MLKernelVec vkc = vecSet(kc);
+	const MLKernelVec vke = vecSet(ke);
+	const MLKernelVec vkk = vecSet(kk);
+	int i = 1;
+	for(; i + kMLKernelVecSize <= width - 1; i += kMLKernelVecSize)
+	{
+		MLKernelVec e = vecAdd(vecAdd(vecAdd(vecLoad(pr2 + i - 1), vecLoad(pr1 + i)), vecLoad(pr2 + i + 1)), vecLoad(pr3 + i));
+		MLKernelVec k = vecAdd(vecAdd(vecAdd(vecLoad(pr1 + i - 1), vecLoad(pr1 + i + 1)), vecLoad(pr3 + i - 1)), vecLoad(pr3 + i + 1));
+		MLKernelVec f = vecMul(vke, e);
+		f = vecAdd(f, vecMul(vkk, k));
+		f = vecAdd(f, vecMul(vkc, vecLoad(pr2 + i)));
+		vecStore(prOut + i, f);
+	}
+	for(; i < width - 1; ++i)
+	{
+		float f = ke * (pr2[i-1] + pr1[i] + pr2[i+1] + pr3[i]);
+		f += kk * (pr1[i-1] + pr1[i+1] + pr3[i-1] + pr3[i+1]);
+		f += kc * pr2[i];
+		prOut[i] = f;
+	}
+}
+
+// samples 1 to width - 2 of the top or bottom output row, with zero outside the signal.
+// prn is the one neighbouring input row.
+static inline void convolve3x3EdgeRow(float* prOut, const float* pr2, const float* prn, int width,
+	float kc, float ke, float kk)
+{
+	const MLKernelVec vkc = vecSet(kc);
+	const MLKernelVec vke = vecSet(ke);
+	const MLKernelVec vkk = vecSet(kk);
+	int i = 1;
+	for(; i + kMLKernelVecSize <= width - 1; i += kMLKernelVecSize)
+	{
+		MLKernelVec e = vecAdd(vecAdd(vecLoad(pr2 + i - 1), vecLoad(pr2 + i + 1)), vecLoad(prn + i));
+		MLKernelVec k = vecAdd(vecLoad(prn + i - 1), vecLoad(prn + i + 1));
+		MLKernelVec f = vecMul(vke, e);
+		f = vecAdd(f, vecMul(vkk, k));
+		f = vecAdd(f, vecMul(vkc, vecLoad(pr2 + i)));
+		vecStore(prOut + i, f);
+	}
+	for(; i < width - 1; ++i)
+	{
+		float f = ke * (pr2[i-1] + pr2[i+1] + prn[i]);
+		f += kk * (prn[i-1] + prn[i+1]);
+		f += kc * pr2[i];
+		prOut[i] = f;
+	}
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::convolve3x3r(float* out, const float* in, int width, int height, int stride, float kc, float ke, float kk)
+{
+	if((width < 2) || (height < 2))
+	{
+		MLKernelsScalar::convolve3x3r(out, in, width, height, stride, kc, ke, kk);
+		return;
+	}
+	
+	for(int j = 0; j < height; ++j)
+	{
+		const float* pr2 = in + j*stride;
+		float* prOut = out + j*stride;
+		if(j == 0)
+		{
+			convolve3x3EdgeRow(prOut, pr2, pr2 + stride, width, kc, ke, kk);
+		}
+		else if(j == height - 1)
+		{
+			convolve3x3EdgeRow(prOut, pr2, pr2 - stride, width, kc, ke, kk);
+		}
+		else
+		{
+			convolve3x3Row(prOut, pr2 - stride, pr2, pr2 + stride, width, kc, ke, kk);
+		}
+		prOut[0] = convolve3x3Sample(in, width, height, stride, 0, j, kc, ke, kk, false);
+		prOut[width - 1] = convolve3x3Sample(in, width, height, stride, width - 1, j, kc, ke, kk, false);
+	}
+}
+
+void ML_SIGNAL_KERNELS_NAMESPACE::convolve3x3rb(float* out, const float* in, int width, int height, int stride, float kc, float ke, float kk)
+{
+	if((width < 2) || (height < 2))
+	{
+		MLKernelsScalar::convolve3x3rb(out, in, width, height, stride, kc, ke, kk);
+		return;
+	}
+	
+	for(int j = 0; j < height; ++j)
+	{
+		const float* pr2 = in + j*stride;
+		const float* pr1 = (j > 0) ? pr2 - stride : pr2;
+		const float* pr3 = (j < height - 1) ? pr2 + stride : pr2;
+		float* prOut = out + j*stride;
+		convolve3x3Row(prOut, pr1, pr2, pr3, width, kc, ke, kk);
+		prOut[0] = convolve3x3Sample(in, width, height, stride, 0, j, kc, ke, kk, true);
+		prOut[width - 1] = convolve3x3Sample(in, width, height, stride, width - 1, j, kc, ke, kk, true);
+	}
+}
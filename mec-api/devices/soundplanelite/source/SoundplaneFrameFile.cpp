@@ -0,0 +1,161 @@
+// SoundplaneFrameFile.cpp
+//
+// Memory mapped reading and writing of raw Soundplane frame captures.
+
+#include "SoundplaneFrameFile.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	const char kFrameFileMagic[8] = { 'S', 'P', 'F', 'R', 'A', 'M', 'E', '1' };
+	const size_t kFrameBytes = kSoundplaneOutputFrameLength * sizeof(float);
+}
+
+// ----------------------------------------------------------------
+#pragma mark SoundplaneFrameReader
+
+SoundplaneFrameReader::~SoundplaneFrameReader()
+{
+	close();
+}
+
+bool SoundplaneFrameReader::open(const std::string& path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SoundplaneFrameFileHeader))
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (p == MAP_FAILED) return false;
+
+	const SoundplaneFrameFileHeader* pHeader = static_cast<const SoundplaneFrameFileHeader*>(p);
+	if (memcmp(pHeader->magic, kFrameFileMagic, sizeof(kFrameFileMagic)) != 0
+		|| pHeader->width != kSoundplaneWidth || pHeader->height != kSoundplaneHeight)
+	{
+		munmap(p, st.st_size);
+		return false;
+	}
+
+	// frames are played in order, so let the kernel read ahead
+	madvise(p, st.st_size, MADV_SEQUENTIAL);
+
+	mpMapping = p;
+	mMappingSize = st.st_size;
+	mpFirstFrame = reinterpret_cast<const float*>(static_cast<const char*>(p) + sizeof(SoundplaneFrameFileHeader));
+	mFrames = (int)((mMappingSize - sizeof(SoundplaneFrameFileHeader)) / kFrameBytes);
+	return true;
+}
+
+void SoundplaneFrameReader::close()
+{
+	if (mpMapping)
+	{
+		munmap(mpMapping, mMappingSize);
+	}
+	mpMapping = nullptr;
+	mMappingSize = 0;
+	mpFirstFrame = nullptr;
+	mFrames = 0;
+}
+
+// ----------------------------------------------------------------
+#pragma mark SoundplaneFrameWriter
+
+SoundplaneFrameWriter::~SoundplaneFrameWriter()
+{
+	close();
+}
+
+bool SoundplaneFrameWriter::open(const std::string& path)
+{
+	close();
+	mFrames = 0;
+
+	mFd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (mFd < 0) return false;
+
+	SoundplaneFrameFileHeader header;
+	memcpy(header.magic, kFrameFileMagic, sizeof(kFrameFileMagic));
+	header.width = kSoundplaneWidth;
+	header.height = kSoundplaneHeight;
+	if (::write(mFd, &header, sizeof(header)) != sizeof(header) || !mapChunk())
+	{
+		::close(mFd);
+		mFd = -1;
+		return false;
+	}
+	return true;
+}
+
+void SoundplaneFrameWriter::close()
+{
+	if (mFd < 0) return;
+
+	unmapChunk();
+	// drop the unused part of the last chunk. if this fails the file just has
+	// trailing empty frames.
+	int r = ftruncate(mFd, sizeof(SoundplaneFrameFileHeader) + (off_t)mFrames * kFrameBytes);
+	(void)r;
+	::close(mFd);
+	mFd = -1;
+}
+
+bool SoundplaneFrameWriter::write(const float* data, int size)
+{
+	if (mFd < 0 || size != kSoundplaneOutputFrameLength) return false;
+	if (mChunkFramesLeft == 0 && !mapChunk()) return false;
+
+	memcpy(mpChunk, data, kFrameBytes);
+	mpChunk += kSoundplaneOutputFrameLength;
+	mChunkFramesLeft--;
+	mFrames++;
+	return true;
+}
+
+// grow the file by a chunk, and map just that chunk. mappings have to start on
+// a page boundary, so the mapping may begin a little before the next frame.
+bool SoundplaneFrameWriter::mapChunk()
+{
+	unmapChunk();
+
+	off_t start = sizeof(SoundplaneFrameFileHeader) + (off_t)mFrames * kFrameBytes;
+	off_t end = start + (off_t)kChunkFrames * kFrameBytes;
+	off_t mapStart = start & ~((off_t)sysconf(_SC_PAGESIZE) - 1);
+	if (ftruncate(mFd, end) != 0) return false;
+
+	void* p = mmap(nullptr, end - mapStart, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, mapStart);
+	if (p == MAP_FAILED) return false;
+
+	mpMapping = p;
+	mMappingSize = end - mapStart;
+	mpChunk = reinterpret_cast<float*>(static_cast<char*>(p) + (start - mapStart));
+	mChunkFramesLeft = kChunkFrames;
+	return true;
+}
+
+void SoundplaneFrameWriter::unmapChunk()
+{
+	if (mpMapping)
+	{
+		munmap(mpMapping, mMappingSize);
+	}
+	mpMapping = nullptr;
+	mMappingSize = 0;
+	mpChunk = nullptr;
+	mChunkFramesLeft = 0;
+}
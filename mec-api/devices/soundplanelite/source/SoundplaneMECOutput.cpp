@@ -153,6 +153,17 @@ void SoundplaneMECOutput_Impl::processSoundplaneMessage(const SoundplaneDataMess
             mTimeToSendNewFrame = false;
         }
 
+        if (mTimeToSendNewFrame)
+        {
+            callback_->startFrame(mSerialNumber.c_str(), mCurrFrameStartTime);
+        }
+    }
+    else if (type == endFrameSym)
+    {
+        if (mTimeToSendNewFrame)
+        {
+            callback_->endFrame(mSerialNumber.c_str(), mCurrFrameStartTime);
+        }
     }
     else if (type == touchSym)
     {
@@ -208,9 +219,5 @@ void SoundplaneMECOutput_Impl::processSoundplaneMessage(const SoundplaneDataMess
         {
             callback_->control(mSerialNumber.c_str(), mCurrFrameStartTime, zoneID, x > 0.5 ? 1 : 0);
         }
-        else if(type == endFrameSym) 
-        {
-            //nop
-        }
     }
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "pa_memorybarrier.h"
 
 #include "InertSoundplaneDriver.h"
+#include "FileSoundplaneDriver.h"
 
 #include <string>
 #include <fstream>
@@ -77,6 +78,9 @@ SoundplaneModel::SoundplaneModel() :
 	mNotchFilter(kSoundplaneWidth, kSoundplaneHeight),
 	mLopassFilter(kSoundplaneWidth, kSoundplaneHeight),
 	mBoxFilter(kSoundplaneWidth, kSoundplaneHeight),
+	mConditioner(kSoundplaneWidth, kSoundplaneHeight),
+	mFusedConditioning(true),
+	mConditioningWasFused(true),
 	//
 	//
 
@@ -105,6 +109,8 @@ SoundplaneModel::SoundplaneModel() :
 	mLopassFilter.setSampleRate(kSoundplaneSampleRate);
 	mLopassFilter.setLopass(50, 0.707);
 	
+	mConditioner.setFilters(mBoxFilter, mNotchFilter, mLopassFilter);
+	
 	for(int i=0; i<kSoundplaneMaxTouches; ++i)
 	{
 		mCurrentKeyX[i] = -1;
@@ -236,6 +242,14 @@ void SoundplaneModel::doPropertyChangeAction(MLSymbol p, const MLProperty & newV
 			{
 				mTracker.setBackgroundFilter(v);
 			}
+			else if (p == "fused_conditioning")
+			{
+				mFusedConditioning = (bool)v;
+			}
+			else if (p == "incremental_touch_sum")
+			{
+				mTracker.setIncrementalTouchSum((bool)v);
+			}
 			else if (p == "quantize")
 			{
 				bool b = v;
@@ -285,6 +299,14 @@ void SoundplaneModel::doPropertyChangeAction(MLSymbol p, const MLProperty & newV
 			{
 				loadZonesFromString(str);
 			}
+			else if (p == "capture_file")
+			{
+				// before initialize, the driver picks this up when created
+				if (mpDriver)
+				{
+					mpDriver->setCaptureFile(str);
+				}
+			}
             //#define ZONEPRESETS
             #ifdef ZONEPRESETS
 			else if (p == "zone_preset")
@@ -359,6 +381,15 @@ void SoundplaneModel::setAllPropertiesToDefaults()
 
 	setProperty("hysteresis", 0.5);
 
+	setProperty("fused_conditioning", 1.);
+	setProperty("incremental_touch_sum", 1.);
+
+	// no playback or capture, unless asked for
+	setProperty("playback_file", "");
+	setProperty("playback_realtime", 1.);
+	setProperty("playback_loop", 0.);
+	setProperty("capture_file", "");
+
 	// menu param defaults
 	setProperty("viewmode", "calibrated");
 
@@ -379,7 +410,6 @@ void SoundplaneModel::initialize()
 {
     addListener(&mOSCOutput);
     addListener(&mMECOutput);
-	mpDriver = SoundplaneDriver::create(this);
 
 	// TODO mem err handling
 	if (!mCalibrateData.setDims(kSoundplaneWidth, kSoundplaneHeight, kSoundplaneCalibrateSize))
@@ -389,6 +419,24 @@ void SoundplaneModel::initialize()
 
 	mTouchFrame.setDims(kTouchWidth, kSoundplaneMaxTouches);
 	mTouchHistory.setDims(kTouchWidth, kSoundplaneMaxTouches, kSoundplaneHistorySize);
+
+	// create the driver last, frames can arrive as soon as it exists
+	const std::string& playbackFile = getStringProperty("playback_file");
+	if (!playbackFile.empty())
+	{
+		mpDriver = FileSoundplaneDriver::create(this, playbackFile,
+			(bool)getFloatProperty("playback_realtime"), (bool)getFloatProperty("playback_loop"));
+	}
+	else
+	{
+		mpDriver = SoundplaneDriver::create(this);
+	}
+
+	const std::string& captureFile = getStringProperty("capture_file");
+	if (!captureFile.empty())
+	{
+		mpDriver->setCaptureFile(captureFile);
+	}
 }
 
 int SoundplaneModel::getDeviceState(void)
@@ -468,34 +516,55 @@ void SoundplaneModel::receivedFrame(SoundplaneDriver& driver, const float* data,
 	}
 	else if(mOutputEnabled)
 	{
-		// scale incoming data
-		float in, cmean, cout;
-		float epsilon = 0.000001;
-		if (mHasCalibration)
+		// start the newly selected path from rest when switching
+		bool fused = mFusedConditioning;
+		if (fused != mConditioningWasFused)
+		{
+			mConditioner.clear();
+			mBoxFilter.clear();
+			mNotchFilter.clear();
+			mLopassFilter.clear();
+			mConditioningWasFused = fused;
+		}
+		
+		if (fused)
+		{
+			// scale and filter data in one pass
+			mConditioner.setInputSignal(&mSurface);
+			mConditioner.setOutputSignal(&mSurface);
+			mConditioner.process(1);
+		}
+		else
 		{
-			for(int j=0; j<mSurface.getHeight(); ++j)
+			// scale incoming data
+			float in, cmean, cout;
+			float epsilon = 0.000001;
+			if (mHasCalibration)
 			{
-				for(int i=0; i<mSurface.getWidth(); ++i)
+				for(int j=0; j<mSurface.getHeight(); ++j)
 				{
-					// scale to 1/z curve
-					in = mSurface(i, j);
-					cmean = mCalibrateMean(i, j);
-					cout = (1.f - ((cmean + epsilon) / (in + epsilon)));
-					mSurface(i, j) = cout;
+					for(int i=0; i<mSurface.getWidth(); ++i)
+					{
+						// scale to 1/z curve
+						in = mSurface(i, j);
+						cmean = mCalibrateMean(i, j);
+						cout = (1.f - ((cmean + epsilon) / (in + epsilon)));
+						mSurface(i, j) = cout;
+					}
 				}
 			}
+			
+			// filter data in time
+			mBoxFilter.setInputSignal(&mSurface);
+			mBoxFilter.setOutputSignal(&mSurface);
+			mBoxFilter.process(1);	
+			mNotchFilter.setInputSignal(&mSurface);
+			mNotchFilter.setOutputSignal(&mSurface);
+			mNotchFilter.process(1);
+			mLopassFilter.setInputSignal(&mSurface);
+			mLopassFilter.setOutputSignal(&mSurface);
+			mLopassFilter.process(1);
 		}
-		
-		// filter data in time
-		mBoxFilter.setInputSignal(&mSurface);
-		mBoxFilter.setOutputSignal(&mSurface);
-		mBoxFilter.process(1);	
-		mNotchFilter.setInputSignal(&mSurface);
-		mNotchFilter.setOutputSignal(&mSurface);
-		mNotchFilter.process(1);
-		mLopassFilter.setInputSignal(&mSurface);
-		mLopassFilter.setOutputSignal(&mSurface);
-		mLopassFilter.process(1);
 
 		// send filtered data to touch tracker.
 		mTracker.setInputSignal(&mSurface);
@@ -1068,10 +1137,12 @@ void SoundplaneModel::endCalibrate()
 
 	mCalibrating = false;
 	mHasCalibration = true;
+	mConditioner.setCalibration(mCalibrateMean);
 
 	mBoxFilter.clear();
 	mNotchFilter.clear();
 	mLopassFilter.clear();
+	mConditioner.clear();
 
 	enableOutput(true);
 }
@@ -1151,6 +1222,10 @@ void SoundplaneModel::nextSelectCarriersStep()
 	mean.scale(1.f / calibrateFrames);
 	mCalibrateMean = mean;
 	mCalibrateMean.sigClamp(0.0001f, 2.f);
+	if (mHasCalibration)
+	{
+		mConditioner.setCalibration(mCalibrateMean);
+	}
 
 	// get std deviation
 	for(int i=startFrame; i<endFrame; ++i)
@@ -52,7 +52,9 @@ TouchTracker::TouchTracker(int w, int h) :
 	mBackgroundFilterFreq(0.125f),
 	mPrevTouchForRotate(0),
 	mRotate(false),
-	mDoNormalize(true)
+	mDoNormalize(true),
+	mTouchSumRenderer(w, h),
+	mIncrementalTouchSum(true)
 {
 	mTouches.resize(kTrackerMaxTouches);	
 	mTouchesToSort.resize(kTrackerMaxTouches);	
@@ -403,6 +405,7 @@ void TouchTracker::clear()
 		mTouches[i] = Touch();	
 	}
 	mBackgroundFilter.clear();
+	mTouchSumRenderer.clear();
 	mNeedsClear = true;
 }
 	
@@ -1088,28 +1091,33 @@ void TouchTracker::process(int)
 			mFilteredInput.convolve3x3r(kc, ke, kk);
 
 			// build sum of currently tracked touches	
+			// scaled by 2 to make sum of touches a bit bigger 
 			//
-			mSumOfTouches.clear();
-			int numActiveTouches = 0;
-			for(int i = 0; i < mMaxTouchesPerFrame; ++i)
+			if(mIncrementalTouchSum)
 			{
-				const Touch& t(mTouches[i]);
-				if(t.isActive())
+				mSumOfTouches.copy(mTouchSumRenderer.process(mTouches, mMaxTouchesPerFrame, mCalibrator, 2.0f));
+			}
+			else
+			{
+				mSumOfTouches.clear();
+				for(int i = 0; i < mMaxTouchesPerFrame; ++i)
 				{
-					Vec2 touchPos(t.x, t.y);
-					mTemplateScaled.clear();
-					mTemplateScaled.add2D(mCalibrator.getTemplate(touchPos), 0, 0);
-					mTemplateScaled.scale(t.z*mCalibrator.getZAdjust(touchPos));
-					mSumOfTouches.add2D(mTemplateScaled, touchPos - Vec2(kTemplateRadius, kTemplateRadius));
-					numActiveTouches++;
-				}
-			}	
-			
-			// to make sum of touches a bit bigger 
-			mSumOfTouches.scale(2.0f);
-			mSumOfTouches.convolve3x3r(kc, ke, kk);
-			mSumOfTouches.convolve3x3r(kc, ke, kk);
-			mSumOfTouches.convolve3x3r(kc, ke, kk);
+					const Touch& t(mTouches[i]);
+					if(t.isActive())
+					{
+						Vec2 touchPos(t.x, t.y);
+						mTemplateScaled.clear();
+						mTemplateScaled.add2D(mCalibrator.getTemplate(touchPos), 0, 0);
+						mTemplateScaled.scale(t.z*mCalibrator.getZAdjust(touchPos));
+						mSumOfTouches.add2D(mTemplateScaled, touchPos - Vec2(kTemplateRadius, kTemplateRadius));
+					}
+				}	
+				
+				mSumOfTouches.scale(2.0f);
+				mSumOfTouches.convolve3x3r(kc, ke, kk);
+				mSumOfTouches.convolve3x3r(kc, ke, kk);
+				mSumOfTouches.convolve3x3r(kc, ke, kk);
+			}
 
 			// TODO lots of optimization here in onepole, 2D filter
 			//
@@ -1234,8 +1242,149 @@ void TouchTracker::setDefaultNormalizeMap()
 }
 
 // --------------------------------------------------------------------------------
-#pragma mark calibration
+#pragma mark sum of touches
 
+// a touch's patch is redrawn when it moves or changes z by more than these.
+const float kTouchSumPosEpsilon = 0.001f;
+const float kTouchSumZEpsilon = 0.0001f;
+
+TouchTracker::TouchSumRenderer::TouchSumRenderer(int w, int h) :
+	mSumValid(false),
+	mTemplateVersion(-1),
+	mScale(0.f),
+	mRenderedTouches(0)
+{
+	mPatches.resize(kTrackerMaxTouches);
+	for(int i=0; i<kTrackerMaxTouches; ++i)
+	{
+		// add 1 for interpolation
+		mPatches[i].signal.setDims(kTemplateSize + 1, kTemplateSize + 1);
+		mPatches[i].valid = false;
+	}
+	mScaled.setDims(kTemplateSize, kTemplateSize);
+	mSum.setDims(w, h);
+	std::fill(mPadded, mPadded + kPaddedSize*kPaddedSize, 0.f);
+}
+
+TouchTracker::TouchSumRenderer::~TouchSumRenderer()
+{
+}
+
+void TouchTracker::TouchSumRenderer::clear()
+{
+	for(int i=0; i<kTrackerMaxTouches; ++i)
+	{
+		mPatches[i].valid = false;
+	}
+	mSumValid = false;
+}
+
+// shift mScaled right and down by the fraction f into patch, interpolating linearly.
+// mScaled is copied into mPadded first, with zeros around it, so the edges need no special cases.
+void TouchTracker::TouchSumRenderer::renderPatch(Vec2 f, MLSignal& patch)
+{
+	for(int j=0; j<kTemplateSize; ++j)
+	{
+		for(int i=0; i<kTemplateSize; ++i)
+		{
+			mPadded[(j + 1)*kPaddedSize + i + 1] = mScaled(i, j);
+		}
+	}
+	
+	// sample from (i - f.x, j - f.y) in the template, or (i - f.x + 1, j - f.y + 1) padded.
+	// f is truncated toward zero so may be negative.
+	int sx = (f.x() > 0.f) ? 0 : 1;
+	int sy = (f.y() > 0.f) ? 0 : 1;
+	float mx = (f.x() > 0.f) ? 1.f - f.x() : -f.x();
+	float my = (f.y() > 0.f) ? 1.f - f.y() : -f.y();
+	for(int j=0; j<kTemplateSize + 1; ++j)
+	{
+		const float* r0 = mPadded + (j + sy)*kPaddedSize + sx;
+		const float* r1 = r0 + kPaddedSize;
+		for(int i=0; i<kTemplateSize + 1; ++i)
+		{
+			patch(i, j) = lerp(lerp(r0[i], r0[i + 1], mx), lerp(r1[i], r1[i + 1], mx), my);
+		}
+	}
+}
+
+const MLSignal& TouchTracker::TouchSumRenderer::process(const std::vector<Touch>& touches, int maxTouches, const Calibrator& calibrator, float scale)
+{
+	if((calibrator.getTemplateVersion() != mTemplateVersion) || (scale != mScale))
+	{
+		clear();
+		mTemplateVersion = calibrator.getTemplateVersion();
+		mScale = scale;
+	}
+	
+	// update the patches of new, moved and removed touches
+	mRenderedTouches = 0;
+	bool changed = !mSumValid;
+	int n = min(maxTouches, (int)touches.size());
+	n = min(n, kTrackerMaxTouches);
+	for(int i = n; i < kTrackerMaxTouches; ++i)
+	{
+		changed |= mPatches[i].valid;
+		mPatches[i].valid = false;
+	}
+	for(int i = 0; i < n; ++i)
+	{
+		const Touch& t(touches[i]);
+		Patch& p(mPatches[i]);
+		if(!t.isActive())
+		{
+			changed |= p.valid;
+			p.valid = false;
+			continue;
+		}
+		
+		bool moved = (fabs(t.x - p.x) > kTouchSumPosEpsilon) || (fabs(t.y - p.y) > kTouchSumPosEpsilon) 
+			|| (fabs(t.z - p.z) > kTouchSumZEpsilon);
+		if(!p.valid || moved)
+		{
+			// scaled template, shifted to its subpixel position as add2D() would.
+			// the integer part of the offset is applied when adding to the sum. 
+			Vec2 touchPos(t.x, t.y);
+			calibrator.getScaledTemplate(touchPos, t.z*calibrator.getZAdjust(touchPos)*scale, mScaled);
+			Vec2 iOffset, fOffset;
+			Vec2 offset = touchPos - Vec2(kTemplateRadius, kTemplateRadius);
+			offset.getIntAndFracParts(iOffset, fOffset);
+			renderPatch(fOffset, p.signal);
+			p.destX = iOffset.x();
+			p.destY = iOffset.y();
+			p.x = t.x;
+			p.y = t.y;
+			p.z = t.z;
+			p.valid = true;
+			mRenderedTouches++;
+			changed = true;
+		}
+	}
+	
+	if(changed)
+	{
+		mSum.clear();
+		for(int i = 0; i < n; ++i)
+		{
+			const Patch& p(mPatches[i]);
+			if(p.valid)
+			{
+				mSum.add2D(p.signal, p.destX, p.destY);
+			}
+		}
+		
+		float kc, ke, kk;
+		kc = 4.f/16.f; ke = 2.f/16.f; kk=1.f/16.f;
+		mSum.convolve3x3r(kc, ke, kk);
+		mSum.convolve3x3r(kc, ke, kk);
+		mSum.convolve3x3r(kc, ke, kk);
+		mSumValid = true;
+	}
+	return mSum;
+}
+
+// --------------------------------------------------------------------------------
+#pragma mark calibration
 
 TouchTracker::Calibrator::Calibrator(int w, int h) :
 	mActive(false),
@@ -1246,7 +1395,8 @@ TouchTracker::Calibrator::Calibrator(int w, int h) :
 	mSrcHeight(h),
 	mWidth(w),
 	mHeight(h),
-	mAutoThresh(0.05f)
+	mAutoThresh(0.05f),
+	mTemplateVersion(0)
 {
 	// resize sums vector and signals in it
 	mData.resize(mWidth*mHeight);//*kCalibrateResolution*kCalibrateResolution);
@@ -1272,6 +1422,7 @@ TouchTracker::Calibrator::Calibrator(int w, int h) :
 	mTemp2.setDims(mSrcWidth, mSrcHeight);
 
 	makeDefaultTemplate();
+	makeBinTemplates();
 }
 
 TouchTracker::Calibrator::~Calibrator()
@@ -1306,6 +1457,7 @@ void TouchTracker::Calibrator::begin()
 	mHasCalibration = false;
 	mHasNormalizeMap = false;
 	mCollectingNormalizeMap = false;
+	makeBinTemplates();
 }
 
 void TouchTracker::Calibrator::cancel()
@@ -1322,6 +1474,7 @@ void TouchTracker::Calibrator::setDefaultNormalizeMap()
 	mActive = false;
 	mHasCalibration = false;
 	mHasNormalizeMap = false;
+	makeBinTemplates();
 }
 
 void TouchTracker::Calibrator::makeDefaultTemplate()
@@ -1353,50 +1506,17 @@ const MLSignal& TouchTracker::Calibrator::getTemplate(Vec2 p) const
 {
 	static MLSignal temp1(kTemplateSize, kTemplateSize);
 	static MLSignal temp2(kTemplateSize, kTemplateSize);
-	static MLSignal d00(kTemplateSize, kTemplateSize);
-	static MLSignal d10(kTemplateSize, kTemplateSize);
-	static MLSignal d01(kTemplateSize, kTemplateSize);
-	static MLSignal d11(kTemplateSize, kTemplateSize);
 	if(mHasCalibration)
 	{
-		Vec2 pos = getBinPosition(p);
-		Vec2 iPos, fPos;
-		pos.getIntAndFracParts(iPos, fPos);	
-		int idx00 = iPos.y()*mWidth + iPos.x();
-
-
-		d00.copy(mCalibrateSignal.getFrame(idx00));
-        if(iPos.x() < mWidth - 3)
-        {
-            d10.copy(mCalibrateSignal.getFrame(idx00 + 1));
-        }
-        else
-        {
-            d10.copy(mDefaultTemplate);
-        }
-        
-        if(iPos.y() < mHeight - 1)
-        {
-            d01.copy(mCalibrateSignal.getFrame(idx00 + mWidth));
-        }
-        else
-        {
-            d01.copy(mDefaultTemplate);
-        }
-        
-        if ((iPos.x() < mWidth - 3) && (iPos.y() < mHeight - 1))
-        {
-            d11.copy(mCalibrateSignal.getFrame(idx00 + mWidth + 1));
-        }
-        else
-        {
-            d11.copy(mDefaultTemplate);
-        }
-		temp1.copy(d00);
+		const MLSignal* d[4];
+		Vec2 fPos;
+		getNeighborTemplates(p, d, fPos);
+		
+		temp1.copy(*d[0]);
         
-        temp1.sigLerp(d10, fPos.x());
-		temp2.copy(d01);
-		temp2.sigLerp(d11, fPos.x());
+        temp1.sigLerp(*d[1], fPos.x());
+		temp2.copy(*d[2]);
+		temp2.sigLerp(*d[3], fPos.x());
 		temp1.sigLerp(temp2, fPos.y());
 
 		return temp1;
@@ -1407,6 +1527,74 @@ const MLSignal& TouchTracker::Calibrator::getTemplate(Vec2 p) const
 	}
 }
 
+// getTemplate() times scale, in one pass. out must be kTemplateSize square.
+void TouchTracker::Calibrator::getScaledTemplate(Vec2 p, float scale, MLSignal& out) const
+{
+	if(mHasCalibration)
+	{
+		const MLSignal* d[4];
+		Vec2 fPos;
+		getNeighborTemplates(p, d, fPos);
+		
+		const MLSample* p00 = d[0]->getConstBuffer();
+		const MLSample* p10 = d[1]->getConstBuffer();
+		const MLSample* p01 = d[2]->getConstBuffer();
+		const MLSample* p11 = d[3]->getConstBuffer();
+		MLSample* pOut = out.getBuffer();
+		float mx = fPos.x();
+		float my = fPos.y();
+		int n = out.getSize();
+		for(int i=0; i<n; ++i)
+		{
+			float a = lerp(p00[i], p10[i], mx);
+			float b = lerp(p01[i], p11[i], mx);
+			pOut[i] = lerp(a, b, my)*scale;
+		}
+	}
+	else
+	{
+		out.copy(mDefaultTemplate);
+		out.scale(scale);
+	}
+}
+
+// get the calibrated templates of the four bins around p, in the order 
+// (0, 0), (1, 0), (0, 1), (1, 1), and the position of p between them.
+void TouchTracker::Calibrator::getNeighborTemplates(Vec2 p, const MLSignal* d[4], Vec2& fPos) const
+{
+	Vec2 pos = getBinPosition(p);
+	Vec2 iPos;
+	pos.getIntAndFracParts(iPos, fPos);	
+	int idx00 = iPos.y()*mWidth + iPos.x();
+	bool hasRight = (iPos.x() < mWidth - 3);
+	bool hasBelow = (iPos.y() < mHeight - 1);
+
+	d[0] = &mBinTemplates[idx00];
+	d[1] = hasRight ? &mBinTemplates[idx00 + 1] : &mDefaultTemplate;
+	d[2] = hasBelow ? &mBinTemplates[idx00 + mWidth] : &mDefaultTemplate;
+	d[3] = (hasRight && hasBelow) ? &mBinTemplates[idx00 + mWidth + 1] : &mDefaultTemplate;
+}
+
+// keep each bin's template in its own signal, so getTemplate() can use them in place.
+// Called whenever the templates change.
+void TouchTracker::Calibrator::makeBinTemplates()
+{
+	if(mHasCalibration)
+	{
+		int bins = mWidth*mHeight;
+		mBinTemplates.resize(bins);
+		for(int i=0; i<bins; ++i)
+		{
+			mBinTemplates[i] = mCalibrateSignal.getFrame(i);
+		}
+	}
+	else
+	{
+		mBinTemplates.clear();
+	}
+	mTemplateVersion++;
+}
+
 Vec2 TouchTracker::Calibrator::getBinPosition(Vec2 pIn) const
 {
 	// Soundplane A
@@ -1710,6 +1898,7 @@ int TouchTracker::Calibrator::addSample(const MLSignal& m)
 				
 				getAverageTemplateDistance();
 				mHasCalibration = true;
+				makeBinTemplates();
 				mActive = false;	
 				r = 1;	
 							
@@ -1797,6 +1986,7 @@ void TouchTracker::Calibrator::setCalibration(const MLSignal& v)
 		MLConsole() << "TouchTracker::Calibrator::setCalibration: bad size, restoring default.\n";
         mHasCalibration = false;
     }
+	makeBinTemplates();
 }
 
 void TouchTracker::Calibrator::setNormalizeMap(const MLSignal& v)
@@ -1815,7 +2005,7 @@ void TouchTracker::Calibrator::setNormalizeMap(const MLSignal& v)
 }
 
 
-float TouchTracker::Calibrator::getZAdjust(const Vec2 p)
+float TouchTracker::Calibrator::getZAdjust(const Vec2 p) const
 {
 	// first adjust z for interpolation based on xy position within unit square
 	//
@@ -0,0 +1,41 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef __ML_SIGNAL_KERNELS_NEON__
+#define __ML_SIGNAL_KERNELS_NEON__
+
+// vector type used by the MLSignal kernels.
+// native NEON rather than SSE2NEON.h, vld1q/vst1q have no alignment requirement.
+
+#include "arm_neon.h"
+
+typedef float32x4_t MLKernelVec;
+const int kMLKernelVecSize = 4;
+
+inline MLKernelVec vecLoad(const float* p) { return vld1q_f32(p); }
+inline void vecStore(float* p, MLKernelVec a) { vst1q_f32(p, a); }
+inline MLKernelVec vecSet(float f) { return vdupq_n_f32(f); }
+inline MLKernelVec vecAdd(MLKernelVec a, MLKernelVec b) { return vaddq_f32(a, b); }
+inline MLKernelVec vecSub(MLKernelVec a, MLKernelVec b) { return vsubq_f32(a, b); }
+inline MLKernelVec vecMul(MLKernelVec a, MLKernelVec b) { return vmulq_f32(a, b); }
+// armv7 has no vector divide, divide each lane to give the same results as scalar code
+inline MLKernelVec vecDiv(MLKernelVec a, MLKernelVec b)
+{
+#if defined(__aarch64__)
+	return vdivq_f32(a, b);
+#else
+	float fa[4], fb[4];
+	vst1q_f32(fa, a);
+	vst1q_f32(fb, b);
+	for(int i = 0; i < 4; ++i)
+	{
+		fa[i] /= fb[i];
+	}
+	return vld1q_f32(fa);
+#endif
+}
+inline MLKernelVec vecMin(MLKernelVec a, MLKernelVec b) { return vminq_f32(a, b); }
+inline MLKernelVec vecMax(MLKernelVec a, MLKernelVec b) { return vmaxq_f32(a, b); }
+
+#endif // __ML_SIGNAL_KERNELS_NEON__
@@ -0,0 +1,49 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+#ifndef __ML_SIGNAL_KERNELS_SSE__
+#define __ML_SIGNAL_KERNELS_SSE__
+
+// vector type used by the MLSignal kernels.
+// 8 wide if the compiler targets AVX (e.g. -mavx2 or -march=native), otherwise 4 wide SSE2.
+// loads and stores are unaligned, since 2D kernels work at arbitrary column offsets.
+// the functions are static, files built with and without AVX get their own copies.
+
+#if defined(__AVX__)
+
+#include <immintrin.h>
+
+typedef __m256 MLKernelVec;
+const int kMLKernelVecSize = 8;
+
+static inline MLKernelVec vecLoad(const float* p) { return _mm256_loadu_ps(p); }
+static inline void vecStore(float* p, MLKernelVec a) { _mm256_storeu_ps(p, a); }
+static inline MLKernelVec vecSet(float f) { return _mm256_set1_ps(f); }
+static inline MLKernelVec vecAdd(MLKernelVec a, MLKernelVec b) { return _mm256_add_ps(a, b); }
+static inline MLKernelVec vecSub(MLKernelVec a, MLKernelVec b) { return _mm256_sub_ps(a, b); }
+static inline MLKernelVec vecMul(MLKernelVec a, MLKernelVec b) { return _mm256_mul_ps(a, b); }
+static inline MLKernelVec vecDiv(MLKernelVec a, MLKernelVec b) { return _mm256_div_ps(a, b); }
+static inline MLKernelVec vecMin(MLKernelVec a, MLKernelVec b) { return _mm256_min_ps(a, b); }
+static inline MLKernelVec vecMax(MLKernelVec a, MLKernelVec b) { return _mm256_max_ps(a, b); }
+
+#else
+
+#include <xmmintrin.h>
+
+typedef __m128 MLKernelVec;
+const int kMLKernelVecSize = 4;
+
+static inline MLKernelVec vecLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline void vecStore(float* p, MLKernelVec a) { _mm_storeu_ps(p, a); }
+static inline MLKernelVec vecSet(float f) { return _mm_set1_ps(f); }
+static inline MLKernelVec vecAdd(MLKernelVec a, MLKernelVec b) { return _mm_add_ps(a, b); }
+static inline MLKernelVec vecSub(MLKernelVec a, MLKernelVec b) { return _mm_sub_ps(a, b); }
+static inline MLKernelVec vecMul(MLKernelVec a, MLKernelVec b) { return _mm_mul_ps(a, b); }
+static inline MLKernelVec vecDiv(MLKernelVec a, MLKernelVec b) { return _mm_div_ps(a, b); }
+static inline MLKernelVec vecMin(MLKernelVec a, MLKernelVec b) { return _mm_min_ps(a, b); }
+static inline MLKernelVec vecMax(MLKernelVec a, MLKernelVec b) { return _mm_max_ps(a, b); }
+
+#endif
+
+#endif // __ML_SIGNAL_KERNELS_SSE__
@@ -0,0 +1,16 @@
+// MadronaLib: a C++ framework for DSP applications.
+// Copyright (c) 2013 Madrona Labs LLC. http://www.madronalabs.com
+// Distributed under the MIT license: http://madrona-labs.mit-license.org/
+
+// the SIMD kernels built for AVX, this file is compiled with -mavx.
+// only called after MLKernelsDispatch has checked the CPU has AVX, so nothing else belongs here.
+
+#include "../../MLSignalKernels.h"
+
+#if defined(ML_USE_AVX)
+
+#define ML_SIGNAL_KERNELS_NAMESPACE MLKernelsAVX
+#include "source/MLSignalKernelsSIMD.h"
+#undef ML_SIGNAL_KERNELS_NAMESPACE
+
+#endif // ML_USE_AVX
@@ -0,0 +1,150 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+#include "MLSignal.h"
+#include "Filters2D.h"
+#include "SoundplaneModelA.h"
+
+// benchmark SoundplaneModel surface conditioning: 1/z calibration, box filter, notch and lopass.
+// compares the separate passes (fused_conditioning off) against SurfaceConditioner (on)
+// reports us/frame, and the largest difference between the two outputs
+
+namespace {
+
+const int kWidth = kSoundplaneWidth;
+const int kHeight = kSoundplaneHeight;
+const int kFrames = 50000;
+const int kRuns = 10;
+
+typedef std::chrono::steady_clock Clock;
+
+// the filters as SoundplaneModel sets them up
+struct Filters {
+    Filters() :
+        notch(kWidth, kHeight),
+        lopass(kWidth, kHeight),
+        box(kWidth, kHeight),
+        conditioner(kWidth, kHeight)
+    {
+        box.setSampleRate(kSoundplaneSampleRate);
+        box.setN(7);
+        notch.setSampleRate(kSoundplaneSampleRate);
+        notch.setNotch(150., 0.707);
+        lopass.setSampleRate(kSoundplaneSampleRate);
+        lopass.setLopass(50, 0.707);
+        conditioner.setFilters(box, notch, lopass);
+    }
+
+    Biquad2D notch;
+    Biquad2D lopass;
+    BoxFilter2D box;
+    SurfaceConditioner conditioner;
+};
+
+void generateFrame(int f, MLSignal& surface)
+{
+    for (int j = 0; j < kHeight; j++) {
+        for (int i = 0; i < kWidth; i++) {
+            float noise = ((float)rand() / (float)RAND_MAX - 0.5f) * 0.002f;
+            float touch = (i == (f / 500) % kWidth && j == 3) ? 0.05f : 0.f;
+            surface(i, j) = 0.1f + noise - touch;
+        }
+    }
+}
+
+void separatePasses(Filters& filters, MLSignal& surface, const MLSignal& calibrateMean)
+{
+    float in, cmean, cout;
+    float epsilon = 0.000001;
+    for (int j = 0; j < surface.getHeight(); ++j) {
+        for (int i = 0; i < surface.getWidth(); ++i) {
+            in = surface(i, j);
+            cmean = calibrateMean(i, j);
+            cout = (1.f - ((cmean + epsilon) / (in + epsilon)));
+            surface(i, j) = cout;
+        }
+    }
+
+    filters.box.setInputSignal(&surface);
+    filters.box.setOutputSignal(&surface);
+    filters.box.process(1);
+    filters.notch.setInputSignal(&surface);
+    filters.notch.setOutputSignal(&surface);
+    filters.notch.process(1);
+    filters.lopass.setInputSignal(&surface);
+    filters.lopass.setOutputSignal(&surface);
+    filters.lopass.process(1);
+}
+
+void fused(Filters& filters, MLSignal& surface, const MLSignal&)
+{
+    filters.conditioner.setInputSignal(&surface);
+    filters.conditioner.setOutputSignal(&surface);
+    filters.conditioner.process(1);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    MLSignal calibrateMean(kWidth, kHeight);
+    calibrateMean.fill(0.1f);
+
+    Filters separateFilters, fusedFilters;
+    fusedFilters.conditioner.setCalibration(calibrateMean);
+
+    std::vector<MLSignal> frames(64, MLSignal(kWidth, kHeight));
+    srand(1);
+    for (size_t f = 0; f < frames.size(); f++) generateFrame(f * 500, frames[f]);
+
+    // check the outputs match over a stretch of frames, including filter state
+    MLSignal a(kWidth, kHeight), b(kWidth, kHeight);
+    float maxDiff = 0.f;
+    for (int f = 0; f < 10000; f++) {
+        a.copy(frames[f % frames.size()]);
+        b.copy(frames[f % frames.size()]);
+        separatePasses(separateFilters, a, calibrateMean);
+        fused(fusedFilters, b, calibrateMean);
+        for (int j = 0; j < kHeight; j++) {
+            for (int i = 0; i < kWidth; i++) {
+                maxDiff = std::max(maxDiff, fabsf(a(i, j) - b(i, j)));
+            }
+        }
+    }
+    std::cout << "max difference: " << maxDiff << std::endl;
+
+    typedef void (*Conditioning)(Filters&, MLSignal&, const MLSignal&);
+    const char* names[] = {"separate passes", "fused"};
+    Conditioning fns[] = {separatePasses, fused};
+    Filters* filters[] = {&separateFilters, &fusedFilters};
+    // best of several runs, alternating, to be less sensitive to other load
+    double best[2] = {1e9, 1e9};
+    float sum = 0.f;
+    for (int run = 0; run < kRuns; run++) {
+        for (int n = 0; n < 2; n++) {
+            MLSignal surface(kWidth, kHeight);
+            Clock::time_point start = Clock::now();
+            for (int f = 0; f < kFrames; f++) {
+                // as receivedFrame, copy the incoming frame then condition it in place
+                surface.copy(frames[f % frames.size()]);
+                fns[n](*filters[n], surface, calibrateMean);
+                sum += surface(kWidth / 2, kHeight / 2);
+            }
+            Clock::time_point end = Clock::now();
+            double us = std::chrono::duration<double, std::micro>(end - start).count() / kFrames;
+            best[n] = std::min(best[n], us);
+        }
+    }
+    for (int n = 0; n < 2; n++) {
+        std::cout << std::left << std::setw(16) << names[n]
+                  << " us/frame: " << best[n]
+                  << std::endl;
+    }
+    if (sum == 0.f) std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+
+#include "SoundplaneFrameFile.h"
+#include "FileSoundplaneDriver.h"
+
+// checks frame files written by SoundplaneFrameWriter (the Libusb driver capture) read back
+// exactly, and that FileSoundplaneDriver plays them with the device state changes of a real
+// driver: unthrottled, at the 1 kHz frame rate, and looping.
+
+namespace {
+
+const char* kFile = "framefiletest.frames";
+// more than one writer chunk, and not a multiple of it
+const int kFrames = SoundplaneFrameWriter::kChunkFrames * 2 + 100;
+int gFailures = 0;
+
+typedef std::chrono::steady_clock Clock;
+
+void check(bool ok, const char* what)
+{
+    if (!ok) {
+        std::cout << "FAIL " << what << std::endl;
+        gFailures++;
+    }
+}
+
+float sample(int frame, int i)
+{
+    return frame * 0.001f + i;
+}
+
+class FrameCheck : public SoundplaneDriverListener
+{
+public:
+    virtual void deviceStateChanged(SoundplaneDriver& driver, MLSoundplaneState s) override {
+        mStates.push_back(s);
+    }
+
+    virtual void receivedFrame(SoundplaneDriver& driver, const float* data, int size) override {
+        int frame = mFrames++ % kFrames;
+        if (size != kSoundplaneOutputFrameLength) mBad++;
+        for (int i = 0; i < size; i++) {
+            if (data[i] != sample(frame, i)) {
+                mBad++;
+                break;
+            }
+        }
+    }
+
+    std::vector<MLSoundplaneState> mStates;
+    int mFrames = 0;
+    int mBad = 0;
+};
+
+void waitForFrames(FileSoundplaneDriver& driver, long frames)
+{
+    Clock::time_point timeout = Clock::now() + std::chrono::seconds(10);
+    while (driver.getFramesPlayed() < frames && Clock::now() < timeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<float> frame(kSoundplaneOutputFrameLength);
+
+    SoundplaneFrameWriter writer;
+    check(writer.open(kFile), "writer open");
+    for (int f = 0; f < kFrames; f++) {
+        for (int i = 0; i < kSoundplaneOutputFrameLength; i++) frame[i] = sample(f, i);
+        check(writer.write(frame.data(), kSoundplaneOutputFrameLength), "write");
+    }
+    check(!writer.write(frame.data(), kSoundplaneOutputFrameLength - 1), "partial frame rejected");
+    writer.close();
+
+    SoundplaneFrameReader reader;
+    check(reader.open(kFile), "reader open");
+    check(reader.getFrames() == kFrames, "frames read");
+    bool same = true;
+    for (int f = 0; f < reader.getFrames() && same; f++) {
+        for (int i = 0; i < kSoundplaneOutputFrameLength; i++) same = same && reader.getFrame(f)[i] == sample(f, i);
+    }
+    check(same, "frames read back");
+    reader.close();
+
+    // unthrottled
+    {
+        FrameCheck listener;
+        {
+            FileSoundplaneDriver driver(&listener, kFile, false, false);
+            check(driver.init(), "driver init");
+            waitForFrames(driver, kFrames);
+            while (driver.getDeviceState() != kNoDevice) std::this_thread::yield();
+        }
+        check(listener.mFrames == kFrames && listener.mBad == 0, "frames played");
+        check(listener.mStates.size() == 4
+              && listener.mStates[0] == kDeviceConnected
+              && listener.mStates[1] == kDeviceHasIsochSync
+              && listener.mStates[2] == kNoDevice
+              && listener.mStates[3] == kDeviceIsTerminating, "device states");
+    }
+
+    // realtime, 100 frames take 100 ms
+    {
+        FrameCheck listener;
+        FileSoundplaneDriver driver(&listener, kFile, true, false);
+        Clock::time_point start = Clock::now();
+        driver.init();
+        waitForFrames(driver, 100);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        check(ms >= 95. && listener.mBad == 0, "realtime playback rate");
+    }
+
+    // looping continues through the end of the file
+    {
+        FrameCheck listener;
+        FileSoundplaneDriver driver(&listener, kFile, false, true);
+        driver.init();
+        waitForFrames(driver, kFrames * 2 + 10);
+        check(driver.getFramesPlayed() >= kFrames * 2 + 10 && listener.mBad == 0, "loop");
+        check(driver.getDeviceState() == kDeviceHasIsochSync, "loop state");
+    }
+
+    // no file, no device
+    {
+        FrameCheck listener;
+        std::unique_ptr<SoundplaneDriver> driver = FileSoundplaneDriver::create(&listener, "framefiletest.missing", false, false);
+        check(driver->getDeviceState() == kNoDevice, "missing file");
+    }
+
+    remove(kFile);
+
+    std::cout << (gFailures ? "FAILED" : "passed") << std::endl;
+    return gFailures ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <math.h>
+#include <stdlib.h>
+
+#include "MLSignalKernels.h"
+#include "SoundplaneModelA.h"
+
+// benchmark the MLSignal kernels, scalar against the platform (SIMD) versions
+// replays 64x8 Soundplane frames, and reports frames/sec per kernel
+// usage: signalkernelbench [frames file]
+// a frames file is raw 32 bit floats, kSoundplaneWidth x kSoundplaneHeight per frame.
+// without one, frames with a few moving touches and noise are generated.
+
+namespace {
+
+const int kWidth = kSoundplaneWidth;
+const int kHeight = kSoundplaneHeight;
+const int kFrameSize = kWidth * kHeight;
+const int kGeneratedFrames = 2000;
+const int kMinSamples = 2000000; // repeat frames until at least this many samples are processed
+const int kRounds = 7; // the fastest round is reported, the others are taken by other load
+const int kTemplateSize = 7;
+const int kTouches = 4;
+
+typedef std::chrono::steady_clock Clock;
+
+bool loadFrames(const char* path, std::vector<float>& frames)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::vector<float> frame(kFrameSize);
+    while (in.read(reinterpret_cast<char*>(frame.data()), kFrameSize * sizeof(float))) {
+        frames.insert(frames.end(), frame.begin(), frame.end());
+    }
+    return !frames.empty();
+}
+
+void generateFrames(std::vector<float>& frames)
+{
+    frames.resize(kGeneratedFrames * kFrameSize);
+    srand(1);
+    for (int f = 0; f < kGeneratedFrames; f++) {
+        float* p = frames.data() + f * kFrameSize;
+        for (int i = 0; i < kFrameSize; i++) {
+            p[i] = ((float)rand() / (float)RAND_MAX - 0.5f) * 0.002f;
+        }
+        for (int t = 0; t < kTouches; t++) {
+            float tx = fmodf(5.f + t * 15.f + f * 0.01f, (float)kWidth);
+            float ty = 1.5f + t + sinf(f * 0.003f) * 0.5f;
+            for (int j = 0; j < kHeight; j++) {
+                for (int i = 0; i < kWidth; i++) {
+                    float d2 = (i - tx) * (i - tx) + (j - ty) * (j - ty);
+                    p[j * kWidth + i] += 0.05f * expf(-d2);
+                }
+            }
+        }
+    }
+}
+
+template<typename Op>
+void runBench(const char* name, const std::vector<float>& frames, Op op)
+{
+    int numFrames = frames.size() / kFrameSize;
+    int passes = kMinSamples / frames.size() + 1;
+    std::vector<float> work(kFrameSize), out(kFrameSize);
+    double sum = 0.;
+    double secs = 0.;
+
+    for (int r = 0; r < kRounds; r++) {
+        Clock::time_point start = Clock::now();
+        for (int p = 0; p < passes; p++) {
+            for (int f = 0; f < numFrames; f++) {
+                const float* frame = frames.data() + f * kFrameSize;
+                std::copy(frame, frame + kFrameSize, work.begin());
+                op(work.data(), out.data());
+                sum += out[kFrameSize / 2];
+            }
+        }
+        Clock::time_point end = Clock::now();
+
+        double roundSecs = std::chrono::duration<double>(end - start).count();
+        if (r == 0 || roundSecs < secs) secs = roundSecs;
+    }
+
+    std::cout << std::left << std::setw(28) << name
+              << " frames/sec: " << static_cast<unsigned long>((passes * numFrames) / secs)
+              << " (" << sum << ")"
+              << std::endl;
+}
+
+const float kc = 4.f / 16.f, ke = 2.f / 16.f, kk = 1.f / 16.f;
+
+template<void (*SigMax)(float*, float, int)>
+void opSigMax(float* w, float* out)
+{
+    SigMax(w, 0.f, kFrameSize);
+    out[kFrameSize / 2] = w[kFrameSize / 2];
+}
+
+template<void (*Scale)(float*, float, int), void (*Add)(float*, const float*, int)>
+void opScaleAdd(float* w, float* out)
+{
+    Scale(w, 2.f, kFrameSize);
+    Add(out, w, kFrameSize);
+}
+
+template<void (*Lerp)(float*, const float*, const float*, float, float, int)>
+void opTemplates(float* w, float* out)
+{
+    static float tmpl[(kTemplateSize + 1) * (kTemplateSize + 1)] = {0.5f};
+    for (int t = 0; t < kTouches; t++) {
+        int x = 4 + t * 14, y = 0;
+        for (int j = 0; j < kTemplateSize; j++) {
+            const float* r0 = tmpl + j * (kTemplateSize + 1);
+            Lerp(out + (y + j) * kWidth + x, r0, r0 + kTemplateSize + 1, 0.25f, 0.75f, kTemplateSize);
+        }
+    }
+    out[kFrameSize / 2] += w[kFrameSize / 2];
+}
+
+template<void (*Convolve)(float*, const float*, int, int, int, float, float, float)>
+void opConvolve(float* w, float* out)
+{
+    Convolve(out, w, kWidth, kHeight, kWidth, kc, ke, kk);
+}
+
+// the four smoothing passes TouchTracker::process makes each frame
+template<void (*Convolve)(float*, const float*, int, int, int, float, float, float)>
+void opTrackerSmoothing(float* w, float* out)
+{
+    Convolve(out, w, kWidth, kHeight, kWidth, kc, ke, kk);
+    Convolve(w, out, kWidth, kHeight, kWidth, kc, ke, kk);
+    Convolve(out, w, kWidth, kHeight, kWidth, kc, ke, kk);
+    Convolve(w, out, kWidth, kHeight, kWidth, kc, ke, kk);
+    out[kFrameSize / 2] = w[kFrameSize / 2];
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<float> frames;
+    if (argc > 1) {
+        if (!loadFrames(argv[1], frames)) {
+            std::cerr << "unable to read frames from " << argv[1] << std::endl;
+            return 1;
+        }
+    } else {
+        generateFrames(frames);
+    }
+    std::cout << "frames: " << frames.size() / kFrameSize << std::endl;
+
+#if ML_SIGNAL_KERNELS_DISPATCH
+    std::cout << "platform kernels chosen at run time: " << (MLKernelsHaveAVX() ? "AVX convolutions" : "scalar convolutions") << std::endl;
+#elif !ML_SIGNAL_KERNELS_SIMD
+    std::cout << "no SIMD kernels for this platform, platform kernels are scalar" << std::endl;
+#endif
+
+    runBench("scalar sigMax", frames, opSigMax<MLKernelsScalar::sigMax>);
+    runBench("kernel sigMax", frames, opSigMax<MLKernels::sigMax>);
+    runBench("scalar scale+add", frames, opScaleAdd<MLKernelsScalar::scale, MLKernelsScalar::add>);
+    runBench("kernel scale+add", frames, opScaleAdd<MLKernels::scale, MLKernels::add>);
+    runBench("scalar add2D (templates)", frames, opTemplates<MLKernelsScalar::addLerp2D>);
+    runBench("kernel add2D (templates)", frames, opTemplates<MLKernels::addLerp2D>);
+    runBench("scalar convolve3x3r", frames, opConvolve<MLKernelsScalar::convolve3x3r>);
+    runBench("kernel convolve3x3r", frames, opConvolve<MLKernels::convolve3x3r>);
+    runBench("scalar convolve3x3rb", frames, opConvolve<MLKernelsScalar::convolve3x3rb>);
+    runBench("kernel convolve3x3rb", frames, opConvolve<MLKernels::convolve3x3rb>);
+    runBench("scalar tracker smoothing", frames, opTrackerSmoothing<MLKernelsScalar::convolve3x3r>);
+    runBench("kernel tracker smoothing", frames, opTrackerSmoothing<MLKernels::convolve3x3r>);
+
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include <iostream>
+#include <vector>
+#include <math.h>
+#include <stdlib.h>
+
+#include "MLSignal.h"
+#include "MLSignalKernels.h"
+
+// checks the platform signal kernels (MLKernels) against the scalar reference (MLKernelsScalar)
+// and the MLSignal 2D operations against their per sample definitions.
+// results should match exactly on SSE, within rounding where the compiler fuses scalar multiply-adds.
+
+namespace {
+
+const float kTolerance = 1e-5f;
+const int kTemplateTestSize = 7;
+int gFailures = 0;
+
+float randomSample()
+{
+    return (float)rand() / (float)RAND_MAX * 2.f - 1.f;
+}
+
+void fillRandom(std::vector<float>& v)
+{
+    for (size_t i = 0; i < v.size(); i++) v[i] = randomSample();
+}
+
+bool close(float a, float b)
+{
+    return fabsf(a - b) <= kTolerance * (1.f + fabsf(b));
+}
+
+void check(const char* name, const std::vector<float>& test, const std::vector<float>& ref)
+{
+    for (size_t i = 0; i < ref.size(); i++) {
+        if (!close(test[i], ref[i])) {
+            std::cout << "FAIL " << name << " at " << i << " : " << test[i] << " expected " << ref[i] << std::endl;
+            gFailures++;
+            return;
+        }
+    }
+}
+
+void check(const char* name, const MLSignal& test, const MLSignal& ref)
+{
+    for (int j = 0; j < ref.getHeight(); j++) {
+        for (int i = 0; i < ref.getWidth(); i++) {
+            if (!close(test(i, j), ref(i, j))) {
+                std::cout << "FAIL " << name << " at (" << i << "," << j << ") : "
+                          << test(i, j) << " expected " << ref(i, j) << std::endl;
+                gFailures++;
+                return;
+            }
+        }
+    }
+}
+
+typedef void (*BinaryKernel)(float*, const float*, int);
+typedef void (*ConstKernel)(float*, float, int);
+typedef void (*ConvolveKernel)(float*, const float*, int, int, int, float, float, float);
+
+void testBinary(const char* name, BinaryKernel kernel, BinaryKernel ref, int n)
+{
+    std::vector<float> a(n), b(n);
+    fillRandom(a);
+    fillRandom(b);
+    std::vector<float> ra(a);
+    kernel(a.data(), b.data(), n);
+    ref(ra.data(), b.data(), n);
+    check(name, a, ra);
+}
+
+void testConst(const char* name, ConstKernel kernel, ConstKernel ref, int n)
+{
+    std::vector<float> a(n);
+    fillRandom(a);
+    std::vector<float> ra(a);
+    float k = randomSample();
+    kernel(a.data(), k, n);
+    ref(ra.data(), k, n);
+    check(name, a, ra);
+}
+
+void testLerp(int n)
+{
+    std::vector<float> a(n), r0(n + 1), r1(n + 1);
+    fillRandom(a);
+    fillRandom(r0);
+    fillRandom(r1);
+    std::vector<float> ra(a);
+    float mx = fabsf(randomSample()), my = fabsf(randomSample());
+    MLKernels::addLerp2D(a.data(), r0.data(), r1.data(), mx, my, n);
+    MLKernelsScalar::addLerp2D(ra.data(), r0.data(), r1.data(), mx, my, n);
+    check("addLerp2D", a, ra);
+}
+
+void testConvolve(const char* name, ConvolveKernel kernel, ConvolveKernel ref, int width, int height)
+{
+    int stride = 1 << bitsToContain(width);
+    std::vector<float> in(stride * height);
+    fillRandom(in);
+    std::vector<float> out(in.size(), 0.f), rout(in.size(), 0.f);
+    float kc = 4.f / 16.f, ke = 2.f / 16.f, kk = 1.f / 16.f;
+    kernel(out.data(), in.data(), width, height, stride, kc, ke, kk);
+    ref(rout.data(), in.data(), width, height, stride, kc, ke, kk);
+    check(name, out, rout);
+}
+
+void testKernels(int n)
+{
+#if ML_SIGNAL_KERNELS_DISPATCH
+    // the set MLKernels did not choose is tested as well
+    testBinary("SSE2 add", MLKernelsSIMD::add, MLKernelsScalar::add, n);
+    testConst("SSE2 scale", MLKernelsSIMD::scale, MLKernelsScalar::scale, n);
+    if (MLKernelsHaveAVX()) {
+        testBinary("AVX add", MLKernelsAVX::add, MLKernelsScalar::add, n);
+        testConst("AVX scale", MLKernelsAVX::scale, MLKernelsScalar::scale, n);
+    }
+#endif
+    testBinary("add", MLKernels::add, MLKernelsScalar::add, n);
+    testBinary("subtract", MLKernels::subtract, MLKernelsScalar::subtract, n);
+    testBinary("multiply", MLKernels::multiply, MLKernelsScalar::multiply, n);
+    testBinary("sigMin", MLKernels::sigMin, MLKernelsScalar::sigMin, n);
+    testBinary("sigMax", MLKernels::sigMax, MLKernelsScalar::sigMax, n);
+    testConst("add k", MLKernels::add, MLKernelsScalar::add, n);
+    testConst("scale", MLKernels::scale, MLKernelsScalar::scale, n);
+    testConst("sigMin k", MLKernels::sigMin, MLKernelsScalar::sigMin, n);
+    testConst("sigMax k", MLKernels::sigMax, MLKernelsScalar::sigMax, n);
+    testLerp(n);
+}
+
+void fillRandom(MLSignal& s)
+{
+    for (int j = 0; j < s.getHeight(); j++) {
+        for (int i = 0; i < s.getWidth(); i++) {
+            s(i, j) = randomSample();
+        }
+    }
+}
+
+// add2D compared to the per sample definitions, for offsets on, across and outside the edges
+void testAdd2D(int width, int height)
+{
+    MLSignal tmpl(kTemplateTestSize, kTemplateTestSize);
+    fillRandom(tmpl);
+    MLSignal dest(width, height);
+
+    for (int t = 0; t < 200; t++) {
+        fillRandom(dest);
+        MLSignal ref(dest);
+        float x = randomSample() * (width + 4);
+        float y = randomSample() * (height + 4);
+
+        dest.add2D(tmpl, Vec2(x, y));
+
+        Vec2 iOffset, fOffset;
+        Vec2(x, y).getIntAndFracParts(iOffset, fOffset);
+        int dx = iOffset[0], dy = iOffset[1];
+        for (int j = 0; j < height; j++) {
+            for (int i = 0; i < width; i++) {
+                if (within(i - dx, 0, tmpl.getWidth() + 1) && within(j - dy, 0, tmpl.getHeight() + 1)) {
+                    ref(i, j) += tmpl.getInterpolatedLinear(i - dx - fOffset[0], j - dy - fOffset[1]);
+                }
+            }
+        }
+        check("add2D subpixel", dest, ref);
+
+        int ix = (int)x, iy = (int)y;
+        MLSignal refInt(dest);
+        dest.add2D(tmpl, ix, iy);
+        for (int j = 0; j < height; j++) {
+            for (int i = 0; i < width; i++) {
+                if (within(i - ix, 0, tmpl.getWidth()) && within(j - iy, 0, tmpl.getHeight())) {
+                    refInt(i, j) += tmpl(i - ix, j - iy);
+                }
+            }
+        }
+        check("add2D", dest, refInt);
+    }
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    srand(1);
+
+#if ML_SIGNAL_KERNELS_DISPATCH
+    std::cout << "testing SIMD kernels, " << (MLKernelsHaveAVX() ? "AVX" : "scalar") << " convolutions chosen at run time" << std::endl;
+#elif ML_SIGNAL_KERNELS_SIMD
+    std::cout << "testing SIMD kernels" << std::endl;
+#else
+    std::cout << "no SIMD kernels for this platform, testing scalar kernels" << std::endl;
+#endif
+
+    // lengths around the vector size, and a whole 64x8 Soundplane frame
+    for (int n = 0; n < 20; n++) testKernels(n);
+    testKernels(64 * 8);
+
+    int sizes[][2] = {{64, 8}, {2, 2}, {3, 3}, {5, 4}, {7, 7}, {13, 5}, {17, 9}, {33, 2}};
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        testConvolve("convolve3x3r", MLKernels::convolve3x3r, MLKernelsScalar::convolve3x3r, sizes[s][0], sizes[s][1]);
+        testConvolve("convolve3x3rb", MLKernels::convolve3x3rb, MLKernelsScalar::convolve3x3rb, sizes[s][0], sizes[s][1]);
+#if ML_SIGNAL_KERNELS_DISPATCH
+        testConvolve("SSE2 convolve3x3r", MLKernelsSIMD::convolve3x3r, MLKernelsScalar::convolve3x3r, sizes[s][0], sizes[s][1]);
+        testConvolve("SSE2 convolve3x3rb", MLKernelsSIMD::convolve3x3rb, MLKernelsScalar::convolve3x3rb, sizes[s][0], sizes[s][1]);
+#endif
+    }
+
+    testAdd2D(64, 8);
+    testAdd2D(9, 9);
+
+    if (gFailures) {
+        std::cout << gFailures << " failures" << std::endl;
+        return 1;
+    }
+    std::cout << "all tests passed" << std::endl;
+    return 0;
+}
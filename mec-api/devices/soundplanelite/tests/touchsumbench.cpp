@@ -0,0 +1,154 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+#include "MLSignal.h"
+#include "TouchTracker.h"
+#include "SoundplaneModelA.h"
+
+// benchmark building the TouchTracker sum of touches, for 1 to 16 touches.
+// compares rendering every template then smoothing the sum (incremental_touch_sum off)
+// against TouchSumRenderer (on), with all touches moving and with touches held still.
+// reports us/frame, and the largest difference between the two sums while moving.
+
+namespace {
+
+const int kWidth = kSoundplaneWidth;
+const int kHeight = kSoundplaneHeight;
+const int kFrames = 20000;
+const int kRuns = 5;
+
+typedef std::chrono::steady_clock Clock;
+
+// a calibration with a slightly different template in each bin
+void makeCalibration(MLSignal& cal)
+{
+    int bins = kCalibrateWidth * kCalibrateHeight;
+    cal.setDims(kTemplateSize, kTemplateSize, bins);
+    MLSignal t(kTemplateSize, kTemplateSize);
+    for (int b = 0; b < bins; b++) {
+        float sx = 3.f + (b % 7) * 0.1f;
+        float sy = 2.5f + (b % 5) * 0.1f;
+        for (int j = 0; j < kTemplateSize; j++) {
+            for (int i = 0; i < kTemplateSize; i++) {
+                float dx = (i + 0.5f - kTemplateSize / 2.f) / sx;
+                float dy = (j + 0.5f - kTemplateSize / 2.f) / sy;
+                t(i, j) = std::max(0.f, 1.f - sqrtf(dx * dx + dy * dy));
+            }
+        }
+        cal.setFrame(b, t);
+    }
+}
+
+// move the first n touches along their own paths. held touches only drift in z below the redraw threshold.
+void updateTouches(std::vector<Touch>& touches, int n, int frame, bool held)
+{
+    for (int i = 0; i < n; i++) {
+        Touch& t = touches[i];
+        float phase = held ? i : frame * 0.002f + i;
+        t.x = 2.f + fmodf(i * 3.7f + phase * 5.f, kWidth - 4.f);
+        t.y = 1.f + (kHeight - 2.f) * (0.5f + 0.5f * sinf(phase * 1.3f + i));
+        t.z = 0.05f + 0.02f * sinf(phase * 2.1f) + (held ? (frame & 1) * 0.00001f : 0.f);
+        t.age = 1;
+    }
+}
+
+void referenceSum(const std::vector<Touch>& touches, int n, TouchTracker::Calibrator& calibrator,
+                  MLSignal& templateScaled, MLSignal& sum)
+{
+    float kc = 4.f / 16.f, ke = 2.f / 16.f, kk = 1.f / 16.f;
+    sum.clear();
+    for (int i = 0; i < n; i++) {
+        const Touch& t(touches[i]);
+        if (t.isActive()) {
+            Vec2 touchPos(t.x, t.y);
+            templateScaled.clear();
+            templateScaled.add2D(calibrator.getTemplate(touchPos), 0, 0);
+            templateScaled.scale(t.z * calibrator.getZAdjust(touchPos));
+            sum.add2D(templateScaled, touchPos - Vec2(kTemplateRadius, kTemplateRadius));
+        }
+    }
+    sum.scale(2.0f);
+    sum.convolve3x3r(kc, ke, kk);
+    sum.convolve3x3r(kc, ke, kk);
+    sum.convolve3x3r(kc, ke, kk);
+}
+
+float maxDifference(const MLSignal& a, const MLSignal& b)
+{
+    float maxDiff = 0.f;
+    for (int j = 0; j < kHeight; j++) {
+        for (int i = 0; i < kWidth; i++) {
+            maxDiff = std::max(maxDiff, fabsf(a(i, j) - b(i, j)));
+        }
+    }
+    return maxDiff;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    TouchTracker::Calibrator calibrator(kWidth, kHeight);
+    MLSignal cal;
+    makeCalibration(cal);
+    calibrator.setCalibration(cal);
+
+    TouchTracker::TouchSumRenderer renderer(kWidth, kHeight);
+    MLSignal templateScaled(kTemplateSize, kTemplateSize);
+    MLSignal refSum(kWidth, kHeight);
+    std::vector<Touch> touches(kTrackerMaxTouches);
+    float check = 0.f;
+
+    std::cout << std::left << std::setw(8) << "touches"
+              << std::setw(14) << "reference"
+              << std::setw(14) << "moving"
+              << std::setw(14) << "held"
+              << "max diff" << std::endl;
+
+    for (int n = 1; n <= kTrackerMaxTouches; n++) {
+        std::fill(touches.begin(), touches.end(), Touch());
+        renderer.clear();
+
+        float diff = 0.f;
+        for (int f = 0; f < 1000; f++) {
+            updateTouches(touches, n, f, false);
+            referenceSum(touches, n, calibrator, templateScaled, refSum);
+            diff = std::max(diff, maxDifference(refSum, renderer.process(touches, n, calibrator, 2.0f)));
+        }
+
+        // best of several runs, to be less sensitive to other load
+        double best[3] = {1e9, 1e9, 1e9};
+        for (int run = 0; run < kRuns; run++) {
+            for (int m = 0; m < 3; m++) {
+                bool held = (m == 2);
+                renderer.clear();
+                Clock::time_point start = Clock::now();
+                for (int f = 0; f < kFrames; f++) {
+                    updateTouches(touches, n, f, held);
+                    if (m == 0) {
+                        referenceSum(touches, n, calibrator, templateScaled, refSum);
+                        check += refSum(kWidth / 2, kHeight / 2);
+                    } else {
+                        check += renderer.process(touches, n, calibrator, 2.0f)(kWidth / 2, kHeight / 2);
+                    }
+                }
+                Clock::time_point end = Clock::now();
+                double us = std::chrono::duration<double, std::micro>(end - start).count() / kFrames;
+                best[m] = std::min(best[m], us);
+            }
+        }
+
+        std::cout << std::left << std::setw(8) << n
+                  << std::setw(14) << best[0]
+                  << std::setw(14) << best[1]
+                  << std::setw(14) << best[2]
+                  << diff << std::endl;
+    }
+    if (check == 0.f) std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+
+#include "SoundplaneModel.h"
+#include "SoundplaneFrameFile.h"
+
+// benchmark the whole SoundplaneModel pipeline: conditioning, TouchTracker, zones and MEC output,
+// on frames played unthrottled by FileSoundplaneDriver, with no device attached.
+// usage: trackerbench [capture file] [runs]
+// the capture file is one written by the soundplane "capture file" preference. without one,
+// a synthetic capture is generated: the board at rest while the model calibrates, then moving touches.
+// reports us/frame and frames/s over the whole file (best of runs), and the touch messages output.
+
+namespace {
+
+const char* kSyntheticFile = "trackerbench.frames";
+// the model sets carriers after ~1000 frames, then calibrates over kSoundplaneCalibrateSize more
+const int kRestFrames = 3500;
+const int kTouchFrames = 20000;
+const int kTouches = 4;
+
+typedef std::chrono::steady_clock Clock;
+
+// a single zone of notes over the whole surface
+const char* kZones = "{ \"zone\" : { \"type\" : \"note_row\", \"name\" : \"notes\", \"note\" : 36, \"offset\" : 5, \"rect\" : [0, 0, 30, 5] } }";
+
+class CountingCallback : public SoundplaneMECCallback
+{
+public:
+    virtual void device(const char* dev, int rows, int cols) {}
+    virtual void touch(const char* dev, unsigned long long t, bool a, int touch, float note, float x, float y, float z) { mTouches++; }
+    virtual void control(const char* dev, unsigned long long t, int id, float val) {}
+
+    std::atomic<long> mTouches{0};
+};
+
+class BenchModel : public SoundplaneModel
+{
+public:
+    virtual void deviceStateChanged(SoundplaneDriver& driver, MLSoundplaneState s) override
+    {
+        SoundplaneModel::deviceStateChanged(driver, s);
+        if (s == kNoDevice) mFinished = true;
+    }
+
+    std::atomic<bool> mFinished{false};
+};
+
+// raw sensor values: a fixed background, raised by 1/(1 - pressure) under touches,
+// which the model's calibration turns back into the pressure.
+bool writeSyntheticCapture(const char* path)
+{
+    SoundplaneFrameWriter writer;
+    if (!writer.open(path)) return false;
+
+    std::vector<float> frame(kSoundplaneOutputFrameLength);
+    for (int f = 0; f < kRestFrames + kTouchFrames; f++) {
+        float tx[kTouches], ty[kTouches], tz[kTouches];
+        for (int t = 0; t < kTouches; t++) {
+            float phase = (f - kRestFrames) * 0.0005f + t * 1.7f;
+            tx[t] = 4.f + t * 14.f + 6.f * sinf(phase);
+            ty[t] = 3.5f + 2.f * sinf(phase * 1.3f);
+            tz[t] = f < kRestFrames ? 0.f : 0.3f + 0.1f * sinf(phase * 3.f);
+        }
+        for (int j = 0; j < kSoundplaneHeight; j++) {
+            for (int i = 0; i < kSoundplaneWidth; i++) {
+                float p = 0.f;
+                for (int t = 0; t < kTouches; t++) {
+                    float dx = i - tx[t], dy = (j - ty[t]) * 2.f;
+                    p += tz[t] * fmaxf(0.f, 1.f - (dx * dx + dy * dy) / 9.f);
+                }
+                float background = 0.5f + 0.1f * sinf(i * 0.7f + j);
+                float noise = 0.0005f * sinf(f * 0.37f + i * 1.1f + j * 2.3f);
+                frame[j * kSoundplaneWidth + i] = background / (1.f - fminf(p, 0.8f)) + noise;
+            }
+        }
+        if (!writer.write(frame.data(), kSoundplaneOutputFrameLength)) return false;
+    }
+    writer.close();
+    return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::string file = argc > 1 ? argv[1] : kSyntheticFile;
+    int runs = argc > 2 ? atoi(argv[2]) : 5;
+    if (argc < 2 && !writeSyntheticCapture(kSyntheticFile)) {
+        std::cout << "unable to write " << kSyntheticFile << std::endl;
+        return 1;
+    }
+
+    SoundplaneFrameReader reader;
+    if (!reader.open(file)) {
+        std::cout << "unable to read frames from " << file << std::endl;
+        return 1;
+    }
+    int frames = reader.getFrames();
+    reader.close();
+
+    double best = 1e9;
+    long touches = 0;
+    for (int run = 0; run < runs; run++) {
+        CountingCallback callback;
+        BenchModel model;
+        model.updateAllProperties();
+        model.setPropertyImmediate("osc_active", 0.0f);
+        model.setPropertyImmediate("mec_active", 1.0f);
+        model.setPropertyImmediate("data_freq_mec", 1000.0f);
+        model.setPropertyImmediate("zone_JSON", std::string(kZones));
+        model.setPropertyImmediate("playback_file", file);
+        model.setPropertyImmediate("playback_realtime", 0.0f);
+        model.mecOutput().connect(&callback);
+
+        Clock::time_point start = Clock::now();
+        model.initialize();
+        while (!model.mFinished) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        Clock::time_point end = Clock::now();
+
+        best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count() / frames);
+        touches = callback.mTouches;
+    }
+
+    std::cout << file << " : " << frames << " frames" << std::endl;
+    std::cout << std::left << std::setw(14) << "us/frame" << std::setw(14) << "frames/s" << "touch msgs" << std::endl;
+    std::cout << std::left << std::setw(14) << best << std::setw(14) << (long)(1e6 / best) << touches << std::endl;
+
+    if (argc < 2) remove(kSyntheticFile);
+    return 0;
+}
@@ -1,9 +1,17 @@
 #include "mec_api.h"
 /////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <map>
+
 #include "mec_prefs.h"
 #include "mec_device.h"
+#include "mec_device_thread.h"
 #include "mec_log.h"
+#include "mec_msg_merge.h"
+#include "mec_msg_queue.h"
+#include "mec_recorder.h"
+#include "mec_surface.h"
 
 #if !DISABLE_EIGENHARP
 #   include "devices/mec_eigenharp.h"
@@ -19,6 +27,7 @@
 #include "devices/mec_mididevice.h"
 #include "devices/mec_osct3d.h"
 #include "devices/mec_kontroldevice.h"
+#include "devices/mec_replay.h"
 
 namespace mec {
 
@@ -31,6 +40,8 @@ public:
 
     void init();
     void process();  // periodically call to process messages
+    bool waitAndProcess(unsigned timeoutMs);
+    void wakeUp();
 
     void subscribe(ICallback *);
     void unsubscribe(ICallback *);
@@ -42,6 +53,9 @@ public:
     void subscribe(IMusicalCallback *);
     void unsubscribe(IMusicalCallback *);
 
+    void subscribe(IFrameCallback *);
+    void unsubscribe(IFrameCallback *);
+
 
     //callbacks...
     virtual void touchOn(int touchId, float note, float x, float y, float z);
@@ -49,6 +63,8 @@ public:
     virtual void touchOff(int touchId, float note, float x, float y, float z);
     virtual void control(int ctrlId, float v);
     virtual void mec_control(int cmd, void *other);
+    virtual void frameStart(unsigned long long t);
+    virtual void frameEnd(unsigned long long t);
 
     virtual void touchOn(const Touch &);
     virtual void touchContinue(const Touch &);
@@ -60,13 +76,37 @@ public:
 
 private:
     void initDevices();
+    ICallback &deviceCallback(const std::string &name);
+    void addDevice(const std::string &name, std::shared_ptr<Device> device);
+    void stopDeviceThreads();
+    void processMerged();
+    void addToFrame(TouchFrame::State state, int touchId, float note, float x, float y, float z);
+    void flushFrame();
 
     std::vector<std::shared_ptr<Device>> devices_;
+    std::vector<std::string> deviceNames_;
+    std::vector<std::unique_ptr<DeviceThread>> deviceThreads_; // per device, null if run on api thread
+    std::vector<std::unique_ptr<DeviceThread>> directThreads_; // not started, still their device's callback
+    std::map<std::string, std::unique_ptr<DeviceThread>> pendingThreads_; // created before their device is added
     std::unique_ptr<Preferences> fileprefs_; // top level prefs on file
     std::unique_ptr<Preferences> prefs_;     // api prefs
     std::vector<ICallback *> callbacks_;
     std::vector<ISurfaceCallback *> surfaces_;
     std::vector<IMusicalCallback *> musicalsurfaces_;
+    std::vector<IFrameCallback *> frameCallbacks_;
+    TouchFrame frame_;
+
+    MsgNotifier notifier_;
+    bool pollRequired_; // a device without a queue is active
+    unsigned pollInterval_;
+
+    // device queues merged in time order, rather than processed device by device
+    bool merge_;
+    MsgMerge msgMerge_;
+    std::vector<bool> merged_;         // per device
+    std::vector<unsigned> laneDevice_; // per merge lane
+
+    std::unique_ptr<Recorder> recorder_;
 };
 
 
@@ -95,6 +135,14 @@ void MecApi::process() {
     impl_->process();
 }
 
+bool MecApi::waitAndProcess(unsigned timeoutMs) {
+    return impl_->waitAndProcess(timeoutMs);
+}
+
+void MecApi::wakeUp() {
+    impl_->wakeUp();
+}
+
 void MecApi::subscribe(ICallback *p) {
     impl_->subscribe(p);
 
@@ -122,21 +170,50 @@ void MecApi::unsubscribe(IMusicalCallback *p) {
     impl_->unsubscribe(p);
 }
 
+void MecApi::subscribe(IFrameCallback *p) {
+    impl_->subscribe(p);
+
+}
+
+void MecApi::unsubscribe(IFrameCallback *p) {
+    impl_->unsubscribe(p);
+}
+
+SurfaceHandle MecApi::surfaceHandle(const SurfaceID &id) {
+    return SurfaceManager::intern(id);
+}
+
+SurfaceID MecApi::surfaceName(SurfaceHandle handle) {
+    return SurfaceManager::name(handle);
+}
+
 
 /////////////////////////////////////////////////////////
 //MecApi_Impl
-MecApi_Impl::MecApi_Impl(void *prefs) {
+MecApi_Impl::MecApi_Impl(void *prefs) : pollRequired_(false) {
     fileprefs_.reset(new Preferences(prefs));
     prefs_.reset(new Preferences(fileprefs_->getSubTree("mec")));
+    pollInterval_ = static_cast<unsigned>(prefs_->getInt("poll interval", 5));
+    merge_ = prefs_->getBool("merge", false);
+    msgMerge_.setWindow(static_cast<unsigned>(prefs_->getInt("merge window", MsgMerge::DEFAULT_WINDOW)));
 }
 
-MecApi_Impl::MecApi_Impl(const std::string &configFile) {
+MecApi_Impl::MecApi_Impl(const std::string &configFile) : pollRequired_(false) {
     fileprefs_.reset(new Preferences(configFile));
     prefs_.reset(new Preferences(fileprefs_->getSubTree("mec")));
+    pollInterval_ = static_cast<unsigned>(prefs_->getInt("poll interval", 5));
+    merge_ = prefs_->getBool("merge", false);
+    msgMerge_.setWindow(static_cast<unsigned>(prefs_->getInt("merge window", MsgMerge::DEFAULT_WINDOW)));
 }
 
 MecApi_Impl::~MecApi_Impl() {
     LOG_1("MecApi_Impl::~MecApi_Impl");
+    if (recorder_) {
+        unsubscribe(recorder_.get());
+        recorder_->deinit();
+        recorder_.reset();
+    }
+    stopDeviceThreads();
     for (std::vector<std::shared_ptr<Device>>::iterator it = devices_.begin(); it != devices_.end(); ++it) {
         LOG_1("device deinit ");
         (*it)->deinit();
@@ -150,14 +227,96 @@ MecApi_Impl::~MecApi_Impl() {
 void MecApi_Impl::init() {
     LOG_1("MecApi_Impl::init");
     initDevices();
+    pendingThreads_.clear(); // devices which failed to init
+
+    for (unsigned i = 0; i < devices_.size(); i++) {
+        if (deviceThreads_[i] && devices_[i]->queue()) {
+            // already queued from the device's own thread, a device thread would only add a hop
+            LOG_1(deviceNames_[i] << " has its own queue, not run on a device thread");
+            deviceThreads_[i]->direct(*this);
+            directThreads_.push_back(std::move(deviceThreads_[i]));
+        }
+        DeviceThread *thread = deviceThreads_[i].get();
+        MsgQueue *queue = thread ? &thread->queue() : devices_[i]->queue();
+        if (queue) {
+            queue->setNotifier(&notifier_);
+        } else {
+            pollRequired_ = true;
+        }
+        if (thread) thread->start(devices_[i]);
+
+        // queued devices are read directly by the merge
+        merged_.push_back(merge_ && queue);
+        if (merged_[i]) {
+            msgMerge_.addQueue(queue);
+            laneDevice_.push_back(i);
+        }
+    }
+    if (merge_) {
+        LOG_1("merging " << laneDevice_.size() << " devices, window (uS) : " << msgMerge_.window());
+    }
+
+    if (prefs_->exists("recorder")) {
+        LOG_1("recorder initialise ");
+        recorder_.reset(new Recorder());
+        if (recorder_->init(prefs_->getSubTree("recorder"), deviceNames_)) {
+            subscribe(recorder_.get());
+        } else {
+            LOG_1("recorder init failed ");
+            recorder_.reset();
+        }
+    }
 }
 
 void MecApi_Impl::process() {
-    for (std::vector<std::shared_ptr<Device>>::iterator it = devices_.begin(); it != devices_.end(); ++it) {
-        (*it)->process();
+    for (unsigned i = 0; i < devices_.size(); i++) {
+        if (merged_[i]) continue;
+        if (recorder_) recorder_->setDevice(i);
+        DeviceThread *thread = deviceThreads_[i].get();
+        if (thread) {
+            thread->queue().process(*this);
+        } else {
+            devices_[i]->process();
+        }
+        // touches outside of a device frame, are sent as a frame per device
+        flushFrame();
+    }
+    if (!laneDevice_.empty()) processMerged();
+    for (std::vector<ICallback *>::iterator it = callbacks_.begin(); it != callbacks_.end(); ++it) {
+        (*it)->flush();
     }
 }
 
+void MecApi_Impl::processMerged() {
+    unsigned long long now = monotonicTimeUs();
+    MecMsg msg;
+    unsigned lane;
+    int device = -1;
+    while (msgMerge_.next(msg, lane, now)) {
+        if (static_cast<int>(laneDevice_[lane]) != device) {
+            flushFrame();
+            device = static_cast<int>(laneDevice_[lane]);
+            if (recorder_) recorder_->setDevice(static_cast<unsigned>(device));
+        }
+        MsgQueue::dispatch(msg, *this);
+    }
+    flushFrame();
+}
+
+bool MecApi_Impl::waitAndProcess(unsigned timeoutMs) {
+    // devices without queues still need to be polled periodically
+    unsigned timeout = (pollRequired_ ? std::min(timeoutMs, pollInterval_) : timeoutMs) * 1000;
+    // merged messages held for the window, are released without further notification
+    if (!laneDevice_.empty() && msgMerge_.isHolding()) timeout = std::min(timeout, msgMerge_.window());
+    bool notified = notifier_.wait(timeout);
+    process();
+    return notified;
+}
+
+void MecApi_Impl::wakeUp() {
+    notifier_.notify();
+}
+
 void MecApi_Impl::subscribe(ICallback *p) {
     callbacks_.push_back(p);
 }
@@ -198,22 +357,59 @@ void MecApi_Impl::unsubscribe(IMusicalCallback *p) {
 }
 
 
+void MecApi_Impl::subscribe(IFrameCallback *p) {
+    frameCallbacks_.push_back(p);
+}
+
+void MecApi_Impl::unsubscribe(IFrameCallback *p) {
+    for (std::vector<IFrameCallback *>::iterator it = frameCallbacks_.begin(); it != frameCallbacks_.end(); ++it) {
+        if (p == (*it)) {
+            frameCallbacks_.erase(it);
+            return;
+        }
+    }
+}
+
+
+void MecApi_Impl::addToFrame(TouchFrame::State state, int touchId, float note, float x, float y, float z) {
+    if (frameCallbacks_.empty()) return;
+
+    if (frame_.size_ == 0) frame_.startTime_ = monotonicTimeUs();
+    frame_.add(state, touchId, note, x, y, z);
+    if (frame_.isFull()) flushFrame();
+}
+
+void MecApi_Impl::flushFrame() {
+    if (frame_.size_ > 0) {
+        frame_.endTime_ = monotonicTimeUs();
+        for (std::vector<IFrameCallback *>::iterator it = frameCallbacks_.begin(); it != frameCallbacks_.end(); ++it) {
+            (*it)->frame(frame_);
+        }
+        frame_.clear();
+    }
+    frame_.deviceTime_ = 0;
+}
+
+
 void MecApi_Impl::touchOn(int touchId, float note, float x, float y, float z) {
     for (std::vector<ICallback *>::iterator it = callbacks_.begin(); it != callbacks_.end(); ++it) {
         (*it)->touchOn(touchId, note, x, y, z);
     }
+    addToFrame(TouchFrame::TOUCH_ON, touchId, note, x, y, z);
 }
 
 void MecApi_Impl::touchContinue(int touchId, float note, float x, float y, float z) {
     for (std::vector<ICallback *>::iterator it = callbacks_.begin(); it != callbacks_.end(); ++it) {
         (*it)->touchContinue(touchId, note, x, y, z);
     }
+    addToFrame(TouchFrame::TOUCH_CONTINUE, touchId, note, x, y, z);
 }
 
 void MecApi_Impl::touchOff(int touchId, float note, float x, float y, float z) {
     for (std::vector<ICallback *>::iterator it = callbacks_.begin(); it != callbacks_.end(); ++it) {
         (*it)->touchOff(touchId, note, x, y, z);
     }
+    addToFrame(TouchFrame::TOUCH_OFF, touchId, note, x, y, z);
 }
 
 void MecApi_Impl::control(int ctrlId, float v) {
@@ -228,6 +424,21 @@ void MecApi_Impl::mec_control(int cmd, void *other) {
     }
 }
 
+void MecApi_Impl::frameStart(unsigned long long t) {
+    flushFrame();
+    frame_.deviceTime_ = t;
+    for (std::vector<ICallback *>::iterator it = callbacks_.begin(); it != callbacks_.end(); ++it) {
+        (*it)->frameStart(t);
+    }
+}
+
+void MecApi_Impl::frameEnd(unsigned long long t) {
+    for (std::vector<ICallback *>::iterator it = callbacks_.begin(); it != callbacks_.end(); ++it) {
+        (*it)->frameEnd(t);
+    }
+    flushFrame();
+}
+
 
 void MecApi_Impl::touchOn(const Touch &t) {
     for (std::vector<ISurfaceCallback *>::iterator it = surfaces_.begin(); it != surfaces_.end(); ++it) {
@@ -272,6 +483,36 @@ void MecApi_Impl::touchOff(const MusicalTouch &t) {
 
 
 
+// the callback a device is created with, either the api, or if run on its own thread, that thread's queue
+ICallback &MecApi_Impl::deviceCallback(const std::string &name) {
+    Preferences prefs(prefs_->getSubTree(name));
+    if (!prefs.getBool("thread", false)) return *this;
+
+    LOG_1(name << " will run on its own thread");
+    std::unique_ptr<DeviceThread> &thread = pendingThreads_[name];
+    thread.reset(new DeviceThread(name, prefs));
+    return thread->callback();
+}
+
+void MecApi_Impl::addDevice(const std::string &name, std::shared_ptr<Device> device) {
+    devices_.push_back(device);
+    deviceNames_.push_back(name);
+    std::map<std::string, std::unique_ptr<DeviceThread>>::iterator it = pendingThreads_.find(name);
+    if (it != pendingThreads_.end()) {
+        deviceThreads_.push_back(std::move(it->second));
+        pendingThreads_.erase(it);
+    } else {
+        deviceThreads_.push_back(nullptr);
+    }
+}
+
+// must be stopped before devices are deinit
+void MecApi_Impl::stopDeviceThreads() {
+    for (std::vector<std::unique_ptr<DeviceThread>>::iterator it = deviceThreads_.begin(); it != deviceThreads_.end(); ++it) {
+        if (*it) (*it)->stop();
+    }
+}
+
 void MecApi_Impl::initDevices() {
     if (fileprefs_ == nullptr || prefs_ == nullptr) {
         LOG_1("MecApi_Impl :: invalid preferences file");
@@ -281,10 +522,10 @@ void MecApi_Impl::initDevices() {
 #if !DISABLE_EIGENHARP
     if (prefs_->exists("eigenharp")) {
         LOG_1("eigenharp initialise ");
-        std::shared_ptr<Device> device = std::make_shared<Eigenharp>(*this);
+        std::shared_ptr<Device> device = std::make_shared<Eigenharp>(deviceCallback("eigenharp"));
         if (device->init(prefs_->getSubTree("eigenharp"))) {
             if (device->isActive()) {
-                devices_.push_back(device);
+                addDevice("eigenharp", device);
             } else {
                 LOG_1("eigenharp init inactive ");
                 device->deinit();
@@ -299,10 +540,10 @@ void MecApi_Impl::initDevices() {
 #if !DISABLE_SOUNDPLANELITE
     if (prefs_->exists("soundplane")) {
         LOG_1("soundplane initialise");
-        std::shared_ptr<Device> device = std::make_shared<Soundplane>(*this);
+        std::shared_ptr<Device> device = std::make_shared<Soundplane>(deviceCallback("soundplane"));
         if (device->init(prefs_->getSubTree("soundplane"))) {
             if (device->isActive()) {
-                devices_.push_back(device);
+                addDevice("soundplane", device);
                 LOG_1("soundplane init active ");
             } else {
                 LOG_1("soundplane init inactive ");
@@ -318,11 +559,11 @@ void MecApi_Impl::initDevices() {
 #if !DISABLE_PUSH2
     if (prefs_->exists("push2")) {
         LOG_1("push2 initialise ");
-        std::shared_ptr<Push2> device = std::make_shared<Push2>(*this);
+        std::shared_ptr<Push2> device = std::make_shared<Push2>(deviceCallback("push2"));
         Kontrol::KontrolModel::model()->addCallback("push2", device);
         if (device->init(prefs_->getSubTree("push2"))) {
             if (device->isActive()) {
-                devices_.push_back(device);
+                addDevice("push2", device);
             } else {
                 LOG_1("push2 init inactive ");
                 device->deinit();
@@ -336,10 +577,10 @@ void MecApi_Impl::initDevices() {
 
     if (prefs_->exists("midi")) {
         LOG_1("midi initialise ");
-        std::shared_ptr<Device> device = std::make_shared<MidiDevice>(*this);
+        std::shared_ptr<Device> device = std::make_shared<MidiDevice>(deviceCallback("midi"));
         if (device->init(prefs_->getSubTree("midi"))) {
             if (device->isActive()) {
-                devices_.push_back(device);
+                addDevice("midi", device);
             } else {
                 LOG_1("midi init inactive ");
                 device->deinit();
@@ -353,10 +594,10 @@ void MecApi_Impl::initDevices() {
 
     if (prefs_->exists("osct3d")) {
         LOG_1("osct3d initialise ");
-        std::shared_ptr<Device> device = std::make_shared<OscT3D>(*this);
+        std::shared_ptr<Device> device = std::make_shared<OscT3D>(deviceCallback("osct3d"));
         if (device->init(prefs_->getSubTree("osct3d"))) {
             if (device->isActive()) {
-                devices_.push_back(device);
+                addDevice("osct3d", device);
             } else {
                 LOG_1("osct3d init inactive ");
                 device->deinit();
@@ -369,10 +610,10 @@ void MecApi_Impl::initDevices() {
 
     if (prefs_->exists("kontrol")) {
         LOG_1("KontrolDevice initialise ");
-        std::shared_ptr<Device> device = std::make_shared<KontrolDevice>(*this);
+        std::shared_ptr<Device> device = std::make_shared<KontrolDevice>(deviceCallback("kontrol"));
         if (device->init(prefs_->getSubTree("Kontrol"))) {
             if (device->isActive()) {
-                devices_.push_back(device);
+                addDevice("kontrol", device);
             } else {
                 LOG_1("KontrolDevice init inactive ");
                 device->deinit();
@@ -383,6 +624,22 @@ void MecApi_Impl::initDevices() {
         }
     }
 
+    if (prefs_->exists("replay")) {
+        LOG_1("replay initialise ");
+        std::shared_ptr<Device> device = std::make_shared<Replay>(deviceCallback("replay"));
+        if (device->init(prefs_->getSubTree("replay"))) {
+            if (device->isActive()) {
+                addDevice("replay", device);
+            } else {
+                LOG_1("replay init inactive ");
+                device->deinit();
+            }
+        } else {
+            LOG_1("replay init failed ");
+            device->deinit();
+        }
+    }
+
 }
 
 }
@@ -1,7 +1,9 @@
 #ifndef MEC_API_H
 #define MEC_API_H
 
+#include <cstdint>
 #include <string>
+#include <type_traits>
 
 
 namespace mec {
@@ -20,6 +22,13 @@ public:
     virtual void touchOff(int touchId, float note, float x, float y, float z) = 0;
     virtual void control(int ctrlId, float v) = 0;
     virtual void mec_control(int cmd, void* other) = 0;
+
+    // optional, marks device frame boundaries (t = device time)
+    virtual void frameStart(unsigned long long t) {};
+    virtual void frameEnd(unsigned long long t) {};
+
+    // optional, called at the end of each process, once all devices have delivered their messages
+    virtual void flush() {};
 };
 
 class Callback : public ICallback {
@@ -32,13 +41,75 @@ public:
     virtual void mec_control(int cmd, void* other) override  {};
 };
 
+// surfaces are named by SurfaceID in preferences, and interned to a SurfaceHandle when loaded
+// (see MecApi::surfaceHandle) so per touch structures can refer to a surface without copying its name
+typedef std::string SurfaceID;
+typedef uint16_t SurfaceHandle;
+
 //////////////////////////////////////////
-// new experimental surface api
+// frame api
+// an alternative to ICallback, receives all touches from a device frame in one call
+// touches are in the order they were received, laid out as arrays to allow simd processing
+// a frame is either a device frame (e.g. soundplane, t3d), or the touches from a device in one process() call
 //////////////////////////////////////////
+struct TouchFrame {
+    static const unsigned MAX_TOUCHES = 64;
 
+    enum State {
+        TOUCH_ON,
+        TOUCH_CONTINUE,
+        TOUCH_OFF
+    };
 
+    TouchFrame() : size_(0), surface_(0), deviceTime_(0), startTime_(0), endTime_(0) { ; }
 
-typedef std::string SurfaceID;
+    void clear() { size_ = 0; }
+
+    bool isFull() const { return size_ >= MAX_TOUCHES; }
+
+    void add(State state, int touchId, float note, float x, float y, float z) {
+        state_[size_] = static_cast<unsigned char>(state);
+        id_[size_] = touchId;
+        note_[size_] = note;
+        x_[size_] = x;
+        y_[size_] = y;
+        z_[size_] = z;
+        size_++;
+    }
+
+    // touch by cell position (row/column), for frames to be mapped to notes by a Scaler
+    void addCell(State state, int touchId, float r, float c, float x, float y, float z) {
+        r_[size_] = r;
+        c_[size_] = c;
+        add(state, touchId, 0.0f, x, y, z);
+    }
+
+    unsigned size_;
+    SurfaceHandle surface_;         // surface touches are on, 0 if none
+    unsigned long long deviceTime_; // as supplied by device frame, 0 if none
+    unsigned long long startTime_;  // uS, monotonic, first touch of frame received
+    unsigned long long endTime_;    // uS, monotonic, frame complete
+
+    int id_[MAX_TOUCHES];
+    float note_[MAX_TOUCHES];
+    float x_[MAX_TOUCHES];
+    float y_[MAX_TOUCHES];
+    float z_[MAX_TOUCHES];
+    float r_[MAX_TOUCHES];          // only set by addCell
+    float c_[MAX_TOUCHES];
+    unsigned char state_[MAX_TOUCHES];
+};
+
+class IFrameCallback {
+public:
+    virtual ~IFrameCallback() {};
+    virtual void frame(const TouchFrame&) = 0;
+};
+
+
+//////////////////////////////////////////
+// new experimental surface api
+//////////////////////////////////////////
 
 
 // represents a single touch on a surface
@@ -51,11 +122,10 @@ typedef std::string SurfaceID;
 // touches originate from a device, and then are passed thru surfaces to allow there coordinates to be translated.
 // a simple exampe is a device surfaces may be 'split' into 2 halfs, a 'split surface' will take the device touches and translate into touches for that
 // split... to the application these touches will be the same as if they came from different devices
+// touches are passed by value per touch, so are kept trivially copyable, nothing is allocated
 struct Touch {
-    Touch() {
-        ;
-    }
-    Touch(int id, SurfaceID surface, float x, float y, float z, float r, float c) :
+    Touch() = default;
+    Touch(int id, SurfaceHandle surface, float x, float y, float z, float r, float c) :
         id_(id), surface_(surface),
         x_(x), y_(y), z_(z),
         r_(r), c_(c) {
@@ -63,7 +133,7 @@ struct Touch {
     }
 
     int   id_;
-    SurfaceID   surface_;
+    SurfaceHandle surface_;
 
     float x_; // typically pitch axis
     float y_; // typically timbre axis
@@ -84,20 +154,36 @@ public:
 
 
 // a musical touch, is a touch that has been converted into a pitched note using a scaler
-struct MusicalTouch : public Touch {
-    MusicalTouch() {
-        ;
-    }
+// has the members of Touch, rather than deriving from it, so it remains a POD
+struct MusicalTouch {
+    MusicalTouch() = default;
 
     MusicalTouch(const Touch& t, float note) :
-        Touch(t.id_, t.surface_, t.x_, t.y_, t.z_, t.r_, t.c_),
+        id_(t.id_), surface_(t.surface_),
+        x_(t.x_), y_(t.y_), z_(t.z_),
+        r_(t.r_), c_(t.c_),
         note_(note)  {
         ;
     }
 
+    Touch touch() const { return Touch(id_, surface_, x_, y_, z_, r_, c_); }
+
+    int   id_;
+    SurfaceHandle surface_;
+
+    float x_;
+    float y_;
+    float z_;
+
+    float r_;
+    float c_;
+
     float note_;
 };
 
+static_assert(std::is_pod<Touch>::value && sizeof(Touch) <= 64, "Touch must be a POD within a cache line");
+static_assert(std::is_pod<MusicalTouch>::value && sizeof(MusicalTouch) <= 64, "MusicalTouch must be a POD within a cache line");
+
 class IMusicalCallback {
 public:
     virtual void touchOn(const MusicalTouch&) = 0;
@@ -115,6 +201,12 @@ public:
     void init();
     void process();  // periodically call to process messages
 
+    // alternative to process(), blocks until a device has messages (or timeout), then processes all devices
+    // returns false if timed out
+    bool waitAndProcess(unsigned timeoutMs);
+    // wakes a thread waiting in waitAndProcess, e.g. to stop it, can be called from any thread
+    void wakeUp();
+
     void subscribe(ICallback*);
     void unsubscribe(ICallback*);
 
@@ -124,6 +216,14 @@ public:
     void subscribe(IMusicalCallback*);
     void unsubscribe(IMusicalCallback*);
 
+    void subscribe(IFrameCallback*);
+    void unsubscribe(IFrameCallback*);
+
+    // surface names to handles, as used by Touch. handles are the same for the life of the process.
+    // surfaceHandle interns the name if not known, it locks, so look up handles up front, not per touch
+    static SurfaceHandle surfaceHandle(const SurfaceID& id);
+    static SurfaceID surfaceName(SurfaceHandle handle);
+
 private:
     MecApi_Impl* impl_;
 };
@@ -5,6 +5,8 @@
 
 namespace mec {
 
+class MsgQueue;
+
 class Device {
 public:
     virtual ~Device() {};
@@ -12,6 +14,10 @@ public:
     virtual bool process() = 0 ;
     virtual void deinit() = 0;
     virtual bool isActive() = 0;
+
+    // queue the device delivers its messages on
+    // if null, the device does its work in process(), so must be polled
+    virtual MsgQueue* queue() { return nullptr; }
 };
 
 }
@@ -0,0 +1,142 @@
+#include "mec_device_thread.h"
+
+#include "mec_log.h"
+
+namespace mec {
+
+////////////////////////////////////////////////
+void MsgQueueCallback::touchOn(int touchId, float note, float x, float y, float z) {
+    if (target_) {
+        target_->touchOn(touchId, note, x, y, z);
+        return;
+    }
+    touch(MecMsg::TOUCH_ON, touchId, note, x, y, z);
+}
+
+void MsgQueueCallback::touchContinue(int touchId, float note, float x, float y, float z) {
+    if (target_) {
+        target_->touchContinue(touchId, note, x, y, z);
+        return;
+    }
+    touch(MecMsg::TOUCH_CONTINUE, touchId, note, x, y, z);
+}
+
+void MsgQueueCallback::touchOff(int touchId, float note, float x, float y, float z) {
+    if (target_) {
+        target_->touchOff(touchId, note, x, y, z);
+        return;
+    }
+    touch(MecMsg::TOUCH_OFF, touchId, note, x, y, z);
+}
+
+void MsgQueueCallback::control(int ctrlId, float v) {
+    if (target_) {
+        target_->control(ctrlId, v);
+        return;
+    }
+    MecMsg msg;
+    msg.t_ = time_;
+    msg.type_ = MecMsg::CONTROL;
+    msg.data_.control_.controlId_ = ctrlId;
+    msg.data_.control_.value_ = v;
+    queue_.addToQueue(msg);
+}
+
+void MsgQueueCallback::mec_control(int cmd, void *other) {
+    if (target_) {
+        target_->mec_control(cmd, other);
+        return;
+    }
+    // only shutdown is carried by MecMsg
+    if (cmd != ICallback::SHUTDOWN) return;
+    MecMsg msg;
+    msg.t_ = time_;
+    msg.type_ = MecMsg::MEC_CONTROL;
+    msg.data_.mec_control_.cmd_ = MecMsg::SHUTDOWN;
+    queue_.addToQueue(msg);
+}
+
+void MsgQueueCallback::frameStart(unsigned long long t) {
+    if (target_) {
+        target_->frameStart(t);
+        return;
+    }
+    frame(MecMsg::FRAME_START, t);
+}
+
+void MsgQueueCallback::frameEnd(unsigned long long t) {
+    if (target_) {
+        target_->frameEnd(t);
+        return;
+    }
+    frame(MecMsg::FRAME_END, t);
+}
+
+void MsgQueueCallback::touch(MecMsg::type t, int touchId, float note, float x, float y, float z) {
+    MecMsg msg;
+    msg.t_ = time_;
+    msg.type_ = t;
+    msg.data_.touch_.touchId_ = touchId;
+    msg.data_.touch_.note_ = note;
+    msg.data_.touch_.x_ = x;
+    msg.data_.touch_.y_ = y;
+    msg.data_.touch_.z_ = z;
+    queue_.addToQueue(msg);
+}
+
+void MsgQueueCallback::frame(MecMsg::type t, unsigned long long time) {
+    MecMsg msg;
+    msg.t_ = time_;
+    msg.type_ = t;
+    msg.data_.frame_.t_ = time;
+    queue_.addToQueue(msg);
+}
+
+
+////////////////////////////////////////////////
+DeviceThread::DeviceThread(const std::string &name, Preferences &prefs)
+        : name_(name),
+          queue_(ringSize(prefs.getInt("queue size", MsgQueue::DEFAULT_CAPACITY), MsgQueue::DEFAULT_CAPACITY)),
+          callback_(queue_),
+          threadPrefs_(prefs),
+          interval_(static_cast<unsigned>(prefs.getInt("thread interval", DEFAULT_INTERVAL))),
+          running_(false) {
+}
+
+DeviceThread::~DeviceThread() {
+    stop();
+}
+
+void DeviceThread::start(std::shared_ptr<Device> device) {
+    stop();
+    if (device->queue()) {
+        LOG_0("DeviceThread " << name_ << " not started, device has its own queue");
+        return;
+    }
+    device_ = device;
+    running_ = true;
+    thread_ = std::thread(&DeviceThread::run, this);
+    LOG_1("DeviceThread started : " << name_);
+}
+
+void DeviceThread::stop() {
+    if (!thread_.joinable()) return;
+    running_ = false;
+    notifier_.notify();
+    thread_.join();
+    device_.reset();
+    if (queue_.overflowCount() > 0) {
+        LOG_0("DeviceThread " << name_ << " queue overflowed, msgs dropped : " << queue_.overflowCount());
+    }
+    LOG_1("DeviceThread stopped : " << name_);
+}
+
+void DeviceThread::run() {
+    threadPrefs_.apply(name_.c_str());
+    while (running_) {
+        device_->process();
+        notifier_.wait(interval_);
+    }
+}
+
+}
@@ -0,0 +1,88 @@
+#ifndef MEC_DEVICE_THREAD_H
+#define MEC_DEVICE_THREAD_H
+
+#include "mec_api.h"
+#include "mec_device.h"
+#include "mec_msg_queue.h"
+#include "mec_thread.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace mec {
+
+// an ICallback that adds each call to a queue, to be delivered on the queue's consumer thread
+// or if a target is set, passes each call straight on to it
+class MsgQueueCallback : public ICallback {
+public:
+    MsgQueueCallback(MsgQueue &q) : queue_(q), time_(0), target_(nullptr) { ; }
+
+    // time (MecMsg::t_) of the following messages, 0 for when they are queued
+    void setTime(unsigned long long t) { time_ = t; }
+    // not thread safe, set before calls are made
+    void setTarget(ICallback *cb) { target_ = cb; }
+
+    void touchOn(int touchId, float note, float x, float y, float z) override;
+    void touchContinue(int touchId, float note, float x, float y, float z) override;
+    void touchOff(int touchId, float note, float x, float y, float z) override;
+    void control(int ctrlId, float v) override;
+    void mec_control(int cmd, void *other) override;
+    void frameStart(unsigned long long t) override;
+    void frameEnd(unsigned long long t) override;
+
+private:
+    void touch(MecMsg::type t, int touchId, float note, float x, float y, float z);
+    void frame(MecMsg::type t, unsigned long long time);
+
+    MsgQueue &queue_;
+    unsigned long long time_;
+    ICallback *target_;
+};
+
+
+// runs a polled device's process() on its own thread, rather than the api thread.
+// the device is created with callback(), so its messages are queued,
+// each device thread is the single producer of its queue, the api thread the consumer.
+// a device with its own queue is already filled on its own thread, a device thread would only add a hop,
+// so it is not started, and callback() is made direct() instead.
+// preferences (in the device's section):
+//   "thread"          : true to run on its own thread
+//   "thread interval" : uS between process() calls
+//   "queue size"      : capacity of the queue to the api thread
+//   plus "thread priority", "thread cpu" (see ThreadPrefs)
+class DeviceThread {
+public:
+    static const unsigned DEFAULT_INTERVAL = 1000; // uS
+
+    DeviceThread(const std::string &name, Preferences &prefs);
+    ~DeviceThread();
+
+    ICallback &callback() { return callback_; }
+    MsgQueue &queue() { return queue_; }
+
+    // device must be created with callback(), have no queue(), and outlive the thread (i.e. stop before deinit)
+    void start(std::shared_ptr<Device> device);
+    void stop();
+
+    // instead of start(), calls on callback() go straight to cb
+    void direct(ICallback &cb) { callback_.setTarget(&cb); }
+
+private:
+    void run();
+
+    std::string name_;
+    MsgQueue queue_;
+    MsgQueueCallback callback_;
+    ThreadPrefs threadPrefs_;
+    unsigned interval_;
+    MsgNotifier notifier_;
+    std::shared_ptr<Device> device_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+};
+
+}
+
+#endif //MEC_DEVICE_THREAD_H
@@ -0,0 +1,205 @@
+#include "mec_latency.h"
+
+#include <chrono>
+#include <iomanip>
+#include <limits>
+
+namespace mec {
+
+static const uint64_t MAX_VALUE = (1ULL << LatencyHistogram::MAX_VALUE_BITS) - 1;
+
+/////////// LatencyHistogram
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+unsigned LatencyHistogram::bucketIndex(uint64_t ns) {
+    if (ns > MAX_VALUE) ns = MAX_VALUE;
+    if (ns < 2 * SUB_BUCKETS) return (unsigned) ns;
+
+    // shift so the value fits in [SUB_BUCKETS, 2 * SUB_BUCKETS), each shift is another row of sub buckets
+#if defined(__GNUC__)
+    unsigned msb = 63 - __builtin_clzll(ns);
+#else
+    unsigned msb = 0;
+    for (uint64_t v = ns; v > 1; v >>= 1) msb++;
+#endif
+    unsigned shift = msb - SUB_BUCKET_BITS;
+    return shift * SUB_BUCKETS + (unsigned) (ns >> shift);
+}
+
+uint64_t LatencyHistogram::bucketUpperValue(unsigned idx) {
+    if (idx < 2 * SUB_BUCKETS) return idx;
+    unsigned shift = idx / SUB_BUCKETS - 1;
+    uint64_t sub = idx - shift * SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    buckets_[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(ns, std::memory_order_relaxed);
+
+    uint64_t v = min_.load(std::memory_order_relaxed);
+    while (ns < v && !min_.compare_exchange_weak(v, ns, std::memory_order_relaxed)) {}
+    v = max_.load(std::memory_order_relaxed);
+    while (ns > v && !max_.compare_exchange_weak(v, ns, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (unsigned i = 0; i < BUCKETS; i++) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) return 0;
+
+    if (q < 0.0) q = 0.0;
+    if (q > 1.0) q = 1.0;
+    uint64_t target = (uint64_t) (q * total + 0.5);
+    if (target < 1) target = 1;
+
+    // buckets may be updated while we read, so never report beyond the max seen
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < BUCKETS; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t v = bucketUpperValue(i);
+            return v < max ? v : max;
+        }
+    }
+    return max;
+}
+
+LatencyHistogram::Stats LatencyHistogram::stats() const {
+    Stats s;
+    s.count_ = count();
+    if (s.count_ == 0) {
+        s.min_ = s.max_ = s.mean_ = 0;
+        s.p50_ = s.p90_ = s.p99_ = s.p999_ = 0;
+        return s;
+    }
+    s.min_ = min_.load(std::memory_order_relaxed);
+    s.max_ = max_.load(std::memory_order_relaxed);
+    s.mean_ = sum_.load(std::memory_order_relaxed) / s.count_;
+    s.p50_ = percentile(0.5);
+    s.p90_ = percentile(0.9);
+    s.p99_ = percentile(0.99);
+    s.p999_ = percentile(0.999);
+    return s;
+}
+
+
+#ifdef MEC_LATENCY_TRACE
+/////////// LatencyTrace
+
+// stamps of the message this thread is handling
+// device threads only use arrival_, the api thread uses all of them for the message being dispatched
+struct TraceContext {
+    uint64_t arrival_;
+    uint64_t dequeue_;
+    bool emitted_;
+};
+
+static LatencyHistogram histograms_[LatencyTrace::NUM_STAGES];
+static thread_local TraceContext context_;
+
+const char *LatencyTrace::stageName(Stage s) {
+    switch (s) {
+        case INPUT : return "input";
+        case QUEUE : return "queue";
+        case OUTPUT : return "output";
+        case TOTAL : return "total";
+        default: return "unknown";
+    }
+}
+
+const LatencyHistogram &LatencyTrace::histogram(Stage s) {
+    return histograms_[s];
+}
+
+void LatencyTrace::reset() {
+    for (unsigned i = 0; i < NUM_STAGES; i++) {
+        histograms_[i].reset();
+    }
+}
+
+uint64_t LatencyTrace::now() {
+    return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void LatencyTrace::arrival() {
+    TraceContext &ctx = context_;
+    ctx.arrival_ = now();
+    // if this is the api thread, the device is delivering directly, so there is no queue stage
+    ctx.dequeue_ = ctx.arrival_;
+    ctx.emitted_ = false;
+}
+
+void LatencyTrace::enqueue(MsgTrace &trace) {
+    const TraceContext &ctx = context_;
+    trace.enqueue_ = now();
+    trace.arrival_ = ctx.arrival_;
+    if (ctx.arrival_) histograms_[INPUT].record(trace.enqueue_ - ctx.arrival_);
+}
+
+void LatencyTrace::dequeue(const MsgTrace &trace) {
+    TraceContext &ctx = context_;
+    ctx.dequeue_ = now();
+    ctx.arrival_ = trace.arrival_ ? trace.arrival_ : trace.enqueue_;
+    ctx.emitted_ = false;
+    if (trace.enqueue_) histograms_[QUEUE].record(ctx.dequeue_ - trace.enqueue_);
+}
+
+void LatencyTrace::emit() {
+    TraceContext &ctx = context_;
+    // only the first output for a message, a note on is several midi messages
+    if (ctx.emitted_ || ctx.dequeue_ == 0) return;
+    ctx.emitted_ = true;
+    uint64_t t = now();
+    histograms_[OUTPUT].record(t - ctx.dequeue_);
+    if (ctx.arrival_) histograms_[TOTAL].record(t - ctx.arrival_);
+}
+
+void LatencyTrace::dump(std::ostream &os) {
+    os << "latency (us)" << std::endl;
+    os << std::left << std::setw(8) << "stage"
+       << std::right << std::setw(10) << "count"
+       << std::setw(10) << "min"
+       << std::setw(10) << "mean"
+       << std::setw(10) << "p50"
+       << std::setw(10) << "p90"
+       << std::setw(10) << "p99"
+       << std::setw(10) << "p99.9"
+       << std::setw(10) << "max" << std::endl;
+
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << std::fixed << std::setprecision(1);
+    for (unsigned i = 0; i < NUM_STAGES; i++) {
+        LatencyHistogram::Stats s = histograms_[i].stats();
+        os << std::left << std::setw(8) << stageName((Stage) i)
+           << std::right << std::setw(10) << s.count_
+           << std::setw(10) << s.min_ / 1000.0
+           << std::setw(10) << s.mean_ / 1000.0
+           << std::setw(10) << s.p50_ / 1000.0
+           << std::setw(10) << s.p90_ / 1000.0
+           << std::setw(10) << s.p99_ / 1000.0
+           << std::setw(10) << s.p999_ / 1000.0
+           << std::setw(10) << s.max_ / 1000.0 << std::endl;
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+#endif
+
+}
@@ -0,0 +1,105 @@
+#ifndef MEC_LATENCY_H
+#define MEC_LATENCY_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+namespace mec {
+
+// log-linear (HDR style) histogram of nanosecond values, fixed size, lock free.
+// values are exact below 64ns, otherwise within 1/32 (~3%) of the recorded value.
+// record() can be called from any thread, and never allocates.
+class LatencyHistogram {
+public:
+    static const unsigned SUB_BUCKET_BITS = 5;
+    static const unsigned SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const unsigned MAX_VALUE_BITS = 40; // ~18 minutes, longer values are clamped
+    static const unsigned BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    struct Stats {
+        uint64_t count_;
+        uint64_t min_, max_, mean_;
+        uint64_t p50_, p90_, p99_, p999_;
+    };
+
+    LatencyHistogram();
+
+    void record(uint64_t ns);
+    void reset();
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+    // the value that q (0..1) of recorded values are at or below
+    uint64_t percentile(double q) const;
+    Stats stats() const;
+
+    static unsigned bucketIndex(uint64_t ns);
+    static uint64_t bucketUpperValue(unsigned idx);
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKETS];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_;
+};
+
+
+// per message timestamps, carried by MecMsg when tracing is enabled (ns, monotonic)
+struct MsgTrace {
+    uint64_t arrival_;  // device received the input, 0 if device does not trace arrival
+    uint64_t enqueue_;  // added to the device queue
+};
+
+#ifdef MEC_LATENCY_TRACE
+// end to end latency tracing, built with MEC_LATENCY_TRACE, otherwise the macros below are empty
+// and messages carry no timestamps.
+// a message is stamped at each stage it passes through, and the time from the previous stage recorded:
+//   INPUT   arrival at device -> MsgQueue enqueue      (device thread)
+//   QUEUE   enqueue -> dequeue in MecApi::process      (api thread)
+//   OUTPUT  dequeue -> first midi/osc message sent     (api thread)
+//   TOTAL   arrival (or enqueue) -> first message sent
+// devices that deliver directly on the api thread (e.g. eigenharp) only record OUTPUT and TOTAL.
+class LatencyTrace {
+public:
+    enum Stage {
+        INPUT,
+        QUEUE,
+        OUTPUT,
+        TOTAL,
+        NUM_STAGES
+    };
+
+    static const char *stageName(Stage s);
+    static const LatencyHistogram &histogram(Stage s);
+    static void reset();
+    static void dump(std::ostream &os);
+
+    static uint64_t now();
+
+    // used by the MEC_TRACE macros
+    static void arrival();
+    static void enqueue(MsgTrace &);
+    static void dequeue(const MsgTrace &);
+    static void emit();
+};
+#endif
+
+}
+
+#ifdef MEC_LATENCY_TRACE
+// device has received input, messages queued by this thread until the next arrival are from it
+#define MEC_TRACE_ARRIVAL() mec::LatencyTrace::arrival()
+#define MEC_TRACE_ENQUEUE(msg) mec::LatencyTrace::enqueue((msg).trace_)
+#define MEC_TRACE_DEQUEUE(msg) mec::LatencyTrace::dequeue((msg).trace_)
+// an output has sent a message for the message being dispatched
+#define MEC_TRACE_EMIT() mec::LatencyTrace::emit()
+#else
+#define MEC_TRACE_ARRIVAL() do { } while (0)
+#define MEC_TRACE_ENQUEUE(msg) do { } while (0)
+#define MEC_TRACE_DEQUEUE(msg) do { } while (0)
+#define MEC_TRACE_EMIT() do { } while (0)
+#endif
+
+#endif //MEC_LATENCY_H
@@ -0,0 +1,165 @@
+#include "mec_mapping.h"
+
+#include "mec_log.h"
+
+#include <algorithm>
+
+namespace mec {
+
+////////////////////////////// MappingTable ////////////////////////////////////////
+
+MappingTable::MappingTable(unsigned rows, unsigned columns, unsigned resolution) :
+        rows_(rows > 0 ? rows : 1),
+        columns_(columns > 0 ? columns : 1),
+        resolution_(resolution > 0 ? resolution : 1) {
+    binsPerRow_ = columns_ * resolution_;
+    bins_.resize(rows_ * binsPerRow_);
+}
+
+
+////////////////////////////// SurfaceMapping ////////////////////////////////////////
+
+SurfaceMapping::SurfaceMapping() :
+        rows_(DEFAULT_ROWS),
+        columns_(DEFAULT_COLUMNS),
+        resolution_(DEFAULT_RESOLUTION),
+        generation_(0),
+        compileRequested_(false),
+        running_(false) {
+    ;
+}
+
+SurfaceMapping::~SurfaceMapping() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        running_ = false;
+    }
+    cond_.notify_one();
+    if (compileThread_.joinable()) compileThread_.join();
+}
+
+bool SurfaceMapping::load(const Preferences &prefs, SurfaceManager &surfaces) {
+    if (!prefs.valid()) return false;
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    source_ = prefs.getString("source", "");
+    rows_ = static_cast<unsigned>(std::max(prefs.getInt("rows", DEFAULT_ROWS), 1));
+    columns_ = static_cast<unsigned>(std::max(prefs.getInt("columns", DEFAULT_COLUMNS), 1));
+    resolution_ = static_cast<unsigned>(std::max(prefs.getInt("resolution", DEFAULT_RESOLUTION), 1));
+
+    chain_.clear();
+    Preferences::Array array(prefs.getArray("surfaces"));
+    for (int i = 0; i < array.getSize(); i++) {
+        SurfaceID id = array.getString(i);
+        std::shared_ptr<Surface> surface = surfaces.getSurface(id);
+        if (!surface) {
+            LOG_0("SurfaceMapping: unknown surface " << id);
+            return false;
+        }
+        chain_.push_back(surface);
+    }
+
+    Preferences scaler(prefs.getSubTree("scaler"));
+    if (scaler.valid()) scaler_.load(scaler);
+
+    compile();
+    LOG_1("SurfaceMapping: compiled " << chain_.size() << " surfaces, "
+                                      << rows_ << " rows, " << columns_ * resolution_ << " bins per row");
+
+    if (!compileThread_.joinable()) {
+        running_ = true;
+        compileThread_ = std::thread(&SurfaceMapping::compileProc, this);
+    }
+    return true;
+}
+
+void SurfaceMapping::setScale(const std::string &name) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    scaler_.setScale(name);
+    requestCompile();
+}
+
+void SurfaceMapping::setScale(const ScaleArray &scale) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    scaler_.setScale(scale);
+    requestCompile();
+}
+
+void SurfaceMapping::setTonic(float f) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    scaler_.setTonic(f);
+    requestCompile();
+}
+
+void SurfaceMapping::setRowOffset(float f) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    scaler_.setRowOffset(f);
+    requestCompile();
+}
+
+void SurfaceMapping::setColumnOffset(float f) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    scaler_.setColumnOffset(f);
+    requestCompile();
+}
+
+bool SurfaceMapping::setSplitPoint(const SurfaceID &id, float splitPoint) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (std::shared_ptr<Surface> &surface : chain_) {
+        SplitSurface *split = dynamic_cast<SplitSurface *>(surface.get());
+        if (split && split->getId() == id) {
+            split->setSplitPoint(splitPoint);
+            requestCompile();
+            return true;
+        }
+    }
+    return false;
+}
+
+// mtx_ must be held
+void SurfaceMapping::requestCompile() {
+    compileRequested_ = true;
+    cond_.notify_one();
+}
+
+void SurfaceMapping::compileProc() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (running_) {
+        cond_.wait(lock, [this] { return compileRequested_ || !running_; });
+        if (!running_) break;
+        // changes made while compiling, request another
+        compileRequested_ = false;
+        compile();
+    }
+}
+
+// mtx_ must be held
+// each bin is sampled at its start and middle, so a bin is exact provided the chain is linear over it
+void SurfaceMapping::compile() {
+    std::shared_ptr<MappingTable> table(new MappingTable(rows_, columns_, resolution_));
+    float binWidth = 1.0f / table->resolution_;
+
+    Touch t(0, SurfaceManager::intern(source_), 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    for (int row = 0; row < table->rows_; row++) {
+        for (int bin = 0; bin < table->binsPerRow_; bin++) {
+            float note[2];
+            for (int i = 0; i < 2; i++) {
+                Touch out = t;
+                out.r_ = static_cast<float>(row);
+                out.c_ = (bin + 0.5f * i) * binWidth;
+                for (const std::shared_ptr<Surface> &surface : chain_) {
+                    out = surface->map(out);
+                }
+                note[i] = scaler_.map(out).note_;
+            }
+            MappingTable::Bin &b = table->bins_[row * table->binsPerRow_ + bin];
+            b.base_ = note[0];
+            b.slope_ = (note[1] - note[0]) * 2.0f;
+        }
+    }
+
+    std::atomic_store(&table_, std::shared_ptr<const MappingTable>(table));
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+}
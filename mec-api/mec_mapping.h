@@ -0,0 +1,127 @@
+#ifndef MEC_MAPPING_H
+#define MEC_MAPPING_H
+
+#include "mec_api.h"
+#include "mec_prefs.h"
+#include "mec_scaler.h"
+#include "mec_surface.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// surface mapping, compiled
+//
+// a mapping is a chain of surfaces (split/join...) followed by a scaler, for touches from a source surface.
+// rather than pass each touch through the chain, the chain is evaluated when loaded (or changed),
+// into a table per row, of column bins. within a bin the chain is linear (scale steps and splits fall on bin edges)
+// so mapping a touch is one table fetch and one multiply-add, regardless of the depth of the chain.
+//
+// e.g.
+// "mapping" : {
+//     "source" : "device",
+//     "surfaces" : ["1", "2"],      applied in order, from the surfaces defined in "surfaces"
+//     "scaler" : { "scale" : "major", "tonic" : 0, "row offset" : 5, "column offset" : 0 },
+//     "rows" : 8,                   rows are whole (strings), r is truncated
+//     "columns" : 64,
+//     "resolution" : 4              bins per column, splits should fall on a bin edge
+// }
+
+namespace mec {
+
+// immutable, once built
+class MappingTable {
+public:
+    MappingTable(unsigned rows, unsigned columns, unsigned resolution);
+
+    // note for row r, column c. columns outside the table extrapolate from the first/last bin
+    inline float map(float r, float c) const {
+        int row = static_cast<int>(r);
+        row = row < 0 ? 0 : (row >= rows_ ? rows_ - 1 : row);
+        float pos = c * resolution_;
+        int bin = static_cast<int>(pos);
+        bin = bin < 0 ? 0 : (bin >= binsPerRow_ ? binsPerRow_ - 1 : bin);
+        const Bin &b = bins_[row * binsPerRow_ + bin];
+        return b.base_ + b.slope_ * (pos - bin);
+    }
+
+    unsigned getRows() const { return rows_; }
+    unsigned getColumns() const { return columns_; }
+    unsigned getResolution() const { return resolution_; }
+
+private:
+    friend class SurfaceMapping;
+
+    struct Bin {
+        float base_;    // note at the bin start
+        float slope_;   // note per bin
+    };
+
+    int rows_;
+    int columns_;
+    int resolution_;
+    int binsPerRow_;
+    std::vector<Bin> bins_;
+};
+
+
+class SurfaceMapping {
+public:
+    static const unsigned DEFAULT_ROWS = 8;
+    static const unsigned DEFAULT_COLUMNS = 64;
+    static const unsigned DEFAULT_RESOLUTION = 4;
+
+    SurfaceMapping();
+    virtual ~SurfaceMapping();
+
+    // compiles the initial table, before returning.
+    // surfaces are shared with the manager, but should only be changed through this mapping once loaded
+    bool load(const Preferences &prefs, SurfaceManager &surfaces);
+
+    // the current table, hold for a frame of touches rather than fetching for each
+    std::shared_ptr<const MappingTable> getTable() const { return std::atomic_load(&table_); }
+
+    // uses the current table, only valid once loaded
+    MusicalTouch map(const Touch &t) const { return MusicalTouch(t, getTable()->map(t.r_, t.c_)); }
+
+    // changes are compiled on a background thread, and the table swapped when complete
+    // until then getTable() returns the previous table
+    void setScale(const std::string &name);
+    void setScale(const ScaleArray &scale);
+    void setTonic(float);
+    void setRowOffset(float);
+    void setColumnOffset(float);
+    bool setSplitPoint(const SurfaceID &surface, float splitPoint);
+
+    // incremented each time a table is swapped in
+    unsigned long getGeneration() const { return generation_.load(std::memory_order_acquire); }
+
+private:
+    void compile();
+    void requestCompile();
+    void compileProc();
+
+    SurfaceID source_;
+    std::vector<std::shared_ptr<Surface>> chain_;
+    Scaler scaler_;
+    unsigned rows_;
+    unsigned columns_;
+    unsigned resolution_;
+
+    std::shared_ptr<const MappingTable> table_;
+    std::atomic<unsigned long> generation_;
+
+    // guards chain_ and scaler_, which setters change and the compile thread reads
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    bool compileRequested_;
+    bool running_;
+    std::thread compileThread_;
+};
+
+}
+
+#endif //MEC_MAPPING_H
@@ -0,0 +1,91 @@
+#include "mec_msg_merge.h"
+
+namespace mec {
+
+////////////////////////////////////////////////
+DeviceClock::DeviceClock(unsigned usPerTick) : usPerTick_(usPerTick), synced_(false), offset_(0) {
+}
+
+unsigned long long DeviceClock::hostTime(unsigned long long deviceTime) {
+    long long now = static_cast<long long>(monotonicTimeUs());
+    long long t = static_cast<long long>(deviceTime * usPerTick_);
+    long long offset = now - t;
+    if (!synced_ || offset < offset_ || offset - offset_ > RESYNC_US) {
+        offset_ = offset;
+        synced_ = true;
+    } else {
+        // allow for a slow device clock
+        offset_ += (offset - offset_) >> 10;
+    }
+    long long host = t + offset_;
+    return static_cast<unsigned long long>(host < now ? host : now);
+}
+
+
+////////////////////////////////////////////////
+MsgMerge::MsgMerge(unsigned windowUs) : window_(windowUs), frameLane_(-1) {
+}
+
+unsigned MsgMerge::addQueue(MsgQueue *queue) {
+    queue->setStampTime(true);
+    Lane lane;
+    lane.queue_ = queue;
+    lane.hasHead_ = false;
+    lane.lastT_ = 0;
+    lanes_.push_back(lane);
+    return static_cast<unsigned>(lanes_.size() - 1);
+}
+
+bool MsgMerge::fill(Lane &lane) {
+    if (lane.hasHead_) return true;
+    if (!lane.queue_->nextMsg(lane.head_)) return false;
+    if (lane.head_.t_ < lane.lastT_) lane.head_.t_ = lane.lastT_;
+    lane.lastT_ = lane.head_.t_;
+    lane.hasHead_ = true;
+    return true;
+}
+
+bool MsgMerge::take(unsigned lane, MecMsg &msg) {
+    Lane &l = lanes_[lane];
+    msg = l.head_;
+    l.hasHead_ = false;
+    if (msg.type_ == MecMsg::FRAME_START) frameLane_ = lane;
+    else if (msg.type_ == MecMsg::FRAME_END) frameLane_ = -1;
+    return true;
+}
+
+bool MsgMerge::next(MecMsg &msg, unsigned &lane, unsigned long long nowUs) {
+    if (frameLane_ >= 0) {
+        // rest of the frame, which the device will be adding shortly
+        lane = static_cast<unsigned>(frameLane_);
+        if (fill(lanes_[lane])) return take(lane, msg);
+        if (lanes_[lane].lastT_ + window_ > nowUs) return false;
+        frameLane_ = -1; // frame end lost (overflow), dont hold other devices
+    }
+
+    bool all = true;
+    int earliest = -1;
+    for (unsigned i = 0; i < lanes_.size(); i++) {
+        if (!fill(lanes_[i])) {
+            all = false;
+            continue;
+        }
+        if (earliest < 0 || lanes_[i].head_.t_ < lanes_[earliest].head_.t_) earliest = i;
+    }
+    if (earliest < 0) return false;
+
+    // an empty lane could still deliver an earlier message, until the window has passed
+    if (!all && lanes_[earliest].head_.t_ + window_ > nowUs) return false;
+
+    lane = static_cast<unsigned>(earliest);
+    return take(lane, msg);
+}
+
+bool MsgMerge::isHolding() {
+    for (unsigned i = 0; i < lanes_.size(); i++) {
+        if (lanes_[i].hasHead_) return true;
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,69 @@
+#ifndef MEC_MSG_MERGE_H
+#define MEC_MSG_MERGE_H
+
+#include "mec_msg_queue.h"
+
+#include <vector>
+
+namespace mec {
+
+// maps a device's clock onto monotonicTimeUs, so times from different devices can be compared.
+// call hostTime() as events arrive from the device. the offset between the clocks is taken from the
+// least delayed event seen, it creeps up slowly (for a device clock running slow), and is reset if
+// the device clock jumps.
+class DeviceClock {
+public:
+    static const long long RESYNC_US = 1000000;
+
+    DeviceClock(unsigned usPerTick = 1);
+
+    unsigned long long hostTime(unsigned long long deviceTime);
+
+private:
+    unsigned usPerTick_;
+    bool synced_;
+    long long offset_;
+};
+
+
+// k-way merge of device queues, messages are delivered in time (MecMsg::t_) order across devices.
+// each queue is assumed to be in time order (a message earlier than its predecessor is treated as
+// simultaneous), this is only called from the consumer thread.
+// a message is released once every queue has a later message, or it is older than the window,
+// so the window bounds both the added latency and how late a message can be and still be ordered.
+// a device frame (FRAME_START to FRAME_END) is delivered whole, not interleaved with other devices.
+class MsgMerge {
+public:
+    static const unsigned DEFAULT_WINDOW = 2000; // uS
+
+    MsgMerge(unsigned windowUs = DEFAULT_WINDOW);
+
+    unsigned addQueue(MsgQueue *queue); // returns lane, in order added, queue stamps untimed messages
+    void setWindow(unsigned windowUs) { window_ = windowUs; }
+    unsigned window() { return window_; }
+
+    // next message that can be released at nowUs, and the lane it came from
+    bool next(MecMsg &msg, unsigned &lane, unsigned long long nowUs);
+
+    // messages held, waiting for the window
+    bool isHolding();
+
+private:
+    struct Lane {
+        MsgQueue *queue_;
+        MecMsg head_;
+        bool hasHead_;
+        unsigned long long lastT_;
+    };
+
+    bool fill(Lane &lane);
+    bool take(unsigned lane, MecMsg &msg);
+
+    std::vector<Lane> lanes_;
+    unsigned window_;
+    int frameLane_; // lane whose frame is being delivered, or -1
+};
+
+}
+
+#endif //MEC_MSG_MERGE_H
@@ -3,48 +3,125 @@
 #include "mec_api.h"
 #include "mec_log.h"
 
+#include <atomic>
+#include <chrono>
+
 namespace mec {
 
-const int RING_BUFFER_SIZE = 30;
+static const unsigned CACHE_LINE_SIZE = 64;
+static const unsigned PROCESS_BATCH_SIZE = 32;
+
+unsigned long long monotonicTimeUs() {
+    return static_cast<unsigned long long>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
 
+unsigned nextPowerOf2(unsigned v) {
+    unsigned p = 1;
+    while (p < v && p < MAX_RING_SIZE) p <<= 1;
+    return p;
+}
 
+unsigned ringSize(int size, unsigned defaultSize) {
+    if (size <= 0) {
+        LOG_0("invalid buffer size " << size << ", using " << defaultSize);
+        return nextPowerOf2(defaultSize);
+    }
+    return nextPowerOf2(static_cast<unsigned>(size));
+}
+
+
+// indices are free running, and masked on access.
+// producer and consumer state are kept on separate cache lines,
+// each side keeps a local copy of the others index, so it only has
+// to touch the shared cache line when it appears full/empty
 class MsgQueue_impl {
 public:
-    MsgQueue_impl();
+    MsgQueue_impl(unsigned capacity);
     ~MsgQueue_impl();
 
     bool addToQueue(MecMsg &);
     bool nextMsg(MecMsg &);
+    unsigned drain(MecMsg *msgs, unsigned maxMsgs);
     bool isEmpty();
     bool isFull();
     int available();
     int pending();
 
+    unsigned capacity() { return mask_ + 1; }
+    unsigned long overflowCount() { return overflow_.load(std::memory_order_relaxed); }
+
 private:
-    MecMsg queue_[RING_BUFFER_SIZE];
-    // unsigned readPtr_;
-    // unsigned writePtr_;
-    volatile unsigned readPtr_;
-    volatile unsigned writePtr_;
+    char pad0_[CACHE_LINE_SIZE];
+
+    // producer
+    std::atomic<unsigned> writePtr_;
+    unsigned readCache_;
+    std::atomic<unsigned long> overflow_;
+    char pad1_[CACHE_LINE_SIZE];
+
+    // consumer
+    std::atomic<unsigned> readPtr_;
+    unsigned writeCache_;
+    char pad2_[CACHE_LINE_SIZE];
+
+    // read only
+    unsigned mask_;
+    std::unique_ptr<MecMsg[]> queue_;
 };
 
 
+/////////// Notifier
+MsgNotifier::MsgNotifier() : seq_(0), waiting_(false), lastSeq_(0) {
+}
+
+void MsgNotifier::notify() {
+    seq_.fetch_add(1);
+    if (waiting_.load()) {
+        // take lock, so we cannot notify between waiter checking seq and sleeping
+        std::lock_guard<std::mutex> lock(mtx_);
+        cond_.notify_one();
+    }
+}
+
+bool MsgNotifier::wait(unsigned timeoutUs) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    waiting_.store(true);
+    bool notified = cond_.wait_for(lock, std::chrono::microseconds(timeoutUs), [this] {
+        return seq_.load() != lastSeq_;
+    });
+    waiting_.store(false);
+    lastSeq_ = seq_.load();
+    return notified;
+}
+
+
 /////////// Public Interface
-MsgQueue::MsgQueue() {
-    impl_.reset(new MsgQueue_impl());
+MsgQueue::MsgQueue(unsigned capacity) : notifier_(nullptr), stampTime_(false) {
+    impl_.reset(new MsgQueue_impl(capacity));
 }
 
 MsgQueue::~MsgQueue() {
 }
 
 bool MsgQueue::addToQueue(MecMsg &msg) {
-    return impl_->addToQueue(msg);
+    MEC_TRACE_ENQUEUE(msg);
+    if (msg.t_ == 0 && stampTime_.load(std::memory_order_relaxed)) msg.t_ = monotonicTimeUs();
+    bool ret = impl_->addToQueue(msg);
+    MsgNotifier *n = notifier_.load(std::memory_order_relaxed);
+    if (ret && n) n->notify();
+    return ret;
 }
 
 bool MsgQueue::nextMsg(MecMsg &msg) {
     return impl_->nextMsg(msg);
 }
 
+unsigned MsgQueue::drain(MecMsg *msgs, unsigned maxMsgs) {
+    return impl_->drain(msgs, maxMsgs);
+}
+
 bool MsgQueue::isEmpty() {
     return impl_->isEmpty();
 }
@@ -61,10 +138,35 @@ int MsgQueue::pending() {
     return impl_->pending();
 }
 
+void MsgQueue::resize(unsigned capacity) {
+    if (nextPowerOf2(capacity) == impl_->capacity()) return;
+    impl_.reset(new MsgQueue_impl(capacity));
+}
+
+unsigned MsgQueue::capacity() {
+    return impl_->capacity();
+}
+
+unsigned long MsgQueue::overflowCount() {
+    return impl_->overflowCount();
+}
+
+void MsgQueue::setNotifier(MsgNotifier *n) {
+    notifier_.store(n);
+}
+
+void MsgQueue::setStampTime(bool stamp) {
+    stampTime_.store(stamp);
+}
+
 
 /////////// Implementation
-MsgQueue_impl::MsgQueue_impl() {
-    writePtr_ = readPtr_ = 0;
+MsgQueue_impl::MsgQueue_impl(unsigned capacity) :
+        writePtr_(0), readCache_(0), overflow_(0),
+        readPtr_(0), writeCache_(0) {
+    unsigned sz = nextPowerOf2(capacity < 2 ? 2 : capacity);
+    mask_ = sz - 1;
+    queue_.reset(new MecMsg[sz]);
 }
 
 MsgQueue_impl::~MsgQueue_impl() {
@@ -72,28 +174,48 @@ MsgQueue_impl::~MsgQueue_impl() {
 }
 
 bool MsgQueue_impl::addToQueue(MecMsg &msg) {
-    unsigned next = (writePtr_ + 1) % RING_BUFFER_SIZE;
-
-    if (next == readPtr_) {
-        LOG_0("MsgQueue_impl : ring buffer overflow");
-        return false;
+    unsigned w = writePtr_.load(std::memory_order_relaxed);
+
+    if (w - readCache_ > mask_) {
+        readCache_ = readPtr_.load(std::memory_order_acquire);
+        if (w - readCache_ > mask_) {
+            // dont log, this is called on device threads
+            overflow_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
     }
-    queue_[writePtr_] = msg;
-    writePtr_ = next;
+    queue_[w & mask_] = msg;
+    writePtr_.store(w + 1, std::memory_order_release);
     return true;
 }
 
 bool MsgQueue_impl::nextMsg(MecMsg &msg) {
-    if (readPtr_ != writePtr_) {
-        msg = queue_[readPtr_];
-        readPtr_ = (readPtr_ + 1) % RING_BUFFER_SIZE;
-        return true;
+    unsigned r = readPtr_.load(std::memory_order_relaxed);
+    if (r == writeCache_) {
+        writeCache_ = writePtr_.load(std::memory_order_acquire);
+        if (r == writeCache_) return false;
     }
-    return false;
+    msg = queue_[r & mask_];
+    readPtr_.store(r + 1, std::memory_order_release);
+    return true;
+}
+
+unsigned MsgQueue_impl::drain(MecMsg *msgs, unsigned maxMsgs) {
+    unsigned r = readPtr_.load(std::memory_order_relaxed);
+    writeCache_ = writePtr_.load(std::memory_order_acquire);
+    unsigned n = writeCache_ - r;
+    if (n > maxMsgs) n = maxMsgs;
+    if (n == 0) return 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        msgs[i] = queue_[(r + i) & mask_];
+    }
+    readPtr_.store(r + n, std::memory_order_release);
+    return n;
 }
 
 bool MsgQueue_impl::isEmpty() {
-    return readPtr_ == writePtr_;
+    return pending() == 0;
 }
 
 bool MsgQueue_impl::isFull() {
@@ -101,63 +223,75 @@ bool MsgQueue_impl::isFull() {
 }
 
 int MsgQueue_impl::available() {
-    return RING_BUFFER_SIZE - pending();
-
+    return capacity() - pending();
 }
 
 int MsgQueue_impl::pending() {
-    if (writePtr_ >= readPtr_) {
-        return writePtr_ - readPtr_;
-    }
-
-    return writePtr_ + RING_BUFFER_SIZE - readPtr_;
+    unsigned w = writePtr_.load(std::memory_order_acquire);
+    unsigned r = readPtr_.load(std::memory_order_acquire);
+    return w - r;
 }
 
 bool MsgQueue::process(ICallback &c) {
-    MecMsg msg;
-    while (nextMsg(msg)) {
-        switch (msg.type_) {
-            case MecMsg::TOUCH_ON:
-                c.touchOn(
-                        msg.data_.touch_.touchId_,
-                        msg.data_.touch_.note_,
-                        msg.data_.touch_.x_,
-                        msg.data_.touch_.y_,
-                        msg.data_.touch_.z_);
-                break;
-            case MecMsg::TOUCH_CONTINUE:
-                c.touchContinue(
-                        msg.data_.touch_.touchId_,
-                        msg.data_.touch_.note_,
-                        msg.data_.touch_.x_,
-                        msg.data_.touch_.y_,
-                        msg.data_.touch_.z_);
-                break;
-            case MecMsg::TOUCH_OFF:
-                c.touchOff(
-                        msg.data_.touch_.touchId_,
-                        msg.data_.touch_.note_,
-                        msg.data_.touch_.x_,
-                        msg.data_.touch_.y_,
-                        msg.data_.touch_.z_);
-                break;
-            case MecMsg::CONTROL :
-                c.control(
-                        msg.data_.control_.controlId_,
-                        msg.data_.control_.value_);
-                break;
-
-            case MecMsg::MEC_CONTROL :
-                if (msg.data_.mec_control_.cmd_ == MecMsg::SHUTDOWN) {
-                    LOG_1("posting shutdown request");
-                    c.mec_control(ICallback::SHUTDOWN, nullptr);
-                }
-            default:
-                LOG_0("MsgQueue::process unhandled message type");
+    MecMsg msgs[PROCESS_BATCH_SIZE];
+    unsigned n;
+    while ((n = drain(msgs, PROCESS_BATCH_SIZE)) > 0) {
+        for (unsigned i = 0; i < n; i++) {
+            dispatch(msgs[i], c);
         }
     }
     return true;
 }
 
+void MsgQueue::dispatch(MecMsg &msg, ICallback &c) {
+    MEC_TRACE_DEQUEUE(msg);
+    switch (msg.type_) {
+        case MecMsg::TOUCH_ON:
+            c.touchOn(
+                    msg.data_.touch_.touchId_,
+                    msg.data_.touch_.note_,
+                    msg.data_.touch_.x_,
+                    msg.data_.touch_.y_,
+                    msg.data_.touch_.z_);
+            break;
+        case MecMsg::TOUCH_CONTINUE:
+            c.touchContinue(
+                    msg.data_.touch_.touchId_,
+                    msg.data_.touch_.note_,
+                    msg.data_.touch_.x_,
+                    msg.data_.touch_.y_,
+                    msg.data_.touch_.z_);
+            break;
+        case MecMsg::TOUCH_OFF:
+            c.touchOff(
+                    msg.data_.touch_.touchId_,
+                    msg.data_.touch_.note_,
+                    msg.data_.touch_.x_,
+                    msg.data_.touch_.y_,
+                    msg.data_.touch_.z_);
+            break;
+        case MecMsg::CONTROL :
+            c.control(
+                    msg.data_.control_.controlId_,
+                    msg.data_.control_.value_);
+            break;
+
+        case MecMsg::MEC_CONTROL :
+            if (msg.data_.mec_control_.cmd_ == MecMsg::SHUTDOWN) {
+                LOG_1("posting shutdown request");
+                c.mec_control(ICallback::SHUTDOWN, nullptr);
+            }
+            break;
+        case MecMsg::FRAME_START :
+            c.frameStart(msg.data_.frame_.t_);
+            break;
+        case MecMsg::FRAME_END :
+            c.frameEnd(msg.data_.frame_.t_);
+            break;
+        default:
+            LOG_0("MsgQueue::process unhandled message type");
+    }
+}
+
 
 }
\ No newline at end of file
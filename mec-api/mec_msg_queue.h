@@ -2,18 +2,39 @@
 #define MECMSGQUEUE_H
 
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+#include "mec_latency.h"
 
 namespace mec {
 
 class ICallback;
 
+// steady clock, in uS, used for MecMsg::t_
+unsigned long long monotonicTimeUs();
+
+// largest ring buffer (MsgQueue, Recorder), in elements
+static const unsigned MAX_RING_SIZE = 1 << 20;
+
+// v rounded up to a power of 2, at most MAX_RING_SIZE
+unsigned nextPowerOf2(unsigned v);
+
+// ring buffer size from a pref, sizes <= 0 are rejected for the default, then rounded by nextPowerOf2
+unsigned ringSize(int size, unsigned defaultSize);
+
 struct MecMsg {
+    MecMsg() : t_(0) { ; }
+
     enum type {
         TOUCH_ON,
         TOUCH_CONTINUE,
         TOUCH_OFF,
         CONTROL,
-        MEC_CONTROL
+        MEC_CONTROL,
+        FRAME_START,
+        FRAME_END
     } type_;
 
     enum mec_cmd {
@@ -33,25 +54,72 @@ struct MecMsg {
         struct {
             mec_cmd cmd_;
         } mec_control_;
+        struct {
+            unsigned long long t_; // device time
+        } frame_;
     } data_;
+
+    // when the event occurred, on the monotonicTimeUs clock
+    // devices with their own clock set this (see DeviceClock), otherwise 0 is stamped with the enqueue time,
+    // on queues which need it (see MsgQueue::setStampTime)
+    unsigned long long t_;
+
+#ifdef MEC_LATENCY_TRACE
+    MsgTrace trace_; // stamped by MsgQueue
+#endif
 };
 
 class MsgQueue_impl;
 
+// allows a consumer to sleep until one of its queues has data
+// producers call notify after adding, this is cheap unless the consumer is waiting
+class MsgNotifier {
+public:
+    MsgNotifier();
+    void notify();
+    // returns true if notified, false on timeout
+    bool wait(unsigned timeoutUs);
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::atomic<unsigned long> seq_;
+    std::atomic<bool> waiting_;
+    unsigned long lastSeq_;
+};
+
+// single producer, single consumer lock-free queue
+// one (device) thread adds, one (api) thread reads
+// capacity is rounded up to a power of 2, at most MAX_RING_SIZE
 class MsgQueue {
 public:
-    MsgQueue();
+    static const unsigned DEFAULT_CAPACITY = 512;
+
+    MsgQueue(unsigned capacity = DEFAULT_CAPACITY);
     ~MsgQueue();
     bool addToQueue(MecMsg&);
     bool nextMsg(MecMsg&);
+    unsigned drain(MecMsg* msgs, unsigned maxMsgs); // read up to maxMsgs, returns number read
     bool isEmpty();
     bool isFull();
     int  available();
     int  pending();
     bool process(ICallback&);
+    static void dispatch(MecMsg&, ICallback&); // deliver a message to a callback
+
+    // not thread safe, only call before producer/consumer are started
+    void resize(unsigned capacity);
+    unsigned capacity();
+    unsigned long overflowCount(); // msgs rejected since creation
+
+    void setNotifier(MsgNotifier*);
+    // stamp messages without a time (t_ == 0) when added, for consumers ordering by time e.g. MsgMerge
+    void setStampTime(bool);
 
 private:
     std::unique_ptr<MsgQueue_impl> impl_;
+    std::atomic<MsgNotifier*> notifier_;
+    std::atomic<bool> stampTime_;
 };
 
 }
@@ -0,0 +1,269 @@
+#include "mec_recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "mec_log.h"
+#include "mec_prefs.h"
+
+namespace mec {
+
+static const char RECORDING_MAGIC[8] = "MECREC1";
+
+static uint64_t monotonicTimeNs() {
+    return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void RecordedMsg::toMsg(MecMsg &msg) const {
+    msg.type_ = static_cast<MecMsg::type>(type_);
+    switch (msg.type_) {
+        case MecMsg::TOUCH_ON:
+        case MecMsg::TOUCH_CONTINUE:
+        case MecMsg::TOUCH_OFF:
+            msg.data_.touch_.touchId_ = id_;
+            msg.data_.touch_.note_ = v_[0];
+            msg.data_.touch_.x_ = v_[1];
+            msg.data_.touch_.y_ = v_[2];
+            msg.data_.touch_.z_ = v_[3];
+            break;
+        case MecMsg::CONTROL:
+            msg.data_.control_.controlId_ = id_;
+            msg.data_.control_.value_ = v_[0];
+            break;
+        case MecMsg::MEC_CONTROL:
+            msg.data_.mec_control_.cmd_ = static_cast<MecMsg::mec_cmd>(id_);
+            break;
+        case MecMsg::FRAME_START:
+        case MecMsg::FRAME_END: {
+            uint64_t t;
+            memcpy(&t, v_, sizeof(t));
+            msg.data_.frame_.t_ = t;
+            break;
+        }
+    }
+}
+
+
+Recorder::Recorder() :
+        active_(false),
+        file_(nullptr),
+        running_(false),
+        flushInterval_(DEFAULT_FLUSH_INTERVAL),
+        mask_(0),
+        writePtr_(0),
+        readPtr_(0),
+        overflow_(0),
+        written_(0),
+        device_(0),
+        startTime_(0) {
+}
+
+Recorder::~Recorder() {
+    deinit();
+}
+
+bool Recorder::init(void *arg, const std::vector<std::string> &devices) {
+    Preferences prefs(arg);
+
+    if (active_) {
+        deinit();
+    }
+
+    std::string filename = prefs.getString("file", "mec.rec");
+    file_ = fopen(filename.c_str(), "wb");
+    if (file_ == nullptr) {
+        LOG_0("Recorder::init - unable to open " << filename);
+        return false;
+    }
+
+    // header
+    fwrite(RECORDING_MAGIC, sizeof(RECORDING_MAGIC), 1, file_);
+    uint32_t n = static_cast<uint32_t>(devices.size());
+    fwrite(&n, sizeof(n), 1, file_);
+    for (std::vector<std::string>::const_iterator it = devices.begin(); it != devices.end(); ++it) {
+        uint32_t len = static_cast<uint32_t>(it->size());
+        fwrite(&len, sizeof(len), 1, file_);
+        fwrite(it->data(), 1, len, file_);
+    }
+
+    // all allocation is done here, recording only copies into the buffer
+    unsigned sz = ringSize(prefs.getInt("buffer size", DEFAULT_BUFFER_SIZE), DEFAULT_BUFFER_SIZE);
+    buffer_.reset(new RecordedMsg[sz]);
+    mask_ = sz - 1;
+    writePtr_.store(0);
+    readPtr_.store(0);
+    overflow_.store(0);
+    written_ = 0;
+    flushInterval_ = static_cast<unsigned>(prefs.getInt("flush interval", DEFAULT_FLUSH_INTERVAL));
+
+    startTime_ = monotonicTimeNs();
+    running_ = true;
+    writeThread_ = std::thread(&Recorder::writeProc, this);
+    active_ = true;
+
+    LOG_1("Recorder::init - recording to " << filename);
+    return true;
+}
+
+void Recorder::deinit() {
+    if (!active_) return;
+
+    running_ = false;
+    writeThread_.join();
+    fclose(file_);
+    file_ = nullptr;
+    active_ = false;
+
+    LOG_1("Recorder::deinit - records written : " << written_);
+    if (overflowCount() > 0) {
+        LOG_0("Recorder::deinit - buffer overflowed, records dropped : " << overflowCount());
+    }
+}
+
+// called on the api thread, never blocks. if the writer has fallen behind the record is dropped
+void Recorder::push(RecordedMsg &rec) {
+    if (!active_) return;
+
+    unsigned w = writePtr_.load(std::memory_order_relaxed);
+    if (w - readPtr_.load(std::memory_order_acquire) > mask_) {
+        overflow_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    rec.t_ = monotonicTimeNs() - startTime_;
+    rec.device_ = device_;
+    rec.reserved_ = 0;
+    buffer_[w & mask_] = rec;
+    writePtr_.store(w + 1, std::memory_order_release);
+}
+
+void Recorder::addTouch(MecMsg::type type, int touchId, float note, float x, float y, float z) {
+    RecordedMsg rec;
+    rec.type_ = static_cast<uint8_t>(type);
+    rec.id_ = touchId;
+    rec.v_[0] = note;
+    rec.v_[1] = x;
+    rec.v_[2] = y;
+    rec.v_[3] = z;
+    push(rec);
+}
+
+void Recorder::addFrame(MecMsg::type type, unsigned long long t) {
+    RecordedMsg rec;
+    rec.type_ = static_cast<uint8_t>(type);
+    rec.id_ = 0;
+    uint64_t dt = t;
+    memcpy(rec.v_, &dt, sizeof(dt));
+    rec.v_[2] = rec.v_[3] = 0.0f;
+    push(rec);
+}
+
+void Recorder::touchOn(int touchId, float note, float x, float y, float z) {
+    addTouch(MecMsg::TOUCH_ON, touchId, note, x, y, z);
+}
+
+void Recorder::touchContinue(int touchId, float note, float x, float y, float z) {
+    addTouch(MecMsg::TOUCH_CONTINUE, touchId, note, x, y, z);
+}
+
+void Recorder::touchOff(int touchId, float note, float x, float y, float z) {
+    addTouch(MecMsg::TOUCH_OFF, touchId, note, x, y, z);
+}
+
+void Recorder::control(int ctrlId, float v) {
+    RecordedMsg rec;
+    rec.type_ = static_cast<uint8_t>(MecMsg::CONTROL);
+    rec.id_ = ctrlId;
+    rec.v_[0] = v;
+    rec.v_[1] = rec.v_[2] = rec.v_[3] = 0.0f;
+    push(rec);
+}
+
+void Recorder::mec_control(int cmd, void *) {
+    RecordedMsg rec;
+    rec.type_ = static_cast<uint8_t>(MecMsg::MEC_CONTROL);
+    rec.id_ = cmd;
+    rec.v_[0] = rec.v_[1] = rec.v_[2] = rec.v_[3] = 0.0f;
+    push(rec);
+}
+
+void Recorder::frameStart(unsigned long long t) {
+    addFrame(MecMsg::FRAME_START, t);
+}
+
+void Recorder::frameEnd(unsigned long long t) {
+    addFrame(MecMsg::FRAME_END, t);
+}
+
+void Recorder::writeProc() {
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(flushInterval_));
+        writePending();
+    }
+    // anything recorded before deinit
+    writePending();
+    fflush(file_);
+}
+
+// write pending records, in at most two contiguous runs of the buffer
+void Recorder::writePending() {
+    unsigned r = readPtr_.load(std::memory_order_relaxed);
+    unsigned w = writePtr_.load(std::memory_order_acquire);
+    while (r != w) {
+        unsigned idx = r & mask_;
+        unsigned n = std::min(w - r, mask_ + 1 - idx);
+        size_t done = fwrite(&buffer_[idx], sizeof(RecordedMsg), n, file_);
+        if (done != n) {
+            LOG_0("Recorder - write failed, records dropped : " << (w - r));
+            r = w;
+            break;
+        }
+        written_ += n;
+        r += n;
+    }
+    readPtr_.store(r, std::memory_order_release);
+}
+
+bool Recorder::load(const std::string &filename, std::vector<std::string> &devices, std::vector<RecordedMsg> &msgs) {
+    FILE *f = fopen(filename.c_str(), "rb");
+    if (f == nullptr) {
+        LOG_0("Recorder::load - unable to open " << filename);
+        return false;
+    }
+
+    bool valid = false;
+    char magic[sizeof(RECORDING_MAGIC)];
+    uint32_t n = 0;
+    if (fread(magic, sizeof(magic), 1, f) == 1
+        && memcmp(magic, RECORDING_MAGIC, sizeof(magic)) == 0
+        && fread(&n, sizeof(n), 1, f) == 1) {
+        valid = true;
+        devices.clear();
+        for (uint32_t i = 0; i < n && valid; i++) {
+            uint32_t len = 0;
+            valid = fread(&len, sizeof(len), 1, f) == 1 && len < 256;
+            if (valid) {
+                std::string name(len, ' ');
+                valid = fread(&name[0], 1, len, f) == len;
+                devices.push_back(name);
+            }
+        }
+    }
+
+    if (valid) {
+        msgs.clear();
+        RecordedMsg rec;
+        while (fread(&rec, sizeof(rec), 1, f) == 1) {
+            msgs.push_back(rec);
+        }
+    } else {
+        LOG_0("Recorder::load - not a recording " << filename);
+    }
+
+    fclose(f);
+    return valid;
+}
+
+}
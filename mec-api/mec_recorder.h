@@ -0,0 +1,89 @@
+#ifndef MEC_RECORDER_H
+#define MEC_RECORDER_H
+
+#include "mec_api.h"
+#include "mec_msg_queue.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+namespace mec {
+
+// binary recording of the messages delivered by MecApi
+// file: header, device names, then fixed size records. host byte order.
+//   char[8]  magic "MECREC1"
+//   uint32   number of devices, then for each: uint32 length, name chars
+//   RecordedMsg...
+struct RecordedMsg {
+    uint64_t t_;        // ns since recording started, monotonic
+    uint8_t type_;      // MecMsg::type
+    uint8_t device_;    // index into device names
+    uint16_t reserved_;
+    int32_t id_;        // touch id, control id, or mec control cmd
+    float v_[4];        // touch: note, x, y, z. control: value. frame: device time (uint64)
+
+    void toMsg(MecMsg &msg) const;
+};
+
+class Recorder : public ICallback {
+public:
+    static const unsigned DEFAULT_BUFFER_SIZE = 65536;  // records
+    static const unsigned DEFAULT_FLUSH_INTERVAL = 10;  // ms
+
+    Recorder();
+    virtual ~Recorder();
+
+    // starts writer thread, device names are written to header, indexed by setDevice()
+    bool init(void *prefs, const std::vector<std::string> &devices);
+    void deinit();
+    bool isActive() { return active_; }
+
+    // device whose messages are being delivered, until next call
+    void setDevice(unsigned device) { device_ = static_cast<uint8_t>(device); }
+
+    unsigned long overflowCount() { return overflow_.load(std::memory_order_relaxed); }
+
+    virtual void touchOn(int touchId, float note, float x, float y, float z) override;
+    virtual void touchContinue(int touchId, float note, float x, float y, float z) override;
+    virtual void touchOff(int touchId, float note, float x, float y, float z) override;
+    virtual void control(int ctrlId, float v) override;
+    virtual void mec_control(int cmd, void *other) override;
+    virtual void frameStart(unsigned long long t) override;
+    virtual void frameEnd(unsigned long long t) override;
+
+    // read a whole recording, false if it cannot be read or is not a recording
+    static bool load(const std::string &file, std::vector<std::string> &devices, std::vector<RecordedMsg> &msgs);
+
+private:
+    void push(RecordedMsg &rec);
+    void addTouch(MecMsg::type type, int touchId, float note, float x, float y, float z);
+    void addFrame(MecMsg::type type, unsigned long long t);
+    void writeProc();
+    void writePending();
+
+    bool active_;
+    FILE *file_;
+    std::thread writeThread_;
+    std::atomic<bool> running_;
+    unsigned flushInterval_;
+
+    // single producer (api thread), single consumer (writer thread)
+    std::unique_ptr<RecordedMsg[]> buffer_;
+    unsigned mask_;
+    std::atomic<unsigned> writePtr_;
+    std::atomic<unsigned> readPtr_;
+    std::atomic<unsigned long> overflow_;
+    unsigned long written_; // writer thread only
+
+    uint8_t device_;
+    uint64_t startTime_;
+};
+
+}
+
+#endif //MEC_RECORDER_H
@@ -1,5 +1,13 @@
 #include "mec_scaler.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MEC_SCALER_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MEC_SCALER_NEON 1
+#endif
+
 namespace mec {
 
 
@@ -86,6 +94,114 @@ MusicalTouch Scaler::map(const Touch &t) const {
     return MusicalTouch(t, note);
 }
 
+void Scaler::mapBatch(const TouchFrame &frame, float *notesOut) const {
+    const unsigned n = frame.size_;
+    const int sz = (int) scale_.size() - 1;
+    const float offset = columnOffset_ + tonic_;
+    if (sz < 1) {
+        // no scale, columns are notes
+        for (unsigned i = 0; i < n; i++) {
+            notesOut[i] = offset + frame.r_[i] * rowOffset_ + frame.c_[i];
+        }
+        return;
+    }
+
+    const float *scale = scale_.data();
+    const float octave = scale_[sz];
+    unsigned i = 0;
+
+#if defined(MEC_SCALER_SSE)
+    const __m128 vSz = _mm_set1_ps((float) sz);
+    const __m128 vInvSz = _mm_set1_ps(1.0f / sz);
+    const __m128 vOctave = _mm_set1_ps(octave);
+    const __m128 vOffset = _mm_set1_ps(offset);
+    const __m128 vRowOffset = _mm_set1_ps(rowOffset_);
+    const __m128 vOne = _mm_set1_ps(1.0f);
+    const __m128 vZero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 c = _mm_loadu_ps(frame.c_ + i);
+        __m128 r = _mm_loadu_ps(frame.r_ + i);
+        __m128 ix = _mm_cvtepi32_ps(_mm_cvttps_epi32(c));
+        __m128 fx = _mm_sub_ps(c, ix);
+
+        // octave and step in float, then correct the estimated octave by one either way
+        __m128 q = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(ix, vInvSz)));
+        __m128 step = _mm_sub_ps(ix, _mm_mul_ps(q, vSz));
+        __m128 over = _mm_cmpge_ps(step, vSz);
+        step = _mm_sub_ps(step, _mm_and_ps(over, vSz));
+        q = _mm_add_ps(q, _mm_and_ps(over, vOne));
+        __m128 under = _mm_cmplt_ps(step, vZero);
+        step = _mm_add_ps(step, _mm_and_ps(under, vSz));
+        q = _mm_sub_ps(q, _mm_and_ps(under, vOne));
+
+        // no gather in SSE2
+        int idx[4];
+        _mm_storeu_si128((__m128i *) idx, _mm_cvttps_epi32(step));
+        __m128 s0 = _mm_setr_ps(scale[idx[0]], scale[idx[1]], scale[idx[2]], scale[idx[3]]);
+        __m128 s1 = _mm_setr_ps(scale[idx[0] + 1], scale[idx[1] + 1], scale[idx[2] + 1], scale[idx[3] + 1]);
+
+        __m128 note = _mm_add_ps(s0, _mm_mul_ps(_mm_sub_ps(s1, s0), fx));
+        note = _mm_add_ps(note, _mm_mul_ps(q, vOctave));
+        note = _mm_add_ps(note, _mm_add_ps(vOffset, _mm_mul_ps(r, vRowOffset)));
+        _mm_storeu_ps(notesOut + i, note);
+    }
+#elif defined(MEC_SCALER_NEON)
+    const float32x4_t vSz = vdupq_n_f32((float) sz);
+    const float32x4_t vInvSz = vdupq_n_f32(1.0f / sz);
+    const float32x4_t vOctave = vdupq_n_f32(octave);
+    const float32x4_t vOffset = vdupq_n_f32(offset);
+    const float32x4_t vRowOffset = vdupq_n_f32(rowOffset_);
+    const float32x4_t vOne = vdupq_n_f32(1.0f);
+    const float32x4_t vZero = vdupq_n_f32(0.0f);
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t c = vld1q_f32(frame.c_ + i);
+        float32x4_t r = vld1q_f32(frame.r_ + i);
+        float32x4_t ix = vcvtq_f32_s32(vcvtq_s32_f32(c));
+        float32x4_t fx = vsubq_f32(c, ix);
+
+        // octave and step in float, then correct the estimated octave by one either way
+        float32x4_t q = vcvtq_f32_s32(vcvtq_s32_f32(vmulq_f32(ix, vInvSz)));
+        float32x4_t step = vmlsq_f32(ix, q, vSz);
+        uint32x4_t over = vcgeq_f32(step, vSz);
+        step = vbslq_f32(over, vsubq_f32(step, vSz), step);
+        q = vbslq_f32(over, vaddq_f32(q, vOne), q);
+        uint32x4_t under = vcltq_f32(step, vZero);
+        step = vbslq_f32(under, vaddq_f32(step, vSz), step);
+        q = vbslq_f32(under, vsubq_f32(q, vOne), q);
+
+        int32_t idx[4];
+        vst1q_s32(idx, vcvtq_s32_f32(step));
+        float g0[4] = {scale[idx[0]], scale[idx[1]], scale[idx[2]], scale[idx[3]]};
+        float g1[4] = {scale[idx[0] + 1], scale[idx[1] + 1], scale[idx[2] + 1], scale[idx[3] + 1]};
+        float32x4_t s0 = vld1q_f32(g0);
+        float32x4_t s1 = vld1q_f32(g1);
+
+        float32x4_t note = vmlaq_f32(s0, vsubq_f32(s1, s0), fx);
+        note = vmlaq_f32(note, q, vOctave);
+        note = vaddq_f32(note, vmlaq_f32(vOffset, r, vRowOffset));
+        vst1q_f32(notesOut + i, note);
+    }
+#endif
+
+    // remainder, same arithmetic as the vector loops
+    for (; i < n; i++) {
+        float c = frame.c_[i];
+        int ix = (int) c;
+        float fx = c - ix;
+        int q = ix / sz;
+        int step = ix - q * sz;
+        if (step < 0) {
+            step += sz;
+            q--;
+        }
+        float s0 = scale[step];
+        float s1 = scale[step + 1];
+        float note = s0 + (s1 - s0) * fx;
+        note = note + q * octave;
+        notesOut[i] = note + (offset + frame.r_[i] * rowOffset_);
+    }
+}
+
 float Scaler::getTonic() const {
     return tonic_;
 }
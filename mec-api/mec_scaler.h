@@ -56,6 +56,10 @@ public:
 
     virtual MusicalTouch map(const Touch &t) const;
 
+    // maps a frame of touches (r_/c_, see TouchFrame::addCell) to notes, notesOut must hold frame.size_
+    // 4 touches at a time with SSE2 or NEON. c is floored, so unlike map() negative columns stay within the scale
+    void mapBatch(const TouchFrame &frame, float *notesOut) const;
+
     float getTonic() const;
     float getRowOffset() const;
     float getColumnOffset() const;
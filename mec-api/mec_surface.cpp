@@ -9,6 +9,8 @@
 #include "mec_log.h"
 
 #include <algorithm>
+#include <limits>
+#include <mutex>
 
 namespace mec {
 
@@ -59,11 +61,47 @@ std::shared_ptr<Surface> SurfaceManager::getSurface(SurfaceID id) {
     return surfaces_[id];
 }
 
+// function static, as surfaces may be created during static initialisation
+struct InternedSurfaces {
+    InternedSurfaces() : names_(1, SurfaceID()) { handles_[SurfaceID()] = 0; }
+
+    std::mutex mtx_;
+    std::vector<SurfaceID> names_;
+    std::map<SurfaceID, SurfaceHandle> handles_;
+};
+
+static InternedSurfaces &internedSurfaces() {
+    static InternedSurfaces interned;
+    return interned;
+}
+
+SurfaceHandle SurfaceManager::intern(const SurfaceID &id) {
+    InternedSurfaces &interned = internedSurfaces();
+    std::lock_guard<std::mutex> lock(interned.mtx_);
+    auto i = interned.handles_.find(id);
+    if (i != interned.handles_.end()) return i->second;
+    if (interned.names_.size() > std::numeric_limits<SurfaceHandle>::max()) {
+        LOG_0("SurfaceManager::intern - too many surfaces, cannot intern " << id);
+        return 0;
+    }
+    SurfaceHandle handle = static_cast<SurfaceHandle>(interned.names_.size());
+    interned.names_.push_back(id);
+    interned.handles_[id] = handle;
+    return handle;
+}
+
+SurfaceID SurfaceManager::name(SurfaceHandle handle) {
+    InternedSurfaces &interned = internedSurfaces();
+    std::lock_guard<std::mutex> lock(interned.mtx_);
+    return handle < interned.names_.size() ? interned.names_[handle] : SurfaceID();
+}
+
 ////////////////////////////// Surface ////////////////////////////////////////
 
 
 Surface::Surface(SurfaceID surfaceId) :
-        surfaceId_(surfaceId) {
+        surfaceId_(surfaceId),
+        surfaceHandle_(SurfaceManager::intern(surfaceId)) {
     ;
 }
 
@@ -83,6 +121,10 @@ SurfaceID Surface::getId() {
     return surfaceId_;
 }
 
+SurfaceHandle Surface::getHandle() const {
+    return surfaceHandle_;
+}
+
 
 //const float UNDEFINED_SPLIT = -1.0f;
 //const float MIN_SPLIT = 0.0f;
@@ -110,7 +152,7 @@ bool SplitSurface::load(const Preferences &prefs) {
     for (unsigned i = 0; i < array.getSize(); i++) {
         SurfaceID n = array.getString(i);
         if (n.size() > 0) {
-            surfaces_.push_back(n);
+            surfaces_.push_back(SurfaceManager::intern(n));
         }
     }
 
@@ -176,6 +218,14 @@ Touch SplitSurface::map(const Touch &t) const {
     return out;
 }
 
+float SplitSurface::getSplitPoint() const {
+    return splitPoint_;
+}
+
+void SplitSurface::setSplitPoint(float f) {
+    splitPoint_ = f;
+}
+
 
 ////////////////////////////// JoinedSurface ////////////////////////////////////////
 
@@ -199,7 +249,7 @@ bool JoinedSurface::load(const Preferences &prefs) {
     for (unsigned i = 0; i < array.getSize(); i++) {
         SurfaceID n = array.getString(i);
         if (n.size() > 0) {
-            surfaces_.push_back(n);
+            surfaces_.push_back(SurfaceManager::intern(n));
         }
     }
 
@@ -226,7 +276,7 @@ Touch JoinedSurface::map(const Touch &t) const {
     // touch id, needs to be voiced on surface
     Touch out = t;
     int idx = 0;
-    for (SurfaceID n : surfaces_) {
+    for (SurfaceHandle n : surfaces_) {
         if (t.surface_ == n) {
             switch (axis_) {
                 case C_X: {
@@ -254,7 +304,7 @@ Touch JoinedSurface::map(const Touch &t) const {
                     break;
             }
 
-            out.surface_ = surfaceId_;
+            out.surface_ = surfaceHandle_;
             return out;
         }
         idx++;
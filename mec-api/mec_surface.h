@@ -26,6 +26,12 @@ public:
     bool init(const Preferences &prefs);
 
     std::shared_ptr<Surface> getSurface(SurfaceID id);
+
+    // handle for a surface name, the same for the life of the process. handle 0 is the empty name,
+    // also returned if all handles are used. locks, so intern when loading, not per touch
+    static SurfaceHandle intern(const SurfaceID &id);
+    static SurfaceID name(SurfaceHandle handle);
+
 private:
     std::map<SurfaceID, std::shared_ptr<Surface>> surfaces_;
 };
@@ -37,11 +43,13 @@ public:
     virtual ~Surface();
 
     SurfaceID getId();
+    SurfaceHandle getHandle() const;
     virtual bool load(const Preferences &prefs);
     virtual Touch map(const Touch &) const;
 
 protected:
     SurfaceID surfaceId_;
+    SurfaceHandle surfaceHandle_;
 };
 
 // simple split with even split division
@@ -53,6 +61,9 @@ public:
     virtual bool load(const Preferences &prefs) override;
     virtual Touch map(const Touch &) const override;
 
+    float getSplitPoint() const;
+    void setSplitPoint(float);
+
 private:
     enum {
         C_X,
@@ -61,7 +72,7 @@ private:
         C_R,
         C_C
     } axis_;
-    std::vector<SurfaceID> surfaces_;
+    std::vector<SurfaceHandle> surfaces_;
     float splitPoint_;
 };
 
@@ -84,7 +95,7 @@ private:
         C_R,
         C_C
     } axis_;
-    std::vector<SurfaceID> surfaces_;
+    std::vector<SurfaceHandle> surfaces_;
     float surfaceSize_;
 };
 
@@ -0,0 +1,52 @@
+#include "mec_thread.h"
+
+#include "mec_log.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <cstring>
+#endif
+
+namespace mec {
+
+ThreadPrefs::ThreadPrefs(Preferences &prefs)
+        : priority_(prefs.getInt("thread priority", 0)),
+          cpu_(prefs.getInt("thread cpu", -1)) {
+}
+
+bool ThreadPrefs::apply(const char *name) const {
+    bool ok = true;
+#ifdef __linux__
+    if (priority_ > 0) {
+        sched_param param;
+        param.sched_priority = priority_;
+        int res = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (res != 0) {
+            LOG_0(name << " unable to set thread priority " << priority_ << " : " << strerror(res));
+            ok = false;
+        } else {
+            LOG_1(name << " thread priority " << priority_);
+        }
+    }
+    if (cpu_ >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu_, &cpus);
+        int res = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (res != 0) {
+            LOG_0(name << " unable to set thread cpu " << cpu_ << " : " << strerror(res));
+            ok = false;
+        } else {
+            LOG_1(name << " thread cpu " << cpu_);
+        }
+    }
+#else
+    if (priority_ > 0 || cpu_ >= 0) {
+        LOG_1(name << " thread priority/cpu only supported on linux");
+    }
+#endif
+    return ok;
+}
+
+}
@@ -0,0 +1,31 @@
+#ifndef MEC_THREAD_H
+#define MEC_THREAD_H
+
+#include "mec_prefs.h"
+
+namespace mec {
+
+// scheduling for device threads, read from a device's preferences
+//   "thread priority" : SCHED_FIFO priority (1-99), 0 leaves the default scheduling
+//   "thread cpu"      : cpu to pin the thread to, -1 for any
+// real time priority usually needs rtprio permission (limits.conf) or root.
+// only applied on linux, elsewhere the thread is left as created.
+class ThreadPrefs {
+public:
+    ThreadPrefs() : priority_(0), cpu_(-1) { ; }
+    ThreadPrefs(Preferences &prefs);
+
+    // apply to the calling thread, returns false if any setting could not be applied
+    bool apply(const char *name) const;
+
+    int priority() const { return priority_; }
+    int cpu() const { return cpu_; }
+
+private:
+    int priority_;
+    int cpu_;
+};
+
+}
+
+#endif //MEC_THREAD_H
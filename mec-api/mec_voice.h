@@ -3,31 +3,56 @@
 
 #include <math.h>
 #include <vector>
-#include <list>
+#include <string>
 
 #include "mec_log.h"
 
 namespace mec {
 
+// voice allocation
+// all operations (other than non-oldest voice stealing) are O(1) and allocation free
+// active voices are found via a direct lookup table on the key/touch id,
+// ids outside of the table size are still supported, but fallback to a search of active voices
 class Voices {
 public:
     const float V_SCALE_AMT = 4.0f;
     const float V_CURVE_AMT = 1.0f;
 
-    Voices(unsigned voiceCount = 15, unsigned velocityCount = 5)
-            : maxVoices_(voiceCount), velocityCount_(velocityCount) {
+    static const unsigned DEFAULT_KEY_COUNT = 256; // covers all eigenharp keys, devices set their own count
+
+    enum StealPolicy {
+        STEAL_OLDEST,
+        STEAL_QUIETEST,
+        STEAL_HIGHEST,
+        STEAL_LOWEST
+    };
+
+    Voices(unsigned voiceCount = 15, unsigned velocityCount = 5, unsigned keyCount = DEFAULT_KEY_COUNT)
+            : maxVoices_(voiceCount), velocityCount_(velocityCount), stealPolicy_(STEAL_OLDEST) {
         voices_.resize(maxVoices_);
-        for (int i = 0; i < maxVoices_; i++) {
+        for (unsigned i = 0; i < maxVoices_; i++) {
             voices_[i].i_ = i;
             voices_[i].state_ = Voice::INACTIVE;
             voices_[i].id_ = -1;
-            freeVoices_.push_back(&voices_[i]);
+            voices_[i].note_ = 0.0f;
+            voices_[i].z_ = 0.0f;
+            freeVoices_.pushBack(&voices_[i]);
         }
-
+        keyVoices_.assign(keyCount, nullptr);
     };
 
     virtual ~Voices() {};
 
+    // size the key lookup table to the device's key/touch ids, allocates, so call when the device is known
+    void setKeyCount(unsigned keyCount) {
+        keyVoices_.assign(keyCount, nullptr);
+        for (Voice *voice = usedVoices_.head_; voice != nullptr; voice = voice->next_) {
+            if ((unsigned) voice->id_ < keyVoices_.size()) keyVoices_[voice->id_] = voice;
+        }
+    }
+
+    unsigned keyCount() { return static_cast<unsigned>(keyVoices_.size()); }
+
 
     struct Voice {
         int i_;
@@ -51,23 +76,30 @@ public:
             float scale_, curve_; // comes from config
             float raw_;
         } vel_;
+
+        // intrusive links, for free or used list
+        Voice *prev_;
+        Voice *next_;
     };
 
     Voice *voiceId(unsigned id) {
-        for (int i = 0; i < maxVoices_; i++) {
-            if (voices_[i].id_ == id)
-                return &voices_[i];
+        if (id < keyVoices_.size()) return keyVoices_[id];
+
+        for (Voice *voice = usedVoices_.head_; voice != nullptr; voice = voice->next_) {
+            if (voice->id_ == (int) id) return voice;
         }
         return NULL;
     }
 
+    // returns null if no voices are free, or the id already has a voice
     Voice *startVoice(unsigned id) {
-        Voice *voice;
-        if (freeVoices_.size() > 0) {
-            voice = freeVoices_.front();
-            freeVoices_.pop_front();
-        } else {
-            // all voices used, use oldestActiveVoice
+        if (voiceId(id) != nullptr) {
+            LOG_1("Voices : voice already active for " << id);
+            return NULL;
+        }
+        Voice *voice = freeVoices_.popFront();
+        if (voice == nullptr) {
+            // all voices used, use voiceToSteal
             // if you wish to steal it
             return NULL;
         }
@@ -90,7 +122,8 @@ public:
         voice->vel_.x_++;
 
 
-        usedVoices_.push_back(voice);
+        usedVoices_.pushBack(voice);
+        if (id < keyVoices_.size()) keyVoices_[id] = voice;
         return voice;
     }
 
@@ -130,8 +163,11 @@ public:
     }
 
     void stopVoice(Voice *voice) {
-        if (!voice) return;
+        if (!voice || voice->state_ == Voice::INACTIVE) return;
         usedVoices_.remove(voice);
+        if (voice->id_ >= 0 && (unsigned) voice->id_ < keyVoices_.size() && keyVoices_[voice->id_] == voice) {
+            keyVoices_[voice->id_] = nullptr;
+        }
         voice->id_ = -1;
         voice->note_ = 0;
         voice->x_ = 0;
@@ -139,20 +175,88 @@ public:
         voice->z_ = 0;
         voice->t_ = 0;
         voice->state_ = Voice::INACTIVE;
-        freeVoices_.push_back(voice);
+        freeVoices_.pushBack(voice);
     }
 
     Voice *oldestActiveVoice() {
-        return usedVoices_.front();
+        return usedVoices_.head_;
     }
 
+    // voice to steal, when no voices are free, as determined by steal policy
+    Voice *voiceToSteal() {
+        if (stealPolicy_ == STEAL_OLDEST) return usedVoices_.head_;
+
+        Voice *steal = usedVoices_.head_;
+        for (Voice *voice = usedVoices_.head_; voice != nullptr; voice = voice->next_) {
+            switch (stealPolicy_) {
+                case STEAL_QUIETEST:
+                    if (voice->z_ < steal->z_) steal = voice;
+                    break;
+                case STEAL_HIGHEST:
+                    if (voice->note_ > steal->note_) steal = voice;
+                    break;
+                case STEAL_LOWEST:
+                    if (voice->note_ < steal->note_) steal = voice;
+                    break;
+                default:
+                    break;
+            }
+        }
+        return steal;
+    }
+
+    void setStealPolicy(StealPolicy p) { stealPolicy_ = p; }
+
+    StealPolicy stealPolicy() { return stealPolicy_; }
+
+    // oldest, quietest, highest, lowest
+    static StealPolicy parseStealPolicy(const std::string &p) {
+        if (p == "quietest") return STEAL_QUIETEST;
+        if (p == "highest") return STEAL_HIGHEST;
+        if (p == "lowest") return STEAL_LOWEST;
+        return STEAL_OLDEST;
+    }
+
+    unsigned activeVoices() { return usedVoices_.size_; }
 
 private:
+    // intrusive doubly linked list of voices, oldest at head
+    struct VoiceList {
+        VoiceList() : head_(nullptr), tail_(nullptr), size_(0) { ; }
+
+        void pushBack(Voice *voice) {
+            voice->next_ = nullptr;
+            voice->prev_ = tail_;
+            if (tail_) tail_->next_ = voice; else head_ = voice;
+            tail_ = voice;
+            size_++;
+        }
+
+        Voice *popFront() {
+            Voice *voice = head_;
+            if (voice) remove(voice);
+            return voice;
+        }
+
+        void remove(Voice *voice) {
+            if (voice->prev_) voice->prev_->next_ = voice->next_; else head_ = voice->next_;
+            if (voice->next_) voice->next_->prev_ = voice->prev_; else tail_ = voice->prev_;
+            voice->prev_ = voice->next_ = nullptr;
+            size_--;
+        }
+
+        Voice *head_;
+        Voice *tail_;
+        unsigned size_;
+    };
+
     std::vector<Voice> voices_;
-    std::list<Voice *> freeVoices_;
-    std::list<Voice *> usedVoices_;
+    std::vector<Voice *> keyVoices_; // key id -> active voice
+    VoiceList freeVoices_;
+    VoiceList usedVoices_;
     unsigned maxVoices_;
     unsigned velocityCount_;
+    StealPolicy stealPolicy_;
 };
 }
 
@@ -0,0 +1,169 @@
+#include "mec_midi_coalescer.h"
+
+namespace mec {
+
+static const unsigned INITIAL_PENDING = 256;
+static const unsigned INITIAL_BUFFER = 2048;
+
+MidiCoalescer::MidiCoalescer() : runningStatus_(false), lastStatus_(0) {
+    ParamState s;
+    s.lastSentUs_ = 0;
+    s.lastValue_ = 0;
+    s.sent_ = false;
+    s.lastHires_ = false;
+    s.slot_ = -1;
+    s.seal_ = 0;
+    state_.assign(16 * NUM_PARAMS, s);
+    for (unsigned ch = 0; ch < 16; ch++) seal_[ch] = 0;
+    for (unsigned i = 0; i < NUM_RATES; i++) intervalUs_[i] = 0;
+
+    // so nothing is allocated in normal use
+    pending_.reserve(INITIAL_PENDING);
+    buffer_.reserve(INITIAL_BUFFER);
+}
+
+void MidiCoalescer::setRunningStatus(bool rs) {
+    runningStatus_ = rs;
+}
+
+void MidiCoalescer::setMaxRate(RateType type, unsigned hz) {
+    intervalUs_[type] = hz > 0 ? 1000000ULL / hz : 0;
+}
+
+unsigned long long MidiCoalescer::interval(unsigned param) const {
+    switch (param) {
+        case PITCHBEND : return intervalUs_[RATE_PITCHBEND];
+        case PRESSURE : return intervalUs_[RATE_PRESSURE];
+        default: return intervalUs_[RATE_CC];
+    }
+}
+
+void MidiCoalescer::value(unsigned ch, unsigned param, unsigned v, bool hires) {
+    ch &= 0x0F;
+    if (param >= NUM_PARAMS) return;
+    ParamState &s = state(ch, param);
+    if (param == PITCHBEND) hires = true;
+    unsigned short value = static_cast<unsigned short>(v & (hires ? 0x3FFF : 0x7F));
+
+    if (s.slot_ >= 0 && s.seal_ == seal_[ch]) {
+        // replace the pending value
+        pending_[s.slot_].value_ = value;
+        pending_[s.slot_].hires_ = hires;
+        return;
+    }
+
+    if (s.slot_ < 0 && s.sent_ && s.lastValue_ == value && s.lastHires_ == hires) return;
+
+    Pending p;
+    p.status_ = static_cast<unsigned char>(ch);
+    p.d1_ = p.d2_ = 0;
+    p.size_ = 0;
+    p.param_ = static_cast<unsigned short>(param);
+    p.value_ = value;
+    p.hires_ = hires;
+    p.forced_ = false;
+    s.slot_ = static_cast<int>(pending_.size());
+    s.seal_ = seal_[ch];
+    pending_.push_back(p);
+}
+
+void MidiCoalescer::message(unsigned char status, unsigned char d1, unsigned char d2, unsigned size) {
+    if (status < 0xF0) {
+        // pending values on this channel go before, and can no longer be replaced
+        unsigned ch = status & 0x0F;
+        for (Pending &p : pending_) {
+            if (p.size_ == 0 && p.status_ == ch) p.forced_ = true;
+        }
+        seal_[ch]++;
+    }
+
+    Pending p;
+    p.status_ = status;
+    p.d1_ = d1;
+    p.d2_ = d2;
+    p.size_ = static_cast<unsigned char>(size);
+    p.param_ = 0;
+    p.value_ = 0;
+    p.hires_ = false;
+    p.forced_ = true;
+    pending_.push_back(p);
+}
+
+unsigned MidiCoalescer::flush(unsigned long long nowUs) {
+    buffer_.clear();
+    lastStatus_ = 0; // each buffer starts with a status
+
+    unsigned held = 0;
+    for (unsigned i = 0; i < pending_.size(); i++) {
+        Pending &p = pending_[i];
+        if (p.size_ > 0) {
+            encode(p.status_, p.d1_, p.d2_, p.size_);
+            continue;
+        }
+
+        ParamState &s = state(p.status_, p.param_);
+        unsigned long long iv = interval(p.param_);
+        if (!p.forced_ && iv > 0 && s.sent_ && nowUs - s.lastSentUs_ < iv) {
+            // over rate, keep (in order) for a later flush
+            s.slot_ = static_cast<int>(held);
+            pending_[held++] = p;
+            continue;
+        }
+
+        s.slot_ = -1;
+        if (s.sent_ && s.lastValue_ == p.value_ && s.lastHires_ == p.hires_) continue; // back to the sent value
+
+        encodeValue(p);
+        s.sent_ = true;
+        s.lastValue_ = p.value_;
+        s.lastHires_ = p.hires_;
+        s.lastSentUs_ = nowUs;
+    }
+    pending_.resize(held);
+    return static_cast<unsigned>(buffer_.size());
+}
+
+void MidiCoalescer::encodeValue(const Pending &p) {
+    unsigned char ch = p.status_;
+    unsigned char lsb = static_cast<unsigned char>(p.value_ & 0x7F);
+    unsigned char msb = static_cast<unsigned char>((p.value_ >> 7) & 0x7F);
+    switch (p.param_) {
+        case PITCHBEND :
+            encode(static_cast<unsigned char>(0xE0 | ch), lsb, msb, 3);
+            break;
+        case PRESSURE :
+            if (p.hires_) {
+                encode(static_cast<unsigned char>(0xB0 | ch), HIRES_LSB_CC, lsb, 3);
+                encode(static_cast<unsigned char>(0xD0 | ch), msb, 0, 2);
+            } else {
+                encode(static_cast<unsigned char>(0xD0 | ch), lsb, 0, 2);
+            }
+            break;
+        default: {
+            unsigned char cc = static_cast<unsigned char>(p.param_);
+            unsigned char status = static_cast<unsigned char>(0xB0 | ch);
+            if (!p.hires_) {
+                encode(status, cc, lsb, 3);
+            } else if (cc < 32) {
+                encode(status, cc, msb, 3);
+                encode(status, static_cast<unsigned char>(cc + 32), lsb, 3);
+            } else {
+                encode(status, HIRES_LSB_CC, lsb, 3);
+                encode(status, cc, msb, 3);
+            }
+            break;
+        }
+    }
+}
+
+void MidiCoalescer::encode(unsigned char status, unsigned char d1, unsigned char d2, unsigned size) {
+    if (!runningStatus_ || status != lastStatus_ || status >= 0xF0) {
+        buffer_.push_back(status);
+    }
+    // system messages cancel running status
+    lastStatus_ = status < 0xF0 ? status : 0;
+    if (size > 1) buffer_.push_back(d1);
+    if (size > 2) buffer_.push_back(d2);
+}
+
+}
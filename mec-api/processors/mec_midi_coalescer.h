@@ -0,0 +1,91 @@
+#pragma once
+
+//////////////
+// collects the midi channel messages for one tick (a MecApi::process), and encodes them into one buffer
+//
+// continuous values (pitchbend, channel pressure, cc) replace a value pending for the same channel/parameter,
+// and values that have not changed since last sent are dropped.
+// each parameter type can be limited to a max rate, a value over the rate is held until its interval has passed,
+// so the last value is always sent (on a later flush).
+// note on/off (and any other message) are kept in order, values pending on their channel are sent before them,
+// regardless of rate, and later values queue after them.
+//
+// high resolution values are 14 bit, and sent as two messages
+//   cc 0-31 : msb, then lsb on cc + 32 (midi 1.0)
+//   other cc, and channel pressure : lsb on cc 87, then the msb message (mpe+)
+
+#include <vector>
+
+namespace mec {
+
+class MidiCoalescer {
+public:
+    enum Param {
+        // 0-127 are cc
+        PITCHBEND = 128,
+        PRESSURE,
+        NUM_PARAMS
+    };
+
+    enum RateType {
+        RATE_PITCHBEND,
+        RATE_PRESSURE,
+        RATE_CC,
+        NUM_RATES
+    };
+
+    static const unsigned HIRES_LSB_CC = 87;
+
+    MidiCoalescer();
+
+    void setRunningStatus(bool);
+    void setMaxRate(RateType type, unsigned hz); // 0 = unlimited
+
+    // value is 14 bit if hires (pitchbend is always 14 bit), otherwise 7 bit
+    void value(unsigned ch, unsigned param, unsigned v, bool hires = false);
+    // any other message, sent in order
+    void message(unsigned char status, unsigned char d1, unsigned char d2, unsigned size);
+
+    bool isEmpty() const { return pending_.empty(); }
+
+    // encode pending messages, other than those held by rate (nowUs, monotonic)
+    // returns the number of bytes in data(), valid until the next flush
+    unsigned flush(unsigned long long nowUs);
+    const unsigned char *data() const { return buffer_.data(); }
+
+private:
+    struct Pending {
+        unsigned char status_;  // raw message status, or channel of a value
+        unsigned char d1_;
+        unsigned char d2_;
+        unsigned char size_;    // raw message size, 0 for a value
+        unsigned short param_;
+        unsigned short value_;
+        bool hires_;
+        bool forced_;           // ignore rate, as a later message on the channel depends on it
+    };
+
+    struct ParamState {
+        unsigned long long lastSentUs_;
+        unsigned short lastValue_;
+        bool sent_;
+        bool lastHires_;
+        int slot_;              // index into pending_, -1 if none
+        unsigned seal_;         // channel seal when slotted, slot only reusable while the channel is unsealed
+    };
+
+    ParamState &state(unsigned ch, unsigned param) { return state_[(ch & 0x0F) * NUM_PARAMS + param]; }
+    unsigned long long interval(unsigned param) const;
+    void encodeValue(const Pending &p);
+    void encode(unsigned char status, unsigned char d1, unsigned char d2, unsigned size);
+
+    std::vector<ParamState> state_;
+    std::vector<Pending> pending_;
+    std::vector<unsigned char> buffer_;
+    unsigned seal_[16];
+    unsigned long long intervalUs_[NUM_RATES];
+    bool runningStatus_;
+    unsigned char lastStatus_;
+};
+
+}
@@ -1,6 +1,10 @@
 
 #include "mec_midi_processor.h"
 
+#include "../mec_latency.h"
+
+#include <chrono>
+
 //#include "mec_log.h"
 
 namespace mec {
@@ -17,6 +21,44 @@ void Midi_Processor::setPitchbendRange(float v) {
     pitchbendRange_ = v;
 }
 
+void Midi_Processor::setCoalescing(bool enable) {
+    if (!enable) {
+        coalescer_.reset();
+    } else if (!coalescer_) {
+        coalescer_.reset(new MidiCoalescer());
+    }
+}
+
+void Midi_Processor::flush() {
+    if (!coalescer_ || coalescer_->isEmpty()) return;
+
+    unsigned long long now = static_cast<unsigned long long>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+    unsigned size = coalescer_->flush(now);
+    if (size > 0) {
+        send(coalescer_->data(), size);
+        MEC_TRACE_EMIT();
+    }
+}
+
+void Midi_Processor::send(const unsigned char* data, unsigned size) {
+    unsigned char status = 0;
+    unsigned i = 0;
+    while (i < size) {
+        if (data[i] & 0x80) status = data[i++];
+        unsigned len = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 1 : 2;
+        if (status == 0 || i + len > size) break;
+        MidiMsg msg(static_cast<char>(status), static_cast<char>(data[i]));
+        if (len == 2) {
+            msg.data[2] = static_cast<char>(data[i + 1]);
+            msg.size = 3;
+        }
+        process(msg);
+        i += len;
+    }
+}
+
 /////////////////////////
 // ICallback interface
 void Midi_Processor::touchOn(int id, float note, float , float , float z) {
@@ -53,37 +95,97 @@ void Midi_Processor::mec_control(int , void* ) {
 
 bool Midi_Processor::noteOn(unsigned ch, unsigned note, unsigned vel) {
     // LOG_1( "midi note on ch " << ch << " note " << note  << " vel " << vel );
+    if (coalescer_) {
+        coalescer_->message(static_cast<unsigned char>(0x90 + ch), static_cast<unsigned char>(note), static_cast<unsigned char>(vel), 3);
+        return true;
+    }
     MidiMsg msg(static_cast<char>(0x90 + ch), static_cast<char>(note), static_cast<char>(vel));
     process(msg);
+    MEC_TRACE_EMIT();
     return true;
 }
 
 
 bool Midi_Processor::noteOff(unsigned ch, unsigned note, unsigned vel) {
     // LOG_1( "midi  note off ch " << ch << " note " << note  << " vel " << vel )
+    if (coalescer_) {
+        coalescer_->message(static_cast<unsigned char>(0x80 + ch), static_cast<unsigned char>(note), static_cast<unsigned char>(vel), 3);
+        return true;
+    }
     MidiMsg msg(static_cast<char>(0x80 + ch), static_cast<char>(note), static_cast<char>(vel));
     process(msg);
+    MEC_TRACE_EMIT();
     return true;
 }
 
 bool Midi_Processor::cc(unsigned ch, unsigned cc, unsigned v) {
     // LOG_1( "midi note off ch " << ch << " note " << note  << " vel " << vel )
+    if (coalescer_) {
+        coalescer_->value(ch, cc, v);
+        return true;
+    }
     MidiMsg msg(static_cast<char>(0xB0 + ch), static_cast<char>(cc), static_cast<char>(v));
     process(msg);
+    MEC_TRACE_EMIT();
     return true;
 }
 
 bool Midi_Processor::pressure(unsigned ch, unsigned v) {
     // LOG_1( "midi pressure ch " << ch << " v  " << v)
+    if (coalescer_) {
+        coalescer_->value(ch, MidiCoalescer::PRESSURE, v);
+        return true;
+    }
     MidiMsg msg(static_cast<char>(0xD0 + ch),static_cast<char>(v));
     process(msg);
+    MEC_TRACE_EMIT();
     return true;
 }
 
 bool Midi_Processor::pitchbend(unsigned ch, unsigned v) {
     // LOG_1( "midi pitchbend ch " << ch << " v  " << v)
+    if (coalescer_) {
+        coalescer_->value(ch, MidiCoalescer::PITCHBEND, v);
+        return true;
+    }
     MidiMsg msg(static_cast<char>(0xE0 + ch), static_cast<char>(v & 0x7f), static_cast<char>((v & 0x3F80) >> 7));
     process(msg);
+    MEC_TRACE_EMIT();
+    return true;
+}
+
+bool Midi_Processor::cc14(unsigned ch, unsigned cc, unsigned v) {
+    if (coalescer_) {
+        coalescer_->value(ch, cc, v, true);
+        return true;
+    }
+    char lsb = static_cast<char>(v & 0x7f);
+    char msb = static_cast<char>((v & 0x3F80) >> 7);
+    if (cc < 32) {
+        MidiMsg m(static_cast<char>(0xB0 + ch), static_cast<char>(cc), msb);
+        process(m);
+        MidiMsg l(static_cast<char>(0xB0 + ch), static_cast<char>(cc + 32), lsb);
+        process(l);
+    } else {
+        MidiMsg l(static_cast<char>(0xB0 + ch), static_cast<char>(MidiCoalescer::HIRES_LSB_CC), lsb);
+        process(l);
+        MidiMsg m(static_cast<char>(0xB0 + ch), static_cast<char>(cc), msb);
+        process(m);
+    }
+    MEC_TRACE_EMIT();
+    return true;
+}
+
+bool Midi_Processor::pressure14(unsigned ch, unsigned v) {
+    if (coalescer_) {
+        coalescer_->value(ch, MidiCoalescer::PRESSURE, v, true);
+        return true;
+    }
+    MidiMsg l(static_cast<char>(0xB0 + ch), static_cast<char>(MidiCoalescer::HIRES_LSB_CC), static_cast<char>(v & 0x7f));
+    process(l);
+    MidiMsg m(static_cast<char>(0xD0 + ch), static_cast<char>((v & 0x3F80) >> 7));
+    process(m);
+    MEC_TRACE_EMIT();
     return true;
 }
 
@@ -5,8 +5,10 @@
 // define the process method to determine what to do with the midi message
 
 #include "../mec_api.h"
+#include "mec_midi_coalescer.h"
 
 #include <list>
+#include <memory>
 
 namespace mec {
 
@@ -29,12 +31,21 @@ public:
     virtual void  process(MidiMsg& msg) = 0;
     void setPitchbendRange(float pbr);
 
+    // when coalescing, messages are collected until flush(), then passed to send() as one buffer
+    void setCoalescing(bool enable);
+    MidiCoalescer* getCoalescer() { return coalescer_.get(); }
+
+    // a buffer of midi messages (possibly using running status)
+    // by default split and passed to process(), override to send as one
+    virtual void send(const unsigned char* data, unsigned size);
+
     // ICallback handling
     virtual void touchOn(int touchId, float note, float x, float y, float z);
     virtual void touchContinue(int touchId, float note, float x, float y, float z);
     virtual void touchOff(int touchId, float note, float x, float y, float z);
     virtual void control(int ctrlId, float v);
     virtual void mec_control(int cmd, void* other); //ignores
+    virtual void flush();
 
 protected:
 
@@ -44,13 +55,18 @@ protected:
     bool cc(unsigned ch, unsigned cc, unsigned v);
     bool pressure(unsigned ch, unsigned v);
     bool pitchbend(unsigned ch, unsigned v);
+    // 14 bit, as two messages, see MidiCoalescer
+    bool cc14(unsigned ch, unsigned cc, unsigned v);
+    bool pressure14(unsigned ch, unsigned v);
 
     unsigned bipolar14bit(float v) {return static_cast<unsigned int>((v * 0x2000) + 0x2000);}
     unsigned bipolar7bit(float v)  {return static_cast<unsigned int>(((v / 2.0f) + 0.5f) * 127); }
     unsigned unipolar7bit(float v) {return static_cast<unsigned int>(v * 127);}
+    unsigned unipolar14bit(float v) {return static_cast<unsigned int>(v * 0x3FFF);}
 
     float global_[127];
     float pitchbendRange_;
+    std::unique_ptr<MidiCoalescer> coalescer_;
 };
 
 }
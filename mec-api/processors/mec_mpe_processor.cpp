@@ -7,7 +7,7 @@ namespace mec {
 
 #define TIMBRE_CC 74
 
-MPE_Processor::MPE_Processor(float pbr) : Midi_Processor(pbr) {
+MPE_Processor::MPE_Processor(float pbr) : Midi_Processor(pbr), hires_(false) {
     ;
 }
 
@@ -28,7 +28,7 @@ void MPE_Processor::touchOn(int id, float note, float x, float y, float z) {
     int pb = bipolar14bit(semis / pitchbendRange_);
 
     unsigned mx = bipolar14bit(x);
-    int my = bipolar7bit(y);
+    int my = hires_ ? bipolar14bit(y) : bipolar7bit(y);
     int mz = unipolar7bit(z);
 
     // LOG_1("MPE_Processor::touchOn");
@@ -38,7 +38,7 @@ void MPE_Processor::touchOn(int id, float note, float x, float y, float z) {
     // LOG_1("   z :" << z << " mz: " << mz);
 
     pitchbend(ch, pb);
-    cc(ch, TIMBRE_CC,  my);
+    timbre(ch, my);
     noteOn(ch, voice.startNote_, mz);
 
     voice.note_ = voice.startNote_;
@@ -46,7 +46,8 @@ void MPE_Processor::touchOn(int id, float note, float x, float y, float z) {
     voice.timbre_ = my;
 
     // start with zero z, as we use intial z of velocity
-    pressure(ch, 0.0f);
+    if (hires_) pressure14(ch, 0);
+    else pressure(ch, 0);
     voice.pressure_ = 0.0f;
 }
 
@@ -55,8 +56,8 @@ void MPE_Processor::touchContinue(int id, float note, float x, float y, float z)
     VoiceData& voice = voices_[id];
     unsigned ch = id + 1; // MPE starts on 2
     // unsigned mx = bipolar14bit(x);
-    int my = bipolar7bit(y);
-    unsigned mz = unipolar7bit(z);
+    int my = hires_ ? bipolar14bit(y) : bipolar7bit(y);
+    unsigned mz = hires_ ? unipolar14bit(z) : unipolar7bit(z);
 
     float semis = note - float(voice.startNote_);
     int pb = bipolar14bit(semis / pitchbendRange_);
@@ -76,11 +77,12 @@ void MPE_Processor::touchContinue(int id, float note, float x, float y, float z)
     }
     if (voice.timbre_ != my) {
         voice.timbre_ = my;
-        cc(ch, TIMBRE_CC, my);
+        timbre(ch, my);
     }
     if (voice.pressure_ != mz) {
         voice.pressure_ = mz;
-        pressure(ch, mz);
+        if (hires_) pressure14(ch, mz);
+        else pressure(ch, mz);
     }
 }
 
@@ -90,7 +92,8 @@ void MPE_Processor::touchOff(int id, float note, float x, float y, float z) {
 
     unsigned ch = id + 1; // MPE starts on 2
     unsigned vel = 0.0f; // last vel = release velocity
-    pressure(ch, 0.0f);
+    if (hires_) pressure14(ch, 0);
+    else pressure(ch, 0);
     noteOff(ch, voice.startNote_ , vel);
 
     voice.startNote_ = 0;
@@ -100,6 +103,11 @@ void MPE_Processor::touchOff(int id, float note, float x, float y, float z) {
     voice.pressure_ = 0.0f;//
 }
 
+void MPE_Processor::timbre(unsigned ch, unsigned v) {
+    if (hires_) cc14(ch, TIMBRE_CC, v > 0x3FFF ? 0x3FFF : v);
+    else cc(ch, TIMBRE_CC, v);
+}
+
 void MPE_Processor::control(int attr, float v) {
 
     if (global_[attr] != v ) {
@@ -16,6 +16,9 @@ public:
 
     virtual void  process(MidiMsg& msg) = 0;
 
+    // 14 bit timbre and pressure (mpe+), see MidiCoalescer
+    void setHighResolution(bool hires) { hires_ = hires; }
+
     // ICallback handling
     virtual void touchOn(int touchId, float note, float x, float y, float z);
     virtual void touchContinue(int touchId, float note, float x, float y, float z);
@@ -24,6 +27,7 @@ public:
     virtual void mec_control(int cmd, void* other); //ignores
 
 private:
+    void timbre(unsigned ch, unsigned v);
 
     struct VoiceData {
         unsigned    startNote_;
@@ -34,6 +38,7 @@ private:
     };
 
     VoiceData voices_[16];
+    bool hires_;
 };
 
 }
@@ -0,0 +1,151 @@
+#include <mec_api.h>
+#include <mec_msg_queue.h>
+#include <mec_log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// benchmark MsgQueue, against the previous 30 slot ring buffer
+// one producer thread, one consumer thread (as with devices)
+// reports msgs/sec and p99 enqueue latency
+
+static const unsigned NUM_MSGS = 1000000;
+
+// original implementation, kept for comparison
+class LegacyMsgQueue {
+public:
+    LegacyMsgQueue() : readPtr_(0), writePtr_(0) { ; }
+
+    bool addToQueue(mec::MecMsg &msg) {
+        unsigned next = (writePtr_ + 1) % SIZE;
+        if (next == readPtr_) return false;
+        queue_[writePtr_] = msg;
+        writePtr_ = next;
+        return true;
+    }
+
+    bool nextMsg(mec::MecMsg &msg) {
+        if (readPtr_ != writePtr_) {
+            msg = queue_[readPtr_];
+            readPtr_ = (readPtr_ + 1) % SIZE;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    static const unsigned SIZE = 30;
+    mec::MecMsg queue_[SIZE];
+    volatile unsigned readPtr_;
+    volatile unsigned writePtr_;
+};
+
+class NewMsgQueue {
+public:
+    NewMsgQueue(unsigned capacity) : queue_(capacity) { ; }
+
+    bool addToQueue(mec::MecMsg &msg) { return queue_.addToQueue(msg); }
+
+    unsigned drain(mec::MecMsg *msgs, unsigned max) { return queue_.drain(msgs, max); }
+
+    unsigned long overflowCount() { return queue_.overflowCount(); }
+
+private:
+    mec::MsgQueue queue_;
+};
+
+
+template<typename Q>
+unsigned consume(Q &q, mec::MecMsg *msgs, unsigned) {
+    return q.nextMsg(msgs[0]) ? 1 : 0;
+}
+
+template<>
+unsigned consume(NewMsgQueue &q, mec::MecMsg *msgs, unsigned max) {
+    return q.drain(msgs, max);
+}
+
+template<typename Q>
+void runBench(const char *name, Q &q) {
+    typedef std::chrono::steady_clock clock;
+    std::vector<unsigned> latency;
+    latency.reserve(NUM_MSGS);
+    std::atomic<bool> done(false);
+    unsigned long received = 0;
+    unsigned long retries = 0;
+
+    std::thread consumer([&]() {
+        mec::MecMsg msgs[64];
+        float sum = 0.0f;
+        while (!done || received < NUM_MSGS) {
+            unsigned n = consume(q, msgs, 64);
+            if (n == 0) std::this_thread::yield();
+            for (unsigned i = 0; i < n; i++) sum += msgs[i].data_.touch_.z_;
+            received += n;
+        }
+        if (sum < 0.0f) LOG_0("");
+    });
+
+    clock::time_point start = clock::now();
+    for (unsigned i = 0; i < NUM_MSGS; i++) {
+        mec::MecMsg msg;
+        msg.type_ = mec::MecMsg::TOUCH_CONTINUE;
+        msg.data_.touch_.touchId_ = i % 16;
+        msg.data_.touch_.note_ = 60.0f;
+        msg.data_.touch_.x_ = 0.0f;
+        msg.data_.touch_.y_ = 0.0f;
+        msg.data_.touch_.z_ = 1.0f;
+
+        for (;;) {
+            clock::time_point t0 = clock::now();
+            bool ok = q.addToQueue(msg);
+            clock::time_point t1 = clock::now();
+            if (ok) {
+                latency.push_back(
+                        static_cast<unsigned>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+                break;
+            }
+            retries++;
+            std::this_thread::yield();
+        }
+    }
+    done = true;
+    consumer.join();
+    clock::time_point end = clock::now();
+
+    double secs = std::chrono::duration<double>(end - start).count();
+    std::sort(latency.begin(), latency.end());
+    unsigned p50 = latency[latency.size() / 2];
+    unsigned p99 = latency[(latency.size() * 99) / 100];
+
+    std::cout << name
+              << " msgs/sec: " << static_cast<unsigned long>(NUM_MSGS / secs)
+              << " enqueue p50: " << p50 << "ns"
+              << " p99: " << p99 << "ns"
+              << " full retries: " << retries
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    LOG_0("benchmark started");
+
+    {
+        LegacyMsgQueue q;
+        runBench("legacy (30)  ", q);
+    }
+    {
+        NewMsgQueue q(mec::MsgQueue::DEFAULT_CAPACITY);
+        runBench("spsc (512)   ", q);
+    }
+    {
+        NewMsgQueue q(4096);
+        runBench("spsc (4096)  ", q);
+    }
+
+    LOG_0("benchmark completed");
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <push2lib/push2lib.h>
+#include <push2lib/push1font.h>
+#include <mec_log.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// benchmark a full screen redraw of the push2 parameter page (as P2_ParamMode::displayPage)
+// pages, 3 rows of parameters and modules, 8 cells of 24 chars each, reports us per redraw (best of runs)
+//   per pixel : drawing from the font image per pixel, as push2lib did before the glyph cache
+//   glyphs    : Push2::drawCell8, copying rows from the glyph cache
+// no device is opened, only drawing is measured
+
+static const unsigned VSCALE = 3;
+static const unsigned HSCALE = 1;
+static const unsigned REDRAWS = 200;
+static const unsigned RUNS = 5;
+static const unsigned ROWS[] = {0, 1, 2, 3, 5};
+
+static const unsigned F_HEIGHT = 8;
+static const unsigned F_WIDTH = 5;
+
+static const uint16_t clrs[8] = {
+        RGB565(0xFF, 0x00, 0x00), RGB565(0x00, 0xFF, 0x00), RGB565(0x00, 0x00, 0xFF), RGB565(0xFF, 0xFF, 0x00),
+        RGB565(0xFF, 0x00, 0xFF), RGB565(0x00, 0xFF, 0xFF), RGB565(0xFF, 0xFF, 0xFF), MONO_CLR
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static uint16_t frame[DATA_PKT_SZ / 2];
+
+// the previous push2lib drawText (monochrome)
+static void perPixelDrawText(unsigned row, unsigned col, const char *str, unsigned ln,
+                             unsigned vscale, unsigned hscale, uint16_t colour) {
+    unsigned CH_COLS = (WIDTH / F_WIDTH) / hscale;
+    unsigned len = col + ln < CH_COLS ? ln : CH_COLS - col;
+    for (unsigned i = 0; i < len; i++) {
+        unsigned c = col + i;
+        int ch = str[i];
+        for (unsigned line = 0; line < F_HEIGHT; line++) {
+            int prow = ch / (GIMP_IMAGE_WIDTH / F_WIDTH);
+            int pchar = ch % (GIMP_IMAGE_WIDTH / F_WIDTH);
+            int pline = ((prow * F_HEIGHT) + line) * (GIMP_IMAGE_WIDTH * GIMP_IMAGE_BYTES_PER_PIXEL);
+            for (unsigned vs = 0; vs < vscale; vs++) {
+                unsigned bl = (((((row * F_HEIGHT) + line)) * vscale) + vs) * (LINE / 2);
+                for (unsigned pix = 0; pix < F_WIDTH; pix++) {
+                    int poffset = (pline) + (((pchar * F_WIDTH) + pix) * GIMP_IMAGE_BYTES_PER_PIXEL);
+                    uint16_t clr = GIMP_IMAGE_PIXEL_DATA[poffset] ? colour : 0;
+                    for (unsigned hs = 0; hs < hscale; hs++) {
+                        unsigned bpos = bl + ((((c * F_WIDTH) + pix) * hscale) + hs);
+                        if (bpos < (DATA_PKT_SZ / 2)) frame[bpos] = clr;
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    LOG_0("benchmark started");
+
+    const char *text = "  Cutoff Frequency 1234 ";
+    const unsigned len = static_cast<unsigned>(strlen(text));
+    const unsigned CELL_COLS = ((WIDTH / F_WIDTH) / HSCALE) / 8;
+
+    Push2API::Push2 push2;
+
+    double bestPixel = 1e18, bestGlyph = 1e18;
+    for (unsigned run = 0; run < RUNS; run++) {
+        Clock::time_point start = Clock::now();
+        for (unsigned n = 0; n < REDRAWS; n++) {
+            memset(frame, 0, DATA_PKT_SZ);
+            for (unsigned row : ROWS) {
+                for (unsigned cell = 0; cell < 8; cell++) {
+                    perPixelDrawText(row, CELL_COLS * cell, text, len, VSCALE, HSCALE, clrs[cell]);
+                }
+            }
+        }
+        bestPixel = std::min(bestPixel, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+        start = Clock::now();
+        for (unsigned n = 0; n < REDRAWS; n++) {
+            push2.clearDisplay();
+            for (unsigned row : ROWS) {
+                for (unsigned cell = 0; cell < 8; cell++) {
+                    push2.drawCell8(row, cell, text, VSCALE, HSCALE, clrs[cell]);
+                }
+            }
+        }
+        bestGlyph = std::min(bestGlyph, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+
+    std::cout << "per pixel us/redraw: " << bestPixel / REDRAWS << std::endl;
+    std::cout << "glyphs    us/redraw: " << bestGlyph / REDRAWS << std::endl;
+    std::cout << "speedup: " << bestPixel / bestGlyph << std::endl;
+
+    LOG_0("benchmark completed");
+    return 0;
+}
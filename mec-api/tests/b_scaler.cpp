@@ -0,0 +1,95 @@
+#include <mec_api.h>
+#include <mec_scaler.h>
+#include <mec_surface.h>
+#include <mec_log.h>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// benchmark Scaler::mapBatch against mapping each touch through the virtual Scaler::map
+// 4 devices, each sending frames of 16 touches at 1kHz, for 10 (simulated) seconds
+// reports ns/touch, and cpu time per second of device input (best of runs)
+
+static const unsigned NUM_DEVICES = 4;
+static const unsigned TOUCHES_PER_FRAME = 16;
+static const unsigned FRAMES_PER_SECOND = 1000;
+static const unsigned SECONDS = 10;
+static const unsigned RUNS = 5;
+
+static const unsigned NUM_FRAMES = NUM_DEVICES * FRAMES_PER_SECOND * SECONDS;
+static const unsigned NUM_TOUCHES = NUM_FRAMES * TOUCHES_PER_FRAME;
+
+typedef std::chrono::steady_clock Clock;
+
+static void report(const char *name, double bestNs, float check) {
+    std::cout << name
+              << " ns/touch: " << bestNs / NUM_TOUCHES
+              << " us per second of input: " << bestNs / SECONDS / 1000.0
+              << " (" << check << ")"
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    LOG_0("benchmark started");
+
+    std::vector<float> scale = {0.0f, 2.0f, 4.0f, 5.0f, 7.0f, 9.0f, 11.0f, 12.0f};
+    mec::Scaler scaler;
+    scaler.setScale(scale);
+    scaler.setRowOffset(5.0f);
+    scaler.setColumnOffset(0.5f);
+    scaler.setTonic(36.0f);
+
+    // as a device frame, touches moving over 8 rows of 30 columns
+    std::vector<mec::TouchFrame> frames(NUM_DEVICES);
+    const char *devices[NUM_DEVICES] = {"soundplane", "eigenharp", "t3d", "midi"};
+    for (unsigned d = 0; d < NUM_DEVICES; d++) {
+        frames[d].surface_ = mec::SurfaceManager::intern(devices[d]);
+        for (unsigned i = 0; i < TOUCHES_PER_FRAME; i++) {
+            frames[d].addCell(mec::TouchFrame::TOUCH_CONTINUE, i, (float) (i % 8), 0.0f, 0.0f, 0.0f, 0.5f);
+        }
+    }
+
+    // through the base class, so map() stays a virtual call
+    const mec::Scaler &virtualScaler = scaler;
+
+    double bestScalar = 1e18, bestBatch = 1e18;
+    float checkScalar = 0.0f, checkBatch = 0.0f;
+    float notes[mec::TouchFrame::MAX_TOUCHES];
+
+    for (unsigned run = 0; run < RUNS; run++) {
+        // scalar, each touch copied into a Touch and mapped
+        checkScalar = 0.0f;
+        Clock::time_point start = Clock::now();
+        for (unsigned f = 0; f < NUM_FRAMES; f++) {
+            const mec::TouchFrame &frame = frames[f % NUM_DEVICES];
+            float column = (f % 1000) * 0.03f;
+            for (unsigned i = 0; i < frame.size_; i++) {
+                mec::Touch t(frame.id_[i], frame.surface_,
+                             frame.x_[i], frame.y_[i], frame.z_[i], frame.r_[i], column + i);
+                mec::MusicalTouch mt = virtualScaler.map(t);
+                checkScalar += mt.note_;
+            }
+        }
+        bestScalar = std::min(bestScalar, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+
+        // batch
+        checkBatch = 0.0f;
+        start = Clock::now();
+        for (unsigned f = 0; f < NUM_FRAMES; f++) {
+            mec::TouchFrame &frame = frames[f % NUM_DEVICES];
+            float column = (f % 1000) * 0.03f;
+            for (unsigned i = 0; i < frame.size_; i++) frame.c_[i] = column + i;
+            scaler.mapBatch(frame, notes);
+            for (unsigned i = 0; i < frame.size_; i++) checkBatch += notes[i];
+        }
+        bestBatch = std::min(bestBatch, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+
+    report("map      ", bestScalar, checkScalar);
+    report("mapBatch ", bestBatch, checkBatch);
+    std::cout << "speedup: " << bestScalar / bestBatch << std::endl;
+
+    LOG_0("benchmark completed");
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <mec_api.h>
+#include <mec_scaler.h>
+#include <mec_surface.h>
+#include <mec_prefs.h>
+#include <mec_log.h>
+
+#include <cJSON.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+// benchmark a touch through the surface api, ns and heap allocations per touch
+// each touch is built from device values, mapped through a split surface, scaled to a MusicalTouch
+// and delivered to an IMusicalCallback, which keeps a copy
+//   string : Touch/MusicalTouch naming their surface with a SurfaceID (as before)
+//   handle : Touch/MusicalTouch with an interned SurfaceHandle
+// surface names are longer than the std::string small string buffer, as names from a config can be
+
+static std::atomic<unsigned long> allocations(0);
+
+void *operator new(std::size_t size) {
+    allocations++;
+    void *p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static const unsigned TOUCHES_PER_FRAME = 16;
+static const unsigned FRAMES = 20000;
+static const unsigned RUNS = 5;
+static const unsigned NUM_TOUCHES = TOUCHES_PER_FRAME * FRAMES;
+
+static const char *SURFACES =
+        "{ \"type\" : \"split\", \"axis\" : \"x\", \"split point\" : 0.5,"
+        "  \"surfaces\" : [\"keyboard left hand split\", \"keyboard right hand split\"] }";
+
+typedef std::chrono::steady_clock Clock;
+
+// the previous Touch and MusicalTouch
+struct StringTouch {
+    StringTouch() { ; }
+
+    StringTouch(int id, mec::SurfaceID surface, float x, float y, float z, float r, float c) :
+            id_(id), surface_(surface), x_(x), y_(y), z_(z), r_(r), c_(c) { ; }
+
+    int id_;
+    mec::SurfaceID surface_;
+    float x_, y_, z_, r_, c_;
+};
+
+struct StringMusicalTouch : public StringTouch {
+    StringMusicalTouch() { ; }
+
+    StringMusicalTouch(const StringTouch &t, float note) :
+            StringTouch(t.id_, t.surface_, t.x_, t.y_, t.z_, t.r_, t.c_), note_(note) { ; }
+
+    float note_;
+};
+
+class StringCallback {
+public:
+    virtual ~StringCallback() { ; }
+    virtual void touchContinue(const StringMusicalTouch &t) { last_ = t; }
+    StringMusicalTouch last_;
+};
+
+class HandleCallback : public mec::IMusicalCallback {
+public:
+    void touchOn(const mec::MusicalTouch &t) override { last_ = t; }
+    void touchContinue(const mec::MusicalTouch &t) override { last_ = t; }
+    void touchOff(const mec::MusicalTouch &t) override { last_ = t; }
+    mec::MusicalTouch last_;
+};
+
+static void report(const char *name, double bestNs, unsigned long allocs) {
+    std::cout << name
+              << " ns/touch: " << bestNs / NUM_TOUCHES
+              << " allocs/touch: " << static_cast<double>(allocs) / NUM_TOUCHES
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    LOG_0("benchmark started");
+
+    cJSON *json = cJSON_Parse(SURFACES);
+    mec::Preferences prefs(json);
+    mec::SplitSurface split("keyboard");
+    split.load(prefs);
+    const mec::Surface &surface = split;
+    const mec::SurfaceID device = "soundplane keyboard surface";
+    const mec::SurfaceID names[2] = {"keyboard left hand split", "keyboard right hand split"};
+
+    mec::Scaler scaler;
+    scaler.setScale(std::vector<float>({0.0f, 2.0f, 4.0f, 5.0f, 7.0f, 9.0f, 11.0f, 12.0f}));
+    const mec::Scaler &virtualScaler = scaler;
+
+    mec::SurfaceHandle deviceHandle = mec::SurfaceManager::intern(device);
+    StringCallback stringCb;
+    HandleCallback handleCb;
+    mec::IMusicalCallback &musicalCb = handleCb;
+    StringCallback &virtualStringCb = stringCb;
+
+    double bestString = 1e18, bestHandle = 1e18;
+    unsigned long allocString = 0, allocHandle = 0;
+    float check = 0.0f;
+
+    for (unsigned run = 0; run < RUNS; run++) {
+        unsigned long a = allocations;
+        Clock::time_point start = Clock::now();
+        for (unsigned f = 0; f < FRAMES; f++) {
+            for (unsigned i = 0; i < TOUCHES_PER_FRAME; i++) {
+                float x = (i + f % 7) * (1.0f / 24.0f);
+                StringTouch t(i, device, x, 0.0f, 0.5f, (float) (i % 8), (f % 30) + x);
+                // the split, as SplitSurface::map did
+                StringTouch out = t;
+                unsigned n = x < 0.5f ? 0 : 1;
+                out.x_ = x - 0.5f * n;
+                out.surface_ = names[n];
+                float note = virtualScaler.map(mec::Touch(out.id_, 0, out.x_, out.y_, out.z_, out.r_, out.c_)).note_;
+                virtualStringCb.touchContinue(StringMusicalTouch(out, note));
+            }
+            check += stringCb.last_.note_;
+        }
+        bestString = std::min(bestString, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        allocString = allocations - a;
+
+        a = allocations;
+        start = Clock::now();
+        for (unsigned f = 0; f < FRAMES; f++) {
+            for (unsigned i = 0; i < TOUCHES_PER_FRAME; i++) {
+                float x = (i + f % 7) * (1.0f / 24.0f);
+                mec::Touch t(i, deviceHandle, x, 0.0f, 0.5f, (float) (i % 8), (f % 30) + x);
+                mec::Touch out = surface.map(t);
+                musicalCb.touchContinue(virtualScaler.map(out));
+            }
+            check -= handleCb.last_.note_;
+        }
+        bestHandle = std::min(bestHandle, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        allocHandle = allocations - a;
+    }
+
+    report("string", bestString, allocString);
+    report("handle", bestHandle, allocHandle);
+    std::cout << "touch size: " << sizeof(mec::Touch) << " musical touch size: " << sizeof(mec::MusicalTouch)
+              << " (" << check << ")" << std::endl;
+
+    cJSON_Delete(json);
+    LOG_0("benchmark completed");
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <mec_voice.h>
+#include <mec_log.h>
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <vector>
+
+// benchmark Voices against the previous std::list based allocator
+// replays a pseudo random stream of key on/continue/off events, as a device handler would
+// reports ns/event
+
+static const unsigned NUM_EVENTS = 4000000;
+static const unsigned NUM_KEYS = 132; // alpha
+static const unsigned NUM_HELD = 24;  // keys held at any one time
+
+// original implementation (allocation parts only), kept for comparison
+class LegacyVoices {
+public:
+    struct Voice {
+        int i_;
+        int id_;
+        float note_;
+        float z_;
+    };
+
+    LegacyVoices(unsigned voiceCount) : maxVoices_(voiceCount) {
+        voices_.resize(maxVoices_);
+        for (unsigned i = 0; i < maxVoices_; i++) {
+            voices_[i].i_ = i;
+            voices_[i].id_ = -1;
+            freeVoices_.push_back(&voices_[i]);
+        }
+    }
+
+    Voice *voiceId(unsigned id) {
+        for (unsigned i = 0; i < maxVoices_; i++) {
+            if (voices_[i].id_ == static_cast<int>(id))
+                return &voices_[i];
+        }
+        return NULL;
+    }
+
+    Voice *startVoice(unsigned id) {
+        if (freeVoices_.size() == 0) return NULL;
+        Voice *voice = freeVoices_.front();
+        freeVoices_.pop_front();
+        voice->id_ = id;
+        usedVoices_.push_back(voice);
+        return voice;
+    }
+
+    void stopVoice(Voice *voice) {
+        if (!voice) return;
+        usedVoices_.remove(voice);
+        voice->id_ = -1;
+        freeVoices_.push_back(voice);
+    }
+
+    Voice *voiceToSteal() {
+        return usedVoices_.front();
+    }
+
+private:
+    std::vector<Voice> voices_;
+    std::list<Voice *> freeVoices_;
+    std::list<Voice *> usedVoices_;
+    unsigned maxVoices_;
+};
+
+
+struct KeyEvent {
+    unsigned key_;
+    bool active_;
+    float z_;
+};
+
+// held keys are replaced at random, each held key sends continues in between
+static void generateEvents(std::vector<KeyEvent> &events) {
+    unsigned seed = 12345;
+    unsigned held[NUM_HELD];
+    for (unsigned i = 0; i < NUM_HELD; i++) held[i] = i;
+
+    events.reserve(NUM_EVENTS);
+    while (events.size() < NUM_EVENTS) {
+        seed = seed * 1103515245 + 12345;
+        unsigned r = (seed >> 16) & 0x7fff;
+        unsigned slot = r % NUM_HELD;
+        if ((r & 0xf) == 0) {
+            KeyEvent off = {held[slot], false, 0.0f};
+            events.push_back(off);
+            held[slot] = (held[slot] + 1 + (r % (NUM_KEYS - 1))) % NUM_KEYS;
+        } else {
+            KeyEvent on = {held[slot], true, float(r & 0xff) / 256.0f};
+            events.push_back(on);
+        }
+    }
+}
+
+template<typename V>
+void processEvent(V &voices, const KeyEvent &e, unsigned &count) {
+    typename V::Voice *voice = voices.voiceId(e.key_);
+    if (e.active_) {
+        if (!voice) {
+            voice = voices.startVoice(e.key_);
+            if (!voice) {
+                voices.stopVoice(voices.voiceToSteal());
+                voice = voices.startVoice(e.key_);
+            }
+        }
+        voice->z_ = e.z_;
+        count += voice->i_;
+    } else if (voice) {
+        voices.stopVoice(voice);
+    }
+}
+
+template<typename V>
+void runBench(const char *name, unsigned voiceCount, const std::vector<KeyEvent> &events) {
+    typedef std::chrono::steady_clock clock;
+    V voices(voiceCount);
+    unsigned count = 0;
+
+    clock::time_point start = clock::now();
+    for (const KeyEvent &e : events) {
+        processEvent(voices, e, count);
+    }
+    clock::time_point end = clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << name << " voices: " << voiceCount
+              << " ns/event: " << ns / events.size()
+              << " (" << count << ")"
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    LOG_0("benchmark started");
+
+    std::vector<KeyEvent> events;
+    generateEvents(events);
+
+    runBench<LegacyVoices>("legacy ", 15, events);
+    runBench<mec::Voices>("voices ", 15, events);
+    runBench<LegacyVoices>("legacy ", 64, events);
+    runBench<mec::Voices>("voices ", 64, events);
+
+    LOG_0("benchmark completed");
+    return 0;
+}
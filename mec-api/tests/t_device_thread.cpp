@@ -0,0 +1,123 @@
+#include <mec_api.h>
+
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <mec_device_thread.h>
+#include <mec_prefs.h>
+#include <mec_log.h>
+
+static const int TOUCHES = 2000;
+
+// polled device, each process() sends the next few touches
+class PolledDevice : public mec::Device {
+public:
+    PolledDevice(mec::ICallback &cb) : callback_(cb), next_(0), thread_() { ; }
+    bool init(void *) override { return true; }
+    bool process() override {
+        thread_ = std::this_thread::get_id();
+        for (int i = 0; i < 3 && next_ < TOUCHES; i++, next_++) {
+            callback_.touchContinue(0, static_cast<float>(next_), 0.0f, 0.0f, 0.5f);
+        }
+        return true;
+    }
+    void deinit() override { ; }
+    bool isActive() override { return true; }
+
+    mec::ICallback &callback_;
+    int next_;
+    std::thread::id thread_;
+};
+
+// queued device, touches are added by its own producer thread, and drained in process()
+class QueuedDevice : public mec::Device {
+public:
+    QueuedDevice(mec::ICallback &cb) : callback_(cb) { ; }
+    bool init(void *) override { return true; }
+    bool process() override { return queue_.process(callback_); }
+    void deinit() override { ; }
+    bool isActive() override { return true; }
+    mec::MsgQueue *queue() override { return &queue_; }
+
+    mec::ICallback &callback_;
+    mec::MsgQueue queue_;
+};
+
+// touch notes received, per touch id
+class Collector : public mec::Callback {
+public:
+    Collector() : notes_(2) { ; }
+    void touchContinue(int touchId, float note, float x, float y, float z) override {
+        notes_[touchId].push_back(static_cast<int>(note));
+    }
+    void frameEnd(unsigned long long t) override { frames_++; }
+
+    std::vector<std::vector<int>> notes_;
+    unsigned frames_ = 0;
+};
+
+int main(int argc, char **argv) {
+    LOG_0("test started");
+
+    mec::Preferences prefs(nullptr); // defaults
+    mec::DeviceThread polledThread("polled", prefs);
+    mec::DeviceThread queuedThread("queued", prefs);
+    mec::MsgNotifier notifier;
+    Collector collector;
+    polledThread.queue().setNotifier(&notifier);
+
+    std::shared_ptr<PolledDevice> polled = std::make_shared<PolledDevice>(polledThread.callback());
+    std::shared_ptr<QueuedDevice> queued = std::make_shared<QueuedDevice>(queuedThread.callback());
+    polledThread.start(polled);
+    // a queued device is not started, its queue is read directly, as the api does
+    queuedThread.start(queued);
+    queuedThread.direct(collector);
+    queued->queue_.setNotifier(&notifier);
+
+    std::thread producer([&queued] {
+        for (int i = 0; i < TOUCHES; i++) {
+            mec::MecMsg msg;
+            msg.type_ = mec::MecMsg::TOUCH_CONTINUE;
+            msg.data_.touch_.touchId_ = 1;
+            msg.data_.touch_.note_ = static_cast<float>(i);
+            while (!queued->queue_.addToQueue(msg)) std::this_thread::yield();
+        }
+        mec::MecMsg msg;
+        msg.type_ = mec::MecMsg::FRAME_END;
+        msg.data_.frame_.t_ = 1;
+        while (!queued->queue_.addToQueue(msg)) std::this_thread::yield();
+    });
+
+    // api thread, drains each device's queue
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((collector.notes_[0].size() < TOUCHES || collector.frames_ == 0)
+           && std::chrono::steady_clock::now() < end) {
+        notifier.wait(10000);
+        polledThread.queue().process(collector);
+        queued->process();
+    }
+    producer.join();
+    polledThread.stop();
+    queuedThread.stop();
+
+    // processed on the device thread, everything delivered in order
+    assert(polled->thread_ != std::this_thread::get_id());
+    for (unsigned d = 0; d < 2; d++) {
+        assert(collector.notes_[d].size() == TOUCHES);
+        for (int i = 0; i < TOUCHES; i++) assert(collector.notes_[d][i] == i);
+    }
+    assert(collector.frames_ == 1);
+    assert(polledThread.queue().overflowCount() == 0);
+    assert(queuedThread.queue().pending() == 0);
+
+    // restart, and stop is safe to call again
+    polledThread.start(polled);
+    polledThread.stop();
+    polledThread.stop();
+
+    LOG_0("test completed");
+    return 0;
+}
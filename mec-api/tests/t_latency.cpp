@@ -0,0 +1,113 @@
+#include <mec_latency.h>
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#include <mec_api.h>
+#include <mec_msg_queue.h>
+#include <mec_log.h>
+
+// checks histogram accuracy, and when built with MEC_LATENCY_TRACE, that a message passing
+// from a device thread through a MsgQueue to an output is recorded at each stage
+
+static bool within(uint64_t v, uint64_t expected, double tolerance) {
+    return std::fabs((double) v - (double) expected) <= expected * tolerance + 1.0;
+}
+
+#ifdef MEC_LATENCY_TRACE
+// an output, sends (emits) on every touch, twice, only the first is recorded
+class Emitter : public mec::ICallback {
+public:
+    Emitter() : received_(0) { ; }
+    virtual void touchOn(int, float, float, float, float) { emit(); }
+    virtual void touchContinue(int, float, float, float, float) { emit(); }
+    virtual void touchOff(int, float, float, float, float) { emit(); }
+    virtual void control(int, float) { emit(); }
+    virtual void mec_control(int, void *) { ; }
+
+    void emit() {
+        received_++;
+        MEC_TRACE_EMIT();
+        MEC_TRACE_EMIT();
+    }
+
+    unsigned received_;
+};
+#endif
+
+int main(int argc, char **argv) {
+    LOG_0("test started");
+
+    // buckets cover every value, upper value within 1/32
+    unsigned lastIdx = 0;
+    for (uint64_t v = 0; v < (1ULL << 30); v = v < 1000 ? v + 1 : v + v / 97) {
+        unsigned idx = mec::LatencyHistogram::bucketIndex(v);
+        uint64_t upper = mec::LatencyHistogram::bucketUpperValue(idx);
+        assert(idx >= lastIdx);
+        assert(idx < mec::LatencyHistogram::BUCKETS);
+        assert(upper >= v);
+        assert(upper - v <= v / mec::LatencyHistogram::SUB_BUCKETS);
+        if (v < 64) assert(upper == v);
+        lastIdx = idx;
+    }
+    assert(mec::LatencyHistogram::bucketIndex(~0ULL) == mec::LatencyHistogram::BUCKETS - 1);
+
+    // percentiles
+    {
+        static mec::LatencyHistogram h;
+        assert(h.count() == 0 && h.percentile(0.5) == 0);
+        for (uint64_t v = 1; v <= 100000; v++) h.record(v);
+        mec::LatencyHistogram::Stats s = h.stats();
+        assert(s.count_ == 100000);
+        assert(s.min_ == 1 && s.max_ == 100000);
+        assert(s.mean_ == 50000);
+        assert(within(s.p50_, 50000, 0.032));
+        assert(within(s.p90_, 90000, 0.032));
+        assert(within(s.p99_, 99000, 0.032));
+        assert(within(s.p999_, 99900, 0.032));
+        assert(h.percentile(1.0) == 100000);
+        h.reset();
+        assert(h.count() == 0);
+    }
+
+#ifdef MEC_LATENCY_TRACE
+    {
+        static const unsigned N = 200;
+        mec::LatencyTrace::reset();
+        mec::MsgQueue queue(N);
+        std::thread device([&queue] {
+            for (unsigned i = 0; i < N; i++) {
+                MEC_TRACE_ARRIVAL();
+                mec::MecMsg msg;
+                msg.type_ = mec::MecMsg::TOUCH_CONTINUE;
+                msg.data_.touch_.touchId_ = i;
+                msg.data_.touch_.note_ = 60.0f;
+                msg.data_.touch_.x_ = msg.data_.touch_.y_ = msg.data_.touch_.z_ = 0.0f;
+                queue.addToQueue(msg);
+            }
+        });
+        device.join();
+
+        Emitter emitter;
+        queue.process(emitter);
+        assert(emitter.received_ == N);
+
+        assert(mec::LatencyTrace::histogram(mec::LatencyTrace::INPUT).count() == N);
+        assert(mec::LatencyTrace::histogram(mec::LatencyTrace::QUEUE).count() == N);
+        assert(mec::LatencyTrace::histogram(mec::LatencyTrace::OUTPUT).count() == N);
+        assert(mec::LatencyTrace::histogram(mec::LatencyTrace::TOTAL).count() == N);
+
+        // total covers every stage
+        mec::LatencyHistogram::Stats total = mec::LatencyTrace::histogram(mec::LatencyTrace::TOTAL).stats();
+        mec::LatencyHistogram::Stats queued = mec::LatencyTrace::histogram(mec::LatencyTrace::QUEUE).stats();
+        assert(total.max_ >= queued.max_);
+
+        mec::LatencyTrace::dump(std::cout);
+    }
+#endif
+
+    LOG_0("test completed");
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <mec_api.h>
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#include <mec_mapping.h>
+#include <mec_prefs.h>
+#include <mec_log.h>
+
+// the note the chain gives for r/c, without compiling
+static float chainNote(mec::SurfaceManager &mgr, const std::vector<mec::SurfaceID> &chain,
+                       const mec::Scaler &scaler, float r, float c) {
+    mec::Touch t(0, mec::SurfaceManager::intern("a1"), 0.0f, 0.0f, 0.0f, r, c);
+    for (const mec::SurfaceID &id : chain) {
+        t = mgr.getSurface(id)->map(t);
+    }
+    return scaler.map(t).note_;
+}
+
+// compiled table matches the chain, over all rows and the columns the table covers
+static bool matches(const mec::SurfaceMapping &mapping, mec::SurfaceManager &mgr,
+                    const std::vector<mec::SurfaceID> &chain, const mec::Scaler &scaler) {
+    std::shared_ptr<const mec::MappingTable> table = mapping.getTable();
+    for (unsigned r = 0; r < table->getRows(); r++) {
+        for (float c = 0.0f; c < table->getColumns(); c += 0.0625f) {
+            float expected = chainNote(mgr, chain, scaler, (float) r, c);
+            float note = table->map((float) r, c);
+            if (std::fabs(note - expected) > 0.0001f) {
+                LOG_0("mismatch r " << r << " c " << c << " note " << note << " expected " << expected);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool waitForGeneration(const mec::SurfaceMapping &mapping, unsigned long generation) {
+    for (int i = 0; i < 1000 && mapping.getGeneration() < generation; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return mapping.getGeneration() >= generation;
+}
+
+int main(int argc, char **argv) {
+    LOG_0("test started");
+
+    mec::Preferences prefs("../mec-api/tests/test.json");
+    assert(prefs.valid());
+    mec::Preferences mec_prefs(prefs.getSubTree("mec"));
+    assert(mec_prefs.valid());
+
+    assert(mec::Scales::init(mec::Preferences(mec_prefs.getSubTree("scales"))));
+    mec::SurfaceManager mgr;
+    assert(mgr.init(mec::Preferences(mec_prefs.getSubTree("surfaces"))));
+
+    // scaler only
+    {
+        mec::Preferences m1(mec_prefs.getSubTree("mapping 1"));
+        mec::SurfaceMapping mapping;
+        assert(mapping.load(m1, mgr));
+        assert(mapping.getGeneration() == 1);
+
+        mec::Scaler scaler;
+        assert(scaler.load(mec::Preferences(m1.getSubTree("scaler"))));
+        assert(matches(mapping, mgr, {}, scaler));
+
+        mec::Touch t(0, mec::SurfaceManager::intern("a1"), 0.0f, 0.0f, 0.0f, 1.0f, 8.5f);
+        // 12 + 2.5 + 4.0 (row o) + 1.0 (col o), as t_scale
+        assert(mapping.map(t).note_ == 19.5f);
+
+        // changes compile in the background, the previous table stays valid until swapped
+        std::shared_ptr<const mec::MappingTable> previous = mapping.getTable();
+        mapping.setTonic(3.0f);
+        assert(waitForGeneration(mapping, 2));
+        assert(previous->map(1.0f, 8.5f) == 19.5f);
+        assert(mapping.map(t).note_ == 22.5f);
+
+        mapping.setScale("major");
+        scaler.setTonic(3.0f);
+        scaler.setScale("major");
+        assert(waitForGeneration(mapping, 3));
+        assert(matches(mapping, mgr, {}, scaler));
+    }
+
+    // split on column, then scaler
+    {
+        mec::Preferences m2(mec_prefs.getSubTree("mapping 2"));
+        mec::SurfaceMapping mapping;
+        assert(mapping.load(m2, mgr));
+
+        mec::Scaler scaler;
+        assert(scaler.load(mec::Preferences(m2.getSubTree("scaler"))));
+        std::vector<mec::SurfaceID> chain = {"3"};
+        assert(matches(mapping, mgr, chain, scaler));
+
+        // second half of the split starts again from the tonic
+        assert(mapping.getTable()->map(0.0f, 12.0f) == mapping.getTable()->map(0.0f, 0.0f));
+
+        unsigned long generation = mapping.getGeneration();
+        assert(mapping.setSplitPoint("3", 8.0f));
+        assert(!mapping.setSplitPoint("1", 8.0f)); // not in this chain
+        assert(waitForGeneration(mapping, generation + 1));
+        assert(matches(mapping, mgr, chain, scaler));
+        assert(mapping.getTable()->map(0.0f, 8.0f) == mapping.getTable()->map(0.0f, 0.0f));
+    }
+
+    LOG_0("test completed");
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <mec_api.h>
+
+#include <cassert>
+#include <vector>
+
+#include <processors/mec_midi_coalescer.h>
+#include <processors/mec_mpe_processor.h>
+#include <mec_log.h>
+
+typedef std::vector<unsigned char> Bytes;
+
+static Bytes flushed(mec::MidiCoalescer &c, unsigned long long nowUs) {
+    unsigned size = c.flush(nowUs);
+    return Bytes(c.data(), c.data() + size);
+}
+
+// collects messages as the default send() splits them
+class TestProcessor : public mec::MPE_Processor {
+public:
+    void process(MidiMsg &msg) override {
+        for (unsigned i = 0; i < msg.size; i++) bytes_.push_back(static_cast<unsigned char>(msg.data[i]));
+        msgs_++;
+    }
+
+    Bytes bytes_;
+    unsigned msgs_ = 0;
+};
+
+int main(int argc, char **argv) {
+    LOG_0("test started");
+
+    // superseded values are dropped, unchanged values not resent
+    {
+        mec::MidiCoalescer c;
+        c.value(1, mec::MidiCoalescer::PITCHBEND, 0x2000);
+        c.value(1, mec::MidiCoalescer::PITCHBEND, 0x2100);
+        c.value(1, 74, 10);
+        c.value(1, 74, 20);
+        assert(flushed(c, 0) == Bytes({0xE1, 0x00, 0x42, 0xB1, 74, 20}));
+
+        c.value(1, 74, 20);
+        assert(c.flush(1) == 0);
+        assert(c.isEmpty());
+
+        // changed and back again, within one flush
+        c.value(1, 74, 30);
+        c.value(1, 74, 20);
+        assert(c.flush(2) == 0);
+    }
+
+    // values before a note on are sent before it, later values after
+    {
+        mec::MidiCoalescer c;
+        c.value(2, mec::MidiCoalescer::PITCHBEND, 0x2000);
+        c.message(0x92, 60, 100, 3);
+        c.value(2, mec::MidiCoalescer::PRESSURE, 0);
+        c.value(2, mec::MidiCoalescer::PITCHBEND, 0x2001);
+        assert(flushed(c, 0) == Bytes({0xE2, 0x00, 0x40, 0x92, 60, 100, 0xD2, 0x00, 0xE2, 0x01, 0x40}));
+    }
+
+    // over rate, the latest value is held and sent on a later flush
+    {
+        mec::MidiCoalescer c;
+        c.setMaxRate(mec::MidiCoalescer::RATE_PRESSURE, 1000); // 1ms
+        c.value(0, mec::MidiCoalescer::PRESSURE, 10);
+        assert(flushed(c, 1000) == Bytes({0xD0, 10}));
+        c.value(0, mec::MidiCoalescer::PRESSURE, 11);
+        assert(c.flush(1500) == 0);
+        c.value(0, mec::MidiCoalescer::PRESSURE, 12);
+        assert(c.flush(1900) == 0);
+        assert(!c.isEmpty());
+        assert(flushed(c, 2000) == Bytes({0xD0, 12}));
+        assert(c.isEmpty());
+
+        // a note off forces the held value out
+        c.value(0, mec::MidiCoalescer::PRESSURE, 0);
+        c.message(0x80, 60, 0, 3);
+        assert(flushed(c, 2100) == Bytes({0xD0, 0, 0x80, 60, 0}));
+    }
+
+    // running status
+    {
+        mec::MidiCoalescer c;
+        c.setRunningStatus(true);
+        c.value(3, 1, 10);
+        c.value(3, 2, 20);
+        c.value(4, 1, 30);
+        c.message(0xF8, 0, 0, 1);
+        c.value(4, 2, 40);
+        assert(flushed(c, 0) == Bytes({0xB3, 1, 10, 2, 20, 0xB4, 1, 30, 0xF8, 0xB4, 2, 40}));
+
+        // each buffer starts with a status
+        c.value(4, 2, 41);
+        assert(flushed(c, 1) == Bytes({0xB4, 2, 41}));
+    }
+
+    // high resolution pairs
+    {
+        mec::MidiCoalescer c;
+        c.value(0, 1, 0x3FFF, true);
+        c.value(0, 74, 0x2001, true);
+        c.value(0, mec::MidiCoalescer::PRESSURE, 0x0081, true);
+        assert(flushed(c, 0) == Bytes({0xB0, 1, 0x7F, 0xB0, 33, 0x7F,
+                                       0xB0, 87, 0x01, 0xB0, 74, 0x40,
+                                       0xB0, 87, 0x01, 0xD0, 0x01}));
+    }
+
+    // processor, coalesced and sent as one buffer, then split by the default send()
+    {
+        TestProcessor p;
+        p.touchOn(0, 60.0f, 0.0f, 0.0f, 0.5f);
+        unsigned direct = p.msgs_;
+        Bytes directBytes = p.bytes_;
+        p.touchOff(0, 60.0f, 0.0f, 0.0f, 0.0f);
+
+        p.setCoalescing(true);
+        p.getCoalescer()->setRunningStatus(true);
+        p.bytes_.clear();
+        p.msgs_ = 0;
+        p.touchOn(0, 60.0f, 0.0f, 0.0f, 0.5f);
+        assert(p.msgs_ == 0);
+        p.flush();
+        assert(p.msgs_ == direct);
+        assert(p.bytes_ == directBytes);
+
+        // many moves in a tick, only the last sent
+        p.bytes_.clear();
+        for (int i = 1; i <= 10; i++) p.touchContinue(0, 60.0f, 0.0f, 0.0f, 0.5f + i * 0.01f);
+        p.flush();
+        assert(p.bytes_ == Bytes({0xD1, 76}));
+    }
+
+    // high resolution mpe, not coalesced
+    {
+        TestProcessor p;
+        p.setHighResolution(true);
+        p.touchOn(0, 60.0f, 0.0f, 1.0f, 0.5f);
+        // pb, timbre (lsb on 87, msb), note on, pressure (lsb on 87, msb)
+        assert(p.bytes_ == Bytes({0xE1, 0x00, 0x40,
+                                  0xB1, 87, 0x7F, 0xB1, 74, 0x7F,
+                                  0x91, 60, 63,
+                                  0xB1, 87, 0x00, 0xD1, 0x00}));
+    }
+
+    LOG_0("test completed");
+    return 0;
+}
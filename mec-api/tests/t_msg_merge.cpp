@@ -0,0 +1,181 @@
+#include <mec_api.h>
+
+#include <cassert>
+#include <vector>
+
+#include <mec_msg_merge.h>
+#include <mec_log.h>
+
+static void add(mec::MsgQueue &q, mec::MecMsg::type type, int id, unsigned long long t) {
+    mec::MecMsg msg;
+    msg.type_ = type;
+    if (type == mec::MecMsg::TOUCH_CONTINUE) {
+        msg.data_.touch_.touchId_ = id;
+    } else {
+        msg.data_.frame_.t_ = t;
+    }
+    msg.t_ = t;
+    q.addToQueue(msg);
+}
+
+static void touch(mec::MsgQueue &q, int id, unsigned long long t) {
+    add(q, mec::MecMsg::TOUCH_CONTINUE, id, t);
+}
+
+struct Out {
+    unsigned lane_;
+    int id_;
+    unsigned long long t_;
+};
+
+static std::vector<Out> merged(mec::MsgMerge &m, unsigned long long now) {
+    std::vector<Out> out;
+    mec::MecMsg msg;
+    unsigned lane;
+    while (m.next(msg, lane, now)) {
+        Out o = {lane, msg.type_ == mec::MecMsg::TOUCH_CONTINUE ? msg.data_.touch_.touchId_ : -1, msg.t_};
+        out.push_back(o);
+    }
+    return out;
+}
+
+int main(int argc, char **argv) {
+    LOG_0("test started");
+
+    // interleaved by time, released when every lane has a later message
+    {
+        mec::MsgQueue a, b;
+        mec::MsgMerge m(1000);
+        assert(m.addQueue(&a) == 0);
+        assert(m.addQueue(&b) == 1);
+
+        touch(a, 1, 100);
+        touch(a, 2, 300);
+        touch(b, 3, 200);
+        touch(b, 4, 400);
+        std::vector<Out> out = merged(m, 400);
+        // 4 is held, a could still deliver something earlier
+        assert(out.size() == 3);
+        assert(out[0].id_ == 1 && out[0].lane_ == 0);
+        assert(out[1].id_ == 3 && out[1].lane_ == 1);
+        assert(out[2].id_ == 2 && out[2].lane_ == 0);
+        assert(m.isHolding());
+
+        // late message within the window is still ordered
+        touch(a, 5, 350);
+        out = merged(m, 400);
+        assert(out.size() == 1 && out[0].id_ == 5);
+
+        // window passed
+        assert(merged(m, 1399).empty());
+        out = merged(m, 1400);
+        assert(out.size() == 1 && out[0].id_ == 4);
+        assert(!m.isHolding());
+    }
+
+    // zero window, nothing held, earliest of what is queued first
+    {
+        mec::MsgQueue a, b;
+        mec::MsgMerge m(0);
+        m.addQueue(&a);
+        m.addQueue(&b);
+        touch(a, 1, 500);
+        touch(b, 2, 100);
+        std::vector<Out> out = merged(m, 500);
+        assert(out.size() == 2 && out[0].id_ == 2 && out[1].id_ == 1);
+    }
+
+    // a message earlier than its predecessor on a lane is treated as simultaneous
+    {
+        mec::MsgQueue a;
+        mec::MsgMerge m(0);
+        m.addQueue(&a);
+        touch(a, 1, 500);
+        touch(a, 2, 400);
+        std::vector<Out> out = merged(m, 500);
+        assert(out.size() == 2 && out[0].id_ == 1 && out[1].id_ == 2 && out[1].t_ == 500);
+    }
+
+    // frames are delivered whole
+    {
+        mec::MsgQueue a, b;
+        mec::MsgMerge m(1000);
+        m.addQueue(&a);
+        m.addQueue(&b);
+        add(a, mec::MecMsg::FRAME_START, 0, 100);
+        touch(a, 1, 100);
+        touch(b, 2, 50);
+        touch(b, 3, 150);
+        std::vector<Out> out = merged(m, 1000);
+        // frame end not yet queued, b waits
+        assert(out.size() == 3);
+        assert(out[0].id_ == 2 && out[1].id_ == -1 && out[2].id_ == 1);
+        assert(merged(m, 1099).empty());
+        add(a, mec::MecMsg::FRAME_END, 0, 100);
+        out = merged(m, 1150);
+        assert(out.size() == 2 && out[0].id_ == -1 && out[0].lane_ == 0 && out[1].id_ == 3);
+
+        // a frame which never ends, is abandoned after the window
+        add(a, mec::MecMsg::FRAME_START, 0, 200);
+        touch(b, 4, 300);
+        out = merged(m, 1199);
+        assert(out.size() == 1 && out[0].id_ == -1);
+        assert(merged(m, 1299).empty());
+        out = merged(m, 1300);
+        assert(out.size() == 1 && out[0].id_ == 4);
+    }
+
+    // a device sending a frame per packet (e.g. t3d) does not hold other devices between frames
+    {
+        mec::MsgQueue a, b;
+        mec::MsgMerge m(1000);
+        m.addQueue(&a);
+        m.addQueue(&b);
+        for (int f = 1; f <= 5; f++) {
+            unsigned long long t = f * 100;
+            add(a, mec::MecMsg::FRAME_START, 0, t);
+            touch(a, f, t);
+            add(a, mec::MecMsg::FRAME_END, 0, t);
+            if (f % 2) touch(b, 10 + f, t + 50);
+        }
+        std::vector<Out> out = merged(m, 2000);
+        assert(out.size() == 5 * 3 + 3);
+        // b's touches are between a's frames, in time order
+        unsigned long long lastT = 0;
+        for (size_t i = 0; i < out.size(); i++) {
+            assert(out[i].t_ >= lastT);
+            lastT = out[i].t_;
+        }
+        assert(out[3].lane_ == 1 && out[3].id_ == 11);
+        assert(out[10].lane_ == 1 && out[10].id_ == 13);
+        assert(out[17].lane_ == 1 && out[17].id_ == 15);
+    }
+
+    // device clock
+    {
+        mec::DeviceClock ms(1000);
+        unsigned long long now = mec::monotonicTimeUs();
+        unsigned long long t0 = ms.hostTime(5000);
+        assert(t0 >= now && t0 <= mec::monotonicTimeUs());
+        // an event delivered later, is placed by its device time
+        unsigned long long t1 = ms.hostTime(5002);
+        assert(t1 == t0 + 2000 || t1 <= mec::monotonicTimeUs());
+        // never in the future
+        assert(ms.hostTime(6000) <= mec::monotonicTimeUs());
+    }
+
+    // untimed messages are only stamped on queues feeding the merge
+    {
+        mec::MsgQueue a, b;
+        mec::MsgMerge m(1000);
+        m.addQueue(&a);
+        touch(a, 1, 0);
+        touch(b, 2, 0);
+        mec::MecMsg msg;
+        assert(a.nextMsg(msg) && msg.t_ != 0);
+        assert(b.nextMsg(msg) && msg.t_ == 0);
+    }
+
+    LOG_0("test completed");
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <mec_api.h>
+
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <mec_recorder.h>
+#include <devices/mec_replay.h>
+#include <mec_prefs.h>
+#include <mec_log.h>
+
+class Collector : public mec::ICallback {
+public:
+    virtual void touchOn(int touchId, float note, float x, float y, float z) { add(mec::MecMsg::TOUCH_ON, touchId, note, x, y, z); }
+    virtual void touchContinue(int touchId, float note, float x, float y, float z) { add(mec::MecMsg::TOUCH_CONTINUE, touchId, note, x, y, z); }
+    virtual void touchOff(int touchId, float note, float x, float y, float z) { add(mec::MecMsg::TOUCH_OFF, touchId, note, x, y, z); }
+    virtual void control(int ctrlId, float v) { add(mec::MecMsg::CONTROL, ctrlId, v, 0.0f, 0.0f, 0.0f); }
+    virtual void mec_control(int cmd, void *) { add(mec::MecMsg::MEC_CONTROL, cmd, 0.0f, 0.0f, 0.0f, 0.0f); }
+
+    void add(mec::MecMsg::type type, int id, float n, float x, float y, float z) {
+        mec::RecordedMsg m;
+        m.type_ = type;
+        m.id_ = id;
+        m.v_[0] = n;
+        m.v_[1] = x;
+        m.v_[2] = y;
+        m.v_[3] = z;
+        msgs_.push_back(m);
+    }
+
+    std::vector<mec::RecordedMsg> msgs_;
+};
+
+int main (int argc, char** argv) {
+    LOG_0("test started");
+
+    mec::Preferences prefs("../mec-api/tests/test.json");
+    assert(prefs.valid());
+    mec::Preferences mec_prefs(prefs.getSubTree("mec"));
+    assert(mec_prefs.valid());
+
+    std::vector<std::string> devices;
+    devices.push_back("soundplane");
+    devices.push_back("eigenharp");
+
+    // record
+    {
+        mec::Recorder recorder;
+        assert(recorder.init(mec_prefs.getSubTree("recorder"), devices));
+        for (int i = 0; i < 20; i++) {
+            recorder.setDevice(i % 2);
+            recorder.touchOn(i, 60.0f + i, 0.1f, 0.2f, 0.3f);
+            recorder.touchContinue(i, 60.0f + i, 0.4f, 0.5f, 0.6f);
+            recorder.touchOff(i, 60.0f + i, 0.7f, 0.8f, 0.0f);
+            recorder.control(i, 0.5f);
+        }
+        recorder.mec_control(mec::ICallback::SHUTDOWN, nullptr);
+        recorder.deinit();
+        assert(recorder.overflowCount() == 0);
+    }
+
+    // load
+    std::vector<std::string> names;
+    std::vector<mec::RecordedMsg> msgs;
+    assert(mec::Recorder::load("t_recorder.rec", names, msgs));
+    assert(names == devices);
+    assert(msgs.size() == 81);
+    for (size_t i = 1; i < msgs.size(); i++) {
+        assert(msgs[i].t_ >= msgs[i - 1].t_);
+    }
+    assert(msgs[0].type_ == mec::MecMsg::TOUCH_ON && msgs[0].device_ == 0 && msgs[0].v_[0] == 60.0f);
+    assert(msgs[5].type_ == mec::MecMsg::TOUCH_CONTINUE && msgs[5].device_ == 1 && msgs[5].id_ == 1);
+    assert(msgs[80].type_ == mec::MecMsg::MEC_CONTROL);
+
+    // replay, control messages are not replayed
+    Collector collector;
+    {
+        mec::Replay replay(collector);
+        assert(replay.init(mec_prefs.getSubTree("replay")));
+        for (int i = 0; i < 1000 && collector.msgs_.size() < 80; i++) {
+            replay.process();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        replay.deinit();
+    }
+    assert(collector.msgs_.size() == 80);
+    for (size_t i = 0; i < collector.msgs_.size(); i++) {
+        const mec::RecordedMsg &a = msgs[i], &b = collector.msgs_[i];
+        assert(a.type_ == b.type_ && a.id_ == b.id_);
+        assert(a.v_[0] == b.v_[0]);
+        if (a.type_ != mec::MecMsg::CONTROL) {
+            assert(a.v_[1] == b.v_[1] && a.v_[2] == b.v_[2] && a.v_[3] == b.v_[3]);
+        }
+    }
+
+    // by default only the first device is replayed, as touch ids from different devices collide
+    Collector first;
+    {
+        mec::Replay replay(first);
+        assert(replay.init(mec_prefs.getSubTree("replay first device")));
+        for (int i = 0; i < 1000 && first.msgs_.size() < 40; i++) {
+            replay.process();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        replay.deinit();
+    }
+    assert(first.msgs_.size() == 40);
+    for (size_t i = 0; i < first.msgs_.size(); i++) {
+        assert(first.msgs_[i].id_ % 2 == 0);
+    }
+
+    LOG_0("test completed");
+    return 0;
+}
@@ -2,7 +2,9 @@
 #include <iostream>
 
 #include <cassert>
+#include <cmath>
 #include <mec_scaler.h>
+#include <mec_surface.h>
 #include <mec_log.h>
 
 void dumpScale(const mec::ScaleArray& a) {
@@ -83,6 +85,21 @@ int main (int argc, char** argv) {
     // 12 + 2.5 + 4.0 (row o) + 1.0 (col o)
     assert(mt.note_ == 19.5f);
 
+    // batch mapping agrees with map, for the vector loop and the remainder
+    mec::TouchFrame frame;
+    frame.surface_ = mec::SurfaceManager::intern("a1");
+    for (int i = 0; i < 23; i++) {
+        frame.addCell(mec::TouchFrame::TOUCH_CONTINUE, i, (float) (i % 5), i * 1.37f, 0.0f, 0.0f, 0.5f);
+    }
+    float notes[mec::TouchFrame::MAX_TOUCHES];
+    scaler.mapBatch(frame, notes);
+    for (unsigned i = 0; i < frame.size_; i++) {
+        t.r_ = frame.r_[i];
+        t.c_ = frame.c_[i];
+        mt = scaler.map(t);
+        assert(std::fabs(notes[i] - mt.note_) < 0.0001f);
+    }
+
 
     LOG_0("test completed");
     return 0;
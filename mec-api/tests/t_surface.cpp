@@ -29,15 +29,15 @@ int main (int argc, char** argv) {
     // simple split
     std::shared_ptr<mec::Surface> split1 = mgr.getSurface("1");
     assert(split1 != nullptr);
-    t.surface_ = "a1";
+    t.surface_ = mec::SurfaceManager::intern("a1");
     t.x_ = 0.1f;
     out = split1->map(t);
     assert(out.x_ == t.x_);
-    assert(out.surface_ == "10");
+    assert(mec::SurfaceManager::name(out.surface_) == "10");
     t.x_ = 0.8f;
     out = split1->map(t);
     assert(out.x_ == 0.3f);
-    assert(out.surface_ == "11");
+    assert(mec::SurfaceManager::name(out.surface_) == "11");
 
 
 
@@ -45,14 +45,14 @@ int main (int argc, char** argv) {
     std::shared_ptr<mec::Surface> join1 = mgr.getSurface("2");
     assert(join1 != nullptr);
     t.x_ = 0.1f;
-    t.surface_ = "20";
+    t.surface_ = mec::SurfaceManager::intern("20");
     out = join1->map(t);
     assert(out.x_ == t.x_);
-    assert(out.surface_ == "2");
-    t.surface_ = "21";
+    assert(mec::SurfaceManager::name(out.surface_) == "2");
+    t.surface_ = mec::SurfaceManager::intern("21");
     out = join1->map(t);
     assert(out.x_ == 1.1f);
-    assert(out.surface_ == "2");
+    assert(mec::SurfaceManager::name(out.surface_) == "2");
 
     LOG_0("test completed");
     return 0;
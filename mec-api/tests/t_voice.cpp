@@ -28,6 +28,52 @@ int main (int argc, char** argv) {
     voices.stopVoice(voices.oldestActiveVoice());
     voices.startVoice(4);
     assert(voices.oldestActiveVoice()->id_ == 2);
+    assert(voices.voiceId(4) != nullptr);
+    assert(voices.voiceId(1) == nullptr);
+
+    // ids outside of key table
+    mec::Voices big(2, 2, 16);
+    v = big.startVoice(1000);
+    assert(big.voiceId(1000) == v);
+    big.stopVoice(v);
+    assert(big.voiceId(1000) == nullptr);
+
+    // an id can only have one voice, and stopping a voice leaves other ids alone
+    mec::Voices dup(3, 2, 16);
+    v = dup.startVoice(5);
+    assert(dup.startVoice(5) == nullptr);
+    assert(dup.voiceId(5) == v);
+    assert(dup.activeVoices() == 1);
+    dup.stopVoice(v);
+    dup.stopVoice(v);
+    assert(dup.voiceId(5) == nullptr);
+    assert(dup.activeVoices() == 0);
+
+    // resizing the key table keeps active voices
+    v = dup.startVoice(20);
+    dup.setKeyCount(32);
+    assert(dup.keyCount() == 32);
+    assert(dup.voiceId(20) == v);
+    dup.setKeyCount(8);
+    assert(dup.voiceId(20) == v);
+    dup.stopVoice(v);
+    assert(dup.voiceId(20) == nullptr);
+
+    // steal policies
+    mec::Voices steal(3, 2);
+    steal.startVoice(1)->note_ = 60.0f;
+    steal.startVoice(2)->note_ = 72.0f;
+    steal.startVoice(3)->note_ = 48.0f;
+    steal.voiceId(1)->z_ = 0.5f;
+    steal.voiceId(2)->z_ = 0.1f;
+    steal.voiceId(3)->z_ = 0.9f;
+    assert(steal.voiceToSteal()->id_ == 1);
+    steal.setStealPolicy(mec::Voices::parseStealPolicy("quietest"));
+    assert(steal.voiceToSteal()->id_ == 2);
+    steal.setStealPolicy(mec::Voices::parseStealPolicy("highest"));
+    assert(steal.voiceToSteal()->id_ == 2);
+    steal.setStealPolicy(mec::Voices::parseStealPolicy("lowest"));
+    assert(steal.voiceToSteal()->id_ == 3);
 
     LOG_0("test completed");
     return 0;
@@ -21,6 +21,7 @@ inline void sleep(unsigned int seconds) { Sleep(seconds * 1000); }
 // #include <ip/UdpSocket.h>
 
 #include "mec_app.h"
+#include <mec_latency.h>
 #include <mec_prefs.h>
 
 // for signal
@@ -33,6 +34,11 @@ std::mutex waitMtx;
 
 volatile bool keepRunning = true;
 
+#ifdef MEC_LATENCY_TRACE
+// set by SIGUSR1, latency is dumped by the main loop
+volatile sig_atomic_t dumpLatency = 0;
+#endif
+
 void exitHandler() {
     LOG_0("mec_app exit handler called");
 }
@@ -44,6 +50,11 @@ void intHandler(int sig) {
         keepRunning = 0;
         waitCond.notify_all();
     }
+#if defined(MEC_LATENCY_TRACE) && !defined(WIN32)
+    if (sig == SIGUSR1) {
+        dumpLatency = 1;
+    }
+#endif
 }
 
 #include <mec_msg_queue.h>
@@ -58,6 +69,9 @@ int main(int ac, char **av) {
     sigset_t sigset, oldset;
     sigemptyset(&sigset);
     sigaddset(&sigset, SIGINT);
+#ifdef MEC_LATENCY_TRACE
+    sigaddset(&sigset, SIGUSR1);
+#endif
     pthread_sigmask(SIG_BLOCK, &sigset, &oldset);
 #endif
     int rc = 0;
@@ -87,21 +101,38 @@ int main(int ac, char **av) {
     sigemptyset(&s.sa_mask);
     s.sa_flags = 0;
     sigaction(SIGINT, &s, NULL);
+#ifdef MEC_LATENCY_TRACE
+    sigaction(SIGUSR1, &s, NULL);
+#endif
     // Restore the old signal mask only for this thread.
     pthread_sigmask(SIG_SETMASK, &oldset, NULL);
 #endif
 
     {
+#ifdef MEC_LATENCY_TRACE
+        // dump latency every interval (seconds, 0 = only on SIGUSR1)
+        mec::Preferences app_prefs(prefs.getSubTree("mec-app"));
+        int dumpInterval = app_prefs.valid() ? app_prefs.getInt("latency dump interval", 0) : 0;
+        auto nextDump = std::chrono::steady_clock::now() + std::chrono::seconds(dumpInterval);
+#endif
         std::unique_lock<std::mutex> lock(waitMtx);
         LOG_0("mec_app running ");
         while (keepRunning) {
             waitCond.wait_for(lock, std::chrono::milliseconds(1000));
+#ifdef MEC_LATENCY_TRACE
+            if (dumpLatency || (dumpInterval > 0 && std::chrono::steady_clock::now() >= nextDump)) {
+                dumpLatency = 0;
+                nextDump = std::chrono::steady_clock::now() + std::chrono::seconds(dumpInterval);
+                mec::LatencyTrace::dump(std::cout);
+            }
+#endif
         }
 
     }
 
     LOG_0("mec_app wait for mec thread ");
     if(mec_thread.joinable()) {
+        mecapi_wakeup();
         mec_thread.join();
     }
     LOG_0("mec_app mec thread stopped ");
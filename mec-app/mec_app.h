@@ -9,6 +9,7 @@
 
 void *osc_command_proc(void *);
 void *mecapi_proc(void *);
+void mecapi_wakeup(); // wakes mecapi_proc, so it sees keepRunning change
 void *midi_proc(void *);
 void *push2_proc(void *);
 
@@ -25,11 +25,24 @@ inline void pthread_exit(void *value_ptr)
 #include "midi_output.h"
 
 #include <mec_api.h>
+#include <mec_latency.h>
 #include <mec_prefs.h>
 #include <processors/mec_mpe_processor.h>
 
 #define OUTPUT_BUFFER_SIZE 1024
 
+// max time to wait for device messages, shutdown wakes the wait (mecapi_wakeup), so this is only a backstop
+static const unsigned MEC_WAIT_TIMEOUT_MS = 100;
+
+// the api mecapi_proc is running, guarded so it cannot be deleted while being woken
+static std::mutex runningApiMtx;
+static mec::MecApi *runningApi = nullptr;
+
+void mecapi_wakeup() {
+    std::lock_guard<std::mutex> lock(runningApiMtx);
+    if (runningApi) runningApi->wakeUp();
+}
+
 //hacks for now
 //#define VELOCITY 1.0f
 //#define PB_RANGE 2.0f
@@ -148,6 +161,7 @@ public:
            << osc::EndMessage
            << osc::EndBundle;
         transmitSocket_.Send(op.Data(), op.Size());
+        MEC_TRACE_EMIT();
     }
 
     void sendMsg(std::string topic, int touchId, float note, float x, float y, float z) {
@@ -158,6 +172,7 @@ public:
            << osc::EndMessage
            << osc::EndBundle;
         transmitSocket_.Send(op.Data(), op.Size());
+        MEC_TRACE_EMIT();
     }
 
 private:
@@ -167,10 +182,23 @@ private:
     bool valid_;
 };
 
+// output coalescing, sent once per process
+static void setupCoalescing(mec::Midi_Processor &proc, mec::Preferences &p) {
+    if (!p.getBool("coalesce", false)) return;
+    proc.setCoalescing(true);
+    mec::MidiCoalescer *c = proc.getCoalescer();
+    c->setRunningStatus(p.getBool("running status", false));
+    c->setMaxRate(mec::MidiCoalescer::RATE_PITCHBEND, static_cast<unsigned>(p.getInt("max rate pitchbend", 0)));
+    c->setMaxRate(mec::MidiCoalescer::RATE_PRESSURE, static_cast<unsigned>(p.getInt("max rate pressure", 0)));
+    c->setMaxRate(mec::MidiCoalescer::RATE_CC, static_cast<unsigned>(p.getInt("max rate cc", 0)));
+    LOG_1("midi output coalescing enabled");
+}
+
 class MecMidiProcessor : public mec::Midi_Processor {
 public:
     MecMidiProcessor(mec::Preferences &p) : prefs_(p) {
         setPitchbendRange(static_cast<float>(p.getDouble("pitchbend range", 48.0f)));
+        setupCoalescing(*this, p);
         std::string device = prefs_.getString("device");
         int virt = prefs_.getInt("virtual", 0);
         if (output_.create(device, virt > 0)) {
@@ -184,14 +212,11 @@ public:
     bool isValid() { return output_.isOpen(); }
 
     void process(mec::Midi_Processor::MidiMsg &m) {
-        if (output_.isOpen()) {
-            std::vector<unsigned char> msg;
+        output_.send(reinterpret_cast<const unsigned char *>(m.data), m.size);
+    }
 
-            for (int i = 0; i < m.size; i++) {
-                msg.push_back((unsigned char) m.data[i]);
-            }
-            output_.sendMsg(msg);
-        }
+    void send(const unsigned char *data, unsigned size) override {
+        output_.send(data, size);
     }
 
 private:
@@ -206,6 +231,8 @@ public:
     MecMpeProcessor(mec::Preferences &p) : prefs_(p) {
         // p.getInt("voices", 15);
         setPitchbendRange(static_cast<float>(p.getDouble("pitchbend range", 48.0f)));
+        setHighResolution(p.getBool("high resolution", false));
+        setupCoalescing(*this, p);
         std::string device = prefs_.getString("device");
         int virt = prefs_.getInt("virtual", 0);
         if (output_.create(device, virt > 0)) {
@@ -221,14 +248,11 @@ public:
     bool isValid() { return output_.isOpen(); }
 
     void process(mec::MPE_Processor::MidiMsg &m) {
-        if (output_.isOpen()) {
-            std::vector<unsigned char> msg;
+        output_.send(reinterpret_cast<const unsigned char *>(m.data), m.size);
+    }
 
-            for (int i = 0; i < m.size; i++) {
-                msg.push_back((unsigned char) m.data[i]);
-            }
-            output_.sendMsg(msg);
-        }
+    void send(const unsigned char *data, unsigned size) override {
+        output_.send(data, size);
     }
 
 private:
@@ -294,17 +318,21 @@ void *mecapi_proc(void *arg) {
     }
 
     mecApi->init();
-
     {
-        std::unique_lock<std::mutex> lock(waitMtx);
-        while (keepRunning) {
-            mecApi->process();
-            waitCond.wait_for(lock, std::chrono::milliseconds(5));
-        }
+        std::lock_guard<std::mutex> lock(runningApiMtx);
+        runningApi = mecApi.get();
+    }
+
+    while (keepRunning) {
+        mecApi->waitAndProcess(MEC_WAIT_TIMEOUT_MS);
     }
 
     // delete the api, so that it can clean up
     LOG_0("mecapi_proc stopping");
+    {
+        std::lock_guard<std::mutex> lock(runningApiMtx);
+        runningApi = nullptr;
+    }
     mecApi.reset();
     sleep(1);
     LOG_0("mecapi_proc stopped");
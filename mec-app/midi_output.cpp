@@ -2,21 +2,68 @@
 
 #include "mec_app.h"
 
+#include <cstring>
 
-MidiOutput::MidiOutput() {
+// data bytes following a status byte, -1 for sysex (up to F7)
+static int dataLength(unsigned char status) {
+    switch (status & 0xF0) {
+        case 0xC0 :
+        case 0xD0 :
+            return 1;
+        case 0xF0 :
+            switch (status) {
+                case 0xF0 : return -1;
+                case 0xF1 :
+                case 0xF3 : return 1;
+                case 0xF2 : return 2;
+                default: return 0;
+            }
+        default:
+            return 2;
+    }
+}
+
+
+MidiOutput::MidiOutput() : virtualOpen_(false) {
+#ifdef MEC_MIDI_ALSA
+    seq_ = nullptr;
+    coder_ = nullptr;
+    seqPort_ = -1;
+    seqOpen_ = false;
+    raw_ = nullptr;
+#else
     try {
         output_.reset(new RtMidiOut(RtMidi::Api::UNSPECIFIED, "MEC MIDI OUTPUT"));
     } catch (RtMidiError &error) {
         LOG_0("Midi output ctor error:" << error.what());
     }
+#endif
 }
 
 MidiOutput::~MidiOutput() {
+#ifdef MEC_MIDI_ALSA
+    close();
+#endif
     output_.reset();
 }
 
 
 bool MidiOutput::create(const std::string &portname, bool virt) {
+#ifdef MEC_MIDI_ALSA
+    close();
+    if (!virt && portname.compare(0, 3, "hw:") == 0) return createRaw(portname);
+    if (createSeq(portname, virt)) return true;
+    if (seq_) return false; // sequencer available, but port not
+
+    // no sequencer, try rtmidi
+    if (!output_) {
+        try {
+            output_.reset(new RtMidiOut(RtMidi::Api::UNSPECIFIED, "MEC MIDI OUTPUT"));
+        } catch (RtMidiError &error) {
+            LOG_0("Midi output ctor error:" << error.what());
+        }
+    }
+#endif
 
     if (!output_) return false;
 
@@ -56,11 +103,80 @@ bool MidiOutput::create(const std::string &portname, bool virt) {
     return false;
 }
 
+bool MidiOutput::isOpen() {
+#ifdef MEC_MIDI_ALSA
+    if (raw_ || seqOpen_) return true;
+#endif
+    return (output_ && (virtualOpen_ || output_->isPortOpen()));
+}
+
+bool MidiOutput::send(const unsigned char *data, unsigned size) {
+#ifdef MEC_MIDI_ALSA
+    if (raw_) {
+        ssize_t res = snd_rawmidi_write(raw_, data, size);
+        if (res < 0) {
+            LOG_0("Midi output write error:" << snd_strerror(static_cast<int>(res)));
+            return false;
+        }
+        return true;
+    }
+    if (seqOpen_) return sendSeq(data, size);
+#endif
+    return sendRtMidi(data, size);
+}
+
 bool MidiOutput::sendMsg(std::vector<unsigned char> &msg) {
-    if (!isOpen()) return false;
+    return send(msg.data(), static_cast<unsigned>(msg.size()));
+}
+
+// rtmidi takes a single complete message, so split the buffer, and expand running status
+bool MidiOutput::sendRtMidi(const unsigned char *data, unsigned size) {
+    if (!output_ || !isOpen()) return false;
 
+    unsigned char msg[3];
+    unsigned char status = 0;
+    unsigned i = 0;
     try {
-        output_->sendMessage(&msg);
+        while (i < size) {
+            unsigned char b = data[i];
+            if (b >= 0xF8) {
+                // realtime, can appear anywhere
+                output_->sendMessage(data + i, 1);
+                i++;
+                continue;
+            }
+            if (b & 0x80) {
+                i++;
+                int len = dataLength(b);
+                if (len < 0) {
+                    unsigned end = i;
+                    while (end < size && data[end] != 0xF7) end++;
+                    if (end == size) break; // incomplete
+                    output_->sendMessage(data + i - 1, end - i + 2);
+                    i = end + 1;
+                    status = 0;
+                    continue;
+                }
+                // system common cancels running status
+                status = b < 0xF0 ? b : 0;
+                if (b >= 0xF0) {
+                    if (i + len > size) break;
+                    output_->sendMessage(data + i - 1, static_cast<size_t>(len + 1));
+                    i += len;
+                    continue;
+                }
+            } else if (status == 0) {
+                i++; // data without a status
+                continue;
+            }
+
+            unsigned len = static_cast<unsigned>(dataLength(status));
+            if (i + len > size) break;
+            msg[0] = status;
+            memcpy(msg + 1, data + i, len);
+            output_->sendMessage(msg, len + 1);
+            i += len;
+        }
     } catch (RtMidiError &error) {
         LOG_0("Midi output write error:" << error.what());
         return false;
@@ -68,3 +184,128 @@ bool MidiOutput::sendMsg(std::vector<unsigned char> &msg) {
     return true;
 }
 
+
+#ifdef MEC_MIDI_ALSA
+
+static const unsigned CODER_BUFFER_SIZE = 256;
+
+bool MidiOutput::createSeq(const std::string &portname, bool virt) {
+    if (snd_seq_open(&seq_, "default", SND_SEQ_OPEN_OUTPUT, 0) < 0) {
+        LOG_0("Midi output, alsa sequencer unavailable");
+        seq_ = nullptr;
+        return false;
+    }
+    snd_seq_set_client_name(seq_, "MEC MIDI OUTPUT");
+
+    seqPort_ = snd_seq_create_simple_port(seq_, "MIDI OUT",
+                                          SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ,
+                                          SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+    if (seqPort_ < 0 || snd_midi_event_new(CODER_BUFFER_SIZE, &coder_) < 0) {
+        LOG_0("Midi output create error: alsa port");
+        coder_ = nullptr;
+        return false;
+    }
+
+    if (virt) {
+        LOG_0("Midi virtual output created :" << portname);
+        seqOpen_ = true;
+        return true;
+    }
+
+    // match as rtmidi names ports "client:port c:p", or by client name, or client:port
+    snd_seq_client_info_t *cinfo;
+    snd_seq_port_info_t *pinfo;
+    snd_seq_client_info_alloca(&cinfo);
+    snd_seq_port_info_alloca(&pinfo);
+    const unsigned caps = SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE;
+    std::vector<std::string> available;
+
+    snd_seq_client_info_set_client(cinfo, -1);
+    while (snd_seq_query_next_client(seq_, cinfo) >= 0) {
+        int client = snd_seq_client_info_get_client(cinfo);
+        if (client == snd_seq_client_id(seq_)) continue;
+        snd_seq_port_info_set_client(pinfo, client);
+        snd_seq_port_info_set_port(pinfo, -1);
+        while (snd_seq_query_next_port(seq_, pinfo) >= 0) {
+            if ((snd_seq_port_info_get_capability(pinfo) & caps) != caps) continue;
+            int port = snd_seq_port_info_get_port(pinfo);
+            std::string clientName = snd_seq_client_info_get_name(cinfo);
+            std::string name = clientName + ":" + snd_seq_port_info_get_name(pinfo);
+            std::string full = name + " " + std::to_string(client) + ":" + std::to_string(port);
+            if (portname == full || portname == name || portname == clientName) {
+                if (snd_seq_connect_to(seq_, seqPort_, client, port) < 0) {
+                    LOG_0("Midi output create error: connecting to " << full);
+                    return false;
+                }
+                LOG_0("Midi output opened :" << full);
+                seqOpen_ = true;
+                return true;
+            }
+            available.push_back(full);
+        }
+    }
+
+    LOG_0("Port not found : [" << portname << "]");
+    LOG_0("available ports : ");
+    for (const std::string &name : available) {
+        LOG_0("[" << name << "]");
+    }
+    return false;
+}
+
+bool MidiOutput::createRaw(const std::string &portname) {
+    int res = snd_rawmidi_open(nullptr, &raw_, portname.c_str(), 0);
+    if (res < 0) {
+        LOG_0("Midi output create error:" << portname << " " << snd_strerror(res));
+        raw_ = nullptr;
+        return false;
+    }
+    LOG_0("Midi output opened (raw) :" << portname);
+    return true;
+}
+
+// all events are queued, then drained once
+bool MidiOutput::sendSeq(const unsigned char *data, unsigned size) {
+    snd_midi_event_reset_encode(coder_);
+    snd_seq_event_t ev;
+    unsigned i = 0;
+    while (i < size) {
+        snd_seq_ev_clear(&ev);
+        long n = snd_midi_event_encode(coder_, data + i, size - i, &ev);
+        if (n <= 0) {
+            LOG_0("Midi output encode error");
+            break;
+        }
+        i += static_cast<unsigned>(n);
+        if (ev.type == SND_SEQ_EVENT_NONE) continue; // incomplete
+        snd_seq_ev_set_source(&ev, seqPort_);
+        snd_seq_ev_set_subs(&ev);
+        snd_seq_ev_set_direct(&ev);
+        if (snd_seq_event_output(seq_, &ev) < 0) {
+            LOG_0("Midi output write error");
+            snd_seq_drop_output(seq_);
+            return false;
+        }
+    }
+    snd_seq_drain_output(seq_);
+    return i == size;
+}
+
+void MidiOutput::close() {
+    if (raw_) {
+        snd_rawmidi_close(raw_);
+        raw_ = nullptr;
+    }
+    if (coder_) {
+        snd_midi_event_free(coder_);
+        coder_ = nullptr;
+    }
+    if (seq_) {
+        snd_seq_close(seq_);
+        seq_ = nullptr;
+    }
+    seqPort_ = -1;
+    seqOpen_ = false;
+}
+
+#endif // MEC_MIDI_ALSA
@@ -4,7 +4,16 @@
 #include <memory>
 #include <RtMidi.h>
 
+#ifdef MEC_MIDI_ALSA
+#include <alsa/asoundlib.h>
+#endif
 
+// midi output port
+//
+// send() takes a buffer of one or more complete messages (running status allowed), nothing is allocated when sending.
+// on linux (when built with alsa, MEC_MIDI_ALSA) the alsa sequencer is used directly, all messages in a buffer
+// are sent with a single drain. a port name starting "hw:" opens that alsa raw midi device, and the buffer is written as is.
+// otherwise rtmidi is used, one message at a time.
 class MidiOutput {
 public:
     MidiOutput();
@@ -12,12 +21,28 @@ public:
 
     bool create(const std::string &portname, bool virt = false);
 
-    bool isOpen() { return (output_ && (virtualOpen_ || output_->isPortOpen())); }
+    bool isOpen();
 
+    bool send(const unsigned char *data, unsigned size);
     bool sendMsg(std::vector<unsigned char> &msg);
 private:
+    bool sendRtMidi(const unsigned char *data, unsigned size);
+
     std::unique_ptr<RtMidiOut> output_;
     bool virtualOpen_;
+
+#ifdef MEC_MIDI_ALSA
+    bool createSeq(const std::string &portname, bool virt);
+    bool createRaw(const std::string &portname);
+    bool sendSeq(const unsigned char *data, unsigned size);
+    void close();
+
+    snd_seq_t *seq_;
+    snd_midi_event_t *coder_;
+    int seqPort_;
+    bool seqOpen_;
+    snd_rawmidi_t *raw_;
+#endif
 };
 
 #endif //MEC_MIDI_OUTPUT_H
@@ -0,0 +1,134 @@
+#include "../midi_output.h"
+
+#include <mec_log.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+// benchmark the midi output send path, messages/sec and heap allocations per message
+// 16 mpe voices, each sending pitchbend, timbre and pressure every 1ms tick
+//   vector : a std::vector built per message, then sendMsg (as mec-app did)
+//   span   : each message sent from the caller's buffer
+//   batch  : a tick of messages in one buffer, with running status, sent at once
+// outputs to a virtual port, if one can't be created only the path up to the port is measured
+
+static std::atomic<unsigned long> allocations(0);
+
+// kept out of line, once inlined gcc pairs free() with operator new (-Wmismatched-new-delete)
+#ifdef _MSC_VER
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+void *operator new(std::size_t size) {
+    allocations++;
+    void *p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+BENCH_NOINLINE void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+BENCH_NOINLINE void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static const unsigned VOICES = 16;
+static const unsigned MSGS_PER_VOICE = 3;
+static const unsigned TICKS = 2000;
+static const unsigned RUNS = 5;
+static const unsigned NUM_MSGS = TICKS * VOICES * MSGS_PER_VOICE;
+
+typedef std::chrono::steady_clock Clock;
+
+struct Msg {
+    unsigned char data[3];
+    unsigned size;
+};
+
+static void tickMessages(unsigned tick, Msg *msgs) {
+    for (unsigned v = 0; v < VOICES; v++) {
+        unsigned ch = v;
+        unsigned pb = 0x2000 + ((tick * 7 + v) & 0xFFF);
+        Msg *m = msgs + v * MSGS_PER_VOICE;
+        m[0] = {{static_cast<unsigned char>(0xE0 | ch), static_cast<unsigned char>(pb & 0x7F), static_cast<unsigned char>(pb >> 7)}, 3};
+        m[1] = {{static_cast<unsigned char>(0xB0 | ch), 74, static_cast<unsigned char>((tick + v) & 0x7F)}, 3};
+        m[2] = {{static_cast<unsigned char>(0xD0 | ch), static_cast<unsigned char>((tick * 3 + v) & 0x7F), 0}, 2};
+    }
+}
+
+static void report(const char *name, double bestNs, unsigned long allocs) {
+    std::cout << name
+              << " msgs/sec: " << static_cast<unsigned long>(NUM_MSGS / (bestNs / 1e9))
+              << " ns/msg: " << bestNs / NUM_MSGS
+              << " allocs/msg: " << static_cast<double>(allocs) / NUM_MSGS
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    LOG_0("benchmark started");
+
+    MidiOutput output;
+    if (!output.create("MEC benchmark", true)) {
+        LOG_0("no virtual port, measuring without output");
+    }
+
+    std::vector<Msg> msgs(VOICES * MSGS_PER_VOICE);
+    std::vector<unsigned char> batch(msgs.size() * 3);
+
+    double bestVector = 1e18, bestSpan = 1e18, bestBatch = 1e18;
+    unsigned long allocVector = 0, allocSpan = 0, allocBatch = 0;
+
+    for (unsigned run = 0; run < RUNS; run++) {
+        unsigned long a = allocations;
+        Clock::time_point start = Clock::now();
+        for (unsigned t = 0; t < TICKS; t++) {
+            tickMessages(t, msgs.data());
+            for (const Msg &m : msgs) {
+                std::vector<unsigned char> msg;
+                for (unsigned i = 0; i < m.size; i++) msg.push_back(m.data[i]);
+                output.sendMsg(msg);
+            }
+        }
+        bestVector = std::min(bestVector, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        allocVector = allocations - a;
+
+        a = allocations;
+        start = Clock::now();
+        for (unsigned t = 0; t < TICKS; t++) {
+            tickMessages(t, msgs.data());
+            for (const Msg &m : msgs) output.send(m.data, m.size);
+        }
+        bestSpan = std::min(bestSpan, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        allocSpan = allocations - a;
+
+        a = allocations;
+        start = Clock::now();
+        for (unsigned t = 0; t < TICKS; t++) {
+            tickMessages(t, msgs.data());
+            unsigned size = 0;
+            unsigned char status = 0;
+            for (const Msg &m : msgs) {
+                if (m.data[0] != status) batch[size++] = status = m.data[0];
+                for (unsigned i = 1; i < m.size; i++) batch[size++] = m.data[i];
+            }
+            output.send(batch.data(), size);
+        }
+        bestBatch = std::min(bestBatch, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        allocBatch = allocations - a;
+    }
+
+    report("vector ", bestVector, allocVector);
+    report("span   ", bestSpan, allocSpan);
+    report("batch  ", bestBatch, allocBatch);
+
+    LOG_0("benchmark completed");
+    return 0;
+}
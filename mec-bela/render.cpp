@@ -138,6 +138,9 @@ public:
     }
 };
 
+// polled from an auxiliary task scheduled each render, rather than blocking in waitAndProcess.
+// bela auxiliary tasks are xenomai tasks, waiting on the api's condition variable, which device
+// threads outside of xenomai signal, would move the task out of the real time domain.
 void mecProcess(void* pvMec) {
 	MecApi *pMecApi = (MecApi*) pvMec;
 	pMecApi->process();
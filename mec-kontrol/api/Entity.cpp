@@ -1,6 +1,122 @@
 #include "Entity.h"
 
+#include <atomic>
+#include <mutex>
+
+#include <mec_log.h>
+
 namespace Kontrol {
 
+// ids index fixed size chunks of strings, and are found from a string by an open addressed hash table of ids.
+// lookups take no lock, adding an id locks, writes its string, then publishes it in the table.
+// tables are replaced when they grow, but never freed, as a lookup may still be using one
+static const unsigned ID_CHUNK_BITS = 10;
+static const unsigned ID_CHUNK_SIZE = 1 << ID_CHUNK_BITS;
+static const unsigned ID_MAX_CHUNKS = 4096;
+static const unsigned ID_MIN_SLOTS = 1024;
+
+struct EntityIdSlots {
+    EntityIdSlots(unsigned size) : mask_(size - 1), slots_(new std::atomic<uint32_t>[size]) {
+        for (unsigned i = 0; i < size; i++) slots_[i].store(0);
+    }
+
+    uint32_t mask_;
+    std::atomic<uint32_t> *slots_;
+};
+
+struct EntityIdTable {
+    EntityIdTable() : slots_(new EntityIdSlots(ID_MIN_SLOTS)), next_(1) {
+        for (auto &c : chunks_) c.store(nullptr);
+    }
+
+    const std::string &str(uint32_t id) const {
+        return chunks_[id >> ID_CHUNK_BITS].load(std::memory_order_acquire)[id & (ID_CHUNK_SIZE - 1)];
+    }
+
+    uint32_t find(const EntityIdSlots &slots, uint32_t hash, const char *id, size_t len) const {
+        for (uint32_t i = hash & slots.mask_;; i = (i + 1) & slots.mask_) {
+            uint32_t n = slots.slots_[i].load(std::memory_order_acquire);
+            if (n == 0) return 0;
+            const std::string &s = str(n);
+            if (s.size() == len && std::memcmp(s.data(), id, len) == 0) return n;
+        }
+    }
+
+    static void insert(EntityIdSlots &slots, uint32_t hash, uint32_t n) {
+        uint32_t i = hash & slots.mask_;
+        while (slots.slots_[i].load(std::memory_order_relaxed) != 0) i = (i + 1) & slots.mask_;
+        slots.slots_[i].store(n, std::memory_order_release);
+    }
+
+    static uint32_t hash(const char *id, size_t len) {
+        uint32_t h = 2166136261u; // fnv-1a
+        for (size_t i = 0; i < len; i++) {
+            h ^= static_cast<unsigned char>(id[i]);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    std::mutex mutex_;
+    std::atomic<EntityIdSlots *> slots_;
+    std::atomic<std::string *> chunks_[ID_MAX_CHUNKS];
+    uint32_t next_; // 0 is the empty id
+};
+
+static EntityIdTable &idTable() {
+    static EntityIdTable table;
+    return table;
+}
+
+uint32_t EntityId::intern(const char *id, size_t len) {
+    if (len == 0) return 0;
+    EntityIdTable &table = idTable();
+    uint32_t hash = EntityIdTable::hash(id, len);
+    uint32_t n = table.find(*table.slots_.load(std::memory_order_acquire), hash, id, len);
+    if (n != 0) return n;
+
+    std::lock_guard<std::mutex> lock(table.mutex_);
+    EntityIdSlots *slots = table.slots_.load(std::memory_order_relaxed);
+    n = table.find(*slots, hash, id, len);
+    if (n != 0) return n;
+
+    n = table.next_;
+    unsigned chunk = n >> ID_CHUNK_BITS;
+    if (chunk >= ID_MAX_CHUNKS) {
+        LOG_0("EntityId table full, cannot add " << std::string(id, len));
+        return 0;
+    }
+    std::string *strs = table.chunks_[chunk].load(std::memory_order_relaxed);
+    if (strs == nullptr) {
+        strs = new std::string[ID_CHUNK_SIZE];
+        table.chunks_[chunk].store(strs, std::memory_order_release);
+    }
+    strs[n & (ID_CHUNK_SIZE - 1)].assign(id, len);
+    table.next_++;
+
+    // keep the table at most half full
+    if (table.next_ * 2 > slots->mask_ + 1) {
+        EntityIdSlots *grown = new EntityIdSlots((slots->mask_ + 1) * 2);
+        for (uint32_t i = 1; i < n; i++) {
+            const std::string &s = table.str(i);
+            EntityIdTable::insert(*grown, EntityIdTable::hash(s.data(), s.size()), i);
+        }
+        EntityIdTable::insert(*grown, hash, n);
+        table.slots_.store(grown, std::memory_order_release);
+    } else {
+        EntityIdTable::insert(*slots, hash, n);
+    }
+    return n;
+}
+
+const std::string &EntityId::str() const {
+    static const std::string empty;
+    if (id_ == 0) return empty;
+    return idTable().str(id_);
+}
+
+std::ostream &operator<<(std::ostream &os, const EntityId &id) {
+    return os << id.str();
+}
 
-} //namespace
\ No newline at end of file
+} //namespace
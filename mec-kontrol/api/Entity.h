@@ -2,6 +2,10 @@
 
 #include <unordered_map>
 #include <string>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
 #include <vector>
 #include <memory>
 
@@ -11,23 +15,36 @@ class Preferences;
 
 namespace Kontrol {
 
-// Eventually give its own type, but will need to be able to be used in maps, ostream etc.
-// class EntityId {
-// public:
-//     EntityId()  { ; }
-//     EntityId(const std::string& id) : id_(id) { ; }
-//     EntityId(const EntityId& id) : id_(id.id_) { ; }
-//     bool valid() { return !id_.empty();}
+// interned id, compared and hashed as its 32 bit value
+// the string is held in a global table (shared by all threads, never removed), and is only needed for display
+// and serialisation. ordering is by string, so ordered containers keep their alphabetic order
+class EntityId {
+public:
+    EntityId() : id_(0) { ; }
+    EntityId(const std::string &id) : id_(intern(id.data(), id.size())) { ; }
+    EntityId(const char *id) : id_(intern(id, std::strlen(id))) { ; }
+
+    const std::string &str() const;
+    const char *c_str() const { return str().c_str(); }
+    operator const std::string &() const { return str(); }
+
+    bool empty() const { return id_ == 0; }
+    uint32_t value() const { return id_; }
+
+    friend bool operator==(const EntityId &a, const EntityId &b) { return a.id_ == b.id_; }
+    friend bool operator!=(const EntityId &a, const EntityId &b) { return a.id_ != b.id_; }
+    friend bool operator<(const EntityId &a, const EntityId &b) { return a.id_ != b.id_ && a.str() < b.str(); }
+
+    friend std::string operator+(const std::string &a, const EntityId &b) { return a + b.str(); }
+    friend std::string operator+(const EntityId &a, const std::string &b) { return a.str() + b; }
 
-//     // operator const char*() { return id_.c_str();}
-//     operator std::string() { return id_;}
-//     EntityId& operator =(const EntityId& id) { id_=id.id_; return *this;}
+private:
+    static uint32_t intern(const char *id, size_t len);
 
-// private:
-//     std::string id_;
-// };
+    uint32_t id_;
+};
 
-typedef std::string EntityId;
+std::ostream &operator<<(std::ostream &os, const EntityId &id);
 
 class Entity {
 public:
@@ -53,17 +70,24 @@ public:
     Page(
         const EntityId& id,
         const std::string& displayName,
-        const std::vector<std::string> paramIds
+        const std::vector<EntityId> paramIds
     ) : Entity(id, displayName),
         paramIds_(paramIds) {
     ;
 }
-    const std::vector<std::string>& paramIds() const { return paramIds_;}
+    const std::vector<EntityId>& paramIds() const { return paramIds_;}
 
 private:
-    std::vector<std::string> paramIds_;
+    std::vector<EntityId> paramIds_;
 };
 
 } //namespace
 
+namespace std {
+template<>
+struct hash<Kontrol::EntityId> {
+    size_t operator()(const Kontrol::EntityId &id) const { return id.value(); }
+};
+}
+
 
@@ -16,7 +16,7 @@ std::shared_ptr<KontrolModel> KontrolModel::model() {
 //     model_.reset();
 // }
 
-KontrolModel::KontrolModel() {
+KontrolModel::KontrolModel() : changeInterval_(0) {
 }
 
 void KontrolModel::publishMetaData() const {
@@ -64,11 +64,8 @@ std::shared_ptr<Rack> KontrolModel::getLocalRack() const {
 }
 
 std::shared_ptr<Rack> KontrolModel::getRack(const EntityId &rackId) const {
-    try {
-        return racks_.at(rackId);
-    } catch (const std::out_of_range &) {
-        return nullptr;
-    }
+    auto rack = racks_.find(rackId);
+    return rack != racks_.end() ? rack->second : nullptr;
 }
 
 std::shared_ptr<Module> KontrolModel::getModule(const std::shared_ptr<Rack> &rack, const EntityId &moduleId) const {
@@ -230,7 +227,7 @@ void KontrolModel::deleteRack(ChangeSource src, const EntityId &rackId)
     auto rack = getRack(rackId);
     if (rack)
     {
-        for (auto i : listeners_) {
+        for (const auto &i : listeners_) {
             (i.second)->deleteRack(src, *rack);
         }
     }
@@ -242,7 +239,7 @@ void KontrolModel::activeModule(ChangeSource src, const EntityId &rackId ,const
     auto rack = getRack(rackId);
     auto module = getModule(rack, moduleId);
     if (module != nullptr) {
-        for (auto i : listeners_) {
+        for (const auto &i : listeners_) {
             (i.second)->activeModule(src, *rack, *module);
         }
     }
@@ -256,7 +253,7 @@ void KontrolModel::createResource(ChangeSource src,
     auto rack = getRack(rackId);
     if (rack == nullptr) return;
     rack->addResource(resType, resValue);
-    for (auto i : listeners_) {
+    for (const auto &i : listeners_) {
         (i.second)->resource(src, *rack, resType, resValue);
     }
 }
@@ -273,7 +270,7 @@ std::shared_ptr<Parameter> KontrolModel::changeParam(
     auto param = getParam(module, paramId);
     if (param == nullptr) return nullptr;
 
-    if (module->changeParam(paramId, v, src == CS_PRESET)) {
+    if (param->change(v, src == CS_PRESET)) {
         publishChanged(src, *rack, *module, *param);
     }
     return param;
@@ -291,7 +288,7 @@ void KontrolModel::assignMidiCC(ChangeSource src, const EntityId &rackId, const
 
         rack->addMidiCCMapping(midiCC, moduleId, paramId);
 
-        for (auto i : listeners_) {
+        for (const auto &i : listeners_) {
             (i.second)->assignMidiCC(src, *rack, *module, *param, midiCC);
         }
     }
@@ -308,7 +305,7 @@ void KontrolModel::unassignMidiCC(ChangeSource src, const EntityId &rackId, cons
         auto param = getParam(module, paramId);
         if (param == nullptr) return;
 
-        for (auto i : listeners_) {
+        for (const auto &i : listeners_) {
             (i.second)->unassignMidiCC(src, *rack, *module, *param, midiCC);
         }
     }
@@ -321,7 +318,7 @@ void KontrolModel::updatePreset(ChangeSource src, const EntityId &rackId, std::s
     } else {
         auto rack = getRack(rackId);
         if (rack == nullptr) return;
-        for (auto i : listeners_) {
+        for (const auto &i : listeners_) {
             (i.second)->updatePreset(src, *rack, preset);
         }
     }
@@ -333,7 +330,7 @@ void KontrolModel::applyPreset(ChangeSource src, const EntityId &rackId, std::st
     } else {
         auto rack = getRack(rackId);
         if (rack == nullptr) return;
-        for (auto i : listeners_) {
+        for (const auto &i : listeners_) {
             (i.second)->applyPreset(src, *rack, preset);
         }
     }
@@ -345,7 +342,7 @@ void KontrolModel::saveSettings(ChangeSource src, const EntityId &rackId) {
     } else {
         auto rack = getRack(rackId);
         if (rack == nullptr) return;
-        for (auto i : listeners_) {
+        for (const auto &i : listeners_) {
             (i.second)->saveSettings(src, *rack);
         }
     }
@@ -356,7 +353,7 @@ void KontrolModel::ping(
         const std::string &host,
         unsigned port,
         unsigned keepAlive) const {
-    for (auto i : listeners_) {
+    for (const auto &i : listeners_) {
         (i.second)->ping(src, host, port, keepAlive);
     }
 }
@@ -368,26 +365,26 @@ void KontrolModel::loadModule(ChangeSource src,
                               const std::string &moduleType) {
     auto rack = getRack(rackId);
     if (rack == nullptr) return;
-    for (auto i : listeners_) {
+    for (const auto &i : listeners_) {
         (i.second)->loadModule(src, *rack, moduleId, moduleType);
     }
 }
 
 
 void KontrolModel::publishRack(ChangeSource src, const Rack &rack) const {
-    for (auto i : listeners_) {
+    for (const auto &i : listeners_) {
         (i.second)->rack(src, rack);
     }
 }
 
 void KontrolModel::publishModule(ChangeSource src, const Rack &rack, const Module &module) const {
-    for (auto i : listeners_) {
+    for (const auto &i : listeners_) {
         (i.second)->module(src, rack, module);
     }
 }
 
 void KontrolModel::publishPage(ChangeSource src, const Rack &rack, const Module &module, const Page &page) const {
-    for (auto i : listeners_) {
+    for (const auto &i : listeners_) {
         (i.second)->page(src, rack, module, page);
     }
 
@@ -395,7 +392,7 @@ void KontrolModel::publishPage(ChangeSource src, const Rack &rack, const Module
 
 void KontrolModel::publishParam(ChangeSource src, const Rack &rack, const Module &module,
                                 const Parameter &param) const {
-    for (auto i : listeners_) {
+    for (const auto &i : listeners_) {
         (i.second)->param(src, rack, module, param);
     }
 
@@ -403,15 +400,85 @@ void KontrolModel::publishParam(ChangeSource src, const Rack &rack, const Module
 
 void KontrolModel::publishChanged(ChangeSource src, const Rack &rack, const Module &module,
                                   const Parameter &param) const {
-    for (auto i : listeners_) {
-        (i.second)->changed(src, rack, module, param);
+    bool coalesce = false;
+    for (const auto &i : listeners_) {
+        if (changeInterval_.count() > 0 && (i.second)->coalesceChanges()) {
+            coalesce = true;
+        } else {
+            (i.second)->changed(src, rack, module, param);
+        }
+    }
+    if (!coalesce) return;
+    std::lock_guard<std::mutex> lock(changedMtx_);
+    markChanged(src, rack, module, param);
+}
+
+void KontrolModel::publishChanged(ChangeSource src, const Rack &rack, const ParamChanges &changes) const {
+    if (changes.empty()) return;
+    bool coalesce = false;
+    for (const auto &i : listeners_) {
+        if (changeInterval_.count() > 0 && (i.second)->coalesceChanges()) {
+            coalesce = true;
+            continue;
+        }
+        (i.second)->beginChanges();
+        for (const auto &c : changes) {
+            (i.second)->changed(src, rack, *c.first, *c.second);
+        }
+        (i.second)->endChanges();
+    }
+    if (!coalesce) return;
+    std::lock_guard<std::mutex> lock(changedMtx_);
+    for (const auto &c : changes) {
+        markChanged(src, rack, *c.first, *c.second);
+    }
+}
+
+// only mark as changed, the value is read when flushed
+void KontrolModel::markChanged(ChangeSource src, const Rack &rack, const Module &module,
+                               const Parameter &param) const {
+    ChangedParam changed = {src, rack.id(), module.id(), param.id()};
+    auto idx = changedIdx_.find(changed);
+    if (idx == changedIdx_.end()) {
+        changedIdx_[changed] = static_cast<unsigned>(changed_.size());
+        changed_.push_back(changed);
+    } else {
+        changed_[idx->second].src_ = src;
+    }
+}
+
+bool KontrolModel::flushChanges(bool force) {
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - lastFlush_ < changeInterval_) return false;
+    lastFlush_ = now;
+
+    // changes made by listeners (or other threads) while flushing, are published on the next flush
+    std::vector<ChangedParam> changed;
+    {
+        std::lock_guard<std::mutex> lock(changedMtx_);
+        if (changed_.empty()) return false;
+        changed.swap(changed_);
+        changedIdx_.clear();
+    }
+
+    for (const auto &i : listeners_) {
+        if (!(i.second)->coalesceChanges()) continue;
+        (i.second)->beginChanges();
+        for (const auto &c : changed) {
+            auto rack = getRack(c.rackId_);
+            auto module = getModule(rack, c.moduleId_);
+            auto param = getParam(module, c.paramId_);
+            if (param != nullptr) (i.second)->changed(c.src_, *rack, *module, *param);
+        }
+        (i.second)->endChanges();
     }
+    return true;
 }
 
 
 void KontrolModel::publishResource(ChangeSource src, const Rack &rack,
                                    const std::string &type, const std::string &res) const {
-    for (auto i : listeners_) {
+    for (const auto &i : listeners_) {
         (i.second)->resource(src, rack, type, res);
     }
 }
@@ -422,7 +489,7 @@ void KontrolModel::publishMidiMapping(ChangeSource src, const Rack &rack, const
         for (auto j : k.second) {
             auto parameter = module.getParam(j);
             if (parameter) {
-                for (auto i : listeners_) {
+                for (const auto &i : listeners_) {
                     (i.second)->assignMidiCC(src, rack, module, *parameter, k.first);
                 }
             }
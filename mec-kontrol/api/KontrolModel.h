@@ -3,6 +3,9 @@
 #include <unordered_map>
 #include <string>
 #include <memory>
+#include <vector>
+#include <chrono>
+#include <mutex>
 
 #include "Entity.h"
 #include "Rack.h"
@@ -45,6 +48,15 @@ public:
     virtual void loadModule(ChangeSource, const Rack &, const EntityId &, const std::string &) { ; }
 
     virtual void stop() { ; }
+
+    // when true, and the model has a change interval, changed() is called from KontrolModel::flushChanges,
+    // once per changed parameter with its latest value, between beginChanges() and endChanges()
+    // changes published together (e.g. a preset) are also between beginChanges() and endChanges()
+    virtual bool coalesceChanges() { return false; }
+
+    virtual void beginChanges() { ; }
+
+    virtual void endChanges() { ; }
 };
 
 
@@ -159,9 +171,22 @@ public:
     void publishPage(ChangeSource src, const Rack &, const Module &, const Page &) const;
     void publishParam(ChangeSource src, const Rack &, const Module &, const Parameter &) const;
     void publishChanged(ChangeSource src, const Rack &, const Module &, const Parameter &) const;
+
+    typedef std::vector<std::pair<const Module *, const Parameter *>> ParamChanges;
+    void publishChanged(ChangeSource src, const Rack &, const ParamChanges &changes) const;
     void publishResource(ChangeSource src, const Rack &, const std::string &, const std::string &) const;
     void publishMidiMapping(ChangeSource src, const Rack &, const Module &, const MidiMap &midiMap) const;
 
+    // coalescing of parameter changes, for listeners that opt in (see KontrolCallback::coalesceChanges)
+    // 0 = off, all listeners are called on each change
+    void setChangeInterval(unsigned ms) { changeInterval_ = std::chrono::milliseconds(ms); }
+
+    unsigned changeInterval() const { return static_cast<unsigned>(changeInterval_.count()); }
+
+    // call regularly (from one thread), publishes changes since the last flush once the change interval has passed
+    // changes may be published from other threads meanwhile
+    bool flushChanges(bool force = false);
+
     bool loadSettings(const EntityId &rackId, const std::string &filename);
     bool loadModuleDefinitions(const EntityId &rackId, const EntityId &moduleId, const std::string &filename);
     bool loadModuleDefinitions(const EntityId &rackId, const EntityId &moduleId, const mec::Preferences &prefs);
@@ -171,9 +196,39 @@ private:
     void publishMetaData(const std::shared_ptr<Rack> &rack, const std::shared_ptr<Module> &module) const;
 
     KontrolModel();
+
+    // caller holds changedMtx_
+    void markChanged(ChangeSource src, const Rack &, const Module &, const Parameter &) const;
+
+    struct ChangedParam {
+        ChangeSource src_;
+        EntityId rackId_;
+        EntityId moduleId_;
+        EntityId paramId_;
+    };
+
+    struct ChangedParamHash {
+        size_t operator()(const ChangedParam &p) const {
+            return (p.rackId_.value() * 31 + p.moduleId_.value()) * 31 + p.paramId_.value();
+        }
+    };
+
+    struct ChangedParamEqual {
+        bool operator()(const ChangedParam &a, const ChangedParam &b) const {
+            return a.paramId_ == b.paramId_ && a.moduleId_ == b.moduleId_ && a.rackId_ == b.rackId_;
+        }
+    };
+
     std::shared_ptr<Rack> localRack_;
     std::unordered_map<EntityId, std::shared_ptr<Rack>> racks_;
     std::unordered_map<std::string, std::shared_ptr<KontrolCallback> > listeners_; // key = source : host:ip
+
+    std::chrono::milliseconds changeInterval_;
+    std::chrono::steady_clock::time_point lastFlush_;
+    // changed since last flush, in order of first change, index = position in changed_
+    mutable std::mutex changedMtx_;
+    mutable std::vector<ChangedParam> changed_;
+    mutable std::unordered_map<ChangedParam, unsigned, ChangedParamHash, ChangedParamEqual> changedIdx_;
 };
 
 } //namespace
@@ -25,18 +25,21 @@ std::string Module::getParamId(const EntityId& pageId, unsigned paramNum) {
 #endif
 
 
+unsigned Module::layoutVersion_ = 0;
+
 // Module
 std::shared_ptr<Parameter> Module::createParam(const std::vector<ParamValue> &args) {
     auto p = Parameter::create(args);
     if (p->valid()) {
         parameters_[p->id()] = p;
+        layoutVersion_++;
         return p;
     }
     return nullptr;
 }
 
 bool Module::changeParam(const EntityId &paramId, const ParamValue &value, bool force) {
-    auto p = parameters_[paramId];
+    auto p = getParam(paramId);
     if (p != nullptr) {
         if (p->change(value, force)) {
             return true;
@@ -71,7 +74,8 @@ std::shared_ptr<Page> Module::getPage(const EntityId &pageId) {
 }
 
 std::shared_ptr<Parameter> Module::getParam(const EntityId &paramId) {
-    return parameters_[paramId];
+    auto parameter = parameters_.find(paramId);
+    return parameter != parameters_.end() ? parameter->second : nullptr;
 }
 
 std::shared_ptr<Parameter> Module::getParam(const EntityId & paramId) const
@@ -118,6 +122,7 @@ bool Module::loadModuleDefinitions(const mec::Preferences &module) {
     pages_.clear();
     pageIds_.clear();
     midi_mapping_.clear();
+    layoutVersion_++;
 
     if (module.exists("parameters")) {
         // load parameters
@@ -165,7 +170,7 @@ bool Module::loadModuleDefinitions(const mec::Preferences &module) {
             if (page.getSize() < 2) return false; // need id, displayname
             auto id = page.getString(0);
             std::string displayname = page.getString(1);
-            std::vector<std::string> paramIds;
+            std::vector<EntityId> paramIds;
             mec::Preferences::Array paramArray(page.getArray(2));
             for (int j = 0; j < paramArray.getSize(); j++) {
                 paramIds.push_back(paramArray.getString(j));
@@ -183,7 +188,7 @@ void Module::dumpParameters() {
     // print by page , this will miss anything not on a page, but gives a clear way of setting things
     LOG_1("Parameter Dump : " << displayName_ << " : " << type_);
     LOG_1("----------------------");
-    for (std::string pageId : pageIds_) {
+    for (const EntityId &pageId : pageIds_) {
         auto page = pages_[pageId];
         if (page == nullptr) {
             LOG_1("Page not found: " << pageId);
@@ -191,7 +196,7 @@ void Module::dumpParameters() {
         }
         LOG_1(page->id());
         LOG_1(page->displayName());
-        for (std::string paramId : page->paramIds()) {
+        for (const EntityId &paramId : page->paramIds()) {
             auto param = parameters_[paramId];
             if (param == nullptr) {
                 LOG_1("Parameter not found:" << paramId);
@@ -222,7 +227,7 @@ void Module::dumpCurrentValues() {
     // print by page , this will miss anything not on a page, but gives a clear way of setting things
     LOG_1("Current Values Dump");
     LOG_1("-------------------");
-    for (std::string pageId : pageIds_) {
+    for (const EntityId &pageId : pageIds_) {
         auto page = pages_[pageId];
         if (page == nullptr) {
             LOG_1("Page not found: " << pageId);
@@ -266,6 +271,7 @@ void Module::addMidiCCMapping(unsigned ccnum, const EntityId &paramId) {
         }
     }
     midi_mapping_[ccnum].push_back(paramId);
+    layoutVersion_++;
 }
 
 void Module::removeMidiCCMapping(unsigned ccnum, const EntityId &paramId) {
@@ -274,6 +280,7 @@ void Module::removeMidiCCMapping(unsigned ccnum, const EntityId &paramId) {
         if (*it == paramId) {
             v.erase(it);
             midi_mapping_[ccnum] = v;
+            layoutVersion_++;
             return;
         }
     }
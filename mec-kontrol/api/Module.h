@@ -68,14 +68,23 @@ public:
 
     MidiMap getMidiMapping() { return midi_mapping_; }
 
-    void setMidiMapping(const MidiMap &map) { midi_mapping_ = map; }
+    void setMidiMapping(const MidiMap &map) {
+        midi_mapping_ = map;
+        layoutVersion_++;
+    }
+
+    // changes when parameters or midi mappings of any module are added or replaced,
+    // racks rebuild their midi cc table when it differs from the one it was built at
+    static unsigned layoutVersion() { return layoutVersion_; }
 
 private:
+    static unsigned layoutVersion_;
+
     std::string type_;
 
-    std::vector<std::string> pageIds_; // ordered list of page id, for presentation
-    std::unordered_map<std::string, std::shared_ptr<Parameter> > parameters_; // key = paramId
-    std::unordered_map<std::string, std::shared_ptr<Page> > pages_; // key = pageId
+    std::vector<EntityId> pageIds_; // ordered list of page id, for presentation
+    std::unordered_map<EntityId, std::shared_ptr<Parameter> > parameters_; // key = paramId
+    std::unordered_map<EntityId, std::shared_ptr<Page> > pages_; // key = pageId
     MidiMap midi_mapping_; // key CC id, value = paramId
 
 };
@@ -11,11 +11,17 @@ namespace Kontrol {
 #define POLL_TIMEOUT_MS 1000
 
 OSCBroadcaster::OSCBroadcaster(Kontrol::ChangeSource src, unsigned keepAlive, bool master) :
-        master_(master),
         port_(0),
+        keepAliveTime_(keepAlive),
+        queue_(QUEUE_SIZE),
+        reportedOverflows_(0),
+        master_(master),
+        running_(false),
         changeSource_(src),
-        keepAliveTime_(keepAlive) {
-    PaUtil_InitializeRingBuffer(&messageQueue_, sizeof(OscMsg), OscMsg::MAX_N_OSC_MSGS, msgData_);
+        coalesce_(true),
+        batching_(false),
+        batch_(nullptr),
+        batchSize_(0) {
 }
 
 OSCBroadcaster::~OSCBroadcaster() {
@@ -34,7 +40,7 @@ bool OSCBroadcaster::connect(const std::string &host, unsigned port) {
     try {
         host_ = host;
         port_ = port;
-        socket_ = std::shared_ptr<UdpTransmitSocket>(new UdpTransmitSocket(IpEndpointName(host.c_str(), port_)));
+        socket_ = std::shared_ptr<OSCPacketSocket>(new OSCPacketSocket(host, port_));
     } catch (const std::runtime_error &e) {
         port_ = 0;
         socket_.reset();
@@ -46,31 +52,39 @@ bool OSCBroadcaster::connect(const std::string &host, unsigned port) {
 }
 
 void OSCBroadcaster::stop() {
-    flush();
-    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(write_lock_);
+        running_ = false;
+    }
     if (socket_) {
+        write_cond_.notify_one();
         writer_thread_.join();
-        PaUtil_FlushRingBuffer(&messageQueue_);
+        queue_.clear();
     }
     port_ = 0;
     socket_.reset();
 }
 
 
+// the writer thread is the only reader of the queue, and sends what is queued before it exits
 void OSCBroadcaster::writePoll() {
     std::unique_lock<std::mutex> lock(write_lock_);
     while (running_) {
         flush();
         write_cond_.wait_for(lock, std::chrono::milliseconds(POLL_TIMEOUT_MS));
     }
+    flush();
 }
 
 void OSCBroadcaster::flush()
 {
-    while (PaUtil_GetRingBufferReadAvailable(&messageQueue_)) {
-        OscMsg msg;
-        PaUtil_ReadRingBuffer(&messageQueue_, &msg, 1);
-        socket_->Send(msg.buffer_, msg.size_);
+    queue_.flush(*socket_);
+
+    unsigned long overflows = queue_.overflows();
+    if (overflows != reportedOverflows_) {
+        LOG_1("OSCBroadcaster queue full, dropped " << overflows - reportedOverflows_
+                                                     << " packets to " << host_ << ":" << port_);
+        reportedOverflows_ = overflows;
     }
 }
 
@@ -88,25 +102,23 @@ bool OSCBroadcaster::isActive() {
 }
 
 
-void OSCBroadcaster::send(const char *data, unsigned size) {
-    OscMsg msg;
-//    {
-//        static unsigned maxsize = 0;
-//        if(size>maxsize) {
-//            maxsize = size;
-//            LOG_0("OSCBroadcaster MAXSIZE " << maxsize);
-//        }
-//    }
-    msg.size_ = (size > OscMsg::MAX_OSC_MESSAGE_SIZE ? OscMsg::MAX_OSC_MESSAGE_SIZE : size);
-    memcpy(msg.buffer_, data, (size_t) msg.size_);
-    PaUtil_WriteRingBuffer(&messageQueue_, (void *) &msg, 1);
+// packets are encoded in place in the queue, or in buffer_ and dropped if the queue is full
+char *OSCBroadcaster::beginPacket() {
+    if (batch_ != nullptr) sendBatch();
+    char *packet = queue_.reserve(MAX_PACKET_SIZE);
+    return packet != nullptr ? packet : buffer_;
+}
+
+void OSCBroadcaster::endPacket(const osc::OutboundPacketStream &ops) {
+    if (ops.Data() == buffer_) return;
+    queue_.commit(static_cast<unsigned>(ops.Size()));
     write_cond_.notify_one();
 }
 
 void OSCBroadcaster::sendPing(unsigned port) {
     if (!socket_) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/ping")
@@ -115,7 +127,7 @@ void OSCBroadcaster::sendPing(unsigned port) {
         << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 bool OSCBroadcaster::broadcastChange(ChangeSource src) {
@@ -176,7 +188,7 @@ void OSCBroadcaster::assignMidiCC(ChangeSource src, const Rack &rack, const Modu
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/assignMidiCC")
@@ -188,7 +200,7 @@ void OSCBroadcaster::assignMidiCC(ChangeSource src, const Rack &rack, const Modu
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 void OSCBroadcaster::unassignMidiCC(ChangeSource src, const Rack &rack, const Module &module, const Parameter &p,
@@ -196,7 +208,7 @@ void OSCBroadcaster::unassignMidiCC(ChangeSource src, const Rack &rack, const Mo
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/unassignMidiCC")
@@ -208,7 +220,7 @@ void OSCBroadcaster::unassignMidiCC(ChangeSource src, const Rack &rack, const Mo
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 
@@ -216,7 +228,7 @@ void OSCBroadcaster::updatePreset(ChangeSource src, const Rack &rack, std::strin
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/updatePreset")
@@ -226,13 +238,13 @@ void OSCBroadcaster::updatePreset(ChangeSource src, const Rack &rack, std::strin
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 void OSCBroadcaster::applyPreset(ChangeSource src, const Rack &rack, std::string preset) {
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/applyPreset")
@@ -242,14 +254,14 @@ void OSCBroadcaster::applyPreset(ChangeSource src, const Rack &rack, std::string
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 void OSCBroadcaster::saveSettings(ChangeSource src, const Rack &rack) {
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/saveSettings")
         << rack.id().c_str();
@@ -257,7 +269,7 @@ void OSCBroadcaster::saveSettings(ChangeSource src, const Rack &rack) {
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 
@@ -266,7 +278,7 @@ void OSCBroadcaster::loadModule(ChangeSource src, const Rack &rack, const Entity
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/loadModule")
         << rack.id().c_str()
@@ -276,7 +288,7 @@ void OSCBroadcaster::loadModule(ChangeSource src, const Rack &rack, const Entity
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 
@@ -284,7 +296,7 @@ void OSCBroadcaster::rack(ChangeSource src, const Rack &p) {
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/rack")
@@ -295,7 +307,7 @@ void OSCBroadcaster::rack(ChangeSource src, const Rack &p) {
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 
@@ -305,7 +317,7 @@ void OSCBroadcaster::module(ChangeSource src, const Rack &rack, const Module &m)
 
 //    LOG_0("OSCBroadcaster::module " << m.id());
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/module")
@@ -317,7 +329,7 @@ void OSCBroadcaster::module(ChangeSource src, const Rack &rack, const Module &m)
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 
@@ -325,7 +337,7 @@ void OSCBroadcaster::page(ChangeSource src, const Rack &rack, const Module &modu
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/page")
@@ -334,21 +346,21 @@ void OSCBroadcaster::page(ChangeSource src, const Rack &rack, const Module &modu
         << p.id().c_str()
         << p.displayName().c_str();
 
-    for (const std::string &paramId : p.paramIds()) {
+    for (const EntityId &paramId : p.paramIds()) {
         ops << paramId.c_str();
     }
 
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 void OSCBroadcaster::param(ChangeSource src, const Rack &rack, const Module &module, const Parameter &p) {
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/param")
@@ -372,17 +384,19 @@ void OSCBroadcaster::param(ChangeSource src, const Rack &rack, const Module &mod
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 void OSCBroadcaster::changed(ChangeSource src, const Rack &rack, const Module &module, const Parameter &p) {
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    // batched messages are copied into the bundle in the queue
+    osc::OutboundPacketStream ops(batching_ ? buffer_ : beginPacket(), MAX_PACKET_SIZE);
 
-    ops << osc::BeginBundleImmediate
-        << osc::BeginMessage("/Kontrol/changed")
+    if (!batching_) ops << osc::BeginBundleImmediate;
+
+    ops << osc::BeginMessage("/Kontrol/changed")
         << rack.id().c_str()
         << module.id().c_str()
         << p.id().c_str();
@@ -397,17 +411,65 @@ void OSCBroadcaster::changed(ChangeSource src, const Rack &rack, const Module &m
 
     }
 
-    ops << osc::EndMessage
-        << osc::EndBundle;
+    ops << osc::EndMessage;
 
-    send(ops.Data(), ops.Size());
+    if (batching_) {
+        addToBatch(ops.Data(), static_cast<unsigned>(ops.Size()));
+        return;
+    }
+
+    ops << osc::EndBundle;
+
+    endPacket(ops);
+}
+
+void OSCBroadcaster::beginChanges() {
+    batching_ = true;
+    batch_ = nullptr;
+    batchSize_ = 0;
+}
+
+void OSCBroadcaster::endChanges() {
+    sendBatch();
+    batching_ = false;
+}
+
+// coalesced changes are sent as bundles of as many messages as fit in a datagram,
+// built in space reserved in the queue
+void OSCBroadcaster::addToBatch(const char *msg, unsigned size) {
+    static const char bundleHeader[BUNDLE_HEADER_SIZE] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', 0,
+                                                          0, 0, 0, 0, 0, 0, 0, 1}; // time tag, immediate
+    if (batch_ != nullptr && batchSize_ + 4 + size > MAX_PACKET_SIZE) sendBatch();
+    if (batch_ == nullptr) {
+        batch_ = queue_.reserve(MAX_PACKET_SIZE);
+        if (batch_ == nullptr) return; // queue full, counted as an overflow
+        memcpy(batch_, bundleHeader, BUNDLE_HEADER_SIZE);
+        batchSize_ = BUNDLE_HEADER_SIZE;
+    }
+    if (batchSize_ + 4 + size > MAX_PACKET_SIZE) return; // too large for a bundle
+
+    batch_[batchSize_++] = static_cast<char>((size >> 24) & 0xFF);
+    batch_[batchSize_++] = static_cast<char>((size >> 16) & 0xFF);
+    batch_[batchSize_++] = static_cast<char>((size >> 8) & 0xFF);
+    batch_[batchSize_++] = static_cast<char>(size & 0xFF);
+    memcpy(batch_ + batchSize_, msg, size);
+    batchSize_ += size;
+}
+
+void OSCBroadcaster::sendBatch() {
+    if (batch_ != nullptr && batchSize_ > BUNDLE_HEADER_SIZE) {
+        queue_.commit(batchSize_);
+        write_cond_.notify_one();
+    }
+    batch_ = nullptr;
+    batchSize_ = 0;
 }
 
 void OSCBroadcaster::resource(ChangeSource src, const Rack &rack, const std::string &type, const std::string &res) {
     if (!broadcastChange(src)) return;
     if (!isActive()) return;
 
-    osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
     ops << osc::BeginBundleImmediate
         << osc::BeginMessage("/Kontrol/resource")
@@ -419,7 +481,7 @@ void OSCBroadcaster::resource(ChangeSource src, const Rack &rack, const std::str
     ops << osc::EndMessage
         << osc::EndBundle;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 void OSCBroadcaster::deleteRack(ChangeSource src, const Rack &rack)
@@ -427,7 +489,7 @@ void OSCBroadcaster::deleteRack(ChangeSource src, const Rack &rack)
 	if (!broadcastChange(src)) return;
 	if (!isActive()) return;
 
-	osc::OutboundPacketStream ops(buffer_, OUTPUT_BUFFER_SIZE);
+	osc::OutboundPacketStream ops(beginPacket(), MAX_PACKET_SIZE);
 
 	ops << osc::BeginBundleImmediate
 		<< osc::BeginMessage("/Kontrol/deleteRack")
@@ -436,7 +498,7 @@ void OSCBroadcaster::deleteRack(ChangeSource src, const Rack &rack)
 	ops << osc::EndMessage
 		<< osc::EndBundle;
 
-	send(ops.Data(), ops.Size());
+	endPacket(ops);
 }
 
 
@@ -2,21 +2,25 @@
 
 #include "KontrolModel.h"
 #include "ChangeSource.h"
+#include "OSCPacketQueue.h"
 
 #include <memory>
-#include <ip/UdpSocket.h>
-#include <pa_ringbuffer.h>
 #include <chrono>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 
+namespace osc {
+class OutboundPacketStream;
+}
+
 namespace Kontrol {
 
 
 class OSCBroadcaster : public KontrolCallback {
 public:
-    static const unsigned int OUTPUT_BUFFER_SIZE = 1024;
+    static const unsigned MAX_PACKET_SIZE = 1472; // udp payload in an ethernet mtu
+    static const unsigned QUEUE_SIZE = 1 << 17;
 
     OSCBroadcaster(Kontrol::ChangeSource src, unsigned keepAlive, bool master);
     ~OSCBroadcaster();
@@ -42,6 +46,14 @@ public:
     void saveSettings(ChangeSource, const Rack &) override;
     void loadModule(ChangeSource, const Rack &, const EntityId &, const std::string &) override;
 
+    // changes are coalesced by default, when the model has a change interval
+    bool coalesceChanges() override { return coalesce_; }
+
+    void setCoalesceChanges(bool coalesce) { coalesce_ = coalesce; }
+
+    void beginChanges() override;
+    void endChanges() override;
+
     bool isThisHost(const std::string &host, unsigned port) { return host == host_ && port == port_; }
 
     bool isActive();
@@ -51,30 +63,33 @@ public:
 
     unsigned port() { return port_; }
 
+    // packets queued, and dropped as the queue was full
+    unsigned long packets() const { return queue_.packets(); }
+
+    unsigned long overflows() const { return queue_.overflows(); }
+
 
 protected:
-    void send(const char *data, unsigned size);
+    char *beginPacket();
+    void endPacket(const osc::OutboundPacketStream &ops);
     bool broadcastChange(ChangeSource src);
 
 private:
     void flush();
+    void addToBatch(const char *msg, unsigned size);
+    void sendBatch();
 
-    struct OscMsg {
-        static const int MAX_N_OSC_MSGS = 128;
-        static const int MAX_OSC_MESSAGE_SIZE = 512;
-        int size_;
-        char buffer_[MAX_OSC_MESSAGE_SIZE];
-    };
+    static const unsigned BUNDLE_HEADER_SIZE = 16;
 
     std::string host_;
     unsigned int port_;
-    std::shared_ptr<UdpTransmitSocket> socket_;
-    char buffer_[OUTPUT_BUFFER_SIZE];
+    std::shared_ptr<OSCPacketSocket> socket_;
+    char buffer_[MAX_PACKET_SIZE]; // encoding space, when the queue is full
     std::chrono::steady_clock::time_point lastPing_;
     unsigned keepAliveTime_;
 
-    PaUtilRingBuffer messageQueue_;
-    char msgData_[sizeof(OscMsg) * OscMsg::MAX_N_OSC_MSGS];
+    OSCPacketQueue queue_;
+    unsigned long reportedOverflows_;
     bool master_;
 
     bool running_;
@@ -82,6 +97,11 @@ private:
     std::condition_variable write_cond_;
     std::thread writer_thread_;
     ChangeSource changeSource_;
+
+    bool coalesce_;
+    bool batching_;
+    char *batch_; // reserved in the queue
+    unsigned batchSize_;
 };
 
 } //namespace
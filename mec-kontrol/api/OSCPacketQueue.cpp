@@ -0,0 +1,181 @@
+#include "OSCPacketQueue.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <ip/IpEndpointName.h>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace Kontrol {
+
+#ifdef __linux__
+
+OSCPacketSocket::OSCPacketSocket(const std::string &host, unsigned port) : fd_(-1) {
+    IpEndpointName endpoint(host.c_str(), port);
+
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ == -1) throw std::runtime_error("unable to create udp socket\n");
+
+    int broadcast = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(static_cast<uint32_t>(endpoint.address));
+    addr.sin_port = htons(static_cast<uint16_t>(endpoint.port));
+    if (::connect(fd_, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("unable to connect udp socket\n");
+    }
+}
+
+OSCPacketSocket::~OSCPacketSocket() {
+    if (fd_ != -1) close(fd_);
+}
+
+unsigned OSCPacketSocket::send(const char *const *packets, const unsigned *sizes, unsigned n) {
+    struct mmsghdr msgs[OSCPacketQueue::MAX_SEND_BATCH];
+    struct iovec iovs[OSCPacketQueue::MAX_SEND_BATCH];
+    unsigned sent = 0;
+    while (sent < n) {
+        unsigned batch = n - sent < OSCPacketQueue::MAX_SEND_BATCH ? n - sent : OSCPacketQueue::MAX_SEND_BATCH;
+        std::memset(msgs, 0, sizeof(struct mmsghdr) * batch);
+        for (unsigned i = 0; i < batch; i++) {
+            iovs[i].iov_base = const_cast<char *>(packets[sent + i]);
+            iovs[i].iov_len = sizes[sent + i];
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int r = sendmmsg(fd_, msgs, batch, 0);
+        if (r > 0) {
+            sent += static_cast<unsigned>(r);
+        } else if (r < 0 && errno == EINTR) {
+            continue;
+        } else {
+            // e.g. nothing listening on a connected socket, drop the packet, as oscpack does
+            sent++;
+        }
+    }
+    return sent;
+}
+
+#else
+
+OSCPacketSocket::OSCPacketSocket(const std::string &host, unsigned port) :
+        socket_(IpEndpointName(host.c_str(), port)) {
+}
+
+OSCPacketSocket::~OSCPacketSocket() {
+}
+
+unsigned OSCPacketSocket::send(const char *const *packets, const unsigned *sizes, unsigned n) {
+    for (unsigned i = 0; i < n; i++) {
+        socket_.Send(packets[i], sizes[i]);
+    }
+    return n;
+}
+
+#endif
+
+
+OSCPacketQueue::OSCPacketQueue(unsigned size) :
+        size_(size),
+        mask_(size - 1),
+        data_(new char[size]),
+        head_(0),
+        tail_(0),
+        reserved_(0),
+        front_(0),
+        packets_(0),
+        overflows_(0) {
+}
+
+void OSCPacketQueue::writeHeader(unsigned pos, uint32_t size) {
+    std::memcpy(data_.get() + (pos & mask_), &size, HEADER_SIZE);
+}
+
+uint32_t OSCPacketQueue::readHeader(unsigned pos) const {
+    uint32_t size;
+    std::memcpy(&size, data_.get() + (pos & mask_), HEADER_SIZE);
+    return size;
+}
+
+char *OSCPacketQueue::reserve(unsigned maxSize) {
+    unsigned need = HEADER_SIZE + align(maxSize);
+    unsigned head = head_.load(std::memory_order_relaxed);
+    unsigned free = size_ - (head - tail_.load(std::memory_order_acquire));
+    unsigned contiguous = size_ - (head & mask_);
+    unsigned skip = contiguous < need ? contiguous : 0;
+    if (need + skip > free) {
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if (skip) writeHeader(head, WRAP_MARKER);
+    reserved_ = head + skip;
+    return data_.get() + (reserved_ & mask_) + HEADER_SIZE;
+}
+
+void OSCPacketQueue::commit(unsigned size) {
+    writeHeader(reserved_, size);
+    packets_.fetch_add(1, std::memory_order_relaxed);
+    head_.store(reserved_ + HEADER_SIZE + align(size), std::memory_order_release);
+}
+
+bool OSCPacketQueue::push(const char *data, unsigned size) {
+    char *p = reserve(size);
+    if (p == nullptr) return false;
+    std::memcpy(p, data, size);
+    commit(size);
+    return true;
+}
+
+unsigned OSCPacketQueue::front(const char **packets, unsigned *sizes, unsigned max) {
+    unsigned head = head_.load(std::memory_order_acquire);
+    unsigned pos = tail_.load(std::memory_order_relaxed);
+    unsigned n = 0;
+    while (pos != head && n < max) {
+        uint32_t size = readHeader(pos);
+        if (size == WRAP_MARKER) {
+            pos += size_ - (pos & mask_);
+            continue;
+        }
+        packets[n] = data_.get() + (pos & mask_) + HEADER_SIZE;
+        sizes[n] = size;
+        n++;
+        pos += HEADER_SIZE + align(size);
+    }
+    front_ = pos;
+    return n;
+}
+
+void OSCPacketQueue::pop() {
+    tail_.store(front_, std::memory_order_release);
+}
+
+unsigned OSCPacketQueue::flush(OSCPacketSocket &socket) {
+    const char *packets[MAX_SEND_BATCH];
+    unsigned sizes[MAX_SEND_BATCH];
+    unsigned total = 0;
+    unsigned n;
+    while ((n = front(packets, sizes, MAX_SEND_BATCH)) > 0) {
+        socket.send(packets, sizes, n);
+        pop();
+        total += n;
+    }
+    return total;
+}
+
+void OSCPacketQueue::clear() {
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+} //namespace
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#ifndef __linux__
+#include <ip/UdpSocket.h>
+#endif
+
+namespace Kontrol {
+
+// a connected udp socket, sending datagrams in batches (sendmmsg on linux)
+class OSCPacketSocket {
+public:
+    // throws std::runtime_error if the socket cannot be created or connected, as oscpack does
+    OSCPacketSocket(const std::string &host, unsigned port);
+    ~OSCPacketSocket();
+
+    // returns number of packets handed to the socket (failed sends are dropped)
+    unsigned send(const char *const *packets, const unsigned *sizes, unsigned n);
+
+private:
+#ifdef __linux__
+    int fd_;
+#else
+    UdpTransmitSocket socket_;
+#endif
+};
+
+
+// single producer/single consumer queue of variable size osc packets, in a byte ring.
+// packets are encoded in place, in space from reserve(), and made visible to the reader by commit().
+// each packet is prefixed by its size, a packet which does not fit before the end of the ring is
+// placed at the start, with a wrap marker left behind.
+// when full, reserve() fails and the packet is counted as an overflow
+class OSCPacketQueue {
+public:
+    static const unsigned MAX_SEND_BATCH = 32;
+
+    // size in bytes, a power of 2
+    explicit OSCPacketQueue(unsigned size);
+
+    // writer
+    char *reserve(unsigned maxSize);
+    void commit(unsigned size);
+    bool push(const char *data, unsigned size);
+
+    // reader, packets at the front of the queue remain valid until pop()
+    unsigned front(const char **packets, unsigned *sizes, unsigned max);
+    void pop();
+    unsigned flush(OSCPacketSocket &socket);
+
+    // only when there is no writer
+    void clear();
+
+    unsigned long packets() const { return packets_.load(std::memory_order_relaxed); }
+
+    unsigned long overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+    static const unsigned HEADER_SIZE = 4;
+    static const uint32_t WRAP_MARKER = 0xFFFFFFFF;
+
+    static unsigned align(unsigned size) { return (size + 3) & ~3u; }
+
+    void writeHeader(unsigned pos, uint32_t size);
+    uint32_t readHeader(unsigned pos) const;
+
+    unsigned size_;
+    unsigned mask_;
+    std::unique_ptr<char[]> data_;
+    std::atomic<unsigned> head_; // positions are free running, indexed by & mask_
+    std::atomic<unsigned> tail_;
+    unsigned reserved_; // writer only
+    unsigned front_; // reader only
+    std::atomic<unsigned long> packets_;
+    std::atomic<unsigned long> overflows_;
+};
+
+} //namespace
@@ -104,7 +104,7 @@ private:
 
     struct OscMsg {
         static const int MAX_N_OSC_MSGS = 128;
-        static const int MAX_OSC_MESSAGE_SIZE = 512;
+        static const int MAX_OSC_MESSAGE_SIZE = 1472; // udp payload in an ethernet mtu
         IpEndpointName origin_;
         int size_;
         char buffer_[MAX_OSC_MESSAGE_SIZE];
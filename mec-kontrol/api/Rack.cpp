@@ -1,6 +1,7 @@
 #include "Rack.h"
 #include "Module.h"
 #include "KontrolModel.h"
+#include "SettingsWriter.h"
 
 
 #include <algorithm>
@@ -8,7 +9,7 @@
 #include <string.h>
 #include <iostream>
 #include <map>
-#include <fstream>
+#include <cstdlib>
 
 
 // for saving presets only , later moved to Preferences
@@ -26,19 +27,25 @@ inline std::shared_ptr<KontrolModel> Rack::model() {
 void Rack::addModule(const std::shared_ptr<Module> &module) {
     if (module != nullptr) {
         modules_[module->id()] = module;
+        ccTableValid_ = false;
     }
 }
 
-std::vector<std::shared_ptr<Module>> Rack::getModules() {
+// modules are kept by id, returned in id order
+std::vector<std::shared_ptr<Module>> Rack::getModules() const {
     std::vector<std::shared_ptr<Module>> ret;
-    for (auto p : modules_) {
+    for (const auto &p : modules_) {
         if (p.second != nullptr) ret.push_back(p.second);
     }
+    std::sort(ret.begin(), ret.end(), [](const std::shared_ptr<Module> &a, const std::shared_ptr<Module> &b) {
+        return a->id() < b->id();
+    });
     return ret;
 }
 
 std::shared_ptr<Module> Rack::getModule(const EntityId &moduleId) {
-    return modules_[moduleId];
+    auto module = modules_.find(moduleId);
+    return module != modules_.end() ? module->second : nullptr;
 }
 
 
@@ -56,6 +63,7 @@ bool Rack::loadModuleDefinitions(const EntityId &moduleId, const mec::Preference
 
 
 bool Rack::loadSettings(const std::string &filename) {
+    flushSettings(); // a save may be pending
     settings_ = std::make_shared<mec::Preferences>(filename);
     settingsFile_ = filename;
     return loadSettings(*settings_);
@@ -66,7 +74,7 @@ bool Rack::saveSettings() {
     // save to original module settings file
     // note: we do not save back to an preferences file, as this would not be complete
     if (!settingsFile_.empty()) {
-        saveSettings(settingsFile_);
+        return saveSettings(settingsFile_);
     }
     return false;
 }
@@ -95,36 +103,45 @@ bool Rack::loadSettings(const mec::Preferences &prefs) {
 }
 
 
+// presets are copied, and written as json on the settings writer thread
 bool Rack::saveSettings(const std::string &filename) {
+    if (settingsWriter_ == nullptr) settingsWriter_ = std::make_shared<SettingsWriter>();
+    auto presets = std::make_shared<std::unordered_map<std::string, RackPreset>>(presets_);
+    settingsWriter_->save(filename, [presets]() { return settingsToJson(*presets); });
+    return true;
+}
+
+void Rack::flushSettings() {
+    if (settingsWriter_ != nullptr) settingsWriter_->flush();
+}
+
+std::string Rack::settingsToJson(const std::unordered_map<std::string, RackPreset> &presets) {
     // do in cJSON for now
-    std::ofstream outfile(filename);
     cJSON *root = cJSON_CreateObject();
-    cJSON *presets = cJSON_CreateObject();
-    cJSON_AddItemToObject(root, "presets", presets);
+    cJSON *jpresets = cJSON_CreateObject();
+    cJSON_AddItemToObject(root, "presets", jpresets);
 
-    for (auto rackPreset : presets_) {
+    for (const auto &rackPreset : presets) {
 
         cJSON *preset = cJSON_CreateObject();
-        cJSON_AddItemToObject(presets, rackPreset.first.c_str(), preset);
+        cJSON_AddItemToObject(jpresets, rackPreset.first.c_str(), preset);
 
 
-        for (auto mp : rackPreset.second) {
+        for (const auto &mp : rackPreset.second) {
 
-            auto moduleId = mp.first;
-            auto modulePreset = mp.second;
             cJSON *mjson = cJSON_CreateObject();
-            cJSON_AddItemToObject(preset, moduleId.c_str(), mjson);
-            saveModulePreset(modulePreset, mjson);
+            cJSON_AddItemToObject(preset, mp.first.c_str(), mjson);
+            saveModulePreset(mp.second, mjson);
         }
     }
 
     // const char* text = cJSON_PrintUnformatted(root);
-    const char *text = cJSON_Print(root);
-    outfile << text << std::endl;
-    outfile.close();
+    char *text = cJSON_Print(root);
+    std::string json = std::string(text) + "\n";
+    free(text);
     cJSON_Delete(root);
 
-    return true;
+    return json;
 }
 
 std::vector<std::string> Rack::getPresetList() {
@@ -140,14 +157,11 @@ bool Rack::updatePreset(std::string presetId) {
     bool ret = false;
     RackPreset rackPreset = presets_[presetId];
 
-    for (auto m : modules_) {
-        auto module = m.second;
-        if (module != nullptr) {
-            auto moduleId = module->id();
-            ModulePreset modulePreset = rackPreset[moduleId];
-            ret |= updateModulePreset(module, modulePreset);
-            rackPreset[moduleId] = modulePreset;
-        }
+    for (auto module : getModules()) {
+        auto moduleId = module->id();
+        ModulePreset modulePreset = rackPreset[moduleId];
+        ret |= updateModulePreset(module, modulePreset);
+        rackPreset[moduleId] = modulePreset;
     }
     presets_[presetId] = rackPreset;
     currentPreset_ = presetId;
@@ -157,46 +171,85 @@ bool Rack::updatePreset(std::string presetId) {
     return ret;
 }
 
+// preset values which differ from the current values are staged, then changed and published together
 bool Rack::applyPreset(std::string presetId) {
     bool ret = false;
-    if (presets_.count(presetId) == 0) return false;
-    RackPreset rackPreset = presets_[presetId];
+    auto preset = presets_.find(presetId);
+    if (preset == presets_.end()) return false;
+    const RackPreset &rackPreset = preset->second;
+
+    std::vector<PresetChange> changes;
+    for (auto module : getModules()) {
+        auto moduleId = module->id();
+        auto modulePreset = rackPreset.find(moduleId);
+        if (modulePreset != rackPreset.end()) {
+            bool loaded = false;
+            if (module->type() != modulePreset->second.moduleType()) {
+                model()->loadModule(CS_PRESET, id(), module->id(), modulePreset->second.moduleType());
+                module = getModule(moduleId);
+                if (module == nullptr) continue;
+                loaded = true;
+            }
 
-    for (auto m : modules_) {
-        auto module = m.second;
-        if (module != nullptr) {
-            auto moduleId = module->id();
-            if (rackPreset.count(moduleId) > 0) {
-                ModulePreset modulePreset = rackPreset[moduleId];
-                if (module->type() != modulePreset.moduleType()) {
-                    model()->loadModule(CS_PRESET, id(), module->id(), modulePreset.moduleType());
-                    module = getModule(moduleId);
-                }
+            ret |= stageModulePreset(module, modulePreset->second, loaded, changes);
+            module->setMidiMapping(modulePreset->second.midiMap());
+        }
+    }
 
-                ret |= applyModulePreset(module, modulePreset);
-            }
+    KontrolModel::ParamChanges changed;
+    changed.reserve(changes.size());
+    for (const auto &change : changes) {
+        if (change.param->change(change.value, true)) {
+            changed.push_back(std::make_pair(change.module.get(), change.param.get()));
         }
     }
+    model()->publishChanged(CS_PRESET, *this, changed);
+
     currentPreset_ = presetId;
     return ret;
 }
 
+void Rack::buildMidiCCTable() {
+    std::vector<MidiCCTarget> targets[MAX_CC];
+    for (auto module : getModules()) {
+        for (auto mm : module->getMidiMapping()) {
+            if (mm.first >= MAX_CC) continue;
+            for (auto paramId : mm.second) {
+                auto param = module->getParam(paramId);
+                if (param != nullptr) targets[mm.first].push_back({module.get(), param.get()});
+            }
+        }
+    }
+
+    ccTargets_.clear();
+    for (unsigned cc = 0; cc < MAX_CC; cc++) {
+        ccIndex_[cc] = static_cast<unsigned>(ccTargets_.size());
+        ccTargets_.insert(ccTargets_.end(), targets[cc].begin(), targets[cc].end());
+    }
+    ccIndex_[MAX_CC] = static_cast<unsigned>(ccTargets_.size());
+    ccTableVersion_ = Module::layoutVersion();
+    ccTableValid_ = true;
+}
+
 bool Rack::changeMidiCC(unsigned midiCC, unsigned midiValue) {
+    if (midiCC >= MAX_CC) return false;
+    if (!ccTableValid_ || ccTableVersion_ != Module::layoutVersion()) buildMidiCCTable();
+
+    unsigned begin = ccIndex_[midiCC];
+    unsigned end = ccIndex_[midiCC + 1];
+    if (begin == end) return false;
+
+    // as KontrolModel::changeParam, without looking up the rack, module and parameter again
     bool ret = false;
-    for (auto m : modules_) {
-        auto module = m.second;
-        if (module != nullptr) {
-            std::vector<EntityId> mmvec = module->getParamsForCC(midiCC);
-            for (auto paramId : mmvec) {
-                auto param = module->getParam(paramId);
-                if (param != nullptr) {
-                    ParamValue pv = param->calcMidi(midiValue);
-                    if (pv != param->current()) {
-                        model()->changeParam(CS_MIDI, id(), module->id(), param->id(), pv);
-                        ret = true;
-                    }
-                }
+    auto kontrol = model();
+    for (unsigned i = begin; i < end; i++) {
+        const MidiCCTarget &t = ccTargets_[i];
+        ParamValue pv = t.param->calcMidi(midiValue);
+        if (pv != t.param->current()) {
+            if (t.param->change(pv, false)) {
+                kontrol->publishChanged(CS_MIDI, *this, *t.module, *t.param);
             }
+            ret = true;
         }
     }
     return ret;
@@ -224,8 +277,8 @@ void Rack::publishCurrentValues(const std::shared_ptr<Module> &module) const {
 
 
 void Rack::publishCurrentValues() const {
-    for (auto p : modules_) {
-        if (p.second != nullptr) publishCurrentValues(p.second);
+    for (auto module : getModules()) {
+        publishCurrentValues(module);
     }
 }
 
@@ -271,8 +324,8 @@ const std::set<std::string> &Rack::getResources(const std::string &type) {
 
 
 void Rack::publishMetaData() const {
-    for (auto p : modules_) {
-        if (p.second != nullptr) publishMetaData(p.second);
+    for (auto module : getModules()) {
+        publishMetaData(module);
     }
 }
 
@@ -330,7 +383,7 @@ bool Rack::loadModulePreset(RackPreset &rackPreset, const EntityId &moduleId, co
     return true;
 }
 
-bool Rack::saveModulePreset(ModulePreset &modulepreset, cJSON *root) {
+bool Rack::saveModulePreset(const ModulePreset &modulepreset, cJSON *root) {
 
     cJSON_AddStringToObject(root, "moduleType", modulepreset.moduleType().c_str());
 
@@ -382,21 +435,22 @@ bool Rack::updateModulePreset(std::shared_ptr<Module> module, ModulePreset &modu
     return ret;
 }
 
-bool Rack::applyModulePreset(std::shared_ptr<Module> module, const ModulePreset &modulePreset) {
+// all values are staged for a newly loaded module, as listeners have not seen its values
+bool Rack::stageModulePreset(const std::shared_ptr<Module> &module, const ModulePreset &modulePreset, bool all,
+                             std::vector<PresetChange> &changes) {
     bool ret = false;
 
-
-    // restore parameter values
     for (auto p : modulePreset.values()) {
         if (p.value().type() == ParamValue::T_Float) {
-            model()->changeParam(CS_PRESET, model()->localRack()->id(), module->id(), p.paramId(), p.value());
             ret |= true;
+            auto param = module->getParam(p.paramId());
+            if (param != nullptr && (all || param->current() != p.value())) {
+                changes.push_back(PresetChange{module, param, p.value()});
+            }
         } //iffloat
         //TODO: preset, support non numeric types
     }
 
-    module->setMidiMapping(modulePreset.midiMap());
-
     return ret;
 }
 
@@ -418,16 +472,16 @@ void Rack::dumpSettings() const {
 void Rack::dumpParameters() {
     LOG_1("Rack Parameters :" << id());
     LOG_1("------------------------");
-    for (auto m : modules_) {
-        if (m.second != nullptr) m.second->dumpParameters();
+    for (auto module : getModules()) {
+        module->dumpParameters();
     }
 }
 
 void Rack::dumpCurrentValues() {
     LOG_1("Rack Values : " << id());
     LOG_1("-----------------------");
-    for (auto m : modules_) {
-        if (m.second != nullptr) m.second->dumpCurrentValues();
+    for (auto module : getModules()) {
+        module->dumpCurrentValues();
     }
 }
 
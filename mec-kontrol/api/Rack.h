@@ -75,13 +75,15 @@ private:
 
 
 class KontrolModel;
+class SettingsWriter;
 
 class Rack : public Entity {
 public:
     Rack(const std::string &host,
          unsigned port,
          const std::string &displayName)
-            : Entity(createId(host, port), displayName), host_(host), port_(port) {
+            : Entity(createId(host, port), displayName), host_(host), port_(port),
+              ccTableValid_(false), ccTableVersion_(0) {
         ;
     }
 
@@ -89,7 +91,7 @@ public:
         return (host + ":" + std::to_string(port));
     }
 
-    std::vector<std::shared_ptr<Module>> getModules();
+    std::vector<std::shared_ptr<Module>> getModules() const;
     std::shared_ptr<Module> getModule(const EntityId &moduleId);
     void addModule(const std::shared_ptr<Module> &module);
 
@@ -99,8 +101,10 @@ public:
     bool loadSettings(const std::string &filename);
     bool loadSettings(const mec::Preferences &prefs);
 
+    // settings are saved on a background thread, after a short delay (see SettingsWriter)
     bool saveSettings();
     bool saveSettings(const std::string &filename);
+    void flushSettings();
 
     bool applyPreset(std::string presetId);
     bool updatePreset(std::string presetId);
@@ -136,22 +140,48 @@ public:
 
 private:
     typedef std::unordered_map<EntityId, ModulePreset> RackPreset;
+
+    // a parameter value to change, when applying a preset
+    struct PresetChange {
+        std::shared_ptr<Module> module;
+        std::shared_ptr<Parameter> param;
+        ParamValue value;
+    };
+
     bool loadModulePreset(RackPreset &rackPreset, const EntityId &moduleId, const mec::Preferences &prefs);
-    bool saveModulePreset(ModulePreset &, cJSON *root);
+    static bool saveModulePreset(const ModulePreset &, cJSON *root);
+    static std::string settingsToJson(const std::unordered_map<std::string, RackPreset> &presets);
     bool updateModulePreset(std::shared_ptr<Module> module, ModulePreset &modulePreset);
-    bool applyModulePreset(std::shared_ptr<Module> module, const ModulePreset &modulePreset);
+    bool stageModulePreset(const std::shared_ptr<Module> &module, const ModulePreset &modulePreset, bool all,
+                           std::vector<PresetChange> &changes);
+    void buildMidiCCTable();
+
+    static const unsigned MAX_CC = 128;
+
+    struct MidiCCTarget {
+        Module *module;
+        Parameter *param;
+    };
 
     std::string host_;
     unsigned port_;
-    std::map<EntityId, std::shared_ptr<Module>> modules_;
+    std::unordered_map<EntityId, std::shared_ptr<Module>> modules_;
     std::unordered_map<std::string, std::set<std::string>> resources_;
 
     std::string settingsFile_;
     std::shared_ptr<mec::Preferences> settings_;
+    std::shared_ptr<SettingsWriter> settingsWriter_; // created on first save
 
     std::string currentPreset_;
     // presets = key = presetid, value = map<moduleId, preset>
     std::unordered_map<std::string, RackPreset> presets_;
+
+    // cc dispatch, targets of all ccs in cc order, cc n maps to [ccIndex_[n], ccIndex_[n + 1])
+    // pointers are owned by modules_, the table is rebuilt when modules or their layout change
+    std::vector<MidiCCTarget> ccTargets_;
+    unsigned ccIndex_[MAX_CC + 1];
+    bool ccTableValid_;
+    unsigned ccTableVersion_;
 };
 
 }
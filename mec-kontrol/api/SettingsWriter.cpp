@@ -0,0 +1,120 @@
+#include "SettingsWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <mec_log.h>
+
+namespace Kontrol {
+
+// a save is delayed by at most this many times the delay, however often it is repeated
+static const unsigned MAX_DELAYS = 4;
+
+SettingsWriter::SettingsWriter(unsigned delayMs) :
+        delay_(delayMs),
+        writing_(0),
+        flushing_(0),
+        running_(true) {
+    thread_ = std::thread(&SettingsWriter::run, this);
+}
+
+SettingsWriter::~SettingsWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+void SettingsWriter::save(const std::string &filename, Serialiser serialiser) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = Clock::now();
+        auto pending = pending_.find(filename);
+        if (pending == pending_.end()) {
+            pending_[filename] = PendingSave{serialiser, now, now + delay_};
+        } else {
+            pending->second.serialiser_ = serialiser;
+            pending->second.due_ = std::min(now + delay_, pending->second.first_ + delay_ * MAX_DELAYS);
+        }
+    }
+    cond_.notify_one();
+}
+
+void SettingsWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushing_++;
+    cond_.notify_one();
+    done_.wait(lock, [this] { return pending_.empty() && writing_ == 0; });
+    flushing_--;
+}
+
+void SettingsWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_ || !pending_.empty()) {
+        if (pending_.empty()) {
+            cond_.wait(lock);
+            continue;
+        }
+
+        auto next = pending_.begin();
+        for (auto i = pending_.begin(); i != pending_.end(); i++) {
+            if (i->second.due_ < next->second.due_) next = i;
+        }
+        // when stopping or flushing, pending saves are written now
+        if (running_ && flushing_ == 0 && next->second.due_ > Clock::now()) {
+            cond_.wait_until(lock, next->second.due_);
+            continue;
+        }
+
+        std::string filename = next->first;
+        Serialiser serialiser = next->second.serialiser_;
+        pending_.erase(next);
+        writing_++;
+        lock.unlock();
+
+        writeFile(filename, serialiser());
+
+        lock.lock();
+        writing_--;
+        done_.notify_all();
+    }
+}
+
+bool SettingsWriter::writeFile(const std::string &filename, const std::string &content) {
+    std::string tmpfile = filename + ".tmp";
+    FILE *fp = fopen(tmpfile.c_str(), "wb");
+    if (fp == nullptr) {
+        LOG_0("SettingsWriter : unable to write " << tmpfile);
+        return false;
+    }
+    bool ok = fwrite(content.data(), 1, content.size(), fp) == content.size();
+    ok &= fflush(fp) == 0;
+#ifndef _WIN32
+    ok &= fsync(fileno(fp)) == 0;
+#endif
+    ok &= fclose(fp) == 0;
+    if (!ok) {
+        LOG_0("SettingsWriter : unable to write " << tmpfile);
+        remove(tmpfile.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    // rename does not replace an existing file on windows
+    remove(filename.c_str());
+#endif
+    if (rename(tmpfile.c_str(), filename.c_str()) != 0) {
+        LOG_0("SettingsWriter : unable to rename " << tmpfile << " to " << filename);
+        remove(tmpfile.c_str());
+        return false;
+    }
+    return true;
+}
+
+} //namespace
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Kontrol {
+
+// writes files on a background thread, so callers never do file i/o.
+// saves are debounced, repeated saves of a file within the delay are written once, with the latest content.
+// files are written to a temporary file, then renamed over the original, so a file is never left part written
+class SettingsWriter {
+public:
+    // produces the file content, called on the writer thread
+    typedef std::function<std::string()> Serialiser;
+
+    static const unsigned DEFAULT_DELAY_MS = 250;
+
+    explicit SettingsWriter(unsigned delayMs = DEFAULT_DELAY_MS);
+    ~SettingsWriter(); // writes pending saves
+
+    void save(const std::string &filename, Serialiser serialiser);
+
+    // blocks until pending saves are written
+    void flush();
+
+    static bool writeFile(const std::string &filename, const std::string &content);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct PendingSave {
+        Serialiser serialiser_;
+        Clock::time_point first_;
+        Clock::time_point due_;
+    };
+
+    void run();
+
+    std::chrono::milliseconds delay_;
+    std::map<std::string, PendingSave> pending_;
+    unsigned writing_;
+    unsigned flushing_;
+    bool running_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::condition_variable done_;
+    std::thread thread_;
+};
+
+} //namespace
@@ -113,6 +113,8 @@ void KontrolRack_tick(t_KontrolRack *x) {
         x->device_->poll();
     }
 
+    x->model_->flushChanges();
+
     if (x->osc_broadcaster_ && x->osc_receiver_
         && x->pollCount_ % OSC_PING_FREQUENCY == 0) {
         x->osc_broadcaster_->sendPing(x->osc_receiver_->port());
@@ -179,6 +181,9 @@ EXTERN void KontrolRack_setup(void) {
     class_addmethod(KontrolRack_class,
                     (t_method) KontrolRack_connect, gensym("connect"),
                     A_DEFFLOAT, A_NULL);
+    class_addmethod(KontrolRack_class,
+                    (t_method) KontrolRack_changeinterval, gensym("changeinterval"),
+                    A_DEFFLOAT, A_NULL);
 
     class_addmethod(KontrolRack_class,
                     (t_method) KontrolRack_knob1Raw, gensym("knob1Raw"),
@@ -423,6 +428,11 @@ void KontrolRack_connect(t_KontrolRack *x, t_floatarg f) {
     }
 }
 
+// coalesce parameter changes sent to osc clients and the display, ms (0 = off), flushed each tick
+void KontrolRack_changeinterval(t_KontrolRack *x, t_floatarg f) {
+    x->model_->setChangeInterval(f > 0 ? (unsigned) f : 0);
+}
+
 void KontrolRack_listen(t_KontrolRack *x, t_floatarg f) {
     if (f > 0) {
         auto p = std::make_shared<Kontrol::OSCReceiver>(x->model_);
@@ -38,6 +38,7 @@ EXTERN void KontrolRack_setup(void);
 
 void KontrolRack_listen(t_KontrolRack *x, t_floatarg f);
 void KontrolRack_connect(t_KontrolRack *x, t_floatarg f);
+void KontrolRack_changeinterval(t_KontrolRack *x, t_floatarg f);
 
 void KontrolRack_enc(t_KontrolRack *x, t_floatarg f);
 void KontrolRack_encbut(t_KontrolRack *x, t_floatarg f);
@@ -3,6 +3,7 @@
 #include <osc/OscOutboundPacketStream.h>
 //#include <cmath>
 #include <algorithm>
+#include <iostream>
 
 #include "../../m_pd.h"
 
@@ -19,7 +20,8 @@ const int8_t PATCH_SCREEN = 3;
 
 
 static const unsigned int OUTPUT_BUFFER_SIZE = 1024;
-static char screenosc[OUTPUT_BUFFER_SIZE];
+static const unsigned int OUTPUT_QUEUE_SIZE = 1 << 15;
+static char screenosc[OUTPUT_BUFFER_SIZE]; // encoding space, when the queue is full
 
 static const float MAX_POT_VALUE = 1023.0F;
 
@@ -833,8 +835,7 @@ void OModuleSelectMenu::clicked(unsigned idx) {
 
 // Organelle implmentation
 
-Organelle::Organelle() {
-    PaUtil_InitializeRingBuffer(&messageQueue_, sizeof(OscMsg), OscMsg::MAX_N_OSC_MSGS, msgData_);
+Organelle::Organelle() : queue_(OUTPUT_QUEUE_SIZE), reportedOverflows_(0), running_(false) {
 }
 
 Organelle::~Organelle() {
@@ -842,10 +843,14 @@ Organelle::~Organelle() {
 }
 
 void Organelle::stop() {
-    running_ = false;
+    {
+        std::lock_guard<std::mutex> lock(write_lock_);
+        running_ = false;
+    }
     if (socket_) {
+        write_cond_.notify_one();
         writer_thread_.join();
-        PaUtil_FlushRingBuffer(&messageQueue_);
+        queue_.clear();
     }
     socket_.reset();
 }
@@ -882,7 +887,7 @@ void *organelle_write_thread_func(void *aObj) {
 
 bool Organelle::connect() {
     try {
-        socket_ = std::shared_ptr<UdpTransmitSocket>(new UdpTransmitSocket(IpEndpointName("127.0.0.1", 4001)));
+        socket_ = std::shared_ptr<Kontrol::OSCPacketSocket>(new Kontrol::OSCPacketSocket("127.0.0.1", 4001));
     } catch (const std::runtime_error &e) {
         post("could not connect to mother host for screen updates");
         socket_.reset();
@@ -897,21 +902,27 @@ bool Organelle::connect() {
 void Organelle::writePoll() {
     std::unique_lock<std::mutex> lock(write_lock_);
     while (running_) {
-        while (PaUtil_GetRingBufferReadAvailable(&messageQueue_)) {
-            OscMsg msg;
-            PaUtil_ReadRingBuffer(&messageQueue_, &msg, 1);
-            socket_->Send(msg.buffer_, msg.size_);
+        queue_.flush(*socket_);
+        unsigned long overflows = queue_.overflows();
+        if (overflows != reportedOverflows_) {
+            // not post(), which is not safe off the pd thread
+            std::cerr << "screen update queue full, dropped " << overflows - reportedOverflows_ << " packets" << std::endl;
+            reportedOverflows_ = overflows;
         }
         write_cond_.wait_for(lock, std::chrono::milliseconds(1000));
     }
 }
 
 
-void Organelle::send(const char *data, unsigned size) {
-    OscMsg msg;
-    msg.size_ = (size > OscMsg::MAX_OSC_MESSAGE_SIZE ? OscMsg::MAX_OSC_MESSAGE_SIZE : size);
-    memcpy(msg.buffer_, data, (size_t) msg.size_);
-    PaUtil_WriteRingBuffer(&messageQueue_, (void *) &msg, 1);
+// packets are encoded in place in the queue, or in screenosc and dropped if the queue is full
+char *Organelle::beginPacket() {
+    char *packet = queue_.reserve(OUTPUT_BUFFER_SIZE);
+    return packet != nullptr ? packet : screenosc;
+}
+
+void Organelle::endPacket(const osc::OutboundPacketStream &ops) {
+    if (ops.Data() == screenosc) return;
+    queue_.commit(static_cast<unsigned>(ops.Size()));
     write_cond_.notify_one();
 }
 
@@ -919,62 +930,62 @@ void Organelle::send(const char *data, unsigned size) {
 void Organelle::displayPopup(const std::string &text, bool dblline) {
     if (dblline) {
         {
-            osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+            osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
             ops << osc::BeginMessage("/oled/gFillArea")
                 << PATCH_SCREEN
                 << 2 << 12
                 << 118 << 38
                 << 0
                 << osc::EndMessage;
-            send(ops.Data(), ops.Size());
+            endPacket(ops);
         }
 
         {
-            osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+            osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
             ops << osc::BeginMessage("/oled/gBox")
                 << PATCH_SCREEN
                 << 2 << 12
                 << 118 << 38
                 << 1
                 << osc::EndMessage;
-            send(ops.Data(), ops.Size());
+            endPacket(ops);
         }
 
     } else {
         {
-            osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+            osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
             ops << osc::BeginMessage("/oled/gFillArea")
                 << PATCH_SCREEN
                 << 4 << 14
                 << 114 << 34
                 << 0
                 << osc::EndMessage;
-            send(ops.Data(), ops.Size());
+            endPacket(ops);
         }
     }
 
     {
-        osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+        osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
         ops << osc::BeginMessage("/oled/gBox")
             << PATCH_SCREEN
             << 4 << 14
             << 114 << 34
             << 1
             << osc::EndMessage;
-        send(ops.Data(), ops.Size());
+        endPacket(ops);
     }
 
     {
         int txtsize = 16;
         if (text.length() > 12) txtsize = 8;
-        osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+        osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
         ops << osc::BeginMessage("/oled/gPrintln")
             << PATCH_SCREEN
             << 10 << 24
             << txtsize << 1
             << text.c_str()
             << osc::EndMessage;
-        send(ops.Data(), ops.Size());
+        endPacket(ops);
     }
 }
 
@@ -993,7 +1004,7 @@ std::string Organelle::asDisplayString(const Kontrol::Parameter &param, unsigned
 }
 
 void Organelle::clearDisplay() {
-    osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
     //ops << osc::BeginMessage( "/oled/gClear" )
     //    << 1
     //    << osc::EndMessage;
@@ -1003,7 +1014,7 @@ void Organelle::clearDisplay() {
         << 128 << 45
         << 0
         << osc::EndMessage;
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 void Organelle::displayParamLine(unsigned line, const Kontrol::Parameter &param) {
@@ -1016,31 +1027,31 @@ void Organelle::displayLine(unsigned line, const char *disp) {
 
     int x = ((line - 1) * 11) + ((line > 0) * 9);
     {
-        osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+        osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
         ops << osc::BeginMessage("/oled/gFillArea")
             << PATCH_SCREEN
             << 0 << x
             << 128 << 10
             << 0
             << osc::EndMessage;
-        send(ops.Data(), ops.Size());
+        endPacket(ops);
     }
     {
-        osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+        osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
         ops << osc::BeginMessage("/oled/gPrintln")
             << PATCH_SCREEN
             << 2 << x
             << 8 << 1
             << disp
             << osc::EndMessage;
-        send(ops.Data(), ops.Size());
+        endPacket(ops);
     }
 
 
 }
 
 void Organelle::invertLine(unsigned line) {
-    osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
 
     int x = ((line - 1) * 11) + ((line > 0) * 9);
     ops << osc::BeginMessage("/oled/gInvertArea")
@@ -1049,7 +1060,7 @@ void Organelle::invertLine(unsigned line) {
         << 128 << 10
         << osc::EndMessage;
 
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 
 }
 
@@ -1106,11 +1117,11 @@ void Organelle::midiCC(unsigned num, unsigned value) {
 }
 
 void Organelle::flipDisplay() {
-    osc::OutboundPacketStream ops(screenosc, OUTPUT_BUFFER_SIZE);
+    osc::OutboundPacketStream ops(beginPacket(), OUTPUT_BUFFER_SIZE);
     ops << osc::BeginMessage("/oled/gFlip")
         << PATCH_SCREEN
         << osc::EndMessage;
-    send(ops.Data(), ops.Size());
+    endPacket(ops);
 }
 
 
@@ -3,15 +3,17 @@
 #include "KontrolDevice.h"
 
 #include <KontrolModel.h>
-
-#include <ip/UdpSocket.h>
+#include <OSCPacketQueue.h>
 
 #include <string>
-#include <pa_ringbuffer.h>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 
+namespace osc {
+class OutboundPacketStream;
+}
+
 class Organelle : public KontrolDevice {
 public:
     Organelle();
@@ -34,6 +36,9 @@ public:
 
     virtual void changed(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &, const Kontrol::Parameter &) override;
 
+    // display updates only need the latest values
+    bool coalesceChanges() override { return true; }
+
     Kontrol::EntityId currentRack() { return currentRackId_; }
     void currentRack(const Kontrol::EntityId &p) { currentRackId_ = p; }
 
@@ -46,16 +51,10 @@ public:
     void writePoll();
 
 private:
-    void send(const char *data, unsigned size);
+    char *beginPacket();
+    void endPacket(const osc::OutboundPacketStream &ops);
     void stop() override ;
 
-    struct OscMsg {
-        static const int MAX_N_OSC_MSGS = 64;
-        static const int MAX_OSC_MESSAGE_SIZE = 128;
-        int size_;
-        char buffer_[MAX_OSC_MESSAGE_SIZE];
-    };
-
 
     bool connect();
     Kontrol::EntityId currentRackId_;
@@ -64,10 +63,10 @@ private:
     bool midiLearnActive_;
 
     std::string asDisplayString(const Kontrol::Parameter &p, unsigned width) const;
-    std::shared_ptr<UdpTransmitSocket> socket_;
+    std::shared_ptr<Kontrol::OSCPacketSocket> socket_;
 
-    PaUtilRingBuffer messageQueue_;
-    char msgData_[sizeof(OscMsg) * OscMsg::MAX_N_OSC_MSGS];
+    Kontrol::OSCPacketQueue queue_;
+    unsigned long reportedOverflows_;
     bool running_;
     std::mutex write_lock_;
     std::condition_variable write_cond_;
@@ -0,0 +1,154 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mec_log.h>
+#include <KontrolModel.h>
+
+// benchmark midi cc to listener, ns per cc (all mapped parameters changed, and each listener called)
+// 8 modules of 32 parameters, each cc mapped to 2 parameters, 2 listeners, sweeping all 128 ccs
+//   lookup : modules, mappings and parameters found by id per cc, then KontrolModel::changeParam (as Rack did)
+//   table  : Rack::changeMidiCC, dispatching from the rack's cc table
+
+static const unsigned MODULES = 8;
+static const unsigned PARAMS = 32;
+static const unsigned LISTENERS = 2;
+static const unsigned SWEEPS = 500;
+static const unsigned RUNS = 5;
+static const unsigned NUM_CCS = SWEEPS * 128;
+
+typedef std::chrono::steady_clock Clock;
+
+class CountingCallback : public Kontrol::KontrolCallback {
+public:
+    void rack(Kontrol::ChangeSource, const Kontrol::Rack &) override { ; }
+
+    void module(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &) override { ; }
+
+    void page(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+              const Kontrol::Page &) override { ; }
+
+    void param(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+               const Kontrol::Parameter &) override { ; }
+
+    void changed(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+                 const Kontrol::Parameter &param) override {
+        changed_++;
+        sum_ += param.current().floatValue();
+    }
+
+    void resource(Kontrol::ChangeSource, const Kontrol::Rack &, const std::string &,
+                  const std::string &) override { ; }
+
+    void deleteRack(Kontrol::ChangeSource, const Kontrol::Rack &) override { ; }
+
+    unsigned long changed_ = 0;
+    double sum_ = 0.0;
+};
+
+static bool lookupChangeMidiCC(Kontrol::Rack &rack, unsigned midiCC, unsigned midiValue) {
+    bool ret = false;
+    auto model = Kontrol::KontrolModel::model();
+    for (auto module : rack.getModules()) {
+        std::vector<Kontrol::EntityId> mmvec = module->getParamsForCC(midiCC);
+        for (auto paramId : mmvec) {
+            auto param = module->getParam(paramId);
+            if (param != nullptr) {
+                Kontrol::ParamValue pv = param->calcMidi(midiValue);
+                if (pv != param->current()) {
+                    model->changeParam(Kontrol::CS_MIDI, rack.id(), module->id(), param->id(), pv);
+                    ret = true;
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+static unsigned sweepValue(unsigned sweep, unsigned cc) {
+    return (sweep + cc) & 1 ? 100 : 10;
+}
+
+int main(int argc, char **argv) {
+    LOG_0("benchmark started");
+
+    auto model = Kontrol::KontrolModel::model();
+    std::vector<std::shared_ptr<CountingCallback>> listeners;
+    for (unsigned i = 0; i < LISTENERS; i++) {
+        listeners.push_back(std::make_shared<CountingCallback>());
+        model->addCallback("bench" + std::to_string(i), listeners.back());
+    }
+
+    auto rack = model->createLocalRack(9001);
+    for (unsigned m = 0; m < MODULES; m++) {
+        Kontrol::EntityId moduleId = "module" + std::to_string(m);
+        model->createModule(Kontrol::CS_LOCAL, rack->id(), moduleId, moduleId, "bench");
+        for (unsigned p = 0; p < PARAMS; p++) {
+            Kontrol::EntityId paramId = "param" + std::to_string(p);
+            std::vector<Kontrol::ParamValue> args = {
+                    Kontrol::ParamValue("float"), Kontrol::ParamValue(paramId), Kontrol::ParamValue(paramId),
+                    Kontrol::ParamValue(0.0f), Kontrol::ParamValue(1.0f), Kontrol::ParamValue(0.5f)
+            };
+            model->createParam(Kontrol::CS_LOCAL, rack->id(), moduleId, args);
+            rack->addMidiCCMapping((m * PARAMS + p) % 128, moduleId, paramId);
+        }
+    }
+
+    // both paths change the same parameters, and publish the same values
+    for (unsigned cc = 0; cc < 128; cc++) {
+        listeners[0]->changed_ = 0;
+        listeners[0]->sum_ = 0.0;
+        assert(lookupChangeMidiCC(*rack, cc, 20));
+        unsigned long lookupChanged = listeners[0]->changed_;
+        double lookupSum = listeners[0]->sum_;
+
+        assert(lookupChangeMidiCC(*rack, cc, 30));
+        listeners[0]->changed_ = 0;
+        listeners[0]->sum_ = 0.0;
+        assert(rack->changeMidiCC(cc, 20));
+        assert(listeners[0]->changed_ == lookupChanged);
+        assert(listeners[0]->sum_ == lookupSum);
+        assert(!rack->changeMidiCC(cc, 20));
+    }
+
+    // mappings changes are picked up
+    assert(!rack->changeMidiCC(127, 20));
+    rack->removeMidiCCMapping(127, "module7", "param31");
+    rack->removeMidiCCMapping(127, "module3", "param31");
+    assert(!rack->changeMidiCC(127, 90));
+    rack->addMidiCCMapping(127, "module7", "param31");
+    assert(rack->changeMidiCC(127, 90));
+
+    double bestLookup = 1e18, bestTable = 1e18;
+    unsigned long changedLookup = 0, changedTable = 0;
+    for (unsigned run = 0; run < RUNS; run++) {
+        unsigned long c = listeners[0]->changed_;
+        Clock::time_point start = Clock::now();
+        for (unsigned s = 0; s < SWEEPS; s++) {
+            for (unsigned cc = 0; cc < 128; cc++) lookupChangeMidiCC(*rack, cc, sweepValue(s, cc));
+        }
+        bestLookup = std::min(bestLookup, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        changedLookup = listeners[0]->changed_ - c;
+
+        c = listeners[0]->changed_;
+        start = Clock::now();
+        for (unsigned s = 0; s < SWEEPS; s++) {
+            for (unsigned cc = 0; cc < 128; cc++) rack->changeMidiCC(cc, sweepValue(s, cc));
+        }
+        bestTable = std::min(bestTable, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        changedTable = listeners[0]->changed_ - c;
+    }
+    assert(changedLookup == changedTable);
+
+    std::cout << "lookup ns/cc: " << bestLookup / NUM_CCS
+              << " changes/cc: " << static_cast<double>(changedLookup) / NUM_CCS << std::endl;
+    std::cout << "table  ns/cc: " << bestTable / NUM_CCS
+              << " changes/cc: " << static_cast<double>(changedTable) / NUM_CCS << std::endl;
+    std::cout << "speedup: " << bestLookup / bestTable << std::endl;
+
+    model->clearCallbacks();
+    LOG_0("benchmark completed");
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <mec_log.h>
+#include <KontrolModel.h>
+
+// benchmark parameter change throughput, changes/sec through KontrolModel::changeParam to a listener
+// 8 modules of 32 parameters, on a rack with a host:port id
+//   strings : ids passed as char strings, as OSCReceiver does for each /Kontrol/changed
+//   ids     : ids held by the caller, as devices and the midi cc table do
+
+static const unsigned MODULES = 8;
+static const unsigned PARAMS = 32;
+static const unsigned SWEEPS = 200;
+static const unsigned RUNS = 5;
+static const unsigned NUM_CHANGES = SWEEPS * MODULES * PARAMS;
+
+typedef std::chrono::steady_clock Clock;
+
+class CountingCallback : public Kontrol::KontrolCallback {
+public:
+    void rack(Kontrol::ChangeSource, const Kontrol::Rack &) override { ; }
+
+    void module(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &) override { ; }
+
+    void page(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+              const Kontrol::Page &) override { ; }
+
+    void param(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+               const Kontrol::Parameter &) override { ; }
+
+    void changed(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+                 const Kontrol::Parameter &) override {
+        changed_++;
+    }
+
+    void resource(Kontrol::ChangeSource, const Kontrol::Rack &, const std::string &,
+                  const std::string &) override { ; }
+
+    void deleteRack(Kontrol::ChangeSource, const Kontrol::Rack &) override { ; }
+
+    unsigned long changed_ = 0;
+};
+
+static void report(const char *name, double bestNs, unsigned long changed) {
+    std::cout << name
+              << " changes/sec: " << static_cast<unsigned long>(NUM_CHANGES / (bestNs / 1e9))
+              << " ns/change: " << bestNs / NUM_CHANGES
+              << " published: " << changed
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    LOG_0("benchmark started");
+
+    auto model = Kontrol::KontrolModel::model();
+    auto listener = std::make_shared<CountingCallback>();
+    model->addCallback("bench", listener);
+
+    auto rack = model->createRack(Kontrol::CS_LOCAL, Kontrol::Rack::createId("192.168.1.10", 9001),
+                                  "192.168.1.10", 9001);
+    std::vector<std::string> moduleNames, paramNames;
+    for (unsigned m = 0; m < MODULES; m++) {
+        moduleNames.push_back("module" + std::to_string(m));
+        model->createModule(Kontrol::CS_LOCAL, rack->id(), moduleNames[m], moduleNames[m], "bench");
+    }
+    for (unsigned p = 0; p < PARAMS; p++) {
+        paramNames.push_back("filter_cutoff_" + std::to_string(p));
+        for (unsigned m = 0; m < MODULES; m++) {
+            std::vector<Kontrol::ParamValue> args = {
+                    Kontrol::ParamValue("float"), Kontrol::ParamValue(paramNames[p]), Kontrol::ParamValue(paramNames[p]),
+                    Kontrol::ParamValue(0.0f), Kontrol::ParamValue(1.0f), Kontrol::ParamValue(0.5f)
+            };
+            model->createParam(Kontrol::CS_LOCAL, rack->id(), moduleNames[m], args);
+        }
+    }
+    std::string rackName = rack->id();
+
+    std::vector<Kontrol::EntityId> moduleIds(moduleNames.begin(), moduleNames.end());
+    std::vector<Kontrol::EntityId> paramIds(paramNames.begin(), paramNames.end());
+    Kontrol::EntityId rackId = rack->id();
+
+    double bestStrings = 1e18, bestIds = 1e18;
+    unsigned long changedStrings = 0, changedIds = 0;
+    for (unsigned run = 0; run < RUNS; run++) {
+        unsigned long c = listener->changed_;
+        Clock::time_point start = Clock::now();
+        for (unsigned s = 0; s < SWEEPS; s++) {
+            float v = (s & 1) ? 0.25f : 0.75f;
+            for (unsigned m = 0; m < MODULES; m++) {
+                for (unsigned p = 0; p < PARAMS; p++) {
+                    model->changeParam(Kontrol::CS_LOCAL, rackName.c_str(), moduleNames[m].c_str(),
+                                       paramNames[p].c_str(), Kontrol::ParamValue(v));
+                }
+            }
+        }
+        bestStrings = std::min(bestStrings, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        changedStrings = listener->changed_ - c;
+
+        c = listener->changed_;
+        start = Clock::now();
+        for (unsigned s = 0; s < SWEEPS; s++) {
+            float v = (s & 1) ? 0.25f : 0.75f;
+            for (unsigned m = 0; m < MODULES; m++) {
+                for (unsigned p = 0; p < PARAMS; p++) {
+                    model->changeParam(Kontrol::CS_LOCAL, rackId, moduleIds[m], paramIds[p], Kontrol::ParamValue(v));
+                }
+            }
+        }
+        bestIds = std::min(bestIds, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        changedIds = listener->changed_ - c;
+    }
+    assert(changedStrings == NUM_CHANGES);
+    assert(changedIds == NUM_CHANGES);
+
+    report("strings", bestStrings, changedStrings);
+    report("ids    ", bestIds, changedIds);
+
+    model->clearCallbacks();
+    LOG_0("benchmark completed");
+    return 0;
+}
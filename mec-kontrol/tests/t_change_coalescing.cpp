@@ -0,0 +1,183 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mec_log.h>
+#include <KontrolModel.h>
+#include <OSCBroadcaster.h>
+
+#include <ip/PacketListener.h>
+#include <ip/UdpSocket.h>
+#include <osc/OscReceivedElements.h>
+
+// parameter changes are coalesced for listeners that opt in, and sent to osc clients in as few datagrams as fit
+// reports datagrams sent for a sweep, with and without coalescing
+
+static const unsigned PARAMS = 40;
+static const unsigned SWEEPS = 10;
+static const unsigned TEST_PORT = 9917;
+
+class CountingCallback : public Kontrol::KontrolCallback {
+public:
+    CountingCallback(bool coalesce) : coalesce_(coalesce) { ; }
+
+    void rack(Kontrol::ChangeSource, const Kontrol::Rack &) override { ; }
+
+    void module(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &) override { ; }
+
+    void page(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+              const Kontrol::Page &) override { ; }
+
+    void param(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+               const Kontrol::Parameter &) override { ; }
+
+    void changed(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+                 const Kontrol::Parameter &param) override {
+        changed_++;
+        last_ = param.current().floatValue();
+    }
+
+    void resource(Kontrol::ChangeSource, const Kontrol::Rack &, const std::string &,
+                  const std::string &) override { ; }
+
+    void deleteRack(Kontrol::ChangeSource, const Kontrol::Rack &) override { ; }
+
+    bool coalesceChanges() override { return coalesce_; }
+
+    void beginChanges() override { batches_++; }
+
+    bool coalesce_;
+    unsigned changed_ = 0;
+    unsigned batches_ = 0;
+    float last_ = 0.0f;
+};
+
+// counts datagrams, and the messages in them
+class CountingPacketListener : public PacketListener {
+public:
+    void ProcessPacket(const char *data, int size, const IpEndpointName &) override {
+        packets_++;
+        osc::ReceivedPacket p(data, size);
+        if (p.IsBundle()) {
+            osc::ReceivedBundle b(p);
+            messages_ += b.ElementCount();
+        } else {
+            messages_++;
+        }
+    }
+
+    std::atomic<unsigned> packets_{0};
+    std::atomic<unsigned> messages_{0};
+};
+
+static void sweep(Kontrol::KontrolModel &model, const Kontrol::EntityId &rackId, unsigned base) {
+    for (unsigned s = 0; s < SWEEPS; s++) {
+        for (unsigned p = 0; p < PARAMS; p++) {
+            float v = static_cast<float>(base + s) / 100.0f;
+            model.changeParam(Kontrol::CS_LOCAL, rackId, "module1", "param" + std::to_string(p), Kontrol::ParamValue(v));
+        }
+    }
+}
+
+static void waitFor(CountingPacketListener &listener, unsigned messages) {
+    for (unsigned i = 0; i < 200 && listener.messages_ < messages; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+int main(int argc, char **argv) {
+    LOG_0("test started");
+
+    auto model = Kontrol::KontrolModel::model();
+    auto rack = model->createLocalRack(9001);
+    model->createModule(Kontrol::CS_LOCAL, rack->id(), "module1", "module1", "test");
+    for (unsigned p = 0; p < PARAMS; p++) {
+        std::string paramId = "param" + std::to_string(p);
+        std::vector<Kontrol::ParamValue> args = {
+                Kontrol::ParamValue("float"), Kontrol::ParamValue(paramId), Kontrol::ParamValue(paramId),
+                Kontrol::ParamValue(0.0f), Kontrol::ParamValue(1.0f), Kontrol::ParamValue(0.0f)
+        };
+        model->createParam(Kontrol::CS_LOCAL, rack->id(), "module1", args);
+    }
+
+    auto direct = std::make_shared<CountingCallback>(false);
+    auto coalesced = std::make_shared<CountingCallback>(true);
+    model->addCallback("direct", direct);
+    model->addCallback("coalesced", coalesced);
+
+    // no interval, all listeners called on each change
+    sweep(*model, rack->id(), 10);
+    assert(direct->changed_ == PARAMS * SWEEPS);
+    assert(coalesced->changed_ == PARAMS * SWEEPS);
+    assert(!model->flushChanges(true));
+
+    // with an interval, coalescing listeners get each changed parameter once, with its latest value
+    model->setChangeInterval(5);
+    direct->changed_ = 0;
+    coalesced->changed_ = 0;
+    sweep(*model, rack->id(), 30);
+    assert(direct->changed_ == PARAMS * SWEEPS);
+    assert(coalesced->changed_ == 0);
+    assert(model->flushChanges(true));
+    assert(coalesced->changed_ == PARAMS);
+    assert(coalesced->batches_ == 1);
+    assert(coalesced->last_ == static_cast<float>(30 + SWEEPS - 1) / 100.0f);
+    assert(!model->flushChanges(true));
+
+    // flushed only once the interval has passed
+    model->setChangeInterval(1000);
+    model->changeParam(Kontrol::CS_LOCAL, rack->id(), "module1", "param0", Kontrol::ParamValue(0.9f));
+    assert(!model->flushChanges());
+    assert(model->flushChanges(true));
+
+    model->removeCallback("direct");
+    model->removeCallback("coalesced");
+
+    // osc client, datagrams per sweep
+    CountingPacketListener packets;
+    UdpListeningReceiveSocket socket(IpEndpointName(IpEndpointName::ANY_ADDRESS, TEST_PORT), &packets);
+    std::thread receiver([&socket]() { socket.Run(); });
+
+    auto client = std::make_shared<Kontrol::OSCBroadcaster>(
+            Kontrol::ChangeSource::createRemoteSource("127.0.0.1", TEST_PORT), 0, false);
+    assert(client->connect("127.0.0.1", TEST_PORT));
+    model->addCallback("client", client);
+
+    // one datagram per change, paced so the broadcaster's queue does not overflow
+    model->setChangeInterval(0);
+    for (unsigned s = 0; s < SWEEPS; s++) {
+        for (unsigned p = 0; p < PARAMS; p++) {
+            float v = static_cast<float>(50 + s) / 100.0f;
+            model->changeParam(Kontrol::CS_LOCAL, rack->id(), "module1", "param" + std::to_string(p),
+                               Kontrol::ParamValue(v));
+        }
+        waitFor(packets, (s + 1) * PARAMS);
+    }
+    unsigned directPackets = packets.packets_;
+    assert(packets.messages_ == PARAMS * SWEEPS);
+    assert(directPackets == PARAMS * SWEEPS);
+
+    packets.packets_ = 0;
+    packets.messages_ = 0;
+    model->setChangeInterval(5);
+    sweep(*model, rack->id(), 70);
+    model->flushChanges(true);
+    waitFor(packets, PARAMS);
+    unsigned coalescedPackets = packets.packets_;
+    assert(packets.messages_ == PARAMS);
+    assert(coalescedPackets * 10 <= PARAMS);
+
+    std::cout << "datagrams per sweep of " << PARAMS << " params x " << SWEEPS
+              << ", direct: " << directPackets << " coalesced: " << coalescedPackets << std::endl;
+
+    model->clearCallbacks();
+    socket.AsynchronousBreak();
+    receiver.join();
+
+    LOG_0("test completed");
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <cassert>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <mec_log.h>
+#include <Entity.h>
+
+static const unsigned THREAD_IDS = 5000;
+
+static void internIds(const char *prefix, std::vector<Kontrol::EntityId> &ids) {
+    for (unsigned i = 0; i < THREAD_IDS; i++) {
+        ids.push_back(Kontrol::EntityId(std::string(prefix) + std::to_string(i % (THREAD_IDS / 2))));
+    }
+}
+
+int main(int argc, char **argv) {
+    LOG_0("test started");
+
+    // interned, equal strings give equal ids
+    {
+        Kontrol::EntityId a("cutoff");
+        Kontrol::EntityId b(std::string("cut") + "off");
+        Kontrol::EntityId c("resonance");
+        assert(a == b);
+        assert(a.value() == b.value());
+        assert(a != c);
+        assert(a.str() == "cutoff");
+        assert(a == "cutoff");
+        assert(std::string("cutoff") == a);
+        assert(std::string(a.c_str()) == "cutoff");
+        assert(std::string("p:") + a == "p:cutoff");
+    }
+
+    // empty
+    {
+        Kontrol::EntityId e;
+        assert(e.empty());
+        assert(e.value() == 0);
+        assert(e == Kontrol::EntityId(""));
+        assert(e.str().empty());
+        assert(!Kontrol::EntityId("x").empty());
+    }
+
+    // ordered by string, hashed by value
+    {
+        std::set<Kontrol::EntityId> ordered = {"zeta", "alpha", "mid"};
+        std::vector<std::string> names;
+        for (const auto &id : ordered) names.push_back(id.str());
+        assert(names == std::vector<std::string>({"alpha", "mid", "zeta"}));
+
+        std::unordered_map<Kontrol::EntityId, int> map;
+        map["one"] = 1;
+        map[Kontrol::EntityId(std::string("one"))]++;
+        assert(map.size() == 1);
+        assert(map["one"] == 2);
+    }
+
+    // interned from several threads, while the table grows
+    {
+        std::vector<Kontrol::EntityId> ids[3];
+        std::thread t1(internIds, "thread_", std::ref(ids[0]));
+        std::thread t2(internIds, "thread_", std::ref(ids[1]));
+        internIds("other_", ids[2]);
+        t1.join();
+        t2.join();
+        assert(ids[0] == ids[1]);
+        for (unsigned i = 0; i < THREAD_IDS; i++) {
+            assert(ids[0][i].str() == "thread_" + std::to_string(i % (THREAD_IDS / 2)));
+            assert(ids[0][i] != ids[2][i]);
+            assert(ids[0][i] == ids[0][i % (THREAD_IDS / 2)]);
+        }
+    }
+
+    LOG_0("test completed");
+    return 0;
+}
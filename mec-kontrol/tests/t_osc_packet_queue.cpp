@@ -0,0 +1,154 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <mec_log.h>
+#include <OSCPacketQueue.h>
+
+#include <ip/PacketListener.h>
+#include <ip/UdpSocket.h>
+
+// variable size packets through the osc packet queue, wrapping, overflow and a writer thread sending to a socket
+
+static const unsigned QUEUE_SIZE = 1 << 12;
+static const unsigned NUM_PACKETS = 20000;
+static const unsigned TEST_PORT = 9918;
+
+static unsigned packetSize(unsigned n) {
+    return 4 + (n % 97) * 4;
+}
+
+static void fill(char *p, unsigned n, unsigned size) {
+    for (unsigned i = 0; i < size; i++) p[i] = static_cast<char>(n + i);
+}
+
+static bool check(const char *p, unsigned n, unsigned size) {
+    if (size != packetSize(n)) return false;
+    for (unsigned i = 0; i < size; i++) {
+        if (p[i] != static_cast<char>(n + i)) return false;
+    }
+    return true;
+}
+
+// checks packets arrive complete, and in order
+class CheckingPacketListener : public PacketListener {
+public:
+    void ProcessPacket(const char *data, int size, const IpEndpointName &) override {
+        if (!check(data, next_, static_cast<unsigned>(size))) errors_++;
+        next_++;
+    }
+
+    std::atomic<unsigned> next_{0};
+    std::atomic<unsigned> errors_{0};
+};
+
+int main(int argc, char **argv) {
+    LOG_0("test started");
+
+    const char *packets[Kontrol::OSCPacketQueue::MAX_SEND_BATCH];
+    unsigned sizes[Kontrol::OSCPacketQueue::MAX_SEND_BATCH];
+
+    // packets are encoded in place, and read back in order, across many wraps of the ring
+    {
+        Kontrol::OSCPacketQueue queue(QUEUE_SIZE);
+        unsigned written = 0, read = 0, full = 0;
+        while (read < NUM_PACKETS) {
+            for (unsigned i = 0; i < 7 && written < NUM_PACKETS; i++) {
+                char *p = queue.reserve(512);
+                if (p == nullptr) {
+                    full++;
+                    break;
+                }
+                fill(p, written, packetSize(written));
+                queue.commit(packetSize(written));
+                written++;
+            }
+            unsigned n = queue.front(packets, sizes, 5);
+            for (unsigned i = 0; i < n; i++) {
+                assert(check(packets[i], read, sizes[i]));
+                read++;
+            }
+            queue.pop();
+        }
+        assert(queue.front(packets, sizes, 5) == 0);
+        assert(queue.packets() == NUM_PACKETS);
+        assert(queue.overflows() == full);
+    }
+
+    // when full, packets are counted as overflows, and the queue is usable once read
+    {
+        Kontrol::OSCPacketQueue queue(QUEUE_SIZE);
+        char data[64];
+        memset(data, 0, sizeof(data));
+        unsigned pushed = 0;
+        while (queue.push(data, sizeof(data))) pushed++;
+        assert(pushed == QUEUE_SIZE / (sizeof(data) + 4));
+        assert(!queue.push(data, sizeof(data)));
+        assert(queue.overflows() == 2);
+
+        unsigned n, read = 0;
+        while ((n = queue.front(packets, sizes, Kontrol::OSCPacketQueue::MAX_SEND_BATCH)) > 0) {
+            read += n;
+            queue.pop();
+        }
+        assert(read == pushed);
+        assert(queue.push(data, sizeof(data)));
+        queue.clear();
+        assert(queue.front(packets, sizes, 1) == 0);
+    }
+
+    // a writer thread sending from the queue, while this thread encodes into it
+    {
+        CheckingPacketListener listener;
+        UdpListeningReceiveSocket socket(IpEndpointName(IpEndpointName::ANY_ADDRESS, TEST_PORT), &listener);
+        std::thread receiver([&socket]() { socket.Run(); });
+
+        Kontrol::OSCPacketQueue queue(1 << 16);
+        Kontrol::OSCPacketSocket sender("127.0.0.1", TEST_PORT);
+        std::atomic<bool> running(true);
+        std::thread writer([&]() {
+            while (running) {
+                if (queue.flush(sender) == 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            queue.flush(sender);
+        });
+
+        unsigned sent = 0;
+        while (sent < NUM_PACKETS) {
+            char *p = queue.reserve(packetSize(sent));
+            if (p == nullptr) {
+                // wait for the writer, rather than lose packets
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                continue;
+            }
+            fill(p, sent, packetSize(sent));
+            queue.commit(packetSize(sent));
+            sent++;
+            // keep within the receiver's socket buffer
+            if ((sent % 64) == 0) {
+                for (unsigned i = 0; i < 400 && listener.next_ < sent; i++) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        }
+        running = false;
+        writer.join();
+
+        for (unsigned i = 0; i < 400 && listener.next_ < NUM_PACKETS; i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::cout << "packets received: " << listener.next_ << " errors: " << listener.errors_
+                  << " overflows: " << queue.overflows() << std::endl;
+        assert(listener.next_ == NUM_PACKETS);
+        assert(listener.errors_ == 0);
+
+        socket.AsynchronousBreak();
+        receiver.join();
+    }
+
+    LOG_0("test completed");
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <mec_log.h>
+#include <KontrolModel.h>
+#include <SettingsWriter.h>
+
+// presets are applied as one batch of the changed parameters, settings are saved on a background thread
+// reports the time the caller spends in applyPreset and saveSettings
+
+static const unsigned MODULES = 4;
+static const unsigned PARAMS = 32;
+static const char *SETTINGS_FILE = "t_preset_settings-rack.json";
+
+typedef std::chrono::steady_clock Clock;
+
+class CountingCallback : public Kontrol::KontrolCallback {
+public:
+    void rack(Kontrol::ChangeSource, const Kontrol::Rack &) override { ; }
+
+    void module(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &) override { ; }
+
+    void page(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+              const Kontrol::Page &) override { ; }
+
+    void param(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+               const Kontrol::Parameter &) override { ; }
+
+    void changed(Kontrol::ChangeSource, const Kontrol::Rack &, const Kontrol::Module &,
+                 const Kontrol::Parameter &) override {
+        changed_++;
+    }
+
+    void resource(Kontrol::ChangeSource, const Kontrol::Rack &, const std::string &,
+                  const std::string &) override { ; }
+
+    void deleteRack(Kontrol::ChangeSource, const Kontrol::Rack &) override { ; }
+
+    void beginChanges() override { batches_++; }
+
+    unsigned changed_ = 0;
+    unsigned batches_ = 0;
+};
+
+static std::string readFile(const std::string &filename) {
+    std::ifstream in(filename);
+    std::stringstream s;
+    s << in.rdbuf();
+    return s.str();
+}
+
+static std::string paramId(unsigned p) {
+    return "param" + std::to_string(p);
+}
+
+static std::string moduleId(unsigned m) {
+    return "module" + std::to_string(m);
+}
+
+static void setAll(Kontrol::KontrolModel &model, const Kontrol::EntityId &rackId, float v) {
+    for (unsigned m = 0; m < MODULES; m++) {
+        for (unsigned p = 0; p < PARAMS; p++) {
+            model.changeParam(Kontrol::CS_LOCAL, rackId, moduleId(m), paramId(p), Kontrol::ParamValue(v));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    LOG_0("test started");
+
+    // saves are debounced, and written whole
+    {
+        std::remove(SETTINGS_FILE);
+        Kontrol::SettingsWriter writer(50);
+        unsigned serialised = 0;
+        for (unsigned i = 0; i < 10; i++) {
+            writer.save(SETTINGS_FILE, [&serialised, i]() {
+                serialised++;
+                return std::to_string(i);
+            });
+        }
+        assert(readFile(SETTINGS_FILE).empty());
+        writer.flush();
+        assert(serialised == 1);
+        assert(readFile(SETTINGS_FILE) == "9");
+
+        writer.save(SETTINGS_FILE, []() { return std::string("10"); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        assert(readFile(SETTINGS_FILE) == "10");
+        assert(serialised == 1);
+        assert(std::ifstream(std::string(SETTINGS_FILE) + ".tmp").fail());
+
+        // written when the writer is destroyed
+        writer.save(SETTINGS_FILE, []() { return std::string("11"); });
+    }
+    assert(readFile(SETTINGS_FILE) == "11");
+    assert(!Kontrol::SettingsWriter::writeFile("no-such-dir/settings.json", "x"));
+
+    auto model = Kontrol::KontrolModel::model();
+    auto rack = model->createLocalRack(9001);
+    for (unsigned m = 0; m < MODULES; m++) {
+        model->createModule(Kontrol::CS_LOCAL, rack->id(), moduleId(m), moduleId(m), "test");
+        for (unsigned p = 0; p < PARAMS; p++) {
+            std::vector<Kontrol::ParamValue> args = {
+                    Kontrol::ParamValue("float"), Kontrol::ParamValue(paramId(p)), Kontrol::ParamValue(paramId(p)),
+                    Kontrol::ParamValue(0.0f), Kontrol::ParamValue(1.0f), Kontrol::ParamValue(0.0f)
+            };
+            model->createParam(Kontrol::CS_LOCAL, rack->id(), moduleId(m), args);
+        }
+    }
+    auto listener = std::make_shared<CountingCallback>();
+    model->addCallback("test", listener);
+
+    setAll(*model, rack->id(), 0.25f);
+    rack->updatePreset("low");
+    setAll(*model, rack->id(), 0.75f);
+    model->changeParam(Kontrol::CS_LOCAL, rack->id(), moduleId(0), paramId(0), Kontrol::ParamValue(0.25f));
+    rack->updatePreset("high");
+
+    // only parameters which differ are changed, published in one batch
+    listener->changed_ = 0;
+    listener->batches_ = 0;
+    Clock::time_point start = Clock::now();
+    assert(rack->applyPreset("low"));
+    double applyUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    assert(listener->changed_ == MODULES * PARAMS - 1);
+    assert(listener->batches_ == 1);
+    assert(rack->getModule(moduleId(3))->getParam(paramId(31))->current().floatValue() == 0.25f);
+
+    listener->changed_ = 0;
+    assert(rack->applyPreset("low"));
+    assert(listener->changed_ == 0);
+    assert(!rack->applyPreset("missing"));
+
+    // coalescing listeners get the preset on the next flush
+    struct Coalescing : public CountingCallback {
+        bool coalesceChanges() override { return true; }
+    };
+    auto coalescing = std::make_shared<Coalescing>();
+    model->addCallback("coalescing", coalescing);
+    model->setChangeInterval(5);
+    listener->changed_ = 0;
+    assert(rack->applyPreset("high"));
+    assert(listener->changed_ == MODULES * PARAMS - 1);
+    assert(coalescing->changed_ == 0);
+    assert(model->flushChanges(true));
+    assert(coalescing->changed_ == MODULES * PARAMS - 1);
+    model->setChangeInterval(0);
+
+    // settings are saved off the caller's thread, and can be loaded back
+    std::remove(SETTINGS_FILE);
+    assert(rack->loadSettings(SETTINGS_FILE) == false);
+    rack->updatePreset("low");
+    start = Clock::now();
+    assert(rack->saveSettings());
+    double saveUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    rack->flushSettings();
+    std::string json = readFile(SETTINGS_FILE);
+    assert(json.find("\"low\"") != std::string::npos);
+    assert(json.find("\"high\"") == std::string::npos);
+
+    assert(rack->loadSettings(SETTINGS_FILE));
+    assert(rack->getPresetList().size() == 1);
+    assert(rack->applyPreset("low"));
+
+    std::cout << "applyPreset us: " << applyUs << " saveSettings us: " << saveUs << std::endl;
+
+    std::remove(SETTINGS_FILE);
+    model->clearCallbacks();
+    LOG_0("test completed");
+    return 0;
+}